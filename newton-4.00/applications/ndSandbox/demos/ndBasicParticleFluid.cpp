@@ -77,7 +77,7 @@ class ndIsoSurfaceParticleVolume : public ndBodySphFluid
 		}
 	}
 
-	void BuildIndexList()
+	void BuildIndexList(ndThreadPool* const threadPool)
 	{
 		D_TRACKTIME();
 		const ndArray<ndVector>& points = m_isoSurface.GetPoints();
@@ -88,7 +88,7 @@ class ndIsoSurfaceParticleVolume : public ndBodySphFluid
 
 			ndReal* const posit = &m_points[0].m_posit.m_x;
 			ndReal* const normal = &m_points[0].m_normal.m_x;
-			ndInt32 pointCount = m_isoSurface.GenerateListIndexList(&m_indexList[0], sizeof(glPositionNormalUV) / sizeof(GLfloat), posit, normal);
+			ndInt32 pointCount = m_isoSurface.GenerateListIndexList(threadPool, &m_indexList[0], sizeof(glPositionNormalUV) / sizeof(GLfloat), posit, normal);
 
 			const ndVector origin(m_isoSurface.GetOrigin());
 			for (ndInt32 i = 0; i < pointCount; ++i)
@@ -102,15 +102,15 @@ class ndIsoSurfaceParticleVolume : public ndBodySphFluid
 		}
 	}
 
-	void UpdateIsoSurface()
+	void UpdateIsoSurface(ndThreadPool* const threadPool)
 	{
 		D_TRACKTIME();
 		ndArray<ndVector>& pointCloud = GetPositions();
 		ndFloat32 gridSpacing = 2.0f * GetParticleRadius();
-		m_isoSurface.GenerateMesh(pointCloud, gridSpacing);
+		m_isoSurface.GenerateMesh(threadPool, pointCloud, gridSpacing);
 
 #if 1
-		BuildIndexList();
+		BuildIndexList(threadPool);
 #else
 		BuildTriangleList();
 #endif
@@ -400,7 +400,7 @@ static void AddWaterVolume(ndDemoEntityManager* const scene, const ndMatrix& loc
 	//BuildHollowBox(matrix, fluidObject, particleCountPerAxis);
 	
 	// make sure we have the first surface generated before rendering.
-	fluidObject->UpdateIsoSurface();
+	fluidObject->UpdateIsoSurface(world->GetScene());
 
 	// add particle volume to world
 	scene->AddEntity(entity);
@@ -0,0 +1,229 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "ndBrainStdafx.h"
+#include "ndBrainTrainer.h"
+#include "ndBrainLayer.h"
+#include "ndBrainAgentContinuePolicyGradient_Rollout.h"
+
+// the rows of the ping pong batch buffer are padded apart, so the rows written
+// by different threads do not share cache lines, and the stride is rounded 
+// to a multiple of four floats, so every row starts simd aligned.
+#define ND_ROLLOUT_BATCH_ROW_PADDING	128
+#define ND_ROLLOUT_BATCH_ROW_ALIGNMENT	4
+
+ndBrainAgentContinuePolicyGradient_Rollout::ndBrainAgentContinuePolicyGradient_Rollout(const ndSharedPtr<ndBrainAgentContinuePolicyGradient_TrainerMaster>& master, ndUnsigned32 randomSeed)
+	:ndClassAlloc()
+	,m_master(master)
+	,m_environmentList()
+	,m_environments()
+	,m_randomGenerators()
+	,m_stepCount()
+	,m_trajectories(master->m_numberOfActions, master->m_numberOfObservations)
+	,m_batchBuffer()
+	,m_maxSteps(master->m_maxTrajectorySteps + master->m_extraTrajectorySteps)
+	,m_batchStride(0)
+	,m_randomSeed(randomSeed)
+{
+	m_trajectories.SetCount(0);
+}
+
+ndBrainAgentContinuePolicyGradient_Rollout::~ndBrainAgentContinuePolicyGradient_Rollout()
+{
+	for (ndInt32 i = 0; i < ndInt32(m_randomGenerators.GetCount()); ++i)
+	{
+		delete m_randomGenerators[i];
+	}
+}
+
+void ndBrainAgentContinuePolicyGradient_Rollout::AddEnvironment(const ndSharedPtr<ndEnvironment>& environment)
+{
+	ndSharedPtr<ndEnvironment>& owner = m_environmentList.Append(environment)->GetInfo();
+	m_environments.PushBack(*owner);
+
+	// the environments are stepped concurrently, a private generator per 
+	// environment keeps the exploration noise independent of the thread schedule
+	ndBrainAgentContinuePolicyGradient_Trainer::ndRandomGenerator* const generator = new ndBrainAgentContinuePolicyGradient_Trainer::ndRandomGenerator;
+	generator->m_gen.seed(m_randomSeed + ndUnsigned32(m_randomGenerators.GetCount()));
+	m_randomGenerators.PushBack(generator);
+	m_stepCount.PushBack(0);
+
+	// each environment owns a region of maxSteps entries of the trajectory buffer
+	m_trajectories.SetCount(ndInt32(m_environments.GetCount()) * m_maxSteps);
+}
+
+void ndBrainAgentContinuePolicyGradient_Rollout::CalculatePolicyBatch()
+{
+	const ndBrain& policy = m_master->m_policy;
+	const ndInt32 count = ndInt32(m_environments.GetCount());
+	const ndInt32 numberOfActions = m_master->m_numberOfActions;
+	const ndInt32 numberOfObservations = m_master->m_numberOfObservations;
+
+	ndInt32 maxSize = policy[0]->GetInputSize();
+	for (ndInt32 i = 0; i < policy.GetCount(); ++i)
+	{
+		maxSize = ndMax(maxSize, policy[i]->GetOutputBufferSize());
+	}
+	m_batchStride = (maxSize + ND_ROLLOUT_BATCH_ROW_PADDING + ND_ROLLOUT_BATCH_ROW_ALIGNMENT - 1) & -ND_ROLLOUT_BATCH_ROW_ALIGNMENT;
+	m_batchBuffer.SetCount(ndInt64(2) * count * m_batchStride);
+
+	// each thread takes a block of rows and runs the whole block through one
+	// layer before moving to the next, so the layer weights stay in cache.
+	auto PolicyBatch = ndMakeObject::ndFunction([this, &policy, count, numberOfActions, numberOfObservations](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		const ndStartEnd startEnd(count, threadIndex, threadCount);
+		ndBrainFloat* const buffer = &m_batchBuffer[0];
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndInt32 entry = i * m_maxSteps + m_stepCount[i];
+			ndMemCpy(&buffer[ndInt64(2 * i) * m_batchStride], m_trajectories.GetObservations(entry), numberOfObservations);
+		}
+
+		ndInt32 src = 0;
+		for (ndInt32 j = 0; j < policy.GetCount(); ++j)
+		{
+			const ndBrainLayer* const layer = policy[j];
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+			{
+				const ndBrainMemVector input(&buffer[ndInt64(2 * i + src) * m_batchStride], layer->GetInputSize());
+				ndBrainMemVector output(&buffer[ndInt64(2 * i + 1 - src) * m_batchStride], layer->GetOutputSize());
+				layer->MakePrediction(input, output);
+			}
+			src = 1 - src;
+		}
+
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndInt32 entry = i * m_maxSteps + m_stepCount[i];
+			ndMemCpy(m_trajectories.GetActions(entry), &buffer[ndInt64(2 * i + src) * m_batchStride], numberOfActions * 2);
+		}
+	});
+	m_master->ParallelExecute(PolicyBatch);
+}
+
+void ndBrainAgentContinuePolicyGradient_Rollout::SaveTrajectory(ndInt32 environment)
+{
+	const ndInt32 steps = m_stepCount[environment];
+	if (!steps)
+	{
+		return;
+	}
+
+	ndBrainAgentContinuePolicyGradient_TrainerMaster* const master = *m_master;
+	master->m_bashTrajectoryIndex++;
+
+	// using the Bellman equation to calculate trajectory rewards. (Monte Carlo method)
+	const ndInt32 base = environment * m_maxSteps;
+	const ndBrainFloat gamma = master->m_gamma;
+	for (ndInt32 i = steps - 2; i >= 0; --i)
+	{
+		const ndBrainFloat r0 = m_trajectories.GetReward(base + i);
+		const ndBrainFloat r1 = m_trajectories.GetReward(base + i + 1);
+		m_trajectories.SetReward(base + i, r0 + gamma * r1);
+	}
+
+	const ndInt32 maxSteps = ndMin(steps, master->m_maxTrajectorySteps);
+	ndBrainAgentContinuePolicyGradient_Trainer::ndTrajectoryStep& trajectoryAccumulator = master->m_trajectoryAccumulator;
+	const ndInt32 start = trajectoryAccumulator.GetCount();
+	trajectoryAccumulator.SetCount(start + maxSteps);
+	for (ndInt32 i = 0; i < maxSteps; ++i)
+	{
+		const ndInt32 index = start + i;
+		trajectoryAccumulator.SetAdvantage(index, ndBrainFloat(0.0f));
+		trajectoryAccumulator.SetReward(index, m_trajectories.GetReward(base + i));
+		ndMemCpy(trajectoryAccumulator.GetActions(index), m_trajectories.GetActions(base + i), master->m_numberOfActions * 2);
+		ndMemCpy(trajectoryAccumulator.GetObservations(index), m_trajectories.GetObservations(base + i), master->m_numberOfObservations);
+	}
+}
+
+void ndBrainAgentContinuePolicyGradient_Rollout::Step(ndFloat32 timestep)
+{
+	const ndInt32 count = ndInt32(m_environments.GetCount());
+	if (!count)
+	{
+		return;
+	}
+
+	ndAtomic<ndInt32> iterator(0);
+	auto GatherObservations = ndMakeObject::ndFunction([this, &iterator, count](ndInt32, ndInt32)
+	{
+		for (ndInt32 i = iterator++; i < count; i = iterator++)
+		{
+			const ndInt32 entry = i * m_maxSteps + m_stepCount[i];
+			m_trajectories.Clear(entry);
+			m_environments[i]->GetObservation(m_trajectories.GetObservations(entry));
+		}
+	});
+	m_master->ParallelExecute(GatherObservations);
+
+	CalculatePolicyBatch();
+
+	iterator = 0;
+	auto StepEnvironments = ndMakeObject::ndFunction([this, &iterator, count, timestep](ndInt32, ndInt32)
+	{
+		const ndInt32 numberOfActions = m_master->m_numberOfActions;
+		for (ndInt32 i = iterator++; i < count; i = iterator++)
+		{
+			const ndInt32 entry = i * m_maxSteps + m_stepCount[i];
+			ndBrainFloat* const actions = m_trajectories.GetActions(entry);
+
+			// same sampling as ndBrainAgentContinuePolicyGradient_Trainer::SelectAction
+			ndBrainAgentContinuePolicyGradient_Trainer::ndRandomGenerator& generator = *m_randomGenerators[i];
+			for (ndInt32 j = numberOfActions - 1; j >= 0; --j)
+			{
+				ndBrainFloat sample = ndBrainFloat(actions[j] + generator.m_d(generator.m_gen) * actions[j + numberOfActions]);
+				actions[j] = ndClamp(sample, ndBrainFloat(-1.0f), ndBrainFloat(1.0f));
+			}
+
+			ndEnvironment* const environment = m_environments[i];
+			environment->ApplyActions(actions);
+			m_trajectories.SetReward(entry, environment->CalculateReward());
+			environment->Step(timestep);
+			m_stepCount[i]++;
+		}
+	});
+	m_master->ParallelExecute(StepEnvironments);
+
+	// trajectories are handed to the master in environment order, so runs are reproducible
+	ndBrainAgentContinuePolicyGradient_TrainerMaster* const master = *m_master;
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		ndEnvironment* const environment = m_environments[i];
+		if (environment->IsTerminal() || (m_stepCount[i] >= m_maxSteps))
+		{
+			SaveTrajectory(i);
+			environment->ResetModel();
+			m_stepCount[i] = 0;
+		}
+		master->m_frameCount++;
+		master->m_framesAlive++;
+	}
+
+	if (master->OptimizeTrajectories())
+	{
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			m_stepCount[i] = 0;
+			m_environments[i]->ResetModel();
+		}
+	}
+}
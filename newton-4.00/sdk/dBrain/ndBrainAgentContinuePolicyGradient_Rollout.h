@@ -0,0 +1,122 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef _ND_AGENT_CONTINUE_POLICY_GRADIENT_ROLLOUT_H__
+#define _ND_AGENT_CONTINUE_POLICY_GRADIENT_ROLLOUT_H__
+
+#include "ndBrainStdafx.h"
+#include "ndBrainAgentContinuePolicyGradient_Trainer.h"
+
+// steps many independent environments in lock step for a policy gradient master.
+// each tick gathers the observations of all environments in one batch, runs
+// the policy once over the batch, layer by layer, and scatters the actions back.
+// the steps of all environments are recorded in one contiguous buffer, with a
+// fixed region per environment, and finished trajectories go to the master.
+// environments are stepped concurrently, so each one must own its simulation,
+// usually a separate single threaded ndWorld. environment i draws its exploration
+// noise from its own generator, seeded with randomSeed + i.
+class ndBrainAgentContinuePolicyGradient_Rollout : public ndClassAlloc
+{
+	public:
+	class ndEnvironment : public ndClassAlloc
+	{
+		public:
+		ndEnvironment()
+			:ndClassAlloc()
+		{
+		}
+
+		virtual ~ndEnvironment()
+		{
+		}
+
+		virtual void ResetModel() = 0;
+		virtual bool IsTerminal() const = 0;
+		virtual ndBrainFloat CalculateReward() = 0;
+		virtual void ApplyActions(ndBrainFloat* const actions) = 0;
+		virtual void GetObservation(ndBrainFloat* const observation) = 0;
+
+		// advance the simulation one step, usually world->Update(timestep) and world->Sync()
+		virtual void Step(ndFloat32 timestep) = 0;
+	};
+
+	ndBrainAgentContinuePolicyGradient_Rollout(const ndSharedPtr<ndBrainAgentContinuePolicyGradient_TrainerMaster>& master, ndUnsigned32 randomSeed = 47);
+	~ndBrainAgentContinuePolicyGradient_Rollout();
+
+	void AddEnvironment(const ndSharedPtr<ndEnvironment>& environment);
+	ndInt32 GetEnvironmentCount() const;
+	ndInt32 GetTrajectorySteps(ndInt32 environment) const;
+
+	// the recorded steps of the trajectory in progress of an environment,
+	// actions are the sampled actions followed by the policy deviations
+	ndBrainFloat GetTrajectoryReward(ndInt32 environment, ndInt32 step) const;
+	const ndBrainFloat* GetTrajectoryActions(ndInt32 environment, ndInt32 step) const;
+	const ndBrainFloat* GetTrajectoryObservations(ndInt32 environment, ndInt32 step) const;
+
+	// one tick of all environments
+	void Step(ndFloat32 timestep);
+
+	private:
+	void CalculatePolicyBatch();
+	void SaveTrajectory(ndInt32 environment);
+
+	ndSharedPtr<ndBrainAgentContinuePolicyGradient_TrainerMaster> m_master;
+	ndList<ndSharedPtr<ndEnvironment>> m_environmentList;
+	ndArray<ndEnvironment*> m_environments;
+	ndArray<ndBrainAgentContinuePolicyGradient_Trainer::ndRandomGenerator*> m_randomGenerators;
+	ndArray<ndInt32> m_stepCount;
+	ndBrainAgentContinuePolicyGradient_Trainer::ndTrajectoryStep m_trajectories;
+	ndBrainVector m_batchBuffer;
+	ndInt32 m_maxSteps;
+	ndInt32 m_batchStride;
+	ndUnsigned32 m_randomSeed;
+};
+
+inline ndInt32 ndBrainAgentContinuePolicyGradient_Rollout::GetEnvironmentCount() const
+{
+	return ndInt32(m_environments.GetCount());
+}
+
+inline ndInt32 ndBrainAgentContinuePolicyGradient_Rollout::GetTrajectorySteps(ndInt32 environment) const
+{
+	return m_stepCount[environment];
+}
+
+inline ndBrainFloat ndBrainAgentContinuePolicyGradient_Rollout::GetTrajectoryReward(ndInt32 environment, ndInt32 step) const
+{
+	ndAssert(step < m_stepCount[environment]);
+	return m_trajectories.GetReward(environment * m_maxSteps + step);
+}
+
+inline const ndBrainFloat* ndBrainAgentContinuePolicyGradient_Rollout::GetTrajectoryActions(ndInt32 environment, ndInt32 step) const
+{
+	ndAssert(step < m_stepCount[environment]);
+	return m_trajectories.GetActions(environment * m_maxSteps + step);
+}
+
+inline const ndBrainFloat* ndBrainAgentContinuePolicyGradient_Rollout::GetTrajectoryObservations(ndInt32 environment, ndInt32 step) const
+{
+	ndAssert(step < m_stepCount[environment]);
+	return m_trajectories.GetObservations(environment * m_maxSteps + step);
+}
+
+#endif 
@@ -209,6 +209,20 @@ ndBrainFloat* ndBrainAgentContinuePolicyGradient_Trainer::ndTrajectoryStep::GetO
 	return &me[stride * entry + 2];
 }
 
+const ndBrainFloat* ndBrainAgentContinuePolicyGradient_Trainer::ndTrajectoryStep::GetActions(ndInt32 entry) const
+{
+	const ndTrajectoryStep& me = *this;
+	ndInt64 stride = 2 + m_actionsSize * 2 + m_obsevationsSize;
+	return &me[stride * entry + 2 + m_obsevationsSize];
+}
+
+const ndBrainFloat* ndBrainAgentContinuePolicyGradient_Trainer::ndTrajectoryStep::GetObservations(ndInt32 entry) const
+{
+	const ndTrajectoryStep& me = *this;
+	ndInt64 stride = 2 + m_actionsSize * 2 + m_obsevationsSize;
+	return &me[stride * entry + 2];
+}
+
 //*********************************************************************************************
 //
 //*********************************************************************************************
@@ -804,6 +818,20 @@ void ndBrainAgentContinuePolicyGradient_TrainerMaster::UpdateBaseLineValue()
 }
 
 //#pragma optimize( "", off )
+bool ndBrainAgentContinuePolicyGradient_TrainerMaster::OptimizeTrajectories()
+{
+	if ((m_bashTrajectoryIndex >= (m_bashTrajectoryCount * 10)) || (m_trajectoryAccumulator.GetCount() >= m_bashTrajectorySteps))
+	{
+		Optimize();
+		m_eposideCount++;
+		m_framesAlive = 0;
+		m_bashTrajectoryIndex = 0;
+		m_trajectoryAccumulator.SetCount(0);
+		return true;
+	}
+	return false;
+}
+
 void ndBrainAgentContinuePolicyGradient_TrainerMaster::OptimizeStep()
 {
 	for (ndList<ndBrainAgentContinuePolicyGradient_Trainer*>::ndNode* node = m_agents.GetFirst(); node; node = node->GetNext())
@@ -821,13 +849,8 @@ void ndBrainAgentContinuePolicyGradient_TrainerMaster::OptimizeStep()
 		m_framesAlive++;
 	}
 
-	if ((m_bashTrajectoryIndex >= (m_bashTrajectoryCount * 10)) || (m_trajectoryAccumulator.GetCount() >= m_bashTrajectorySteps))
+	if (OptimizeTrajectories())
 	{
-		Optimize();
-		m_eposideCount++;
-		m_framesAlive = 0;
-		m_bashTrajectoryIndex = 0;
-		m_trajectoryAccumulator.SetCount(0);
 		for (ndList<ndBrainAgentContinuePolicyGradient_Trainer*>::ndNode* node = m_agents.GetFirst(); node; node = node->GetNext())
 		{
 			ndBrainAgentContinuePolicyGradient_Trainer* const agent = node->GetInfo();
@@ -36,6 +36,7 @@
 
 class ndBrainOptimizerAdam;
 class ndBrainAgentContinuePolicyGradient_TrainerMaster;
+class ndBrainAgentContinuePolicyGradient_Rollout;
 
 class ndBrainAgentContinuePolicyGradient_Trainer : public ndBrainAgent
 {
@@ -56,6 +57,8 @@ class ndBrainAgentContinuePolicyGradient_Trainer : public ndBrainAgent
 		void Clear(ndInt32 entry);
 		ndBrainFloat* GetActions(ndInt32 entry);
 		ndBrainFloat* GetObservations(ndInt32 entry);
+		const ndBrainFloat* GetActions(ndInt32 entry) const;
+		const ndBrainFloat* GetObservations(ndInt32 entry) const;
 
 		ndInt64 m_actionsSize;
 		ndInt64 m_obsevationsSize;
@@ -92,6 +95,7 @@ class ndBrainAgentContinuePolicyGradient_Trainer : public ndBrainAgent
 	ndSharedPtr<ndBrainAgentContinuePolicyGradient_TrainerMaster> m_master;
 	ndRandomGenerator* m_randomGenerator;
 
+	friend class ndBrainAgentContinuePolicyGradient_Rollout;
 	friend class ndBrainAgentContinuePolicyGradient_TrainerMaster;
 };
 
@@ -156,6 +160,7 @@ class ndBrainAgentContinuePolicyGradient_TrainerMaster : public ndBrainThreadPoo
 	void OptimizePolicy();
 	void OptimizeCritic();
 	void UpdateBaseLineValue();
+	bool OptimizeTrajectories();
 	ndBrainAgentContinuePolicyGradient_Trainer::ndRandomGenerator* GetRandomGenerator();
 
 	ndBrain m_policy;
@@ -196,6 +201,7 @@ class ndBrainAgentContinuePolicyGradient_TrainerMaster : public ndBrainThreadPoo
 	ndString m_name;
 	ndList<ndBrainAgentContinuePolicyGradient_Trainer*> m_agents;
 	friend class ndBrainAgentContinuePolicyGradient_Trainer;
+	friend class ndBrainAgentContinuePolicyGradient_Rollout;
 };
 
 #endif 
\ No newline at end of file
@@ -43,8 +43,11 @@ class ndBrainFloat4
 	ndBrainFloat4 operator+ (const ndBrainFloat4& A) const;
 	ndBrainFloat4 operator- (const ndBrainFloat4& A) const;
 	ndBrainFloat4 operator* (const ndBrainFloat4& A) const;
+	ndBrainFloat4 operator/ (const ndBrainFloat4& A) const;
 
+	ndBrainFloat4 Sqrt() const;
 	ndBrainFloat HorizontalAdd() const;
+	void Store(ndBrainFloat* const ptr) const;
 	ndBrainFloat4 MulAdd(const ndBrainFloat4& A, const ndBrainFloat4& B) const;
 	ndBrainFloat4 MulSub(const ndBrainFloat4& A, const ndBrainFloat4& B) const;
 
@@ -145,6 +148,21 @@ inline ndBrainFloat4 ndBrainFloat4::operator* (const ndBrainFloat4& A) const
 	return _mm_mul_ps(m_type, A.m_type);
 }
 
+inline ndBrainFloat4 ndBrainFloat4::operator/ (const ndBrainFloat4& A) const
+{
+	return _mm_div_ps(m_type, A.m_type);
+}
+
+inline ndBrainFloat4 ndBrainFloat4::Sqrt() const
+{
+	return _mm_sqrt_ps(m_type);
+}
+
+inline void ndBrainFloat4::Store(ndBrainFloat* const ptr) const
+{
+	_mm_storeu_ps(ptr, m_type);
+}
+
 inline ndBrainFloat ndBrainFloat4::HorizontalAdd() const
 {
 	__m128 tmp(_mm_hadd_ps(m_type, m_type));
@@ -241,6 +259,24 @@ inline ndBrainFloat4 ndBrainFloat4::operator* (const ndBrainFloat4& A) const
 	return ndBrainFloat4(m_x * A.m_x, m_y * A.m_y, m_z * A.m_z, m_w * A.m_w);
 }
 
+inline ndBrainFloat4 ndBrainFloat4::operator/ (const ndBrainFloat4& A) const
+{
+	return ndBrainFloat4(m_x / A.m_x, m_y / A.m_y, m_z / A.m_z, m_w / A.m_w);
+}
+
+inline ndBrainFloat4 ndBrainFloat4::Sqrt() const
+{
+	return ndBrainFloat4(ndBrainFloat(ndSqrt(m_x)), ndBrainFloat(ndSqrt(m_y)), ndBrainFloat(ndSqrt(m_z)), ndBrainFloat(ndSqrt(m_w)));
+}
+
+inline void ndBrainFloat4::Store(ndBrainFloat* const ptr) const
+{
+	ptr[0] = m_x;
+	ptr[1] = m_y;
+	ptr[2] = m_z;
+	ptr[3] = m_w;
+}
+
 inline ndBrainFloat ndBrainFloat4::HorizontalAdd() const
 {
 	return m_x + m_y + m_z + m_w;
@@ -0,0 +1,178 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "ndBrainStdafx.h"
+#include "ndBrain.h"
+#include "ndBrainLayer.h"
+#include "ndBrainMatrix.h"
+#include "ndBrainLayerLinear.h"
+#include "ndBrainLayerActivationElu.h"
+#include "ndBrainLayerActivationRelu.h"
+#include "ndBrainLayerActivationTanh.h"
+#include "ndBrainLayerActivationSigmoid.h"
+#include "ndBrainLayerActivationSigmoidLinear.h"
+#include "ndBrainFusedInference.h"
+
+// rows of a fused linear layer evaluated at the time, 
+// the tile of results should stay in the level one cache.
+#define ND_BRAIN_FUSED_TILE_SIZE	64
+
+ndBrainFusedInference::ndBrainFusedInference(const ndBrain& brain)
+	:ndClassAlloc()
+	,m_steps()
+	,m_maxSize(0)
+	,m_fusedCount(0)
+{
+	const ndArray<ndBrainLayer*>& layers = brain;
+	ndAssert(layers.GetCount());
+	m_maxSize = layers[0]->GetInputSize();
+	for (ndInt32 i = 0; i < layers.GetCount(); ++i)
+	{
+		ndBrainLayer* const layer = layers[i];
+		m_maxSize = ndMax(m_maxSize, layer->GetOutputBufferSize());
+
+		ndStep step;
+		step.m_linear = nullptr;
+		step.m_layer = layer;
+		step.m_inputSize = layer->GetInputSize();
+		step.m_outputSize = layer->GetOutputSize();
+
+		// the linear layer with drop out has the same label, but drop out is not used for inference
+		const bool isLinear = !strcmp(layer->GetLabelId(), ND_BRAIN_LAYER_LINEAR_NAME);
+		if (isLinear && ((i + 1) < layers.GetCount()) && IsElementWise(layers[i + 1]))
+		{
+			ndBrainLayer* const activation = layers[i + 1];
+			ndAssert(activation->GetInputSize() == layer->GetOutputSize());
+			m_maxSize = ndMax(m_maxSize, activation->GetOutputBufferSize());
+
+			step.m_linear = (ndBrainLayerLinear*)layer;
+			step.m_layer = activation;
+			step.m_outputSize = activation->GetOutputSize();
+			m_fusedCount++;
+			i++;
+		}
+		m_steps.PushBack(step);
+	}
+}
+
+ndBrainFusedInference::~ndBrainFusedInference()
+{
+}
+
+ndInt32 ndBrainFusedInference::GetInputSize() const
+{
+	return m_steps[0].m_inputSize;
+}
+
+ndInt32 ndBrainFusedInference::GetOutputSize() const
+{
+	return m_steps[m_steps.GetCount() - 1].m_outputSize;
+}
+
+ndInt32 ndBrainFusedInference::GetStepsCount() const
+{
+	return ndInt32(m_steps.GetCount());
+}
+
+ndInt32 ndBrainFusedInference::GetFusedStepsCount() const
+{
+	return m_fusedCount;
+}
+
+ndInt32 ndBrainFusedInference::CalculateWorkingBufferSize() const
+{
+	return m_maxSize * 2 + ND_BRAIN_FUSED_TILE_SIZE + 256;
+}
+
+bool ndBrainFusedInference::IsElementWise(const ndBrainLayer* const layer) const
+{
+	const char* const label = layer->GetLabelId();
+	return !strcmp(label, ND_BRAIN_LAYER_ACTIVATION_RELU_NAME) ||
+		!strcmp(label, ND_BRAIN_LAYER_ACTIVATION_TANH_NAME) ||
+		!strcmp(label, ND_BRAIN_LAYER_ACTIVATION_ELU_NAME) ||
+		!strcmp(label, ND_BRAIN_LAYER_ACTIVATION_SIGMOID_NAME) ||
+		!strcmp(label, ND_BRAIN_LAYER_ACTIVATION_SIGMOID_LINEAR_NAME);
+}
+
+void ndBrainFusedInference::FusedLinear(const ndStep& step, const ndBrainVector& input, ndBrainVector& output, ndBrainFloat* const tile) const
+{
+	const ndBrainMatrix& weights = *step.m_linear->GetWeights();
+	const ndBrainVector& bias = *step.m_linear->GetBias();
+	const ndInt32 columns = step.m_inputSize;
+	ndAssert(columns == weights.GetColumns());
+
+	// same arithmetic as ndBrainLayerLinear::MakePrediction, so results are bit identical
+	for (ndInt32 start = 0; start < step.m_outputSize; start += ND_BRAIN_FUSED_TILE_SIZE)
+	{
+		const ndInt32 count = ndMin(ND_BRAIN_FUSED_TILE_SIZE, step.m_outputSize - start);
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			const ndBrainVector& row = weights[start + i];
+			tile[i] = ndDotProduct(columns, &row[0], &input[0]);
+			tile[i] += bias[start + i];
+		}
+		const ndBrainMemVector tileIn(tile, count);
+		ndBrainMemVector tileOut(&output[start], count);
+		step.m_layer->MakePrediction(tileIn, tileOut);
+	}
+}
+
+void ndBrainFusedInference::MakePrediction(const ndBrainVector& input, ndBrainVector& output, ndBrainVector& workingBuffer) const
+{
+	const ndInt32 maxMemory = CalculateWorkingBufferSize();
+	if (maxMemory > workingBuffer.GetCapacity())
+	{
+		workingBuffer.SetCount(maxMemory);
+	}
+	workingBuffer.SetCount(maxMemory);
+
+	ndBrainMemVector in(&workingBuffer[0], input.GetCount());
+	ndBrainMemVector out(&workingBuffer[m_maxSize + 128], input.GetCount());
+	ndBrainFloat* const tile = &workingBuffer[m_maxSize * 2 + 256];
+
+	in.Set(input);
+	for (ndInt32 i = 0; i < m_steps.GetCount(); ++i)
+	{
+		const ndStep& step = m_steps[i];
+		out.SetSize(step.m_outputSize);
+		if (step.m_linear)
+		{
+			FusedLinear(step, in, out, tile);
+		}
+		else
+		{
+			step.m_layer->MakePrediction(in, out);
+		}
+		in.Swap(out);
+	}
+
+	ndAssert(in.GetCount() == output.GetCount());
+	output.Set(in);
+}
+
+void ndBrainFusedInference::MakePrediction(const ndBrainVector& input, ndBrainVector& output) const
+{
+	const ndInt32 maxMemory = CalculateWorkingBufferSize();
+	ndBrainFloat* const buffer = ndAlloca(ndBrainFloat, maxMemory + 256);
+	ndBrainMemVector workingBuffer(buffer, maxMemory + 256);
+	MakePrediction(input, output, workingBuffer);
+}
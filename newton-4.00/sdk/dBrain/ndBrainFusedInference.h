@@ -0,0 +1,74 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef _ND_BRAIN_FUSED_INFERENCE_H__
+#define _ND_BRAIN_FUSED_INFERENCE_H__
+
+#include "ndBrainStdafx.h"
+#include "ndBrainVector.h"
+
+class ndBrain;
+class ndBrainLayer;
+class ndBrainLayerLinear;
+
+// inference plan compiled from a trained brain.
+// a linear layer followed by an element wise activation runs as one step,
+// that evaluates a small tile of rows (dot product plus bias) and applies
+// the activation to the tile while it is still in the level one cache, so
+// the pre activation values are never written to the working buffer.
+// all other layers run as they are. layer outputs ping pong between two buffers.
+// the plan references the layers of the brain, weights can be trained
+// after the plan is compiled, but the layer list can not change.
+class ndBrainFusedInference : public ndClassAlloc
+{
+	class ndStep
+	{
+		public:
+		ndBrainLayerLinear* m_linear;
+		const ndBrainLayer* m_layer;
+		ndInt32 m_inputSize;
+		ndInt32 m_outputSize;
+	};
+
+	public:
+	ndBrainFusedInference(const ndBrain& brain);
+	~ndBrainFusedInference();
+
+	ndInt32 GetInputSize() const;
+	ndInt32 GetOutputSize() const;
+	ndInt32 GetStepsCount() const;
+	ndInt32 GetFusedStepsCount() const;
+	ndInt32 CalculateWorkingBufferSize() const;
+
+	void MakePrediction(const ndBrainVector& input, ndBrainVector& output) const;
+	void MakePrediction(const ndBrainVector& input, ndBrainVector& output, ndBrainVector& workingBuffer) const;
+
+	private:
+	bool IsElementWise(const ndBrainLayer* const layer) const;
+	void FusedLinear(const ndStep& step, const ndBrainVector& input, ndBrainVector& output, ndBrainFloat* const tile) const;
+
+	ndArray<ndStep> m_steps;
+	ndInt32 m_maxSize;
+	ndInt32 m_fusedCount;
+};
+
+#endif 
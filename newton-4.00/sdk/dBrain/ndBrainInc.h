@@ -38,6 +38,8 @@
 #include <ndBrainThreadPool.h>
 #include <ndBrainLayerLinear.h>
 #include <ndBrainReplayBuffer.h>
+#include <ndBrainReplayStore.h>
+#include <ndBrainFusedInference.h>
 #include <ndBrainOptimizerSgd.h>
 #include <ndBrainOptimizerAdam.h>
 #include <ndBrainLayerActivation.h>
@@ -62,6 +64,7 @@
 #include <ndBrainLayerActivationCategoricalSoftmax.h>
 #include <ndBrainAgentDiscretePolicyGradient_Trainer.h>
 #include <ndBrainAgentContinuePolicyGradient_Trainer.h>
+#include <ndBrainAgentContinuePolicyGradient_Rollout.h>
 
 #include <gpu/ndBrainGpuBuffer.h>
 #include <gpu/ndBrainGpuCommand.h>
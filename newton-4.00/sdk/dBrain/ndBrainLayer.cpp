@@ -67,6 +67,10 @@ ndInt32 ndBrainLayer::GetNumberOfParameters() const
 	return 0;
 }
 
+void ndBrainLayer::GetParameterBuffers(ndArray<ndBrainFloat*>&, ndArray<ndInt32>&)
+{
+}
+
 void ndBrainLayer::GetNumberOfGPUParameters(ndBrainVector&, ndArray<ndInt32>&) const
 {
 	ndAssert(0);
@@ -25,6 +25,8 @@
 #include "ndBrainStdafx.h"
 #include "ndBrainLayerActivation.h"
 
+#define ND_BRAIN_LAYER_ACTIVATION_RELU_NAME "ndBrainLayerActivationRelu"
+
 class ndBrainLayerActivationRelu : public ndBrainLayerActivation
 {
 	public:
@@ -39,7 +39,7 @@ ndBrainLayer* ndBrainLayerActivationSigmoid::Clone() const
 
 const char* ndBrainLayerActivationSigmoid::GetLabelId() const
 {
-	return "ndBrainLayerActivationSigmoid";
+	return ND_BRAIN_LAYER_ACTIVATION_SIGMOID_NAME;
 }
 
 ndBrainLayer* ndBrainLayerActivationSigmoid::Load(const ndBrainLoad* const loadSave)
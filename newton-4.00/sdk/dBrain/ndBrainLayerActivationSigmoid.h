@@ -26,6 +26,8 @@
 #include "ndBrainSaveLoad.h"
 #include "ndBrainLayerActivation.h"
 
+#define ND_BRAIN_LAYER_ACTIVATION_SIGMOID_NAME "ndBrainLayerActivationSigmoid"
+
 class ndBrainLayerActivationSigmoid : public ndBrainLayerActivation
 {
 	public:
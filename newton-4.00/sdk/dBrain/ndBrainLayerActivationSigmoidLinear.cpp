@@ -39,7 +39,7 @@ ndBrainLayer* ndBrainLayerActivationSigmoidLinear::Clone() const
 
 const char* ndBrainLayerActivationSigmoidLinear::GetLabelId() const
 {
-	return "ndBrainLayerActivationSigmoidLinear";
+	return ND_BRAIN_LAYER_ACTIVATION_SIGMOID_LINEAR_NAME;
 }
 
 ndBrainLayer* ndBrainLayerActivationSigmoidLinear::Load(const ndBrainLoad* const loadSave)
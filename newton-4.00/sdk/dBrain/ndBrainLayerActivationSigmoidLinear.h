@@ -27,6 +27,8 @@
 #include "ndBrainLayerActivation.h"
 
 
+#define ND_BRAIN_LAYER_ACTIVATION_SIGMOID_LINEAR_NAME "ndBrainLayerActivationSigmoidLinear"
+
 class ndBrainLayerActivationSigmoidLinear : public ndBrainLayerActivation
 {
 	public:
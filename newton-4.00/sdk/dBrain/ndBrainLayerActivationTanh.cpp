@@ -41,7 +41,7 @@ ndBrainLayer* ndBrainLayerActivationTanh::Clone() const
 
 const char* ndBrainLayerActivationTanh::GetLabelId() const
 {
-	return "ndBrainLayerActivationTanh";
+	return ND_BRAIN_LAYER_ACTIVATION_TANH_NAME;
 }
 
 ndBrainLayer* ndBrainLayerActivationTanh::Load(const ndBrainLoad* const loadSave)
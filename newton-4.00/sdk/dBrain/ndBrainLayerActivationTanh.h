@@ -27,6 +27,8 @@
 
 typedef ndVector ndBrainVector4;
 
+#define ND_BRAIN_LAYER_ACTIVATION_TANH_NAME "ndBrainLayerActivationTanh"
+
 class ndBrainLayerActivationTanh : public ndBrainLayerActivation
 {
 	public:
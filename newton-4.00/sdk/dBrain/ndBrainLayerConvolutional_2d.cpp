@@ -223,6 +223,14 @@ void ndBrainLayerConvolutional_2d::Blend(const ndBrainLayer& src, ndBrainFloat b
 	m_kernels.Blend(linearSrc.m_kernels, blend);
 }
 
+void ndBrainLayerConvolutional_2d::GetParameterBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes)
+{
+	buffers.PushBack(&m_bias[0]);
+	sizes.PushBack(ndInt32(m_bias.GetCount()));
+	buffers.PushBack(&m_kernels[0]);
+	sizes.PushBack(ndInt32(m_kernels.GetCount()));
+}
+
 void ndBrainLayerConvolutional_2d::AdamUpdate(const ndBrainLayer& u, const ndBrainLayer& v, ndBrainFloat epsilon)
 {
 	const ndBrainLayerConvolutional_2d& linear_U = (ndBrainLayerConvolutional_2d&)u;
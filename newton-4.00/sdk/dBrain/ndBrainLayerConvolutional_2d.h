@@ -50,6 +50,7 @@ class ndBrainLayerConvolutional_2d : public ndBrainLayer
 	virtual void UpdateDropOut();
 	virtual void InitWeights();
 	virtual void AdamUpdate(const ndBrainLayer& u, const ndBrainLayer& v, ndBrainFloat epsilon);
+	virtual void GetParameterBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes);
 
 	virtual void MakePrediction(const ndBrainVector& input, ndBrainVector& output) const;
 	virtual void InputDerivative(const ndBrainVector& input, const ndBrainVector& output, const ndBrainVector& outputDerivative, ndBrainVector& inputDerivative) const;
@@ -195,6 +195,14 @@ void ndBrainLayerCrossCorrelation_2d::Blend(const ndBrainLayer& src, ndBrainFloa
 	m_kernels.Blend(linearSrc.m_kernels, blend);
 }
 
+void ndBrainLayerCrossCorrelation_2d::GetParameterBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes)
+{
+	buffers.PushBack(&m_bias[0]);
+	sizes.PushBack(ndInt32(m_bias.GetCount()));
+	buffers.PushBack(&m_kernels[0]);
+	sizes.PushBack(ndInt32(m_kernels.GetCount()));
+}
+
 void ndBrainLayerCrossCorrelation_2d::AdamUpdate(const ndBrainLayer& u, const ndBrainLayer& v, ndBrainFloat epsilon)
 {
 	const ndBrainLayerCrossCorrelation_2d& linear_U = (ndBrainLayerCrossCorrelation_2d&)u;
@@ -58,7 +58,7 @@ ndBrainLayerLinear::~ndBrainLayerLinear()
 
 const char* ndBrainLayerLinear::GetLabelId() const
 {
-	return "ndBrainLayerLinear";
+	return ND_BRAIN_LAYER_LINEAR_NAME;
 }
 
 ndBrainLayer* ndBrainLayerLinear::Clone() const
@@ -185,6 +185,18 @@ void ndBrainLayerLinear::AdamUpdate(const ndBrainLayer& u, const ndBrainLayer& v
 	}
 }
 
+void ndBrainLayerLinear::GetParameterBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes)
+{
+	// rows are padded to the matrix alignment, so each row is its own span
+	buffers.PushBack(&m_bias[0]);
+	sizes.PushBack(ndInt32(m_bias.GetCount()));
+	for (ndInt32 i = 0; i < m_weights.GetRows(); ++i)
+	{
+		buffers.PushBack(&m_weights[i][0]);
+		sizes.PushBack(ndInt32(m_weights[i].GetCount()));
+	}
+}
+
 void ndBrainLayerLinear::Save(const ndBrainSave* const loadSave) const
 {
 	char buffer[1024];
@@ -27,6 +27,8 @@
 #include "ndBrainVector.h"
 #include "ndBrainMatrix.h"
 
+#define ND_BRAIN_LAYER_LINEAR_NAME "ndBrainLayerLinear"
+
 class ndBrainLayerLinear : public ndBrainLayer
 {
 	public: 
@@ -66,6 +68,7 @@ class ndBrainLayerLinear : public ndBrainLayer
 
 	protected:
 	void AdamUpdate(const ndBrainLayer& u, const ndBrainLayer& v, ndBrainFloat epsilon);
+	void GetParameterBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes);
 
 	virtual void GetNumberOfGPUParameters(ndBrainVector& parameters, ndArray<ndInt32>& offsets) const;
 	virtual ndBrainGpuCommand* AssemblyGPUCommand(ndBrainGpuContext* const context, ndInt32 layerIndex, ndInt32 batchCount, ndFixSizeArray<ndBufferOffsetPair*, 8>& params);
@@ -53,7 +53,7 @@ ndBrainLayerLinearWithDropOut::~ndBrainLayerLinearWithDropOut()
 const char* ndBrainLayerLinearWithDropOut::GetLabelId() const
 {
 	//return "ndBrainLayerLinearWithDropOut";
-	return "ndBrainLayerLinear";
+	return ND_BRAIN_LAYER_LINEAR_NAME;
 }
 
 ndBrainLayer* ndBrainLayerLinearWithDropOut::Clone() const
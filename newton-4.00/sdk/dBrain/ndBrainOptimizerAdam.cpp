@@ -21,49 +21,24 @@
 
 #include "ndBrainStdafx.h"
 #include "ndBrain.h"
-#include "ndBrainMatrix.h"
+#include "ndBrainFloat4.h"
 #include "ndBrainTrainer.h"
 #include "ndBrainThreadPool.h"
 #include "ndBrainOptimizerAdam.h"
 
-class ndBrainOptimizerAdam::ndBrainOptimizerAdam::ndAdamData : public ndClassAlloc
-{
-	public:
-	ndAdamData(ndBrainLayer* const layer)
-		:ndClassAlloc()
-		,m_u(nullptr)
-		,m_v(nullptr)
-		,m_v2(nullptr)
-	{
-		if (layer->HasParameters())
-		{
-			m_u = layer->Clone();
-			m_v = layer->Clone();
-			m_v2 = layer->Clone();
-
-			m_u->Clear();
-			m_v->Clear();
-			m_v2->Clear();
-		}
-	}
-
-	~ndAdamData()
-	{
-		if (m_u)
-		{
-			delete m_u;
-			delete m_v;
-			delete m_v2;
-		}
-	}
-
-	ndBrainLayer* m_u;
-	ndBrainLayer* m_v;
-	ndBrainLayer* m_v2;
-};
+// number of parameters updated by a thread at the time, the chunk plus the 
+// moments and the gradients of a few trainers should fit in the level two cache.
+#define ND_ADAM_CHUNK_SIZE	(1024 * 4)
 
 ndBrainOptimizerAdam::ndBrainOptimizerAdam()
 	:ndBrainOptimizer()
+	,m_u()
+	,m_v()
+	,m_segments()
+	,m_chunks()
+	,m_weights()
+	,m_gradients()
+	,m_sizes()
 	,m_beta(0.999f)
 	,m_alpha(0.9f)
 	//,m_epsilon(1.0e-8f)
@@ -76,84 +51,166 @@ ndBrainOptimizerAdam::ndBrainOptimizerAdam()
 
 ndBrainOptimizerAdam::~ndBrainOptimizerAdam()
 {
-	for (ndInt32 i = 0; i < m_data.GetCount(); ++i)
-	{
-		delete (m_data[i]);
-	}
 }
 
-void ndBrainOptimizerAdam::Update(ndBrainThreadPool* const, ndArray<ndBrainTrainer*>& partialGradients, ndBrainFloat learnRate)
+void ndBrainOptimizerAdam::Initialize(const ndBrainTrainer* const trainer)
 {
-	ndBrainTrainer* const trainer = partialGradients[0];
-	ndBrain& brain = *trainer->GetBrain();
+	m_weights.SetCount(0);
+	m_sizes.SetCount(0);
+	trainer->GetWeightBuffers(m_weights, m_sizes);
 
-	if (!m_initalized)
+	// split the spans in segments no larger than a chunk
+	ndInt32 offset = 0;
+	for (ndInt32 i = 0; i < m_sizes.GetCount(); ++i)
 	{
-		m_initalized = true;
-		for (ndInt32 i = 0; i < brain.GetCount(); ++i)
+		for (ndInt32 start = 0; start < m_sizes[i]; start += ND_ADAM_CHUNK_SIZE)
 		{
-			m_data.PushBack(new ndAdamData(brain[i]));
+			ndSegment segment;
+			segment.m_buffer = i;
+			segment.m_start = start;
+			segment.m_count = ndMin(m_sizes[i] - start, ND_ADAM_CHUNK_SIZE);
+			segment.m_offset = offset;
+			offset += segment.m_count;
+			m_segments.PushBack(segment);
 		}
 	}
 
-	for (ndInt32 i = 1; i < partialGradients.GetCount(); ++i)
+	// pack consecutive segments in chunks, so that small spans like bias and
+	// matrix rows do not pay the scheduling cost one by one.
+	ndChunk chunk;
+	chunk.m_start = 0;
+	chunk.m_count = 0;
+	ndInt32 chunkSize = 0;
+	for (ndInt32 i = 0; i < m_segments.GetCount(); ++i)
 	{
-		const ndBrainTrainer* const src = partialGradients[i];
-		trainer->AddGradients(src);
+		if (chunk.m_count && ((chunkSize + m_segments[i].m_count) > ND_ADAM_CHUNK_SIZE))
+		{
+			m_chunks.PushBack(chunk);
+			chunk.m_start = i;
+			chunk.m_count = 0;
+			chunkSize = 0;
+		}
+		chunk.m_count++;
+		chunkSize += m_segments[i].m_count;
 	}
+	if (chunk.m_count)
+	{
+		m_chunks.PushBack(chunk);
+	}
+
+	m_u.SetCount(offset);
+	m_v.SetCount(offset);
+	m_u.Set(ndBrainFloat(0.0f));
+	m_v.Set(ndBrainFloat(0.0f));
+}
 
-	ndBrainFloat betaWeight = ndBrainFloat(1.0f) / (ndBrainFloat(1.0f) - m_betaAcc);
-	ndBrainFloat alphaWeight = ndBrainFloat(1.0f) / (ndBrainFloat(1.0f) - m_alphaAcc);
+void ndBrainOptimizerAdam::Update(ndBrainThreadPool* const threadPool, ndArray<ndBrainTrainer*>& partialGradients, ndBrainFloat learnRate)
+{
+	D_TRACKTIME();
+	ndBrainTrainer* const trainer = partialGradients[0];
+	if (!m_initalized)
+	{
+		m_initalized = true;
+		Initialize(trainer);
+	}
 
-	ndBrainFloat regularizer = -GetRegularizer();
-	//ndBrainFloat regularizer = GetRegularizer();
-	ndBrainFloat descendRate = learnRate * ndBrainFloat(-1.0f);
-	ndBrainFloat den = ndBrainFloat(1.0f) / ndBrainFloat(partialGradients.GetCount());
+	// gather the flat view of the weights and all the partial gradients
+	m_weights.SetCount(0);
+	m_sizes.SetCount(0);
+	trainer->GetWeightBuffers(m_weights, m_sizes);
+	const ndInt32 buffersCount = ndInt32(m_weights.GetCount());
+	const ndInt32 trainersCount = ndInt32(partialGradients.GetCount());
 
-	for (ndInt32 i = 0; i < brain.GetCount(); ++i)
+	m_gradients.SetCount(0);
+	for (ndInt32 i = 0; i < trainersCount; ++i)
 	{
-		if (brain[i]->HasParameters())
-		{
-			ndAssert(m_data[i]);
-			ndAdamData& data = *m_data[i];
-			ndBrainLayer& gradients = *trainer->GetGradientLayer(i);
+		m_sizes.SetCount(0);
+		partialGradients[i]->GetGradientBuffers(m_gradients, m_sizes);
+		ndAssert(m_sizes.GetCount() == buffersCount);
+	}
 
-			gradients.Scale(den);
-			data.m_v->Scale(m_beta);
-			data.m_u->Scale(m_alpha);
-			data.m_v2->Set(gradients);
-			data.m_v2->Mul(gradients);
+	const bool biasCorrection = m_betaAcc > ndBrainFloat(0.0f);
+	const ndBrainFloat betaWeight = biasCorrection ? ndBrainFloat(1.0f) / (ndBrainFloat(1.0f) - m_betaAcc) : ndBrainFloat(1.0f);
+	const ndBrainFloat alphaWeight = biasCorrection ? ndBrainFloat(1.0f) / (ndBrainFloat(1.0f) - m_alphaAcc) : ndBrainFloat(1.0f);
 
-			data.m_u->ScaleAdd(gradients, ndBrainFloat(1.0f) - m_alpha);
-			data.m_v->ScaleAdd(*data.m_v2, ndBrainFloat(1.0f) - m_beta);
+	const ndBrainFloat regularizer = -GetRegularizer();
+	const ndBrainFloat descendRate = learnRate * ndBrainFloat(-1.0f);
+	const ndBrainFloat den = ndBrainFloat(1.0f) / ndBrainFloat(trainersCount);
 
-			if (m_betaAcc > ndBrainFloat(0.0f))
-			{
-				ndBrainLayer& vHat = gradients;
-				ndBrainLayer& uHat = *data.m_v2;
-
-				uHat.Set(*data.m_u);
-				vHat.Set(*data.m_v);
-				vHat.Scale(betaWeight);
-				uHat.Scale(alphaWeight);
-				gradients.AdamUpdate(uHat, vHat, m_epsilon);
-			}
-			else
+	ndAtomic<ndInt32> iterator(0);
+	auto UpdateChunks = ndMakeObject::ndFunction([this, &iterator, buffersCount, trainersCount, betaWeight, alphaWeight, regularizer, descendRate, den](ndInt32, ndInt32)
+	{
+		const ndBrainFloat4 den4(den);
+		const ndBrainFloat4 beta4(m_beta);
+		const ndBrainFloat4 alpha4(m_alpha);
+		const ndBrainFloat4 beta4_1(ndBrainFloat(1.0f) - m_beta);
+		const ndBrainFloat4 alpha4_1(ndBrainFloat(1.0f) - m_alpha);
+		const ndBrainFloat4 betaWeight4(betaWeight);
+		const ndBrainFloat4 alphaWeight4(alphaWeight);
+		const ndBrainFloat4 epsilon4(m_epsilon);
+		const ndBrainFloat4 regularizer4(regularizer);
+		const ndBrainFloat4 descendRate4(descendRate);
+		const ndBrainFloat4 max4(ndBrainFloat(1.0e-16f));
+		const ndBrainFloat4 min4(ndBrainFloat(-1.0e-16f));
+
+		const ndInt32 chunksCount = ndInt32(m_chunks.GetCount());
+		for (ndInt32 i = iterator++; i < chunksCount; i = iterator++)
+		{
+			const ndChunk& chunk = m_chunks[i];
+			for (ndInt32 j = 0; j < chunk.m_count; ++j)
 			{
-				gradients.AdamUpdate(*data.m_u, *data.m_v, m_epsilon);
+				const ndSegment& segment = m_segments[chunk.m_start + j];
+				ndBrainFloat* const weights = m_weights[segment.m_buffer] + segment.m_start;
+				ndBrainFloat* const u = &m_u[segment.m_offset];
+				ndBrainFloat* const v = &m_v[segment.m_offset];
+				const ndInt32 count = segment.m_count;
+				const ndInt32 roundCount = count & -4;
+
+				for (ndInt32 k = 0; k < roundCount; k += 4)
+				{
+					ndBrainFloat4 g(m_gradients[segment.m_buffer] + segment.m_start + k);
+					for (ndInt32 n = 1; n < trainersCount; ++n)
+					{
+						g = g + ndBrainFloat4(m_gradients[n * buffersCount + segment.m_buffer] + segment.m_start + k);
+					}
+					g = g * den4;
+
+					const ndBrainFloat4 u4((alpha4 * ndBrainFloat4(&u[k])).MulAdd(alpha4_1, g));
+					const ndBrainFloat4 v4((beta4 * ndBrainFloat4(&v[k])).MulAdd(beta4_1, g * g));
+					u4.Store(&u[k]);
+					v4.Store(&v[k]);
+
+					const ndBrainFloat4 w(&weights[k]);
+					const ndBrainFloat4 step((u4 * alphaWeight4) / ((v4 * betaWeight4).Sqrt() + epsilon4));
+					const ndBrainFloat4 w1(w.MulAdd(step.MulAdd(regularizer4, w), descendRate4));
+					(w1 & ((w1 < min4) | (w1 > max4))).Store(&weights[k]);
+				}
+
+				for (ndInt32 k = roundCount; k < count; ++k)
+				{
+					ndBrainFloat g = m_gradients[segment.m_buffer][segment.m_start + k];
+					for (ndInt32 n = 1; n < trainersCount; ++n)
+					{
+						g += m_gradients[n * buffersCount + segment.m_buffer][segment.m_start + k];
+					}
+					g *= den;
+
+					u[k] = m_alpha * u[k] + (ndBrainFloat(1.0f) - m_alpha) * g;
+					v[k] = m_beta * v[k] + (ndBrainFloat(1.0f) - m_beta) * g * g;
+
+					const ndBrainFloat w = weights[k];
+					const ndBrainFloat step = (u[k] * alphaWeight) / (ndBrainFloat(ndSqrt(v[k] * betaWeight)) + m_epsilon);
+					weights[k] = ndFlushToZero(w + descendRate * (step + regularizer * w));
+				}
 			}
-
-			ndBrainLayer& weights = *trainer->GetWeightsLayer(i);
-			gradients.ScaleAdd(weights, regularizer);
-			weights.ScaleAdd(gradients, descendRate);
-			weights.FlushToZero();
 		}
-	}
-	
+	});
+	threadPool->ParallelExecute(UpdateChunks);
+
 	m_betaAcc = ndFlushToZero(m_betaAcc * m_beta);
 	m_alphaAcc = ndFlushToZero(m_alphaAcc * m_alpha);
 	if (m_betaAcc < ndBrainFloat(1.0e-6f))
 	{
 		m_betaAcc = ndBrainFloat(0.0f);
 	}
-}
\ No newline at end of file
+}
@@ -25,16 +25,46 @@
 #include "ndBrainStdafx.h"
 #include "ndBrainOptimizer.h"
 
+// Adam update fused in a single pass over the parameters of the whole brain.
+// the parameters are seen as a flat list of spans, the moments live in two flat
+// buffers, and each thread updates cache sized chunks of the list, reducing the
+// gradients of all trainers, updating the moments and the weights in one pass.
 class ndBrainOptimizerAdam : public ndBrainOptimizer
 {
 	public: 
-	class ndAdamData;
+	class ndSegment
+	{
+		public:
+		ndInt32 m_buffer;
+		ndInt32 m_start;
+		ndInt32 m_count;
+		ndInt32 m_offset;
+	};
+
+	class ndChunk
+	{
+		public:
+		ndInt32 m_start;
+		ndInt32 m_count;
+	};
+
 	ndBrainOptimizerAdam();
 	virtual ~ndBrainOptimizerAdam();
 
 	virtual void Update(ndBrainThreadPool* const threadPool, ndArray<ndBrainTrainer*>& partialGradients, ndBrainFloat learnRate);
 
-	ndArray<ndAdamData*> m_data;
+	private:
+	void Initialize(const ndBrainTrainer* const trainer);
+
+	ndBrainVector m_u;
+	ndBrainVector m_v;
+	ndArray<ndSegment> m_segments;
+	ndArray<ndChunk> m_chunks;
+	ndArray<ndBrainFloat*> m_weights;
+	ndArray<ndBrainFloat*> m_gradients;
+	ndArray<ndInt32> m_sizes;
+
+	public:
 	ndBrainFloat m_beta;
 	ndBrainFloat m_alpha;
 	ndBrainFloat m_epsilon;
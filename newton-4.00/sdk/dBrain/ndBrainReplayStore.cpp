@@ -0,0 +1,275 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndBrainStdafx.h"
+#include "ndBrainReplayStore.h"
+
+ndBrainReplayStore::ndBrainReplayStore()
+	:ndClassAlloc()
+	,m_action()
+	,m_observation()
+	,m_nextObservation()
+	,m_reward()
+	,m_terminal()
+	,m_priority()
+	,m_sumTree()
+	,m_insertIndex(0)
+	,m_sumTreeInsertIndex(0)
+	,m_maxPriority(ndBrainFloat(1.0f))
+	,m_priorityExponent(ndBrainFloat(0.6f))
+	,m_capacity(0)
+	,m_actionSize(0)
+	,m_observationSize(0)
+	,m_sumTreeLeafs(0)
+	,m_sumTreeDirty(false)
+{
+}
+
+ndBrainReplayStore::ndBrainReplayStore(ndInt32 capacity, ndInt32 observationSize, ndInt32 actionSize)
+	:ndClassAlloc()
+	,m_action()
+	,m_observation()
+	,m_nextObservation()
+	,m_reward()
+	,m_terminal()
+	,m_priority()
+	,m_sumTree()
+	,m_insertIndex(0)
+	,m_sumTreeInsertIndex(0)
+	,m_maxPriority(ndBrainFloat(1.0f))
+	,m_priorityExponent(ndBrainFloat(0.6f))
+	,m_capacity(0)
+	,m_actionSize(0)
+	,m_observationSize(0)
+	,m_sumTreeLeafs(0)
+	,m_sumTreeDirty(false)
+{
+	Init(capacity, observationSize, actionSize);
+}
+
+ndBrainReplayStore::~ndBrainReplayStore()
+{
+}
+
+void ndBrainReplayStore::Init(ndInt32 capacity, ndInt32 observationSize, ndInt32 actionSize)
+{
+	ndAssert(capacity > 0);
+	m_capacity = capacity;
+	m_actionSize = actionSize;
+	m_observationSize = observationSize;
+
+	m_sumTreeLeafs = 1;
+	while (m_sumTreeLeafs < capacity)
+	{
+		m_sumTreeLeafs *= 2;
+	}
+
+	// all the memory is allocated here, insertions never resize the buffers
+	m_action.SetCount(ndInt64(capacity) * actionSize);
+	m_observation.SetCount(ndInt64(capacity) * observationSize);
+	m_nextObservation.SetCount(ndInt64(capacity) * observationSize);
+	m_reward.SetCount(capacity);
+	m_terminal.SetCount(capacity);
+	m_priority.SetCount(capacity);
+	m_sumTree.SetCount(2 * ndInt64(m_sumTreeLeafs));
+	Clear();
+}
+
+void ndBrainReplayStore::Clear()
+{
+	m_action.Set(ndBrainFloat(0.0f));
+	m_observation.Set(ndBrainFloat(0.0f));
+	m_nextObservation.Set(ndBrainFloat(0.0f));
+	m_reward.Set(ndBrainFloat(0.0f));
+	m_terminal.Set(ndBrainFloat(1.0f));
+	m_priority.Set(ndBrainFloat(0.0f));
+	m_sumTree.Set(ndBrainFloat(0.0f));
+	m_maxPriority = ndBrainFloat(1.0f);
+	m_insertIndex.store(0);
+	m_sumTreeInsertIndex = 0;
+	m_sumTreeDirty = false;
+}
+
+ndInt32 ndBrainReplayStore::AddTransition(const ndBrainVector& observation, const ndBrainVector& action, ndBrainFloat reward, const ndBrainVector& nextObservation, bool terminal)
+{
+	ndAssert(m_capacity);
+	ndAssert(action.GetCount() == m_actionSize);
+	ndAssert(observation.GetCount() == m_observationSize);
+	ndAssert(nextObservation.GetCount() == m_observationSize);
+
+	// concurrent producers get different slots, unless more than 
+	// capacity insertions are in flight at the same time.
+	const ndInt32 index = ndInt32(m_insertIndex.fetch_add(1) % m_capacity);
+	ndMemCpy(&m_action[ndInt64(index) * m_actionSize], &action[0], m_actionSize);
+	ndMemCpy(&m_observation[ndInt64(index) * m_observationSize], &observation[0], m_observationSize);
+	ndMemCpy(&m_nextObservation[ndInt64(index) * m_observationSize], &nextObservation[0], m_observationSize);
+	m_reward[index] = reward;
+	m_terminal[index] = terminal ? ndBrainFloat(0.0f) : ndBrainFloat(1.0f);
+	m_priority[index] = m_maxPriority;
+	return index;
+}
+
+void ndBrainReplayStore::SetPriority(ndInt32 index, ndBrainFloat priority)
+{
+	ndAssert(index >= 0);
+	ndAssert(index < GetCount());
+	const ndBrainFloat value = ndMax(ndBrainFloat(ndAbs(priority)), ndBrainFloat(1.0e-6f));
+	m_priority[index] = value;
+	m_maxPriority = ndMax(m_maxPriority, value);
+	if (!m_sumTreeDirty)
+	{
+		UpdateSumTree(index);
+	}
+}
+
+void ndBrainReplayStore::SampleUniform(ndInt32 batchSize, ndArray<ndInt32>& indices) const
+{
+	const ndInt32 count = GetCount();
+	ndAssert(count);
+	indices.SetCount(batchSize);
+	for (ndInt32 i = 0; i < batchSize; ++i)
+	{
+		indices[i] = ndInt32(ndRandInt() % ndUnsigned32(count));
+	}
+}
+
+void ndBrainReplayStore::UpdateSumTree(ndInt32 index)
+{
+	ndInt32 node = m_sumTreeLeafs + index;
+	m_sumTree[node] = ndBrainFloat(ndPow(m_priority[index], m_priorityExponent));
+	// the parents are summed from their children, so repeated updates do not drift
+	for (node = node >> 1; node; node = node >> 1)
+	{
+		m_sumTree[node] = m_sumTree[2 * node] + m_sumTree[2 * node + 1];
+	}
+}
+
+void ndBrainReplayStore::SyncSumTree()
+{
+	const ndInt64 insertIndex = m_insertIndex.load();
+	if (m_sumTreeDirty || ((insertIndex - m_sumTreeInsertIndex) >= m_capacity))
+	{
+		// the exponent changed or the whole ring was rewritten, rebuild bottom up
+		const ndInt32 count = GetCount();
+		for (ndInt32 i = 0; i < m_sumTreeLeafs; ++i)
+		{
+			m_sumTree[m_sumTreeLeafs + i] = (i < count) ? ndBrainFloat(ndPow(m_priority[i], m_priorityExponent)) : ndBrainFloat(0.0f);
+		}
+		for (ndInt32 node = m_sumTreeLeafs - 1; node; --node)
+		{
+			m_sumTree[node] = m_sumTree[2 * node] + m_sumTree[2 * node + 1];
+		}
+	}
+	else
+	{
+		for (ndInt64 i = m_sumTreeInsertIndex; i < insertIndex; ++i)
+		{
+			UpdateSumTree(ndInt32(i % m_capacity));
+		}
+	}
+	m_sumTreeInsertIndex = insertIndex;
+	m_sumTreeDirty = false;
+}
+
+ndInt32 ndBrainReplayStore::FindSumTreeLeaf(ndBrainFloat target) const
+{
+	ndInt32 node = 1;
+	while (node < m_sumTreeLeafs)
+	{
+		const ndInt32 left = 2 * node;
+		// round off can push the target past the last non empty leaf, 
+		// never descend into an empty subtree
+		if ((target < m_sumTree[left]) || (m_sumTree[left + 1] <= ndBrainFloat(0.0f)))
+		{
+			node = left;
+		}
+		else
+		{
+			target -= m_sumTree[left];
+			node = left + 1;
+		}
+	}
+	return node - m_sumTreeLeafs;
+}
+
+void ndBrainReplayStore::SamplePrioritized(ndInt32 batchSize, ndBrainFloat beta, ndArray<ndInt32>& indices, ndBrainVector& weights)
+{
+	const ndInt32 count = GetCount();
+	ndAssert(count);
+
+	SyncSumTree();
+	const ndBrainFloat sum = m_sumTree[1];
+	ndAssert(sum > ndBrainFloat(0.0f));
+
+	indices.SetCount(batchSize);
+	weights.SetCount(batchSize);
+	ndBrainFloat maxWeight = ndBrainFloat(0.0f);
+	const ndBrainFloat segment = sum / ndBrainFloat(batchSize);
+	for (ndInt32 i = 0; i < batchSize; ++i)
+	{
+		// one sample from each of batchSize equal probability segments
+		const ndBrainFloat target = segment * (ndBrainFloat(i) + ndBrainFloat(ndRand()));
+		const ndInt32 index = FindSumTreeLeaf(target);
+		ndAssert(index < count);
+		indices[i] = index;
+
+		const ndBrainFloat probability = ndMax(m_sumTree[m_sumTreeLeafs + index] / sum, ndBrainFloat(1.0e-12f));
+		weights[i] = ndBrainFloat(ndPow(ndBrainFloat(count) * probability, -beta));
+		maxWeight = ndMax(maxWeight, weights[i]);
+	}
+	weights.Scale(ndBrainFloat(1.0f) / maxWeight);
+}
+
+void ndBrainReplayStore::Gather(const ndArray<ndInt32>& indices, ndBrainMatrix& observations, ndBrainMatrix& actions, ndBrainVector& rewards, ndBrainMatrix& nextObservations, ndBrainVector& terminals) const
+{
+	const ndInt32 batchSize = ndInt32(indices.GetCount());
+	if (!observations.GetCount())
+	{
+		observations.Init(batchSize, m_observationSize);
+	}
+	if (!nextObservations.GetCount())
+	{
+		nextObservations.Init(batchSize, m_observationSize);
+	}
+	if (!actions.GetCount())
+	{
+		actions.Init(batchSize, m_actionSize);
+	}
+	ndAssert(observations.GetRows() == batchSize);
+	ndAssert(nextObservations.GetRows() == batchSize);
+	ndAssert(actions.GetRows() == batchSize);
+	ndAssert(observations.GetColumns() == m_observationSize);
+	ndAssert(nextObservations.GetColumns() == m_observationSize);
+	ndAssert(actions.GetColumns() == m_actionSize);
+
+	rewards.SetCount(batchSize);
+	terminals.SetCount(batchSize);
+	for (ndInt32 i = 0; i < batchSize; ++i)
+	{
+		const ndInt32 index = indices[i];
+		ndAssert((index >= 0) && (index < GetCount()));
+		ndMemCpy(&observations[i][0], GetObservation(index), m_observationSize);
+		ndMemCpy(&nextObservations[i][0], GetNextObservation(index), m_observationSize);
+		ndMemCpy(&actions[i][0], GetAction(index), m_actionSize);
+		rewards[i] = m_reward[index];
+		terminals[i] = m_terminal[index];
+	}
+}
@@ -0,0 +1,154 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _ND_BRAIN_REPLAY_STORE_H__
+#define _ND_BRAIN_REPLAY_STORE_H__
+
+#include "ndBrainStdafx.h"
+#include "ndBrainVector.h"
+#include "ndBrainMatrix.h"
+
+// struct of arrays replay store, each field is one contiguous row major buffer.
+// AddTransition is thread safe, the slot is reserved with an atomic ring index,
+// so any number of environments can insert at the same time. sampling and
+// priority updates must not run concurrently with insertions.
+class ndBrainReplayStore : public ndClassAlloc
+{
+	public:
+	ndBrainReplayStore();
+	ndBrainReplayStore(ndInt32 capacity, ndInt32 observationSize, ndInt32 actionSize);
+	~ndBrainReplayStore();
+
+	void Init(ndInt32 capacity, ndInt32 observationSize, ndInt32 actionSize);
+	void Clear();
+
+	ndInt32 GetCount() const;
+	ndInt32 GetCapacity() const;
+	ndInt32 GetActionSize() const;
+	ndInt32 GetObservationSize() const;
+
+	// returns the slot where the transition was written
+	ndInt32 AddTransition(const ndBrainVector& observation, const ndBrainVector& action, ndBrainFloat reward, const ndBrainVector& nextObservation, bool terminal);
+
+	const ndBrainFloat* GetAction(ndInt32 index) const;
+	const ndBrainFloat* GetObservation(ndInt32 index) const;
+	const ndBrainFloat* GetNextObservation(ndInt32 index) const;
+	ndBrainFloat GetReward(ndInt32 index) const;
+	bool GetTerminal(ndInt32 index) const;
+
+	// prioritized replay, new transitions get the largest priority seen so far.
+	void SetPriorityExponent(ndBrainFloat alpha);
+	ndBrainFloat GetPriority(ndInt32 index) const;
+	void SetPriority(ndInt32 index, ndBrainFloat priority);
+
+	void SampleUniform(ndInt32 batchSize, ndArray<ndInt32>& indices) const;
+	// stratified proportional sampling, weights are the normalized importance sampling weights.
+	void SamplePrioritized(ndInt32 batchSize, ndBrainFloat beta, ndArray<ndInt32>& indices, ndBrainVector& weights);
+
+	// copy the sampled transitions to the rows of batch matrices,
+	// empty matrices are initialized to the batch size. 
+	// terminals are stored as 0 for terminal transitions and 1 otherwise.
+	void Gather(const ndArray<ndInt32>& indices, ndBrainMatrix& observations, ndBrainMatrix& actions, ndBrainVector& rewards, ndBrainMatrix& nextObservations, ndBrainVector& terminals) const;
+
+	private:
+	void UpdateSumTree(ndInt32 index);
+	void SyncSumTree();
+	ndInt32 FindSumTreeLeaf(ndBrainFloat target) const;
+
+	ndBrainVector m_action;
+	ndBrainVector m_observation;
+	ndBrainVector m_nextObservation;
+	ndBrainVector m_reward;
+	ndBrainVector m_terminal;
+	ndBrainVector m_priority;
+	// binary sum tree of the scaled priorities, node i has children 2i and 2i + 1,
+	// the leaves start at m_sumTreeLeafs. insertions do not touch the tree, 
+	// the slots written since the last sample are folded in by SyncSumTree.
+	ndBrainVector m_sumTree;
+	ndAtomic<ndInt64> m_insertIndex;
+	ndInt64 m_sumTreeInsertIndex;
+	ndBrainFloat m_maxPriority;
+	ndBrainFloat m_priorityExponent;
+	ndInt32 m_capacity;
+	ndInt32 m_actionSize;
+	ndInt32 m_observationSize;
+	ndInt32 m_sumTreeLeafs;
+	bool m_sumTreeDirty;
+};
+
+inline ndInt32 ndBrainReplayStore::GetCount() const
+{
+	return ndInt32(ndMin(ndInt64(m_insertIndex.load()), ndInt64(m_capacity)));
+}
+
+inline ndInt32 ndBrainReplayStore::GetCapacity() const
+{
+	return m_capacity;
+}
+
+inline ndInt32 ndBrainReplayStore::GetActionSize() const
+{
+	return m_actionSize;
+}
+
+inline ndInt32 ndBrainReplayStore::GetObservationSize() const
+{
+	return m_observationSize;
+}
+
+inline const ndBrainFloat* ndBrainReplayStore::GetAction(ndInt32 index) const
+{
+	return &m_action[ndInt64(index) * m_actionSize];
+}
+
+inline const ndBrainFloat* ndBrainReplayStore::GetObservation(ndInt32 index) const
+{
+	return &m_observation[ndInt64(index) * m_observationSize];
+}
+
+inline const ndBrainFloat* ndBrainReplayStore::GetNextObservation(ndInt32 index) const
+{
+	return &m_nextObservation[ndInt64(index) * m_observationSize];
+}
+
+inline ndBrainFloat ndBrainReplayStore::GetReward(ndInt32 index) const
+{
+	return m_reward[index];
+}
+
+inline bool ndBrainReplayStore::GetTerminal(ndInt32 index) const
+{
+	return m_terminal[index] == ndBrainFloat(0.0f);
+}
+
+inline ndBrainFloat ndBrainReplayStore::GetPriority(ndInt32 index) const
+{
+	return m_priority[index];
+}
+
+inline void ndBrainReplayStore::SetPriorityExponent(ndBrainFloat alpha)
+{
+	m_priorityExponent = ndMax(alpha, ndBrainFloat(0.0f));
+	m_sumTreeDirty = true;
+}
+
+#endif 
+
@@ -103,27 +103,27 @@ ndBrain* ndBrainLoad::Load() const
 		ReadString(layerType);
 	
 		ndBrainLayer* layer = nullptr;
-		if (!strcmp(layerType, "ndBrainLayerLinear"))
+		if (!strcmp(layerType, ND_BRAIN_LAYER_LINEAR_NAME))
 		{
 			layer = ndBrainLayerLinear::Load(this);
 		}
-		else if (!strcmp(layerType, "ndBrainLayerActivationRelu"))
+		else if (!strcmp(layerType, ND_BRAIN_LAYER_ACTIVATION_RELU_NAME))
 		{
 			layer = ndBrainLayerActivationRelu::Load(this);
 		}
-		else if (!strcmp(layerType, "ndBrainLayerActivationTanh"))
+		else if (!strcmp(layerType, ND_BRAIN_LAYER_ACTIVATION_TANH_NAME))
 		{
 			layer = ndBrainLayerActivationTanh::Load(this);
 		}
-		else if (!strcmp(layerType, "ndBrainLayerActivationSigmoid"))
+		else if (!strcmp(layerType, ND_BRAIN_LAYER_ACTIVATION_SIGMOID_NAME))
 		{
 			layer = ndBrainLayerActivationSigmoid::Load(this);
 		}
-		else if (!strcmp(layerType, "ndBrainLayerActivationSigmoidLinear"))
+		else if (!strcmp(layerType, ND_BRAIN_LAYER_ACTIVATION_SIGMOID_LINEAR_NAME))
 		{
 			layer = ndBrainLayerActivationSigmoidLinear::Load(this);
 		}
-		else if (!strcmp(layerType, "ndBrainLayerActivationElu"))
+		else if (!strcmp(layerType, ND_BRAIN_LAYER_ACTIVATION_ELU_NAME))
 		{
 			layer = ndBrainLayerActivationElu::Load(this);
 		}
@@ -155,6 +155,25 @@ ndBrainLayer* ndBrainTrainer::GetGradientLayer(ndInt32 index) const
 	return m_data[index]->m_gradient;
 }
 
+void ndBrainTrainer::GetWeightBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes) const
+{
+	for (ndInt32 i = 0; i < m_data.GetCount(); ++i)
+	{
+		m_data[i]->m_layer->GetParameterBuffers(buffers, sizes);
+	}
+}
+
+void ndBrainTrainer::GetGradientBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes) const
+{
+	for (ndInt32 i = 0; i < m_data.GetCount(); ++i)
+	{
+		if (m_data[i]->m_gradient)
+		{
+			m_data[i]->m_gradient->GetParameterBuffers(buffers, sizes);
+		}
+	}
+}
+
 void ndBrainTrainer::AcculumateGradients(const ndBrainTrainer& src, ndInt32 index)
 {
 	ndLayerData* const dstData = m_data[index];
@@ -44,6 +44,11 @@ class ndBrainTrainer: public ndClassAlloc
 	ndBrainLayer* GetWeightsLayer(ndInt32 index) const;
 	ndBrainLayer* GetGradientLayer(ndInt32 index) const;
 
+	// flat view of the parameters of the whole brain, as a list of contiguous spans.
+	// weights and gradients spans are in the same order and have the same sizes.
+	void GetWeightBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes) const;
+	void GetGradientBuffers(ndArray<ndBrainFloat*>& buffers, ndArray<ndInt32>& sizes) const;
+
 	void ClearGradients();
 	void ScaleWeights(const ndBrainFloat s);
 	void AddGradients(const ndBrainTrainer* const src);
@@ -34,6 +34,7 @@ ndBody::ndBody()
 	,m_omega(ndVector::m_zero)
 	,m_localCentreOfMass(ndVector::m_wOne)
 	,m_globalCentreOfMass(ndVector::m_wOne)
+	,m_globalCentreOfMassError(ndVector::m_zero)
 	,m_minAabb(ndVector::m_wOne)
 	,m_maxAabb(ndVector::m_wOne)
 	,m_rotation()
@@ -62,6 +63,7 @@ ndBody::ndBody(const ndBody& src)
 	,m_omega(src.m_omega)
 	,m_localCentreOfMass(src.m_localCentreOfMass)
 	,m_globalCentreOfMass(src.m_globalCentreOfMass)
+	,m_globalCentreOfMassError(src.m_globalCentreOfMassError)
 	,m_minAabb(src.m_minAabb)
 	,m_maxAabb(src.m_maxAabb)
 	,m_rotation(src.m_rotation)
@@ -103,6 +105,7 @@ void ndBody::SetCentreOfMass(const ndVector& com)
 	m_localCentreOfMass.m_z = com.m_z;
 	m_localCentreOfMass.m_w = ndFloat32(1.0f);
 	m_globalCentreOfMass = m_matrix.TransformVector(m_localCentreOfMass);
+	m_globalCentreOfMassError = ndVector::m_zero;
 }
 
 void ndBody::SetNotifyCallback(ndBodyNotify* const notify)
@@ -150,6 +153,7 @@ void ndBody::SetMatrixNoSleep(const ndMatrix& matrix)
 
 	m_rotation = ndQuaternion(m_matrix);
 	m_globalCentreOfMass = m_matrix.TransformVector(m_localCentreOfMass);
+	m_globalCentreOfMassError = ndVector::m_zero;
 }
 
 void ndBody::SetMatrixAndCentreOfMass(const ndQuaternion& rotation, const ndVector& globalcom)
@@ -157,6 +161,7 @@ void ndBody::SetMatrixAndCentreOfMass(const ndQuaternion& rotation, const ndVect
 	m_rotation = rotation;
 	ndAssert(m_rotation.DotProduct(m_rotation).GetScalar() > ndFloat32(0.9999f));
 	m_globalCentreOfMass = globalcom;
+	m_globalCentreOfMassError = ndVector::m_zero;
 	m_matrix = ndCalculateMatrix(rotation, m_matrix.m_posit);
 	m_matrix.m_posit = m_globalCentreOfMass - m_matrix.RotateVector(m_localCentreOfMass);
 }
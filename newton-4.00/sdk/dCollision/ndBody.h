@@ -97,6 +97,7 @@ class ndBody : public ndContainersFreeListAlloc<ndBody>
 	ndVector m_omega;
 	ndVector m_localCentreOfMass;
 	ndVector m_globalCentreOfMass;
+	ndVector m_globalCentreOfMassError;
 	ndVector m_minAabb;
 	ndVector m_maxAabb;
 	ndQuaternion m_rotation;
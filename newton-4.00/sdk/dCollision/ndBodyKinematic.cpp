@@ -119,6 +119,8 @@ ndBodyKinematic::ndBodyKinematic()
 	,m_sceneNodeIndex(-1)
 	,m_buildBodyNodeIndex(-1)
 	,m_buildSceneNodeIndex(-1)
+	,m_collisionCategory(D_COLLISION_LAYER_ALL)
+	,m_collisionMask(D_COLLISION_LAYER_ALL)
 {
 	m_invWorldInertiaMatrix[3][3] = ndFloat32(1.0f);
 	m_shapeInstance.m_ownerBody = this;
@@ -154,6 +156,8 @@ ndBodyKinematic::ndBodyKinematic(const ndBodyKinematic& src)
 	,m_sceneNodeIndex(-1)
 	,m_buildBodyNodeIndex(-1)
 	,m_buildSceneNodeIndex(-1)
+	,m_collisionCategory(src.m_collisionCategory)
+	,m_collisionMask(src.m_collisionMask)
 {
 }
 
@@ -164,6 +168,16 @@ ndBodyKinematic::~ndBodyKinematic()
 	ndAssert(m_spetialUpdateNode == nullptr);
 }
 
+void ndBodyKinematic::SetCollisionLayers(ndUnsigned32 category, ndUnsigned32 mask)
+{
+	m_collisionCategory = category;
+	m_collisionMask = mask;
+	if (m_scene)
+	{
+		m_scene->InvalidateCollisionLayers();
+	}
+}
+
 void ndBodyKinematic::SetSleepState(bool state)
 {
 	m_equilibrium = ndUnsigned8 (state ? 1 : 0);
@@ -565,7 +579,7 @@ void ndBodyKinematic::IntegrateVelocity(ndFloat32 timestep)
 {
 	ndAssert(m_veloc.m_w == ndFloat32(0.0f));
 	ndAssert(m_omega.m_w == ndFloat32(0.0f));
-	m_globalCentreOfMass += m_veloc.Scale(timestep);
+	ndKahanAdd(m_globalCentreOfMass, m_globalCentreOfMassError, m_veloc.Scale(timestep));
 
 	const ndFloat32 omegaMag2 = m_omega.DotProduct(m_omega).GetScalar();
 
@@ -34,6 +34,7 @@ class ndJointBilateralConstraint;
 
 #define	D_FREEZZING_VELOCITY_DRAG	ndFloat32 (0.9f)
 #define	D_SOLVER_MAX_ACCEL_ERROR	(D_FREEZE_MAG * ndFloat32 (0.5f))
+#define	D_COLLISION_LAYER_ALL		ndUnsigned32 (0xffffffff)
 
 D_MSV_NEWTON_ALIGN_32
 class ndBodyKinematic : public ndBody
@@ -116,6 +117,11 @@ class ndBodyKinematic : public ndBody
 	virtual ndVector GetAngularDamping() const;
 	virtual void SetAngularDamping(const ndVector& angularDamp);
 
+	ndUnsigned32 GetCollisionCategory() const;
+	ndUnsigned32 GetCollisionMask() const;
+	bool TestCollisionLayers(const ndBodyKinematic* const otherBody) const;
+	D_COLLISION_API void SetCollisionLayers(ndUnsigned32 category, ndUnsigned32 mask);
+
 	D_COLLISION_API ndShapeInstance& GetCollisionShape();
 	D_COLLISION_API const ndShapeInstance& GetCollisionShape() const;
 	D_COLLISION_API virtual void SetCollisionShape(const ndShapeInstance& shapeInstance);
@@ -224,6 +230,8 @@ class ndBodyKinematic : public ndBody
 	ndInt32 m_sceneNodeIndex;
 	ndInt32 m_buildBodyNodeIndex;
 	ndInt32 m_buildSceneNodeIndex;
+	ndUnsigned32 m_collisionCategory;
+	ndUnsigned32 m_collisionMask;
 
 	D_COLLISION_API static ndVector m_velocTol;
 
@@ -251,6 +259,22 @@ class ndBodySentinel : public ndBodyKinematic
 	ndBodySentinel* GetAsBodySentinel() { return this; }
 };
 
+inline ndUnsigned32 ndBodyKinematic::GetCollisionCategory() const
+{
+	return m_collisionCategory;
+}
+
+inline ndUnsigned32 ndBodyKinematic::GetCollisionMask() const
+{
+	return m_collisionMask;
+}
+
+// two bodies can collide when each one's category is in the mask of the other
+inline bool ndBodyKinematic::TestCollisionLayers(const ndBodyKinematic* const otherBody) const
+{
+	return (m_collisionCategory & otherBody->m_collisionMask) && (otherBody->m_collisionCategory & m_collisionMask);
+}
+
 inline ndUnsigned32 ndBodyKinematic::GetIndex() const
 {
 	return ndUnsigned32(m_index);
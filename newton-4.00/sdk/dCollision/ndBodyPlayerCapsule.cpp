@@ -531,7 +531,7 @@ void ndBodyPlayerCapsuleContactSolver::CalculateContacts()
 			}
 			ndContact contact;
 			contact.SetBodies(body0, body1);
-			contact.m_material = contactNotify->GetMaterial(&contact, body0->GetCollisionShape(), body1->GetCollisionShape());
+			contact.m_material = contactNotify->FindMaterial(&contact, body0->GetCollisionShape(), body1->GetCollisionShape());
 	
 			ndContactPoint contactBuffer[D_MAX_CONTATCS];
 			ndContactSolver contactSolver(&contact, scene->GetContactNotify(), ndFloat32(1.0f), 0);
@@ -22,6 +22,8 @@
 #include "ndCoreStdafx.h"
 #include "ndCollisionStdafx.h"
 #include "ndScene.h"
+#include "ndBodyKinematic.h"
+#include "ndBodiesInAabbNotify.h"
 #include "ndBodySphFluid.h"
 
 #ifndef D_USE_NEW_FLUID
@@ -1316,8 +1318,34 @@ class ndBodySphFluid::ndParticleKernelDistance
 class ndBodySphFluid::ndWorkingBuffers
 {
 #define D_SPH_GRID_X_RESOLUTION 4
+#define D_SPH_CELL_BITS			21
+#define D_SPH_CELL_MARGIN		1024
 
 	public:
+	class ndCellEntry
+	{
+		public:
+		ndUnsigned64 m_key;
+		ndInt32 m_index;
+		ndInt32 m_moved;
+	};
+
+	// rigid body shape approximated by a rounded box in shape space:
+	// spheres and capsules are exact, other convex shapes use their obb.
+	class ndCouplingProxy
+	{
+		public:
+		ndMatrix m_matrix;
+		ndVector m_extent;
+		ndVector m_veloc;
+		ndVector m_omega;
+		ndVector m_com;
+		ndVector m_boxP0;
+		ndVector m_boxP1;
+		ndBodyKinematic* m_body;
+		ndFloat32 m_radius;
+	};
+
 	ndWorkingBuffers()
 		:m_accel(D_SPH_BUFFER_GRANULARITY)
 		, m_locks(D_SPH_BUFFER_GRANULARITY)
@@ -1334,6 +1362,17 @@ class ndBodySphFluid::ndWorkingBuffers
 		, m_hashGridSize(ndFloat32(0.0f))
 		, m_hashInvGridSize(ndFloat32(0.0f))
 		, m_particleDiameter(ndFloat32(0.0f))
+		, m_cellEntries(D_SPH_BUFFER_GRANULARITY)
+		, m_cellEntriesScratch(D_SPH_BUFFER_GRANULARITY)
+		, m_cellKeys(D_SPH_BUFFER_GRANULARITY)
+		, m_cellStart(D_SPH_BUFFER_GRANULARITY)
+		, m_reorderScratch(D_SPH_BUFFER_GRANULARITY)
+		, m_couplingProxies()
+		, m_couplingReactions()
+		, m_cellOrigin(ndVector::m_zero)
+		, m_invCellSize(ndFloat32(1.0f))
+		, m_framesSinceReorder(0)
+		, m_cellsValid(false)
 	{
 		for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
 		{
@@ -1341,6 +1380,61 @@ class ndBodySphFluid::ndWorkingBuffers
 		}
 	}
 
+	static ndUnsigned64 ExpandBits(ndUnsigned64 x)
+	{
+		// spread the low 21 bits so that there are two zero bits between them
+		x &= 0x1fffff;
+		x = (x | (x << 32)) & 0x1f00000000ffffULL;
+		x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+		x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+		x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+		x = (x | (x << 2)) & 0x1249249249249249ULL;
+		return x;
+	}
+
+	static ndUnsigned64 CellKey(ndInt32 x, ndInt32 y, ndInt32 z)
+	{
+		return ExpandBits(ndUnsigned64(x)) | (ExpandBits(ndUnsigned64(y)) << 1) | (ExpandBits(ndUnsigned64(z)) << 2);
+	}
+
+	// returns false if the cell is too close to the edge of the morton domain
+	bool CellCoordinates(const ndVector& point, ndInt32* const coord) const
+	{
+		const ndVector cell(((point - m_cellOrigin) * ndVector(m_invCellSize)).Floor().GetInt());
+		bool inside = true;
+		for (ndInt32 i = 0; i < 3; ++i)
+		{
+			const ndInt32 value = ndInt32(cell.m_i[i]) + D_SPH_CELL_MARGIN;
+			inside = inside && (value >= 1) && (value < ((1 << D_SPH_CELL_BITS) - 1));
+			coord[i] = ndClamp(value, 1, (1 << D_SPH_CELL_BITS) - 2);
+		}
+		return inside;
+	}
+
+	ndInt32 FindCell(ndUnsigned64 key) const
+	{
+		ndInt32 i0 = 0;
+		ndInt32 i1 = ndInt32(m_cellKeys.GetCount()) - 1;
+		while (i0 <= i1)
+		{
+			const ndInt32 mid = (i0 + i1) >> 1;
+			const ndUnsigned64 midKey = m_cellKeys[mid];
+			if (midKey == key)
+			{
+				return mid;
+			}
+			else if (midKey < key)
+			{
+				i0 = mid + 1;
+			}
+			else
+			{
+				i1 = mid - 1;
+			}
+		}
+		return -1;
+	}
+
 	~ndWorkingBuffers()
 	{
 	}
@@ -1385,6 +1479,21 @@ class ndBodySphFluid::ndWorkingBuffers
 	ndFloat32 m_hashGridSize;
 	ndFloat32 m_hashInvGridSize;
 	ndFloat32 m_particleDiameter;
+
+	// persistent cell lists, entries are sorted by cell key
+	ndArray<ndCellEntry> m_cellEntries;
+	ndArray<ndCellEntry> m_cellEntriesScratch;
+	ndArray<ndUnsigned64> m_cellKeys;
+	ndArray<ndInt32> m_cellStart;
+	ndArray<ndVector> m_reorderScratch;
+
+	// rigid body coupling, two reaction vectors (force, torque) per thread and proxy
+	ndArray<ndCouplingProxy> m_couplingProxies;
+	ndArray<ndVector> m_couplingReactions;
+	ndVector m_cellOrigin;
+	ndFloat32 m_invCellSize;
+	ndInt32 m_framesSinceReorder;
+	bool m_cellsValid;
 };
 
 ndBodySphFluid::ndBodySphFluid()
@@ -1394,6 +1503,13 @@ ndBodySphFluid::ndBodySphFluid()
 	,m_viscosity(ndFloat32(1.05f))
 	,m_restDensity(ndFloat32(1000.0f))
 	,m_gasConstant(ndFloat32(1.0f))
+	,m_couplingStiffness(ndFloat32(2000.0f))
+	,m_couplingDamping(ndFloat32(20.0f))
+	,m_reorderFrames(16)
+	,m_rebinnedCount(0)
+	,m_coupledCount(0)
+	,m_persistentCells(false)
+	,m_rigidCoupling(false)
 {
 	SetRestDensity(m_restDensity);
 }
@@ -1958,24 +2074,26 @@ void ndBodySphFluid::CalculateParticlesDensity(ndThreadPool* const threadPool)
 		//const ndFloat32 selfDensity = kernelConst * h2 * h2 * h2;
 		const ndFloat32 selfVolume = h2 * h2 * h2;
 
+		const ndVector h2Vector(h2);
+		const ndVector lanes(ndFloat32(0.0f), ndFloat32(1.0f), ndFloat32(2.0f), ndFloat32(3.0f));
+
 		const ndStartEnd startEnd(ndInt32(posit.GetCount()), threadIndex, threadCount);
 		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 		{
 			const ndInt32 count = data.m_pairCount[i];
 			const ndParticleKernelDistance& distance = data.m_kernelDistance[i];
-			//ndFloat32 density = selfDensity;
-			ndFloat32 volume = selfVolume;
-			for (ndInt32 j = 0; j < count; ++j)
+			const ndVector countVector((ndFloat32)count);
+
+			// four neighbors at a time, the lanes past the count are masked out
+			ndVector volume(ndVector::m_zero);
+			for (ndInt32 j = 0; j < count; j += 4)
 			{
-				const ndFloat32 dist = distance.m_dist[j];
-				const ndFloat32 dist2 = h2 - dist * dist;
-				ndAssert(dist2 >= ndFloat32(0.0f));
-				const ndFloat32 dist6 = dist2 * dist2 * dist2;
-				//density += kernelConst * dist6;
-				volume += dist6;
+				const ndVector dist(&distance.m_dist[j]);
+				const ndVector mask((ndVector(ndFloat32(j)) + lanes) < countVector);
+				const ndVector dist2((h2Vector - dist * dist) & mask);
+				volume += dist2 * dist2 * dist2;
 			}
-			//density = kernelConst * density;
-			ndFloat32 density = kernelMassConst * volume;
+			ndFloat32 density = kernelMassConst * (selfVolume + volume.AddHorizontal().GetScalar());
 			data.m_density[i] = density;
 			data.m_invDensity[i] = ndFloat32(1.0f) / density;
 		}
@@ -2330,6 +2448,576 @@ void ndBodySphFluid::CreateGrids(ndThreadPool* const threadPool)
 	//ndAssert(TraceHashes());
 }
 
+void ndBodySphFluid::SetPersistentCells(bool state, ndInt32 reorderFrames)
+{
+	m_persistentCells = state;
+	m_reorderFrames = ndMax(reorderFrames, 1);
+	m_workingBuffers->m_cellsValid = false;
+}
+
+void ndBodySphFluid::ReorderParticles(ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	class ndCellKeyByte
+	{
+		public:
+		ndCellKeyByte(void* const context)
+			:m_shift(*((ndInt32*)context))
+		{
+		}
+
+		ndInt32 GetKey(const ndWorkingBuffers::ndCellEntry& entry) const
+		{
+			return ndInt32((entry.m_key >> m_shift) & 0xff);
+		}
+
+		ndInt32 m_shift;
+	};
+
+	ndWorkingBuffers& data = *m_workingBuffers;
+	const ndInt32 particleCount = ndInt32(m_posit.GetCount());
+
+	// anchor the morton domain to the current aabb
+	data.m_cellOrigin = m_box0;
+	data.m_invCellSize = ndFloat32(1.0f) / data.m_particleDiameter;
+	data.m_cellEntries.SetCount(particleCount);
+	data.m_cellEntriesScratch.SetCount(particleCount);
+
+	ndUnsigned64 maxKeys[D_MAX_THREADS_COUNT];
+	auto CalculateKeys = ndMakeObject::ndFunction([this, &data, &maxKeys](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CalculateKeys);
+		ndUnsigned64 maxKey = 0;
+		ndWorkingBuffers::ndCellEntry* const entries = &data.m_cellEntries[0];
+		const ndStartEnd startEnd(ndInt32(m_posit.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			ndInt32 coord[3];
+			const bool inside = data.CellCoordinates(m_posit[i], coord);
+			ndAssert(inside);
+			ndWorkingBuffers::ndCellEntry& entry = entries[i];
+			entry.m_key = data.CellKey(coord[0], coord[1], coord[2]);
+			entry.m_index = i;
+			entry.m_moved = 0;
+			maxKey = ndMax(maxKey, entry.m_key);
+		}
+		maxKeys[threadIndex] = maxKey;
+	});
+	threadPool->ParallelExecute(CalculateKeys);
+
+	ndUnsigned64 maxKey = 0;
+	for (ndInt32 i = 0; i < threadPool->GetThreadCount(); ++i)
+	{
+		maxKey = ndMax(maxKey, maxKeys[i]);
+	}
+
+	// radix sort, only over the bytes that are used by the keys
+	for (ndInt32 shift = 0; (shift < 64) && (maxKey >> shift); shift += 8)
+	{
+		ndCountingSort<ndWorkingBuffers::ndCellEntry, ndCellKeyByte, 8>(*threadPool, data.m_cellEntries, data.m_cellEntriesScratch, nullptr, &shift);
+	}
+
+	// move the particles so that the particles of a cell are contiguous in memory
+	auto ShuffleParticles = ndMakeObject::ndFunction([this, &data](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(ShuffleParticles);
+		ndWorkingBuffers::ndCellEntry* const entries = &data.m_cellEntries[0];
+		const ndStartEnd startEnd(ndInt32(data.m_cellEntries.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndInt32 index = entries[i].m_index;
+			data.m_reorderScratch[i] = m_posit[index];
+			data.m_accel[i] = m_veloc[index];
+			entries[i].m_index = i;
+		}
+	});
+
+	data.m_accel.SetCount(particleCount);
+	data.m_reorderScratch.SetCount(particleCount);
+	threadPool->ParallelExecute(ShuffleParticles);
+	m_posit.Swap(data.m_reorderScratch);
+	m_veloc.Swap(data.m_accel);
+
+	data.m_framesSinceReorder = 0;
+	m_rebinnedCount = particleCount;
+}
+
+void ndBodySphFluid::UpdatePersistentCells(ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	class ndCompareKey
+	{
+		public:
+		ndCompareKey(void* const)
+		{
+		}
+
+		ndInt32 Compare(const ndWorkingBuffers::ndCellEntry& entryA, const ndWorkingBuffers::ndCellEntry& entryB) const
+		{
+			if (entryA.m_key < entryB.m_key)
+			{
+				return -1;
+			}
+			else if (entryA.m_key > entryB.m_key)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	ndWorkingBuffers& data = *m_workingBuffers;
+	const ndInt32 particleCount = ndInt32(m_posit.GetCount());
+
+	bool reorder = !data.m_cellsValid;
+	reorder = reorder || (data.m_cellEntries.GetCount() != particleCount);
+	reorder = reorder || ((data.m_framesSinceReorder + 1) >= m_reorderFrames);
+	reorder = reorder || (ndAbs(data.m_invCellSize * data.m_particleDiameter - ndFloat32(1.0f)) > ndFloat32(1.0e-5f));
+
+	if (!reorder)
+	{
+		// re-bin the particles, the sorted entries keep their order
+		// and only the ones that changed cell are flagged
+		ndInt32 movedCount[D_MAX_THREADS_COUNT];
+		bool outOfRange[D_MAX_THREADS_COUNT];
+		auto UpdateKeys = ndMakeObject::ndFunction([this, &data, &movedCount, &outOfRange](ndInt32 threadIndex, ndInt32 threadCount)
+		{
+			D_TRACKTIME_NAMED(UpdateKeys);
+			ndInt32 moved = 0;
+			bool outside = false;
+			ndWorkingBuffers::ndCellEntry* const entries = &data.m_cellEntries[0];
+			const ndStartEnd startEnd(ndInt32(data.m_cellEntries.GetCount()), threadIndex, threadCount);
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+			{
+				ndInt32 coord[3];
+				ndWorkingBuffers::ndCellEntry& entry = entries[i];
+				outside = !data.CellCoordinates(m_posit[entry.m_index], coord) || outside;
+				const ndUnsigned64 key = data.CellKey(coord[0], coord[1], coord[2]);
+				entry.m_moved = (key != entry.m_key) ? 1 : 0;
+				entry.m_key = key;
+				moved += entry.m_moved;
+			}
+			movedCount[threadIndex] = moved;
+			outOfRange[threadIndex] = outside;
+		});
+		threadPool->ParallelExecute(UpdateKeys);
+
+		ndInt32 moved = 0;
+		for (ndInt32 i = 0; i < threadPool->GetThreadCount(); ++i)
+		{
+			moved += movedCount[i];
+			reorder = reorder || outOfRange[i];
+		}
+
+		if (!reorder && moved)
+		{
+			// split the entries in the still sorted resident list and the moved list,
+			// sort the moved list and merge them back.
+			ndInt32 residentCount = 0;
+			ndInt32 movedIndex = particleCount - moved;
+			ndWorkingBuffers::ndCellEntry* const entries = &data.m_cellEntries[0];
+			ndWorkingBuffers::ndCellEntry* const scratch = &data.m_cellEntriesScratch[0];
+			for (ndInt32 i = 0; i < particleCount; ++i)
+			{
+				if (entries[i].m_moved)
+				{
+					scratch[movedIndex++] = entries[i];
+				}
+				else
+				{
+					scratch[residentCount++] = entries[i];
+				}
+			}
+			ndAssert(residentCount == (particleCount - moved));
+			ndSort<ndWorkingBuffers::ndCellEntry, ndCompareKey>(&scratch[residentCount], moved, nullptr);
+
+			ndInt32 i0 = 0;
+			ndInt32 i1 = residentCount;
+			for (ndInt32 i = 0; i < particleCount; ++i)
+			{
+				if ((i1 >= particleCount) || ((i0 < residentCount) && (scratch[i0].m_key <= scratch[i1].m_key)))
+				{
+					entries[i] = scratch[i0++];
+				}
+				else
+				{
+					entries[i] = scratch[i1++];
+				}
+			}
+		}
+
+		if (!reorder)
+		{
+			data.m_framesSinceReorder++;
+			m_rebinnedCount = moved;
+			if (!moved)
+			{
+				// nothing changed cell, the cell table is still valid
+				return;
+			}
+		}
+	}
+
+	if (reorder)
+	{
+		ReorderParticles(threadPool);
+	}
+
+	// build the table of occupied cells
+	data.m_cellKeys.SetCount(0);
+	data.m_cellStart.SetCount(0);
+	ndUnsigned64 prevKey = ndUnsigned64(-1);
+	for (ndInt32 i = 0; i < particleCount; ++i)
+	{
+		const ndUnsigned64 key = data.m_cellEntries[i].m_key;
+		if (key != prevKey)
+		{
+			data.m_cellKeys.PushBack(key);
+			data.m_cellStart.PushBack(i);
+			prevKey = key;
+		}
+	}
+	data.m_cellStart.PushBack(particleCount);
+	data.m_cellsValid = true;
+}
+
+void ndBodySphFluid::BuildPersistentPairs(ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	ndWorkingBuffers& data = *m_workingBuffers;
+	const ndInt32 particleCount = ndInt32(m_posit.GetCount());
+	data.m_pairs.SetCount(particleCount);
+	data.m_pairCount.SetCount(particleCount);
+	data.m_kernelDistance.SetCount(particleCount);
+
+	auto BuildPairs = ndMakeObject::ndFunction([this, &data](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(BuildPairs);
+		const ndFloat32 h = data.m_particleDiameter;
+		const ndFloat32 h2 = h * h;
+		const ndVector* const posit = &m_posit[0];
+		const ndWorkingBuffers::ndCellEntry* const entries = &data.m_cellEntries[0];
+		const ndInt32* const cellStart = &data.m_cellStart[0];
+
+		// the particles are visited in cell order, so consecutive
+		// particles scan the same neighbor cells
+		const ndStartEnd startEnd(ndInt32(data.m_cellEntries.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndInt32 i0 = entries[i].m_index;
+			const ndVector p0(posit[i0]);
+			ndParticlePair& pairs = data.m_pairs[i0];
+			ndParticleKernelDistance& distance = data.m_kernelDistance[i0];
+
+			ndInt32 coord[3];
+			data.CellCoordinates(p0, coord);
+
+			ndInt32 count = 0;
+			for (ndInt32 z = -1; z <= 1; ++z)
+			{
+				for (ndInt32 y = -1; y <= 1; ++y)
+				{
+					for (ndInt32 x = -1; x <= 1; ++x)
+					{
+						const ndInt32 cell = data.FindCell(data.CellKey(coord[0] + x, coord[1] + y, coord[2] + z));
+						if (cell < 0)
+						{
+							continue;
+						}
+						const ndInt32 end = cellStart[cell + 1];
+						for (ndInt32 j = cellStart[cell]; (j < end) && (count < D_PARTICLE_BUCKET_SIZE); ++j)
+						{
+							const ndInt32 i1 = entries[j].m_index;
+							const ndVector p10(p0 - posit[i1]);
+							const ndFloat32 dist2 = p10.DotProduct(p10).GetScalar();
+							if ((i1 != i0) && (dist2 < h2))
+							{
+								pairs.m_neighborg[count] = i1;
+								distance.m_dist[count] = ndSqrt(dist2);
+								count++;
+							}
+						}
+					}
+				}
+			}
+			data.m_pairCount[i0] = ndInt8(count);
+		}
+	});
+
+	threadPool->ParallelExecute(BuildPairs);
+}
+
+void ndBodySphFluid::SetRigidCoupling(bool state, ndFloat32 stiffness, ndFloat32 damping)
+{
+	m_rigidCoupling = state;
+	m_couplingStiffness = ndMax(stiffness, ndFloat32(0.0f));
+	m_couplingDamping = ndMax(damping, ndFloat32(0.0f));
+	if (state && !m_persistentCells)
+	{
+		SetPersistentCells(true, m_reorderFrames);
+	}
+}
+
+void ndBodySphFluid::GatherCouplingBodies(const ndScene* const scene)
+{
+	D_TRACKTIME();
+	ndWorkingBuffers& data = *m_workingBuffers;
+	data.m_couplingProxies.SetCount(0);
+
+	// the scene bvh is only queried here, while the scene is not updating, 
+	// with the fluid aabb padded by the distance particles can travel in one step.
+	const ndVector padding(ndFloat32(2.0f) * data.m_hashGridSize);
+	ndBodiesInAabbNotify notify;
+	scene->BodiesInAabb(notify, m_box0 - padding, m_box1 + padding);
+
+	const ndVector radius(GetParticleRadius());
+	for (ndInt32 i = 0; i < ndInt32(notify.m_bodyArray.GetCount()); ++i)
+	{
+		ndBodyKinematic* const body = ((ndBody*)notify.m_bodyArray[i])->GetAsBodyKinematic();
+		if (!body)
+		{
+			continue;
+		}
+		const ndShapeInstance& instance = body->GetCollisionShape();
+		const ndShape* const shape = instance.GetShape();
+		if (!((ndShape*)shape)->GetAsShapeConvex())
+		{
+			continue;
+		}
+
+		ndWorkingBuffers::ndCouplingProxy proxy;
+		const ndShapeInfo info(instance.GetShapeInfo());
+		const ndVector scale(instance.GetScale().Abs());
+		const ndFloat32 minScale = ndMin(scale.m_x, ndMin(scale.m_y, scale.m_z));
+		proxy.m_matrix = instance.GetLocalMatrix() * body->GetMatrix();
+		switch (info.m_collisionType)
+		{
+			case ndShapeID::m_sphere:
+				proxy.m_extent = ndVector::m_zero;
+				proxy.m_radius = info.m_sphere.m_radius * minScale;
+				break;
+
+			case ndShapeID::m_capsule:
+				proxy.m_extent = ndVector(ndFloat32(0.5f) * info.m_capsule.m_height * scale.m_x, ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f));
+				proxy.m_radius = ndMax(info.m_capsule.m_radio0, info.m_capsule.m_radio1) * minScale;
+				break;
+
+			case ndShapeID::m_box:
+				proxy.m_extent = ndVector(info.m_box.m_x, info.m_box.m_y, info.m_box.m_z, ndFloat32(0.0f)) * ndVector::m_half * scale;
+				proxy.m_radius = ndFloat32(0.0f);
+				break;
+
+			default:
+				proxy.m_extent = (shape->GetObbSize() * scale) & ndVector::m_triplexMask;
+				proxy.m_radius = ndFloat32(0.0f);
+				proxy.m_matrix.m_posit += proxy.m_matrix.RotateVector(shape->GetObbOrigin() * scale);
+				break;
+		}
+		proxy.m_matrix.m_posit.m_w = ndFloat32(1.0f);
+
+		instance.CalculateAabb(instance.GetLocalMatrix() * body->GetMatrix(), proxy.m_boxP0, proxy.m_boxP1);
+		proxy.m_boxP0 = (proxy.m_boxP0 - radius) & ndVector::m_triplexMask;
+		proxy.m_boxP1 = (proxy.m_boxP1 + radius) & ndVector::m_triplexMask;
+		proxy.m_veloc = body->GetVelocity() & ndVector::m_triplexMask;
+		proxy.m_omega = body->GetOmega() & ndVector::m_triplexMask;
+		proxy.m_com = body->GetGlobalGetCentreOfMass() & ndVector::m_triplexMask;
+		proxy.m_body = body;
+		data.m_couplingProxies.PushBack(proxy);
+	}
+}
+
+void ndBodySphFluid::CalculateRigidCoupling(ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	ndWorkingBuffers& data = *m_workingBuffers;
+	const ndInt32 proxyCount = ndInt32(data.m_couplingProxies.GetCount());
+	const ndInt32 threadCount = threadPool->GetThreadCount();
+
+	m_coupledCount = 0;
+	if (!proxyCount)
+	{
+		return;
+	}
+
+	data.m_couplingReactions.SetCount(2 * proxyCount * threadCount);
+	ndInt32 coupledCount[D_MAX_THREADS_COUNT];
+	auto CalculateCoupling = ndMakeObject::ndFunction([this, &data, &coupledCount, proxyCount](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CalculateCoupling);
+		const ndVector* const posit = &m_posit[0];
+		const ndVector* const veloc = &m_veloc[0];
+		const ndWorkingBuffers::ndCellEntry* const entries = &data.m_cellEntries[0];
+		const ndInt32* const cellStart = &data.m_cellStart[0];
+		const ndVector particleRadius(GetParticleRadius());
+		const ndVector stiffness(m_couplingStiffness);
+		const ndVector damping(m_couplingDamping);
+		const ndVector mass(m_mass);
+		const ndVector laneIndex(ndFloat32(0.0f), ndFloat32(1.0f), ndFloat32(2.0f), ndFloat32(3.0f));
+
+		ndVector* const reactions = &data.m_couplingReactions[2 * proxyCount * threadIndex];
+		for (ndInt32 i = 0; i < 2 * proxyCount; ++i)
+		{
+			reactions[i] = ndVector::m_zero;
+		}
+
+		ndInt32 count = 0;
+		const ndStartEnd startEnd(ndInt32(data.m_cellKeys.GetCount()), threadIndex, threadCount);
+		for (ndInt32 cell = startEnd.m_start; cell < startEnd.m_end; ++cell)
+		{
+			const ndInt32 start = cellStart[cell];
+			const ndInt32 end = cellStart[cell + 1];
+			ndVector cellP0(ndFloat32(1.0e10f));
+			ndVector cellP1(ndFloat32(-1.0e10f));
+			for (ndInt32 i = start; i < end; ++i)
+			{
+				cellP0 = cellP0.GetMin(posit[entries[i].m_index]);
+				cellP1 = cellP1.GetMax(posit[entries[i].m_index]);
+			}
+
+			for (ndInt32 j = 0; j < proxyCount; ++j)
+			{
+				const ndWorkingBuffers::ndCouplingProxy& proxy = data.m_couplingProxies[j];
+				const ndVector overlap((cellP1 >= proxy.m_boxP0) & (proxy.m_boxP1 >= cellP0));
+				if ((overlap.GetSignMask() & 7) != 7)
+				{
+					continue;
+				}
+
+				// signed distance to the rounded box, four particles at a time in soa form
+				const ndMatrix& matrix = proxy.m_matrix;
+				const ndVector extentX(proxy.m_extent.m_x);
+				const ndVector extentY(proxy.m_extent.m_y);
+				const ndVector extentZ(proxy.m_extent.m_z);
+				const ndVector contactDist(particleRadius + ndVector(proxy.m_radius));
+				for (ndInt32 base = start; base < end; base += 4)
+				{
+					ndInt32 index[4];
+					ndVector p[4];
+					ndVector v[4];
+					for (ndInt32 k = 0; k < 4; ++k)
+					{
+						index[k] = entries[ndMin(base + k, end - 1)].m_index;
+						p[k] = posit[index[k]];
+						v[k] = veloc[index[k]];
+					}
+					const ndVector valid(laneIndex < ndVector((ndFloat32)(end - base)));
+
+					ndVector px;
+					ndVector py;
+					ndVector pz;
+					ndVector pw;
+					ndVector::Transpose4x4(px, py, pz, pw, p[0], p[1], p[2], p[3]);
+
+					const ndVector dx(px - ndVector(matrix.m_posit.m_x));
+					const ndVector dy(py - ndVector(matrix.m_posit.m_y));
+					const ndVector dz(pz - ndVector(matrix.m_posit.m_z));
+					const ndVector lx(dx * ndVector(matrix.m_front.m_x) + dy * ndVector(matrix.m_front.m_y) + dz * ndVector(matrix.m_front.m_z));
+					const ndVector ly(dx * ndVector(matrix.m_up.m_x) + dy * ndVector(matrix.m_up.m_y) + dz * ndVector(matrix.m_up.m_z));
+					const ndVector lz(dx * ndVector(matrix.m_right.m_x) + dy * ndVector(matrix.m_right.m_y) + dz * ndVector(matrix.m_right.m_z));
+
+					const ndVector qx(lx.Abs() - extentX);
+					const ndVector qy(ly.Abs() - extentY);
+					const ndVector qz(lz.Abs() - extentZ);
+					const ndVector ox(qx.GetMax(ndVector::m_zero));
+					const ndVector oy(qy.GetMax(ndVector::m_zero));
+					const ndVector oz(qz.GetMax(ndVector::m_zero));
+					const ndVector outside2(ox * ox + oy * oy + oz * oz);
+					const ndVector outsideDist(outside2.Sqrt());
+					const ndVector insideDist(qx.GetMax(qy).GetMax(qz).GetMin(ndVector::m_zero));
+					const ndVector dist(outsideDist + insideDist);
+
+					const ndVector contact(valid & (dist < contactDist));
+					const ndInt32 contactMask = contact.GetSignMask();
+					if (!contactMask)
+					{
+						continue;
+					}
+
+					// local normal, the gradient of the distance field
+					const ndVector isOutside(outside2 > ndVector(ndFloat32(1.0e-12f)));
+					const ndVector invOutside(outside2.GetMax(ndVector(ndFloat32(1.0e-12f))).InvSqrt());
+					const ndVector maxX((qx >= qy) & (qx >= qz));
+					const ndVector maxY((qy >= qz).AndNot(maxX));
+					const ndVector maxZ(ndVector::m_negOne.AndNot(maxX | maxY));
+					const ndVector inside(ndVector::m_negOne.AndNot(isOutside));
+					const ndVector magX((ox * invOutside).Select(ndVector::m_one & maxX, inside));
+					const ndVector magY((oy * invOutside).Select(ndVector::m_one & maxY, inside));
+					const ndVector magZ((oz * invOutside).Select(ndVector::m_one & maxZ, inside));
+					const ndVector nx(magX | lx.AndNot(ndVector::m_signMask));
+					const ndVector ny(magY | ly.AndNot(ndVector::m_signMask));
+					const ndVector nz(magZ | lz.AndNot(ndVector::m_signMask));
+
+					const ndVector wx(nx * ndVector(matrix.m_front.m_x) + ny * ndVector(matrix.m_up.m_x) + nz * ndVector(matrix.m_right.m_x));
+					const ndVector wy(nx * ndVector(matrix.m_front.m_y) + ny * ndVector(matrix.m_up.m_y) + nz * ndVector(matrix.m_right.m_y));
+					const ndVector wz(nx * ndVector(matrix.m_front.m_z) + ny * ndVector(matrix.m_up.m_z) + nz * ndVector(matrix.m_right.m_z));
+					const ndVector penetration(contactDist - dist);
+
+					for (ndInt32 k = 0; k < 4; ++k)
+					{
+						if (!(contactMask & (1 << k)))
+						{
+							continue;
+						}
+						const ndVector n(wx[k], wy[k], wz[k], ndFloat32(0.0f));
+						const ndVector r(p[k] - proxy.m_com);
+						const ndVector bodyVeloc(proxy.m_veloc + proxy.m_omega.CrossProduct(r));
+						const ndVector relVeloc((v[k] - bodyVeloc).DotProduct(n));
+						const ndVector accelMag((stiffness * ndVector(penetration[k]) - damping * relVeloc).GetMax(ndVector::m_zero));
+						const ndVector accel(n * accelMag);
+						data.m_accel[index[k]] += accel;
+
+						const ndVector reaction(accel * mass * ndVector::m_negOne);
+						reactions[j * 2 + 0] += reaction;
+						reactions[j * 2 + 1] += r.CrossProduct(reaction);
+						count++;
+					}
+				}
+			}
+		}
+		coupledCount[threadIndex] = count;
+	});
+	threadPool->ParallelExecute(CalculateCoupling);
+
+	// sum the reactions of all threads, in thread order so that the result is deterministic
+	for (ndInt32 j = 0; j < proxyCount; ++j)
+	{
+		ndVector force(ndVector::m_zero);
+		ndVector torque(ndVector::m_zero);
+		for (ndInt32 i = 0; i < threadCount; ++i)
+		{
+			force += data.m_couplingReactions[2 * (proxyCount * i + j) + 0];
+			torque += data.m_couplingReactions[2 * (proxyCount * i + j) + 1];
+		}
+		data.m_couplingReactions[2 * j + 0] = force;
+		data.m_couplingReactions[2 * j + 1] = torque;
+	}
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		m_coupledCount += coupledCount[i];
+	}
+}
+
+void ndBodySphFluid::ApplyCouplingReactions()
+{
+	ndWorkingBuffers& data = *m_workingBuffers;
+	if (m_coupledCount)
+	{
+		D_TRACKTIME();
+		for (ndInt32 i = 0; i < ndInt32(data.m_couplingProxies.GetCount()); ++i)
+		{
+			ndBodyKinematic* const body = data.m_couplingProxies[i].m_body;
+			const ndVector& force = data.m_couplingReactions[2 * i + 0];
+			const ndVector& torque = data.m_couplingReactions[2 * i + 1];
+			if ((body->GetInvMass() > ndFloat32(0.0f)) && (force.DotProduct(force).GetScalar() > ndFloat32(0.0f)))
+			{
+				body->SetSleepState(false);
+				body->ApplyImpulsePair(force.Scale(m_timestep), torque.Scale(m_timestep), m_timestep);
+			}
+		}
+	}
+	data.m_couplingProxies.SetCount(0);
+}
+
 bool ndBodySphFluid::TraceHashes() const
 {
 #if 0
@@ -2351,10 +3039,16 @@ void ndBodySphFluid::Update(const ndScene* const scene, ndFloat32 timestep)
 		if (m_posit.GetCount())
 		{
 			m_timestep = timestep;
+			if (m_rigidCoupling)
+			{
+				ApplyCouplingReactions();
+				GatherCouplingBodies(scene);
+			}
 			((ndScene*)scene)->SendBackgroundTask(this);
 			if (!m_updateInBackground)
 			{
 				Sync();
+				ApplyCouplingReactions();
 			}
 		}
 	}
@@ -2366,12 +3060,24 @@ void ndBodySphFluid::Execute(ndThreadPool* const threadPool)
 	ndAssert(sizeof(ndGridHash) == sizeof(ndUnsigned64));
 
 	CaculateAabb(threadPool);
-	CreateGrids(threadPool);
-	SortGrids(threadPool);
-	CalculateScans(threadPool);
-	BuildBuckets(threadPool);
+	if (m_persistentCells)
+	{
+		UpdatePersistentCells(threadPool);
+		BuildPersistentPairs(threadPool);
+	}
+	else
+	{
+		CreateGrids(threadPool);
+		SortGrids(threadPool);
+		CalculateScans(threadPool);
+		BuildBuckets(threadPool);
+	}
 	CalculateParticlesDensity(threadPool);
 	CalculateAccelerations(threadPool);
+	if (m_rigidCoupling)
+	{
+		CalculateRigidCoupling(threadPool);
+	}
 	IntegrateParticles(threadPool);
 }
 
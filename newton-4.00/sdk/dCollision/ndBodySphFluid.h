@@ -47,6 +47,24 @@ class ndBodySphFluid: public ndBodyParticleSet
 	ndFloat32 GetGasConstant() const;
 	void SetGasConstant(ndFloat32 gasConst);
 
+	// persistent cell lists: every reorderFrames updates the particle arrays are
+	// sorted in morton order of their grid cell, in between only the particles
+	// that moved to a different cell are re-binned.
+	// note: this permutes the position and velocity arrays.
+	D_COLLISION_API void SetPersistentCells(bool state, ndInt32 reorderFrames = 16);
+	bool GetPersistentCells() const;
+	ndInt32 GetReorderFrames() const;
+	ndInt32 GetRebinnedParticleCount() const;
+
+	// two way coupling with the rigid bodies of the scene: particles closer than
+	// their radius to a convex shape are pushed out with a spring damper, and the
+	// reaction forces are applied to the bodies. the coupling is done per cell
+	// of the persistent cell lists, enabling it also enables persistent cells.
+	// stiffness and damping are per unit of particle mass.
+	D_COLLISION_API void SetRigidCoupling(bool state, ndFloat32 stiffness = ndFloat32(2000.0f), ndFloat32 damping = ndFloat32(20.0f));
+	bool GetRigidCoupling() const;
+	ndInt32 GetCoupledParticleCount() const;
+
 	virtual ndBodySphFluid* GetAsBodySphFluid();
 	D_COLLISION_API void Execute(ndThreadPool* const threadPool);
 
@@ -70,6 +88,12 @@ class ndBodySphFluid: public ndBodyParticleSet
 	void IntegrateParticles(ndThreadPool* const threadPool);
 	void CalculateAccelerations(ndThreadPool* const threadPool);
 	void CalculateParticlesDensity(ndThreadPool* const threadPool);
+	void ReorderParticles(ndThreadPool* const threadPool);
+	void UpdatePersistentCells(ndThreadPool* const threadPool);
+	void BuildPersistentPairs(ndThreadPool* const threadPool);
+	void GatherCouplingBodies(const ndScene* const scene);
+	void CalculateRigidCoupling(ndThreadPool* const threadPool);
+	void ApplyCouplingReactions();
 
 	bool TraceHashes() const;
 
@@ -78,7 +102,13 @@ class ndBodySphFluid: public ndBodyParticleSet
 	ndFloat32 m_viscosity;
 	ndFloat32 m_restDensity;
 	ndFloat32 m_gasConstant;
-	
+	ndFloat32 m_couplingStiffness;
+	ndFloat32 m_couplingDamping;
+	ndInt32 m_reorderFrames;
+	ndInt32 m_rebinnedCount;
+	ndInt32 m_coupledCount;
+	bool m_persistentCells;
+	bool m_rigidCoupling;
 } D_GCC_NEWTON_ALIGN_32 ;
 
 inline bool ndBodySphFluid::RayCast(ndRayCastNotify&, const ndFastRay&, const ndFloat32) const
@@ -91,6 +121,31 @@ inline ndBodySphFluid* ndBodySphFluid::GetAsBodySphFluid()
 	return this; 
 }
 
+inline bool ndBodySphFluid::GetPersistentCells() const
+{
+	return m_persistentCells;
+}
+
+inline ndInt32 ndBodySphFluid::GetReorderFrames() const
+{
+	return m_reorderFrames;
+}
+
+inline ndInt32 ndBodySphFluid::GetRebinnedParticleCount() const
+{
+	return m_rebinnedCount;
+}
+
+inline bool ndBodySphFluid::GetRigidCoupling() const
+{
+	return m_rigidCoupling;
+}
+
+inline ndInt32 ndBodySphFluid::GetCoupledParticleCount() const
+{
+	return m_coupledCount;
+}
+
 inline ndFloat32 ndBodySphFluid::GetViscosity() const
 {
 	return m_viscosity;
@@ -56,6 +56,9 @@ class ndBvhNode : public ndContainersFreeListAlloc<ndBvhNode>
 	ndBvhNode* m_parent;
 	ndSpinLock m_lock;
 	ndInt32 m_depthLevel;
+	// union of the collision layers of all bodies in the subtree
+	ndUnsigned32 m_layerCategory;
+	ndUnsigned32 m_layerMask;
 	ndUnsigned8 m_isDead;
 	ndUnsigned8 m_bhvLinked;
 #ifdef _DEBUG
@@ -207,6 +210,8 @@ inline ndBvhNode::ndBvhNode(ndBvhNode* const parent)
 	,m_parent(parent)
 	,m_lock()
 	,m_depthLevel(0)
+	,m_layerCategory(~ndUnsigned32(0))
+	,m_layerMask(~ndUnsigned32(0))
 	,m_isDead(0)
 	,m_bhvLinked(0)
 {
@@ -222,6 +227,8 @@ inline ndBvhNode::ndBvhNode(const ndBvhNode& src)
 	,m_parent(nullptr)
 	,m_lock()
 	,m_depthLevel(0)
+	,m_layerCategory(~ndUnsigned32(0))
+	,m_layerMask(~ndUnsigned32(0))
 	,m_isDead(0)
 	,m_bhvLinked(0)
 {
@@ -44,6 +44,7 @@
 #include <ndShapeSphere.h>
 #include <ndShapeConvex.h>
 #include <ndBodyListView.h>
+#include <ndFractureAsset.h>
 #include <ndContactArray.h>
 #include <ndBodySphFluid.h>
 #include <ndBodySphFluid_New.h>
@@ -51,6 +51,8 @@ ndContact::ndContact()
 	,m_skeletonSelftCollision(1)
 {
 	m_active = 0;
+	m_supportVertexCache[0] = 0;
+	m_supportVertexCache[1] = 0;
 }
 
 ndContact::~ndContact()
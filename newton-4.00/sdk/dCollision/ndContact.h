@@ -131,6 +131,9 @@ class ndContact: public ndConstraint
 	ndFloat32 m_timeOfImpact;
 	ndFloat32 m_separationDistance;
 	ndUnsigned32 m_sceneLru;
+	// hill climbing start vertices of the two shapes, a compound shares them
+	// across all its subshape pairs, so there they are only a rough hint
+	ndInt32 m_supportVertexCache[2];
 	ndUnsigned32 m_isDead : 1;
 	ndUnsigned32 m_inTrigger : 1;
 	ndUnsigned32 m_isAttached : 1;
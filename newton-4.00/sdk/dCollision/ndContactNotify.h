@@ -46,6 +46,32 @@ class ndMaterial : public ndContainersFreeListAlloc<ndMaterial>
 	ndUnsigned32 m_userFlags;
 };
 
+// dense table of materials indexed by the pair of shape material ids.
+// an empty entry, or an entry marked for override, falls back to the
+// virtual GetMaterial call.
+class ndMaterialPairTable
+{
+	public:
+	class ndEntry
+	{
+		public:
+		ndMaterial* m_material;
+		bool m_override;
+	};
+
+	ndMaterialPairTable();
+
+	ndInt32 GetCount() const;
+	void SetCount(ndInt32 materialIdCount);
+	const ndEntry* Find(ndInt64 id0, ndInt64 id1) const;
+	void SetMaterial(ndInt32 id0, ndInt32 id1, ndMaterial* const material);
+	void SetOverride(ndInt32 id0, ndInt32 id1, bool state);
+
+	private:
+	ndArray<ndEntry> m_entries;
+	ndInt32 m_count;
+};
+
 D_MSV_NEWTON_ALIGN_32
 class ndContactNotify: public ndClassAlloc
 {
@@ -54,6 +80,10 @@ class ndContactNotify: public ndClassAlloc
 	virtual ~ndContactNotify();
 	virtual ndMaterial* GetMaterial(const ndContact* const, const ndShapeInstance&, const ndShapeInstance&) const;
 
+	// table lookup first, the virtual GetMaterial is only called for pairs not in the table
+	D_COLLISION_API ndMaterial* FindMaterial(const ndContact* const contact, const ndShapeInstance& instance0, const ndShapeInstance& instance1) const;
+	ndMaterialPairTable& GetMaterialPairTable();
+
 	protected:
 	virtual void OnBodyAdded(ndBodyKinematic* const) const;
 	virtual void OnBodyRemoved(ndBodyKinematic* const) const;
@@ -62,6 +92,7 @@ class ndContactNotify: public ndClassAlloc
 	virtual bool OnCompoundSubShapeOverlap(const ndContact* const contact, ndFloat32 timestep, const ndShapeInstance* const subShapeA, const ndShapeInstance* const subShapeB) const;
 	
 	ndMaterial m_default;
+	ndMaterialPairTable m_materialPairTable;
 
 	private:
 	ndScene* m_scene;
@@ -84,8 +115,74 @@ inline ndMaterial::ndMaterial()
 	m_userFlags = 0;
 }
 
+inline ndMaterialPairTable::ndMaterialPairTable()
+	:m_entries()
+	,m_count(0)
+{
+}
+
+inline ndInt32 ndMaterialPairTable::GetCount() const
+{
+	return m_count;
+}
+
+inline void ndMaterialPairTable::SetCount(ndInt32 materialIdCount)
+{
+	ndArray<ndEntry> entries;
+	entries.SetCount(materialIdCount * materialIdCount);
+	for (ndInt32 i = 0; i < materialIdCount; ++i)
+	{
+		for (ndInt32 j = 0; j < materialIdCount; ++j)
+		{
+			ndEntry& entry = entries[i * materialIdCount + j];
+			if ((i < m_count) && (j < m_count))
+			{
+				entry = m_entries[i * m_count + j];
+			}
+			else
+			{
+				entry.m_material = nullptr;
+				entry.m_override = false;
+			}
+		}
+	}
+	m_entries.Swap(entries);
+	m_count = materialIdCount;
+}
+
+inline const ndMaterialPairTable::ndEntry* ndMaterialPairTable::Find(ndInt64 id0, ndInt64 id1) const
+{
+	if ((ndUnsigned64(id0) < ndUnsigned64(m_count)) && (ndUnsigned64(id1) < ndUnsigned64(m_count)))
+	{
+		return &m_entries[id0 * m_count + id1];
+	}
+	return nullptr;
+}
+
+inline void ndMaterialPairTable::SetMaterial(ndInt32 id0, ndInt32 id1, ndMaterial* const material)
+{
+	if ((id0 >= m_count) || (id1 >= m_count))
+	{
+		SetCount(ndMax(id0, id1) + 1);
+	}
+	m_entries[id0 * m_count + id1].m_material = material;
+	m_entries[id1 * m_count + id0].m_material = material;
+}
+
+inline void ndMaterialPairTable::SetOverride(ndInt32 id0, ndInt32 id1, bool state)
+{
+	if ((id0 >= m_count) || (id1 >= m_count))
+	{
+		SetCount(ndMax(id0, id1) + 1);
+	}
+	m_entries[id0 * m_count + id1].m_override = state;
+	m_entries[id1 * m_count + id0].m_override = state;
+}
+
 inline ndContactNotify::ndContactNotify(ndScene* const scene)
 	:ndClassAlloc()
+	,m_default()
+	,m_materialPairTable()
 	,m_scene(scene)
 {
 }
@@ -99,6 +196,11 @@ inline ndMaterial* ndContactNotify::GetMaterial(const ndContact* const, const nd
 	return (ndMaterial*)&m_default;
 }
 
+inline ndMaterialPairTable& ndContactNotify::GetMaterialPairTable()
+{
+	return m_materialPairTable;
+}
+
 inline void ndContactNotify::OnBodyAdded(ndBodyKinematic* const) const
 {
 }
@@ -438,8 +438,19 @@ void ndContactSolver::SupportVertex(const ndVector& dir0, ndInt32 vertexIndex)
 	
 	const ndMatrix& matrix0 = m_instance0.m_globalMatrix;
 	const ndMatrix& matrix1 = m_instance1.m_globalMatrix;
-	ndVector p(matrix0.TransformVector(m_instance0.SupportVertexSpecial(matrix0.UnrotateVector (dir0))) & ndVector::m_triplexMask);
-	ndVector q(matrix1.TransformVector(m_instance1.SupportVertexSpecial(matrix1.UnrotateVector (dir1))) & ndVector::m_triplexMask);
+	ndVector p;
+	ndVector q;
+	if (m_contact)
+	{
+		// warm start from the support vertices of the last query on this pair
+		p = matrix0.TransformVector(m_instance0.SupportVertexSpecial(matrix0.UnrotateVector(dir0), &m_contact->m_supportVertexCache[0])) & ndVector::m_triplexMask;
+		q = matrix1.TransformVector(m_instance1.SupportVertexSpecial(matrix1.UnrotateVector(dir1), &m_contact->m_supportVertexCache[1])) & ndVector::m_triplexMask;
+	}
+	else
+	{
+		p = matrix0.TransformVector(m_instance0.SupportVertexSpecial(matrix0.UnrotateVector(dir0))) & ndVector::m_triplexMask;
+		q = matrix1.TransformVector(m_instance1.SupportVertexSpecial(matrix1.UnrotateVector(dir1))) & ndVector::m_triplexMask;
+	}
 	m_hullDiff[vertexIndex] = p - q;
 	m_hullSum[vertexIndex] = p + q;
 }
@@ -2631,7 +2642,9 @@ ndInt32 ndContactSolver::CompoundContactsDiscrete()
 		}
 		else if (m_instance1.GetShape()->GetAsShapeStaticBVH())
 		{
-			return CompoundToShapeStaticBvhContactsDiscrete();
+			// a compressed bvh has no binary nodes, the generic mesh path queries it by sector
+			const ndShapeStatic_bvh* const bvh = m_instance1.GetShape()->GetAsShapeStaticBVH();
+			return bvh->GetRootNode() ? CompoundToShapeStaticBvhContactsDiscrete() : CompoundToStaticProceduralMesh();
 		}
 		else if (m_instance1.GetShape()->GetAsShapeHeightfield())
 		{
@@ -0,0 +1,793 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndCollisionStdafx.h"
+#include "ndMeshEffect.h"
+#include "ndConvexHull3d.h"
+#include "ndShapeInstance.h"
+#include "ndFractureAsset.h"
+#include "ndShapeConvexHull.h"
+
+#define D_FRACTURE_ASSET_FILE_ID		"ndFrac01"
+
+// the element sizes reject files written by a build with a different layout.
+class ndFractureAssetFileHeader
+{
+	public:
+	char m_id[8];
+	ndInt32 m_pieceSize;
+	ndInt32 m_vertexSize;
+	ndInt32 m_pieceCount;
+	ndInt32 m_hullPointCount;
+	ndInt32 m_vertexCount;
+	ndInt32 m_indexCount;
+	ndInt32 m_neighborCount;
+	ndInt32 m_padding;
+};
+
+// convex cell of one fracture piece, the faces are convex polygons
+// tagged with the site that cut them, or -1 for the outer surface.
+class ndFracturePolytope: public ndClassAlloc
+{
+	public:
+	class ndFace
+	{
+		public:
+		ndInt32 m_start;
+		ndInt32 m_count;
+		ndInt32 m_neighbor;
+	};
+
+	class ndSortKey
+	{
+		public:
+		ndFloat64 m_dist2;
+		ndInt32 m_site;
+	};
+
+	ndFracturePolytope()
+		:ndClassAlloc()
+		,m_points()
+		,m_faces()
+	{
+	}
+
+	ndFracturePolytope(const ndFracturePolytope& src)
+		:ndClassAlloc()
+		,m_points(src.m_points)
+		,m_faces(src.m_faces)
+	{
+	}
+
+	ndFloat64 CalculateRadius2(const ndBigVector& origin) const
+	{
+		ndFloat64 radius2 = ndFloat64(0.0f);
+		for (ndInt32 i = 0; i < ndInt32(m_points.GetCount()); ++i)
+		{
+			const ndBigVector dist(m_points[i] - origin);
+			radius2 = ndMax(radius2, dist.DotProduct(dist).GetScalar());
+		}
+		return radius2;
+	}
+
+	// keep the part on the back side of the plane, and close the cut with a
+	// new face tagged with neighbor. returns false if the plane misses the cell.
+	bool Clip(const ndBigPlane& plane, ndInt32 neighbor, ndFloat64 tolerance)
+	{
+		ndArray<ndFloat64> dist;
+		dist.SetCount(m_points.GetCount());
+		bool front = false;
+		bool back = false;
+		for (ndInt32 i = 0; i < ndInt32(m_points.GetCount()); ++i)
+		{
+			ndFloat64 side = plane.Evalue(m_points[i]);
+			side = (ndAbs(side) < tolerance) ? ndFloat64(0.0f) : side;
+			front = front || (side > ndFloat64(0.0f));
+			back = back || (side < ndFloat64(0.0f));
+			dist[i] = side;
+		}
+		if (!front)
+		{
+			return false;
+		}
+		if (!back)
+		{
+			m_points.SetCount(0);
+			m_faces.SetCount(0);
+			return true;
+		}
+
+		ndArray<ndBigVector> points;
+		ndArray<ndFace> faces;
+		ndArray<ndBigVector> capPoints;
+		for (ndInt32 i = 0; i < ndInt32(m_faces.GetCount()); ++i)
+		{
+			const ndFace& face = m_faces[i];
+			ndFace newFace;
+			newFace.m_start = ndInt32(points.GetCount());
+			newFace.m_neighbor = face.m_neighbor;
+			ndInt32 i0 = face.m_start + face.m_count - 1;
+			for (ndInt32 j = 0; j < face.m_count; ++j)
+			{
+				const ndInt32 i1 = face.m_start + j;
+				const ndFloat64 d0 = dist[i0];
+				const ndFloat64 d1 = dist[i1];
+				if (((d0 < ndFloat64(0.0f)) && (d1 > ndFloat64(0.0f))) || ((d0 > ndFloat64(0.0f)) && (d1 < ndFloat64(0.0f))))
+				{
+					const ndBigVector p(m_points[i0] + (m_points[i1] - m_points[i0]).Scale(d0 / (d0 - d1)));
+					points.PushBack(p);
+					capPoints.PushBack(p);
+				}
+				if (d1 <= ndFloat64(0.0f))
+				{
+					points.PushBack(m_points[i1]);
+					if (d1 == ndFloat64(0.0f))
+					{
+						capPoints.PushBack(m_points[i1]);
+					}
+				}
+				i0 = i1;
+			}
+			newFace.m_count = ndInt32(points.GetCount()) - newFace.m_start;
+			if (newFace.m_count >= 3)
+			{
+				faces.PushBack(newFace);
+			}
+			else
+			{
+				points.SetCount(newFace.m_start);
+			}
+		}
+
+		// the cap polygon is the convex set of the points on the plane
+		ndInt32 capCount = 0;
+		for (ndInt32 i = 0; i < ndInt32(capPoints.GetCount()); ++i)
+		{
+			bool duplicated = false;
+			for (ndInt32 j = 0; !duplicated && (j < capCount); ++j)
+			{
+				const ndBigVector step(capPoints[j] - capPoints[i]);
+				duplicated = step.DotProduct(step).GetScalar() < tolerance * tolerance;
+			}
+			if (!duplicated)
+			{
+				capPoints[capCount] = capPoints[i];
+				capCount++;
+			}
+		}
+
+		if (capCount >= 3)
+		{
+			const ndBigVector normal(plane & ndBigVector::m_triplexMask);
+			ndBigVector origin(ndBigVector::m_zero);
+			for (ndInt32 i = 0; i < capCount; ++i)
+			{
+				origin += capPoints[i];
+			}
+			origin = origin.Scale(ndFloat64(1.0f) / ndFloat64(capCount));
+			const ndBigVector uDir(capPoints[0] - origin);
+			const ndBigVector vDir(normal.CrossProduct(uDir));
+
+			// counter clockwise around the outward normal
+			ndArray<ndFloat64> angles;
+			angles.SetCount(capCount);
+			for (ndInt32 i = 0; i < capCount; ++i)
+			{
+				const ndBigVector step(capPoints[i] - origin);
+				angles[i] = atan2(vDir.DotProduct(step).GetScalar(), uDir.DotProduct(step).GetScalar());
+			}
+			for (ndInt32 i = 1; i < capCount; ++i)
+			{
+				const ndFloat64 angle = angles[i];
+				const ndBigVector point(capPoints[i]);
+				ndInt32 j = i - 1;
+				for (; (j >= 0) && (angles[j] > angle); --j)
+				{
+					angles[j + 1] = angles[j];
+					capPoints[j + 1] = capPoints[j];
+				}
+				angles[j + 1] = angle;
+				capPoints[j + 1] = point;
+			}
+
+			ndFace capFace;
+			capFace.m_start = ndInt32(points.GetCount());
+			capFace.m_count = capCount;
+			capFace.m_neighbor = neighbor;
+			faces.PushBack(capFace);
+			for (ndInt32 i = 0; i < capCount; ++i)
+			{
+				points.PushBack(capPoints[i]);
+			}
+		}
+
+		m_points.Swap(points);
+		m_faces.Swap(faces);
+		if (m_faces.GetCount() < 4)
+		{
+			m_points.SetCount(0);
+			m_faces.SetCount(0);
+		}
+		return true;
+	}
+
+	ndArray<ndBigVector> m_points;
+	ndArray<ndFace> m_faces;
+};
+
+// one read per section, each section goes directly to its array.
+// the section must fit in what is left of the file before it is allocated
+template <class T>
+static bool ndReadSection(FILE* const file, ndArray<T>& array, ndInt32 count, ndInt64 fileSize)
+{
+	if (count < 0)
+	{
+		return false;
+	}
+	const ndInt64 position = ndInt64(ftell(file));
+	if ((position < 0) || (ndInt64(count) * ndInt64(sizeof(T)) > fileSize - position))
+	{
+		return false;
+	}
+	array.SetCount(count);
+	return !count || (fread(&array[0], sizeof(T), size_t(count), file) == size_t(count));
+}
+
+template <class T>
+static bool ndWriteSection(FILE* const file, const ndArray<T>& array)
+{
+	const size_t count = size_t(array.GetCount());
+	return !count || (fwrite(&array[0], sizeof(T), count, file) == count);
+}
+
+static ndInt64 ndFileSize(FILE* const file)
+{
+	if (fseek(file, 0, SEEK_END))
+	{
+		return -1;
+	}
+	const ndInt64 size = ndInt64(ftell(file));
+	return fseek(file, 0, SEEK_SET) ? -1 : size;
+}
+
+// true if [start, start + count) is inside a section of size bound
+static bool ndValidRange(ndInt64 start, ndInt64 count, ndInt64 bound)
+{
+	return (start >= 0) && (count >= 0) && (start + count <= bound);
+}
+
+ndFractureAsset::ndFractureAsset()
+	:ndClassAlloc()
+	,m_pieces()
+	,m_hullPoints()
+	,m_vertices()
+	,m_indices()
+	,m_neighbors()
+	,m_shapes()
+{
+}
+
+ndFractureAsset::~ndFractureAsset()
+{
+	ReleaseShapes();
+}
+
+void ndFractureAsset::ReleaseShapes()
+{
+	for (ndInt32 i = 0; i < ndInt32(m_shapes.GetCount()); ++i)
+	{
+		if (m_shapes[i])
+		{
+			m_shapes[i]->Release();
+		}
+	}
+	m_shapes.SetCount(0);
+}
+
+void ndFractureAsset::RemoveAll()
+{
+	ReleaseShapes();
+	m_pieces.SetCount(0);
+	m_hullPoints.SetCount(0);
+	m_vertices.SetCount(0);
+	m_indices.SetCount(0);
+	m_neighbors.SetCount(0);
+}
+
+ndShapeInstance* ndFractureAsset::CreatePieceInstance(ndInt32 index) const
+{
+	return new ndShapeInstance(m_shapes[index]);
+}
+
+bool ndFractureAsset::Build(const ndDesc& desc)
+{
+	D_TRACKTIME();
+	RemoveAll();
+	ndAssert(desc.m_outerShape);
+
+	// the initial cell is the convex hull of the outer shape
+	const ndMeshEffect outerMesh(*desc.m_outerShape);
+	if (outerMesh.GetVertexCount() < 4)
+	{
+		return false;
+	}
+	const ndConvexHull3d outerHull(outerMesh.GetVertexPool(), outerMesh.GetVertexStrideInByte(), outerMesh.GetVertexCount(), ndFloat64(0.0f));
+	if (!outerHull.GetCount())
+	{
+		return false;
+	}
+
+	ndFracturePolytope outerCell;
+	const ndArray<ndBigVector>& outerPoints = outerHull.GetVertexPool();
+	for (ndConvexHull3d::ndNode* node = outerHull.GetFirst(); node; node = node->GetNext())
+	{
+		const ndConvexHull3dFace& face = node->GetInfo();
+		ndFracturePolytope::ndFace cellFace;
+		cellFace.m_start = ndInt32(outerCell.m_points.GetCount());
+		cellFace.m_count = 3;
+		cellFace.m_neighbor = -1;
+		outerCell.m_faces.PushBack(cellFace);
+		outerCell.m_points.PushBack(outerPoints[face.m_index[0]]);
+		outerCell.m_points.PushBack(outerPoints[face.m_index[1]]);
+		outerCell.m_points.PushBack(outerPoints[face.m_index[2]]);
+	}
+
+	const ndInt32 siteCount = ndInt32(desc.m_pointCloud.GetCount());
+	ndArray<ndBigVector> sites;
+	sites.SetCount(siteCount);
+	for (ndInt32 i = 0; i < siteCount; ++i)
+	{
+		sites[i] = ndBigVector(desc.m_pointCloud[i] & ndVector::m_triplexMask);
+	}
+
+	ndArray<ndFracturePolytope*> cells;
+	cells.SetCount(siteCount);
+	const ndFloat64 tolerance = outerHull.GetDiagonal() * ndFloat64(1.0e-7f);
+
+	// every cell is the outer hull clipped by the bisector planes of the closer
+	// sites, the cells are independent so they are built in parallel.
+	ndAtomic<ndInt32> iterator(0);
+	auto BuildCells = ndMakeObject::ndFunction([&sites, &cells, &outerCell, &iterator, siteCount, tolerance](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(BuildCells);
+		class ndCompareKey
+		{
+			public:
+			ndCompareKey(void* const)
+			{
+			}
+
+			ndInt32 Compare(const ndFracturePolytope::ndSortKey& keyA, const ndFracturePolytope::ndSortKey& keyB) const
+			{
+				if (keyA.m_dist2 < keyB.m_dist2)
+				{
+					return -1;
+				}
+				else if (keyA.m_dist2 > keyB.m_dist2)
+				{
+					return 1;
+				}
+				return keyA.m_site - keyB.m_site;
+			}
+		};
+
+		ndArray<ndFracturePolytope::ndSortKey> order;
+		order.SetCount(siteCount);
+		for (ndInt32 i = iterator++; i < siteCount; i = iterator++)
+		{
+			const ndBigVector& site = sites[i];
+			for (ndInt32 j = 0; j < siteCount; ++j)
+			{
+				const ndBigVector dist(sites[j] - site);
+				order[j].m_dist2 = dist.DotProduct(dist).GetScalar();
+				order[j].m_site = j;
+			}
+			ndSort<ndFracturePolytope::ndSortKey, ndCompareKey>(&order[0], siteCount, nullptr);
+
+			ndFracturePolytope* cell = new ndFracturePolytope(outerCell);
+			ndFloat64 radius2 = cell->CalculateRadius2(site);
+			for (ndInt32 k = 0; (k < siteCount) && cell; ++k)
+			{
+				const ndInt32 j = order[k].m_site;
+				if (j == i)
+				{
+					continue;
+				}
+				if (order[k].m_dist2 < tolerance * tolerance)
+				{
+					// duplicated sites, the first one gets the cell
+					if (j < i)
+					{
+						delete cell;
+						cell = nullptr;
+					}
+					continue;
+				}
+				if (order[k].m_dist2 * ndFloat64(0.25f) > radius2)
+				{
+					// the bisectors of this and all farther sites miss the cell
+					break;
+				}
+
+				const ndBigVector normal((sites[j] - site).Scale(ndFloat64(1.0f) / sqrt(order[k].m_dist2)));
+				const ndBigVector midPoint((sites[j] + site).Scale(ndFloat64(0.5f)));
+				if (cell->Clip(ndBigPlane(normal, -normal.DotProduct(midPoint).GetScalar()), j, tolerance))
+				{
+					radius2 = cell->CalculateRadius2(site);
+				}
+				if (!cell->m_faces.GetCount())
+				{
+					delete cell;
+					cell = nullptr;
+				}
+			}
+			cells[i] = cell;
+		}
+	});
+
+	if (desc.m_threadPool && siteCount)
+	{
+		desc.m_threadPool->Begin();
+		desc.m_threadPool->ParallelExecute(BuildCells);
+		desc.m_threadPool->End();
+	}
+	else
+	{
+		BuildCells(0, 1);
+	}
+
+	bool piecesOk = true;
+	ndArray<ndInt32> siteToPiece;
+	siteToPiece.SetCount(siteCount);
+	for (ndInt32 i = 0; i < siteCount; ++i)
+	{
+		siteToPiece[i] = -1;
+		if (cells[i])
+		{
+			if (piecesOk)
+			{
+				siteToPiece[i] = ndInt32(m_pieces.GetCount());
+				piecesOk = AddPiece(*cells[i], desc.m_textureMatrix);
+			}
+			delete cells[i];
+		}
+	}
+	if (!piecesOk)
+	{
+		RemoveAll();
+		return false;
+	}
+
+	// the faces store the site that cut them, make the graph symmetric
+	// in piece indices, in case round off drops a tiny face on one side.
+	class ndCompareEdge
+	{
+		public:
+		ndCompareEdge(void* const)
+		{
+		}
+
+		ndInt32 Compare(const ndInt64& keyA, const ndInt64& keyB) const
+		{
+			return (keyA < keyB) ? -1 : ((keyA > keyB) ? 1 : 0);
+		}
+	};
+	ndArray<ndInt64> graphEdges;
+	for (ndInt32 i = 0; i < ndInt32(m_pieces.GetCount()); ++i)
+	{
+		const ndPiece& piece = m_pieces[i];
+		for (ndInt32 j = 0; j < piece.m_neighborCount; ++j)
+		{
+			const ndInt32 neighbor = siteToPiece[m_neighbors[piece.m_neighborStart + j]];
+			if (neighbor >= 0)
+			{
+				graphEdges.PushBack((ndInt64(i) << 32) + neighbor);
+				graphEdges.PushBack((ndInt64(neighbor) << 32) + i);
+			}
+		}
+	}
+	if (graphEdges.GetCount())
+	{
+		ndSort<ndInt64, ndCompareEdge>(&graphEdges[0], ndInt32(graphEdges.GetCount()), nullptr);
+	}
+	m_neighbors.SetCount(0);
+	ndInt32 edgeIndex = 0;
+	for (ndInt32 i = 0; i < ndInt32(m_pieces.GetCount()); ++i)
+	{
+		ndPiece& piece = m_pieces[i];
+		piece.m_neighborStart = ndInt32(m_neighbors.GetCount());
+		for (; (edgeIndex < ndInt32(graphEdges.GetCount())) && (ndInt32(graphEdges[edgeIndex] >> 32) == i); ++edgeIndex)
+		{
+			const ndInt32 neighbor = ndInt32(graphEdges[edgeIndex] & 0xffffffff);
+			if ((ndInt32(m_neighbors.GetCount()) == piece.m_neighborStart) || (m_neighbors[m_neighbors.GetCount() - 1] != neighbor))
+			{
+				m_neighbors.PushBack(neighbor);
+			}
+		}
+		piece.m_neighborCount = ndInt32(m_neighbors.GetCount()) - piece.m_neighborStart;
+	}
+
+	CreateShapes(desc.m_threadPool);
+
+	ndFloat32 volume = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < ndInt32(m_pieces.GetCount()); ++i)
+	{
+		ndPiece& piece = m_pieces[i];
+		const ndShapeInstance instance(m_shapes[i]);
+		piece.m_volume = instance.GetVolume();
+		piece.m_centerOfMass = instance.CalculateInertia().m_posit & ndVector::m_triplexMask;
+		volume += piece.m_volume;
+	}
+	for (ndInt32 i = 0; i < ndInt32(m_pieces.GetCount()); ++i)
+	{
+		ndPiece& piece = m_pieces[i];
+		piece.m_massFraction = piece.m_volume / volume;
+	}
+	return m_pieces.GetCount() != 0;
+}
+
+bool ndFractureAsset::AddPiece(const ndFracturePolytope& cell, const ndMatrix& textureMatrix)
+{
+	ndPiece piece;
+	piece.m_centerOfMass = ndVector::m_zero;
+	piece.m_volume = ndFloat32(0.0f);
+	piece.m_massFraction = ndFloat32(0.0f);
+	piece.m_padding = 0;
+
+	// the face polygons share their corners, keep each corner once for the hull
+	piece.m_hullPointStart = ndInt32(m_hullPoints.GetCount());
+	for (ndInt32 i = 0; i < ndInt32(cell.m_points.GetCount()); ++i)
+	{
+		ndHullPoint point;
+		point.m_x = ndFloat32(cell.m_points[i].m_x);
+		point.m_y = ndFloat32(cell.m_points[i].m_y);
+		point.m_z = ndFloat32(cell.m_points[i].m_z);
+		bool duplicated = false;
+		for (ndInt32 j = piece.m_hullPointStart; !duplicated && (j < ndInt32(m_hullPoints.GetCount())); ++j)
+		{
+			const ndHullPoint& other = m_hullPoints[j];
+			duplicated = (other.m_x == point.m_x) && (other.m_y == point.m_y) && (other.m_z == point.m_z);
+		}
+		if (!duplicated)
+		{
+			m_hullPoints.PushBack(point);
+		}
+	}
+	piece.m_hullPointCount = ndInt32(m_hullPoints.GetCount()) - piece.m_hullPointStart;
+
+	// flat shaded faces, the outer surface first and then the interior faces
+	piece.m_vertexStart = ndInt32(m_vertices.GetCount());
+	piece.m_indexStart = ndInt32(m_indices.GetCount());
+	piece.m_neighborStart = ndInt32(m_neighbors.GetCount());
+	for (ndInt32 pass = 0; pass < 2; ++pass)
+	{
+		for (ndInt32 i = 0; i < ndInt32(cell.m_faces.GetCount()); ++i)
+		{
+			const ndFracturePolytope::ndFace& face = cell.m_faces[i];
+			const bool interior = face.m_neighbor >= 0;
+			if (interior != (pass == 1))
+			{
+				continue;
+			}
+			if (interior)
+			{
+				m_neighbors.PushBack(face.m_neighbor);
+			}
+
+			const ndBigVector* const polygon = &cell.m_points[face.m_start];
+			ndBigVector normal(ndBigVector::m_zero);
+			for (ndInt32 j = 2; j < face.m_count; ++j)
+			{
+				normal += (polygon[j - 1] - polygon[0]).CrossProduct(polygon[j] - polygon[0]);
+			}
+			normal = normal & ndBigVector::m_triplexMask;
+			normal = normal.Scale(ndFloat64(1.0f) / ndMax(sqrt(normal.DotProduct(normal).GetScalar()), ndFloat64(1.0e-20f)));
+
+			// box mapping, project along the dominant axis of the face normal
+			const ndBigVector uvNormal(normal.Abs());
+			const ndInt32 axis = (uvNormal.m_x > uvNormal.m_y) ? ((uvNormal.m_x > uvNormal.m_z) ? 0 : 2) : ((uvNormal.m_y > uvNormal.m_z) ? 1 : 2);
+			const ndInt32 uAxis = (axis + 1) % 3;
+			const ndInt32 vAxis = (axis + 2) % 3;
+
+			const ndInt32 baseVertex = ndInt32(m_vertices.GetCount()) - piece.m_vertexStart;
+			for (ndInt32 j = 0; j < face.m_count; ++j)
+			{
+				const ndVector p(ndFloat32(polygon[j].m_x), ndFloat32(polygon[j].m_y), ndFloat32(polygon[j].m_z), ndFloat32(1.0f));
+				const ndVector uv(textureMatrix.TransformVector(p));
+				ndVertex vertex;
+				vertex.m_posit[0] = p.m_x;
+				vertex.m_posit[1] = p.m_y;
+				vertex.m_posit[2] = p.m_z;
+				vertex.m_normal[0] = ndFloat32(normal.m_x);
+				vertex.m_normal[1] = ndFloat32(normal.m_y);
+				vertex.m_normal[2] = ndFloat32(normal.m_z);
+				vertex.m_uv[0] = uv[uAxis];
+				vertex.m_uv[1] = uv[vAxis];
+				m_vertices.PushBack(vertex);
+			}
+			for (ndInt32 j = 2; j < face.m_count; ++j)
+			{
+				m_indices.PushBack(ndUnsigned16(baseVertex));
+				m_indices.PushBack(ndUnsigned16(baseVertex + j - 1));
+				m_indices.PushBack(ndUnsigned16(baseVertex + j));
+			}
+		}
+		if (pass == 0)
+		{
+			piece.m_outerIndexCount = ndInt32(m_indices.GetCount()) - piece.m_indexStart;
+		}
+	}
+	piece.m_vertexCount = ndInt32(m_vertices.GetCount()) - piece.m_vertexStart;
+	piece.m_innerIndexCount = ndInt32(m_indices.GetCount()) - piece.m_indexStart - piece.m_outerIndexCount;
+	piece.m_neighborCount = ndInt32(m_neighbors.GetCount()) - piece.m_neighborStart;
+	if (piece.m_vertexCount > 0xffff)
+	{
+		// the render indices are 16 bit, this piece can not be baked
+		return false;
+	}
+	m_pieces.PushBack(piece);
+	return true;
+}
+
+bool ndFractureAsset::ValidatePieces() const
+{
+	const ndInt32 pieceCount = ndInt32(m_pieces.GetCount());
+	for (ndInt32 i = 0; i < pieceCount; ++i)
+	{
+		const ndPiece& piece = m_pieces[i];
+		if ((piece.m_hullPointCount < 4) || !ndValidRange(piece.m_hullPointStart, piece.m_hullPointCount, ndInt32(m_hullPoints.GetCount())))
+		{
+			return false;
+		}
+		if ((piece.m_vertexCount > 0xffff) || !ndValidRange(piece.m_vertexStart, piece.m_vertexCount, ndInt32(m_vertices.GetCount())))
+		{
+			return false;
+		}
+		if ((piece.m_outerIndexCount < 0) || (piece.m_innerIndexCount < 0))
+		{
+			return false;
+		}
+		const ndInt64 indexCount = ndInt64(piece.m_outerIndexCount) + ndInt64(piece.m_innerIndexCount);
+		if (!ndValidRange(piece.m_indexStart, indexCount, ndInt64(m_indices.GetCount())))
+		{
+			return false;
+		}
+		for (ndInt64 j = 0; j < indexCount; ++j)
+		{
+			if (ndInt32(m_indices[piece.m_indexStart + j]) >= piece.m_vertexCount)
+			{
+				return false;
+			}
+		}
+		if (!ndValidRange(piece.m_neighborStart, piece.m_neighborCount, ndInt32(m_neighbors.GetCount())))
+		{
+			return false;
+		}
+		for (ndInt32 j = 0; j < piece.m_neighborCount; ++j)
+		{
+			const ndInt32 neighbor = m_neighbors[piece.m_neighborStart + j];
+			if ((neighbor < 0) || (neighbor >= pieceCount))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void ndFractureAsset::CreateShapes(ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	ReleaseShapes();
+	const ndInt32 count = ndInt32(m_pieces.GetCount());
+	m_shapes.SetCount(count);
+
+	// the points are already the hull vertices, the hull rebuild is cheap.
+	ndAtomic<ndInt32> iterator(0);
+	auto CreatePieceShapes = ndMakeObject::ndFunction([this, count, &iterator](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(CreatePieceShapes);
+		for (ndInt32 i = iterator++; i < count; i = iterator++)
+		{
+			const ndPiece& piece = m_pieces[i];
+			ndShape* const shape = new ndShapeConvexHull(piece.m_hullPointCount, sizeof(ndHullPoint), ndFloat32(0.0f), &m_hullPoints[piece.m_hullPointStart].m_x);
+			shape->AddRef();
+			m_shapes[i] = shape;
+		}
+	});
+
+	if (threadPool && count)
+	{
+		threadPool->Begin();
+		threadPool->ParallelExecute(CreatePieceShapes);
+		threadPool->End();
+	}
+	else
+	{
+		CreatePieceShapes(0, 1);
+	}
+}
+
+bool ndFractureAsset::Save(const char* const path) const
+{
+	FILE* const file = fopen(path, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	ndFractureAssetFileHeader header;
+	memcpy(header.m_id, D_FRACTURE_ASSET_FILE_ID, sizeof(header.m_id));
+	header.m_pieceSize = ndInt32(sizeof(ndPiece));
+	header.m_vertexSize = ndInt32(sizeof(ndVertex));
+	header.m_pieceCount = ndInt32(m_pieces.GetCount());
+	header.m_hullPointCount = ndInt32(m_hullPoints.GetCount());
+	header.m_vertexCount = ndInt32(m_vertices.GetCount());
+	header.m_indexCount = ndInt32(m_indices.GetCount());
+	header.m_neighborCount = ndInt32(m_neighbors.GetCount());
+	header.m_padding = 0;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && ndWriteSection(file, m_pieces);
+	ok = ok && ndWriteSection(file, m_hullPoints);
+	ok = ok && ndWriteSection(file, m_vertices);
+	ok = ok && ndWriteSection(file, m_indices);
+	ok = ok && ndWriteSection(file, m_neighbors);
+	// the buffered data is only written out by the close
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
+
+bool ndFractureAsset::Load(const char* const path, ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	RemoveAll();
+	FILE* const file = fopen(path, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	const ndInt64 fileSize = ndFileSize(file);
+	ndFractureAssetFileHeader header;
+	bool ok = (fileSize >= 0) && (fread(&header, sizeof(header), 1, file) == 1);
+	ok = ok && !memcmp(header.m_id, D_FRACTURE_ASSET_FILE_ID, sizeof(header.m_id));
+	ok = ok && (header.m_pieceSize == ndInt32(sizeof(ndPiece)));
+	ok = ok && (header.m_vertexSize == ndInt32(sizeof(ndVertex)));
+	ok = ok && ndReadSection(file, m_pieces, header.m_pieceCount, fileSize);
+	ok = ok && ndReadSection(file, m_hullPoints, header.m_hullPointCount, fileSize);
+	ok = ok && ndReadSection(file, m_vertices, header.m_vertexCount, fileSize);
+	ok = ok && ndReadSection(file, m_indices, header.m_indexCount, fileSize);
+	ok = ok && ndReadSection(file, m_neighbors, header.m_neighborCount, fileSize);
+	fclose(file);
+
+	// the shapes index the sections directly, reject a file with ranges out of bounds
+	ok = ok && ValidatePieces();
+
+	if (!ok)
+	{
+		RemoveAll();
+		return false;
+	}
+	CreateShapes(threadPool);
+	return true;
+}
@@ -0,0 +1,172 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_FRACTURE_ASSET_H__
+#define __ND_FRACTURE_ASSET_H__
+
+#include "ndCollisionStdafx.h"
+
+class ndShape;
+class ndShapeInstance;
+class ndFracturePolytope;
+
+/// Pre baked Voronoi fracture of a solid.
+/// Build runs the expensive part once: the Voronoi cells clipped to the outer
+/// shape, the piece hulls, the render meshes with their interior faces, and
+/// the piece connectivity graph.
+/// the result is saved to a compact binary file, and Load reads it back in bulk
+/// and creates one shared convex hull shape per piece. every debris instance of
+/// the asset references these shapes instead of building a new hull.
+class ndFractureAsset: public ndClassAlloc
+{
+	public:
+	class ndDesc
+	{
+		public:
+		ndDesc()
+			:m_pointCloud()
+			,m_textureMatrix(ndGetIdentityMatrix())
+			,m_outerShape(nullptr)
+			,m_threadPool(nullptr)
+		{
+		}
+
+		// Voronoi sites, in the space of the outer shape
+		ndArray<ndVector> m_pointCloud;
+		// uv box projection of the outer surface and the interior faces
+		ndMatrix m_textureMatrix;
+		// the cells are clipped to the convex hull of this shape
+		const ndShapeInstance* m_outerShape;
+		// optional, the cells and the piece shapes are built in parallel
+		ndThreadPool* m_threadPool;
+	};
+
+	// render vertex of a piece, in the space of the outer shape
+	class ndVertex
+	{
+		public:
+		ndFloat32 m_posit[3];
+		ndFloat32 m_normal[3];
+		ndFloat32 m_uv[2];
+	};
+
+	class ndHullPoint
+	{
+		public:
+		ndFloat32 m_x;
+		ndFloat32 m_y;
+		ndFloat32 m_z;
+	};
+
+	class ndPiece
+	{
+		public:
+		ndVector m_centerOfMass;
+		ndFloat32 m_volume;
+		ndFloat32 m_massFraction;
+		ndInt32 m_hullPointStart;
+		ndInt32 m_hullPointCount;
+		ndInt32 m_vertexStart;
+		ndInt32 m_vertexCount;
+		// the outer surface triangles come first, followed by the interior faces.
+		// the indices are relative to m_vertexStart
+		ndInt32 m_indexStart;
+		ndInt32 m_outerIndexCount;
+		ndInt32 m_innerIndexCount;
+		ndInt32 m_neighborStart;
+		ndInt32 m_neighborCount;
+		ndInt32 m_padding;
+	};
+
+	D_COLLISION_API ndFractureAsset();
+	D_COLLISION_API ~ndFractureAsset();
+
+	/// bake the pieces, fails if a piece needs more vertices than its 16 bit indices can address.
+	D_COLLISION_API bool Build(const ndDesc& desc);
+	/// write the baked pieces, fails if the file can not be opened or a write fails.
+	D_COLLISION_API bool Save(const char* const path) const;
+	/// read a file written by Save and create the piece shapes, in parallel when a pool is given.
+	/// a file with a piece range outside its sections or a bad neighbor id is rejected.
+	D_COLLISION_API bool Load(const char* const path, ndThreadPool* const threadPool = nullptr);
+	D_COLLISION_API void RemoveAll();
+
+	ndInt32 GetPieceCount() const;
+	const ndPiece& GetPiece(ndInt32 index) const;
+	const ndShape* GetPieceShape(ndInt32 index) const;
+	/// new instance referencing the shared shape of the piece, the caller owns it.
+	D_COLLISION_API ndShapeInstance* CreatePieceInstance(ndInt32 index) const;
+
+	const ndHullPoint* GetHullPoints(ndInt32 index) const;
+	const ndVertex* GetVertices(ndInt32 index) const;
+	const ndUnsigned16* GetIndices(ndInt32 index) const;
+	const ndInt32* GetNeighbors(ndInt32 index) const;
+
+	private:
+	bool AddPiece(const ndFracturePolytope& cell, const ndMatrix& textureMatrix);
+	bool ValidatePieces() const;
+	void CreateShapes(ndThreadPool* const threadPool);
+	void ReleaseShapes();
+
+	ndArray<ndPiece> m_pieces;
+	ndArray<ndHullPoint> m_hullPoints;
+	ndArray<ndVertex> m_vertices;
+	ndArray<ndUnsigned16> m_indices;
+	ndArray<ndInt32> m_neighbors;
+	ndArray<ndShape*> m_shapes;
+};
+
+inline ndInt32 ndFractureAsset::GetPieceCount() const
+{
+	return ndInt32(m_pieces.GetCount());
+}
+
+inline const ndFractureAsset::ndPiece& ndFractureAsset::GetPiece(ndInt32 index) const
+{
+	return m_pieces[index];
+}
+
+inline const ndShape* ndFractureAsset::GetPieceShape(ndInt32 index) const
+{
+	return m_shapes[index];
+}
+
+inline const ndFractureAsset::ndHullPoint* ndFractureAsset::GetHullPoints(ndInt32 index) const
+{
+	return &m_hullPoints[m_pieces[index].m_hullPointStart];
+}
+
+inline const ndFractureAsset::ndVertex* ndFractureAsset::GetVertices(ndInt32 index) const
+{
+	return &m_vertices[m_pieces[index].m_vertexStart];
+}
+
+inline const ndUnsigned16* ndFractureAsset::GetIndices(ndInt32 index) const
+{
+	return &m_indices[m_pieces[index].m_indexStart];
+}
+
+inline const ndInt32* ndFractureAsset::GetNeighbors(ndInt32 index) const
+{
+	const ndPiece& piece = m_pieces[index];
+	return piece.m_neighborCount ? &m_neighbors[piece.m_neighborStart] : nullptr;
+}
+
+#endif
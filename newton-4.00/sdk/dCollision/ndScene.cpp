@@ -51,7 +51,8 @@ ndScene::ndScene()
 	,m_particleSetList()
 	,m_contactArray()
 	,m_bvhSceneManager()
-	,m_scratchBuffer(1024 * sizeof (void*))
+	,m_frameArena()
+	,m_scratchBuffer()
 	,m_sceneBodyArray(1024)
 	,m_activeConstraintArray(1024)
 	,m_specialUpdateList()
@@ -66,6 +67,9 @@ ndScene::ndScene()
 	,m_frameNumber(0)
 	,m_subStepNumber(0)
 	,m_forceBalanceSceneCounter(0)
+	,m_deterministic(false)
+	,m_collisionLayersActive(false)
+	,m_collisionLayersDirty(false)
 {
 	m_sentinelBody = new ndBodySentinel;
 	m_contactNotifyCallback->m_scene = this;
@@ -82,6 +86,7 @@ ndScene::ndScene(const ndScene& src)
 	,m_particleSetList()
 	,m_contactArray(src.m_contactArray)
 	,m_bvhSceneManager(src.m_bvhSceneManager)
+	,m_frameArena()
 	,m_scratchBuffer()
 	,m_sceneBodyArray()
 	,m_activeConstraintArray()
@@ -97,13 +102,16 @@ ndScene::ndScene(const ndScene& src)
 	,m_frameNumber(src.m_frameNumber)
 	,m_subStepNumber(src.m_subStepNumber)
 	,m_forceBalanceSceneCounter(0)
+	,m_deterministic(src.m_deterministic)
+	,m_collisionLayersActive(src.m_collisionLayersActive)
+	,m_collisionLayersDirty(true)
 {
 	ndScene* const stealData = (ndScene*)&src;
 
 	SetThreadCount(src.GetThreadCount());
 	//m_backgroundThread.SetThreadCount(m_backgroundThread.GetThreadCount());
 
-	m_scratchBuffer.Swap(stealData->m_scratchBuffer);
+	m_frameArena.SetTrimPolicy(src.m_frameArena.GetTrimPolicy());
 	m_sceneBodyArray.Swap(stealData->m_sceneBodyArray);
 	m_activeConstraintArray.Swap(stealData->m_activeConstraintArray);
 
@@ -238,6 +246,11 @@ bool ndScene::AddBody(const ndSharedPtr<ndBody>& body)
 			kinematicBody->UpdateCollisionMatrix();
 
 			m_rootNode = m_bvhSceneManager.AddBody(kinematicBody, m_rootNode);
+			m_collisionLayersDirty = true;
+			if ((kinematicBody->m_collisionCategory != D_COLLISION_LAYER_ALL) || (kinematicBody->m_collisionMask != D_COLLISION_LAYER_ALL))
+			{
+				m_collisionLayersActive = true;
+			}
 			if (kinematicBody->GetAsBodyKinematicSpecial())
 			{
 				kinematicBody->m_spetialUpdateNode = m_specialUpdateList.Append(kinematicBody);
@@ -276,6 +289,7 @@ bool ndScene::RemoveBody(const ndSharedPtr<ndBody>& body)
 	{
 		m_forceBalanceSceneCounter = 0;
 		m_bvhSceneManager.RemoveBody(kinematicBody);
+		m_collisionLayersDirty = true;
 
 		//ndAssert(0);
 		ndBodyKinematic::ndContactMap& contactMap = kinematicBody->GetContactMap();
@@ -318,6 +332,7 @@ void ndScene::BalanceScene()
 		if (!m_forceBalanceSceneCounter)
 		{
 			m_rootNode = m_bvhSceneManager.BuildBvhTree(*this);
+			m_collisionLayersDirty = true;
 		}
 		const ndInt32 sceneUpdatePeriod = 64;
 		m_forceBalanceSceneCounter = (m_forceBalanceSceneCounter < sceneUpdatePeriod) ? m_forceBalanceSceneCounter + 1 : 0;
@@ -387,7 +402,7 @@ void ndScene::CalculateJointContacts(ndInt32 threadIndex, ndContact* const conta
 	ndAssert(contact->m_material);
 	ndAssert(m_contactNotifyCallback);
 
-	bool processContacts = m_contactNotifyCallback->OnAabbOverlap(contact, m_timestep);
+	bool processContacts = body0->TestCollisionLayers(body1) && m_contactNotifyCallback->OnAabbOverlap(contact, m_timestep);
 	if (processContacts)
 	{
 		//ndAssert(!body0->GetCollisionShape().GetShape()->GetAsShapeNull());
@@ -465,7 +480,7 @@ void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* co
 	ndAssert(body1);
 	ndAssert(body0 != body1);
 
-	contact->m_material = m_contactNotifyCallback->GetMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
+	contact->m_material = m_contactNotifyCallback->FindMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
 	const ndContactPoint* const contactArray = contactSolver->m_contactBuffer;
 	
 	ndInt32 count = 0;
@@ -661,6 +676,8 @@ void ndScene::SubmitPairs(ndBvhLeafNode* const leafNode, ndBvhNode* const node,
 	const ndVector boxP1(leafNode->m_maxBox);
 	const ndUnsigned8 test0 = ndUnsigned8(!body0->m_equilibrium);
 	const ndUnsigned8 fowardTest = forward ? ndUnsigned8(1) : ndUnsigned8(0);
+	const ndUnsigned32 category0 = body0->m_collisionCategory;
+	const ndUnsigned32 mask0 = body0->m_collisionMask;
 
 	ndBodyNotify* const notify = body0->GetNotifyCallback();
 
@@ -670,7 +687,9 @@ void ndScene::SubmitPairs(ndBvhLeafNode* const leafNode, ndBvhNode* const node,
 	{
 		stack--;
 		ndBvhNode* const rootNode = pool[stack];
-		if (ndOverlapTest(rootNode->m_minBox, rootNode->m_maxBox, boxP0, boxP1)) 
+		// subtrees with no layer that can collide with body0 are skipped
+		const bool layerTest = (rootNode->m_layerCategory & mask0) && (category0 & rootNode->m_layerMask);
+		if (layerTest && ndOverlapTest(rootNode->m_minBox, rootNode->m_maxBox, boxP0, boxP1)) 
 		{
 			if (rootNode->GetAsSceneBodyNode()) 
 			{
@@ -680,7 +699,7 @@ void ndScene::SubmitPairs(ndBvhLeafNode* const leafNode, ndBvhNode* const node,
 				ndBodyKinematic* const body1 = rootNode->GetBody();
 				ndAssert(body1);
 				const ndUnsigned8 test = ndUnsigned8((body1->m_sceneEquilibrium | fowardTest) & (test0 | ndUnsigned8(!body1->m_equilibrium)));
-				if (test)
+				if (test && body0->TestCollisionLayers(body1))
 				{
 					//if (notify->OnSceneAabbOverlap(body1))
 					if (!notify || notify->OnSceneAabbOverlap(body1))
@@ -1189,6 +1208,8 @@ void ndScene::Cleanup()
 	if (m_backgroundThread)
 	{
 		m_backgroundThread->Terminate();
+		delete m_backgroundThread;
+		m_backgroundThread = nullptr;
 	}
 	PrepareCleanup();
 	
@@ -1207,9 +1228,10 @@ void ndScene::Cleanup()
 	ndFreeListAlloc::Flush();
 	m_sceneBodyArray.Resize(1024);
 	m_activeConstraintArray.Resize(1024);
-	m_scratchBuffer.Resize(1024 * sizeof(void*));
+	m_scratchBuffer.ResetMembers();
+	m_frameArena.Reset();
+	m_frameArena.Trim(0);
 
-	m_scratchBuffer.SetCount(0);
 	m_sceneBodyArray.SetCount(0);
 	m_activeConstraintArray.SetCount(0);
 }
@@ -1269,15 +1291,13 @@ bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& co
 
 void ndScene::SendBackgroundTask(ndBackgroundTask* const job)
 {
-	if (m_backgroundThread)
+	if (!m_backgroundThread)
 	{
-		m_backgroundThread->SendTask(job);
-	}
-	else
-	{
-		ndAssert(0);
-		delete job;
+		// most scenes never send background tasks, so the worker is created on demand
+		m_backgroundThread = new ndThreadBackgroundWorker();
+		m_backgroundThread->SetThreadCount(GetThreadCount());
 	}
+	m_backgroundThread->SendTask(job);
 }
 
 void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1, ndInt32 threadId)
@@ -1299,9 +1319,60 @@ void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1
 	}
 }
 
+void ndScene::UpdateCollisionLayers()
+{
+	if (!(m_collisionLayersActive && m_collisionLayersDirty && m_rootNode))
+	{
+		return;
+	}
+
+	D_TRACKTIME();
+	m_collisionLayersDirty = false;
+
+	// breadth first list of the tree, so that traversing it
+	// backward visits all children before their parent.
+	const ndInt32 nodeCount = ndInt32(m_bvhSceneManager.GetNodeArray().GetCount()) + 1;
+	m_frameArena.Bind(m_scratchBuffer, ndInt64(nodeCount * sizeof(ndBvhNode*)));
+	ndBvhNode** const nodes = (ndBvhNode**)&m_scratchBuffer[0];
+
+	ndInt32 count = 1;
+	nodes[0] = m_rootNode;
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		ndBvhInternalNode* const node = nodes[i]->GetAsSceneTreeNode();
+		if (node)
+		{
+			ndAssert((count + 2) <= nodeCount);
+			nodes[count + 0] = node->m_left;
+			nodes[count + 1] = node->m_right;
+			count += 2;
+		}
+	}
+
+	for (ndInt32 i = count - 1; i >= 0; --i)
+	{
+		ndBvhNode* const node = nodes[i];
+		ndBvhInternalNode* const internalNode = node->GetAsSceneTreeNode();
+		if (internalNode)
+		{
+			node->m_layerCategory = internalNode->m_left->m_layerCategory | internalNode->m_right->m_layerCategory;
+			node->m_layerMask = internalNode->m_left->m_layerMask | internalNode->m_right->m_layerMask;
+		}
+		else
+		{
+			const ndBodyKinematic* const body = node->GetBody();
+			ndAssert(body);
+			node->m_layerCategory = body->m_collisionCategory;
+			node->m_layerMask = body->m_collisionMask;
+		}
+	}
+}
+
 void ndScene::FindCollidingPairs()
 {
 	D_TRACKTIME();
+	UpdateCollisionLayers();
+
 	ndAtomic<ndInt32> iterator0(0);
 	auto FindPairsForward = ndMakeObject::ndFunction([this, &iterator0](ndInt32 threadIndex, ndInt32)
 	{
@@ -1366,6 +1437,56 @@ void ndScene::FindCollidingPairs()
 			sum += count;
 		}
 	}
+
+	if (m_deterministic)
+	{
+		SortNewPairs();
+	}
+}
+
+void ndScene::SortNewPairs()
+{
+	D_TRACKTIME();
+	// the merge order of the per thread partial pairs depends on the thread count, 
+	// a radix sort by (body0, body1) makes the new contact array canonical.
+	class ndPairKey
+	{
+		public:
+		ndPairKey(void* const context)
+			:m_shift(*((ndInt32*)context))
+		{
+		}
+
+		ndInt32 GetKey(const ndContactPairs& pair) const
+		{
+			const ndUnsigned64 key = (ndUnsigned64(pair.m_body0) << 32) + pair.m_body1;
+			return ndInt32((key >> m_shift) & 0xff);
+		}
+
+		ndInt32 m_shift;
+	};
+
+	const ndInt32 count = ndInt32(m_newPairs.GetCount());
+	if (count <= 1)
+	{
+		return;
+	}
+
+	ndInt32 bodyBits = 0;
+	for (ndUnsigned32 bodyCount = ndUnsigned32(GetActiveBodyArray().GetCount()); bodyCount; bodyCount >>= 1)
+	{
+		bodyBits++;
+	}
+
+	m_frameArena.Bind(m_scratchBuffer, ndInt64(count * sizeof(ndContactPairs)));
+	ndContactPairs* const tmpPairs = (ndContactPairs*)&m_scratchBuffer[0];
+	for (ndInt32 base = 0; base < 64; base += 32)
+	{
+		for (ndInt32 shift = base; shift < (base + bodyBits); shift += 8)
+		{
+			ndCountingSortInPlace<ndContactPairs, ndPairKey, 8>(*this, &m_newPairs[0], tmpPairs, count, nullptr, &shift);
+		}
+	}
 }
 
 void ndScene::UpdateBodyList()
@@ -1529,6 +1650,7 @@ void ndScene::InitBodyArray()
 		else
 		{
 			m_bvhSceneManager.UpdateScene(*this);
+			m_collisionLayersDirty = true;
 		}
 	}
 	
@@ -1550,7 +1672,7 @@ void ndScene::CreateNewContacts()
 {
 	D_TRACKTIME();
 	const ndInt32 contactCount = ndInt32(m_contactArray.GetCount());
-	m_scratchBuffer.SetCount(ndInt32((contactCount + m_newPairs.GetCount() + 16) * sizeof(ndContact*)));
+	m_frameArena.Bind(m_scratchBuffer, ndInt64((contactCount + m_newPairs.GetCount() + 16) * sizeof(ndContact*)));
 
 	ndContact** const tmpJointsArray = (ndContact**)&m_scratchBuffer[0];
 
@@ -1578,7 +1700,7 @@ void ndScene::CreateNewContacts()
 				contact->AttachToBodies();
 
 				ndAssert(contact->m_body0->GetInvMass() != ndFloat32(0.0f));
-				contact->m_material = m_contactNotifyCallback->GetMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
+				contact->m_material = m_contactNotifyCallback->FindMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
 				tmpJointsArray[i + j] = contact;
 			}
 		}
@@ -111,9 +111,14 @@ class ndScene : public ndThreadPool
 	const ndArray<ndConstraint*>& GetActiveContactArray() const;
 
 	ndArray<ndUnsigned8>& GetScratchBuffer();
+	ndFrameArena& GetFrameArena();
 
 	ndFloat32 GetTimestep() const;
 	void SetTimestep(ndFloat32 timestep);
+
+	bool IsDeterministic() const;
+	void SetDeterministic(bool state);
+	void InvalidateCollisionLayers();
 	ndBodyKinematic* GetSentinelBody() const;
 
 	protected:
@@ -127,6 +132,8 @@ class ndScene : public ndThreadPool
 	void FindCollidingPairsBackward(ndBodyKinematic* const body, ndInt32 threadId);
 	void AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1, ndInt32 threadId);
 	void SubmitPairs(ndBvhLeafNode* const bodyNode, ndBvhNode* const node, bool forward, ndInt32 threadId);
+	void SortNewPairs();
+	void UpdateCollisionLayers();
 
 	void CalculateJointContacts(ndInt32 threadIndex, ndContact* const contact);
 	void ProcessContacts(ndInt32 threadIndex, ndInt32 contactCount, ndContactSolver* const contactSolver);
@@ -158,6 +165,9 @@ class ndScene : public ndThreadPool
 	ndBodyList m_particleSetList;
 	ndContactArray m_contactArray;
 	ndBvhSceneManager m_bvhSceneManager;
+	// transient buffers, reset at the beginning of each sub step
+	ndFrameArena m_frameArena;
+	// bound to frame arena memory, it does not own its array
 	ndArray<ndUnsigned8> m_scratchBuffer;
 	ndArray<ndBodyKinematic*> m_sceneBodyArray;
 	ndArray<ndConstraint*> m_activeConstraintArray;
@@ -178,6 +188,9 @@ class ndScene : public ndThreadPool
 	ndUnsigned32 m_frameNumber;
 	ndUnsigned32 m_subStepNumber;
 	ndUnsigned32 m_forceBalanceSceneCounter;
+	bool m_deterministic;
+	bool m_collisionLayersActive;
+	bool m_collisionLayersDirty;
 
 	static ndVector m_velocTol;
 	static ndVector m_linearContactError2;
@@ -221,6 +234,11 @@ inline ndArray<ndUnsigned8>& ndScene::GetScratchBuffer()
 	return m_scratchBuffer;
 }
 
+inline ndFrameArena& ndScene::GetFrameArena()
+{
+	return m_frameArena;
+}
+
 inline const ndBodyList& ndScene::GetParticleList() const
 {
 	return m_particleSetList;
@@ -266,6 +284,22 @@ inline void ndScene::SetTimestep(ndFloat32 timestep)
 	m_timestep = timestep;
 }
 
+inline bool ndScene::IsDeterministic() const
+{
+	return m_deterministic;
+}
+
+inline void ndScene::SetDeterministic(bool state)
+{
+	m_deterministic = state;
+}
+
+inline void ndScene::InvalidateCollisionLayers()
+{
+	m_collisionLayersActive = true;
+	m_collisionLayersDirty = true;
+}
+
 inline ndBodyKinematic* ndScene::GetSentinelBody() const
 {
 	return m_sentinelBody;
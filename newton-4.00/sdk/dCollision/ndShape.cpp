@@ -106,6 +106,11 @@ ndFloat32 ndShape::GetUmbraClipSize() const
 	return ndFloat32(3.0f) * GetBoxMaxRadius();
 }
 
+ndVector ndShape::SupportVertexSpecialCached(const ndVector& dir, ndFloat32 skinMargin, ndInt32* const) const
+{
+	return SupportVertexSpecial(dir, skinMargin);
+}
+
 ndUnsigned64 ndShape::GetHash(ndUnsigned64 hash) const
 {
 	ndAssert(0);
@@ -260,6 +260,8 @@ class ndShape: public ndContainersFreeListAlloc<ndShape>
 
 	virtual ndVector SupportVertex(const ndVector& dir) const = 0;
 	virtual ndVector SupportVertexSpecial(const ndVector& dir, ndFloat32 skinMargin) const = 0;
+	// same as SupportVertexSpecial, vertexCache is the support vertex index of a previous query, used as a starting point by shapes that support it.
+	D_COLLISION_API virtual ndVector SupportVertexSpecialCached(const ndVector& dir, ndFloat32 skinMargin, ndInt32* const vertexCache) const;
 	virtual void CalculateAabb(const ndMatrix& matrix, ndVector& p0, ndVector& p1) const = 0;
 	virtual ndVector SupportVertexSpecialProjectPoint(const ndVector& point, const ndVector& dir) const = 0;
 	virtual ndInt32 CalculatePlaneIntersection(const ndVector& normal, const ndVector& point, ndVector* const contactsOut) const = 0;
@@ -963,6 +963,57 @@ ndVector ndShapeConvexHull::SupportFeatureVertex(const ndVector& dir, ndInt32* c
 	}
 }
 
+ndVector ndShapeConvexHull::SupportVertexHillClimbing(const ndVector& dir, ndInt32* const vertexIndex) const
+{
+	// on a convex hull a vertex that no neighbor improves is the global support,
+	// so walk from the start vertex to the best vertex of its incident faces.
+	// the faces merged by RemoveCoplanarEdge are only nearly flat, testing all
+	// their vertices and not just the edge neighbors keeps the walk exact.
+	ndInt32 index = *vertexIndex;
+	if ((index < 0) || (index >= m_vertexCount))
+	{
+		index = 0;
+	}
+
+	ndFloat32 maxProj = m_vertex[index].DotProduct(dir).GetScalar();
+	for (ndInt32 prevIndex = -1; prevIndex != index; )
+	{
+		prevIndex = index;
+		const ndConvexSimplexEdge* const edge = m_vertexToEdgeMapping[prevIndex];
+		const ndConvexSimplexEdge* ptr = edge;
+		do
+		{
+			for (const ndConvexSimplexEdge* facePtr = ptr->m_next; facePtr != ptr; facePtr = facePtr->m_next)
+			{
+				const ndInt32 neighbor = facePtr->m_vertex;
+				const ndFloat32 proj = m_vertex[neighbor].DotProduct(dir).GetScalar();
+				if (proj > maxProj)
+				{
+					maxProj = proj;
+					index = neighbor;
+				}
+			}
+			ptr = ptr->m_twin->m_next;
+		} while (ptr != edge);
+	}
+
+	*vertexIndex = index;
+	return m_vertex[index];
+}
+
+ndVector ndShapeConvexHull::SupportVertexSpecialCached(const ndVector& dir, ndFloat32, ndInt32* const vertexCache) const
+{
+	ndAssert(dir.m_w == ndFloat32(0.0f));
+	if (m_vertexCount > D_CONVEX_VERTEX_BRUTE_FORCE_SPLIT)
+	{
+		return SupportVertexHillClimbing(dir, vertexCache);
+	}
+	else
+	{
+		return SupportVertexBruteForce(dir, vertexCache);
+	}
+}
+
 ndShapeInfo ndShapeConvexHull::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
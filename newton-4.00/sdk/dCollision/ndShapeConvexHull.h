@@ -44,10 +44,12 @@ class ndShapeConvexHull : public ndShapeConvex
 	bool Create(ndInt32 count, ndInt32 strideInBytes, const ndFloat32* const vertexArray, ndFloat32 tolerance, ndInt32 maxPointsOut);
 	virtual ndVector SupportVertex(const ndVector& dir) const;
 	virtual ndVector SupportFeatureVertex(const ndVector& dir, ndInt32* const vertexIndex) const;
+	D_COLLISION_API virtual ndVector SupportVertexSpecialCached(const ndVector& dir, ndFloat32 skinMargin, ndInt32* const vertexCache) const;
 	
 	private:
 	ndVector SupportVertexBruteForce(const ndVector& dir, ndInt32* const vertexIndex) const;
 	ndVector SupportVertexhierarchical(const ndVector& dir, ndInt32* const vertexIndex) const;
+	ndVector SupportVertexHillClimbing(const ndVector& dir, ndInt32* const vertexIndex) const;
 	
 	void DebugShape(const ndMatrix& matrix, ndShapeDebugNotify& debugCallback) const;
 
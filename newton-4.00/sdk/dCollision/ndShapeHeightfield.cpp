@@ -45,6 +45,8 @@ ndShapeHeightfield::ndShapeHeightfield(
 	,m_maxBox(ndVector::m_zero)
 	,m_attributeMap(width * height)
 	,m_elevationMap(width * height)
+	,m_elevationMip()
+	,m_mipLevels()
 	,m_horizontalScale_x(horizontalScale_x)
 	,m_horizontalScale_z(horizontalScale_z)
 	,m_horizontalScaleInv_x(ndFloat32(1.0f) / horizontalScale_x)
@@ -115,26 +117,133 @@ ndInt32 ndShapeHeightfield::FastInt(ndFloat32 x) const
 
 void ndShapeHeightfield::CalculateLocalObb()
 {
-	ndReal y0 = ndReal (1.0e10f);
-	ndReal y1 = -ndReal(1.0e10f);
-	for (ndInt32 i = ndInt32(m_elevationMap.GetCount()-1); i >= 0; --i)
+	// each level of the pyramid halves the one below, down to a single root tile
+	m_mipLevels.SetCount(0);
+	ndInt32 start = 0;
+	// a map one vertex wide has no cells along that axis, it still gets one tile
+	ndInt32 width = ndMax((m_width - 1 + (1 << D_HEIGHTFIELD_MIP_TILE_SHIFT) - 1) >> D_HEIGHTFIELD_MIP_TILE_SHIFT, 1);
+	ndInt32 height = ndMax((m_height - 1 + (1 << D_HEIGHTFIELD_MIP_TILE_SHIFT) - 1) >> D_HEIGHTFIELD_MIP_TILE_SHIFT, 1);
+	while (1)
 	{
-		y0 = ndMin(y0, m_elevationMap[i]);
-		y1 = ndMax(y1, m_elevationMap[i]);
+		ndMipLevel level;
+		level.m_start = start;
+		level.m_width = width;
+		level.m_height = height;
+		m_mipLevels.PushBack(level);
+
+		start += width * height;
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		width = (width + 1) >> 1;
+		height = (height + 1) >> 1;
+	}
+	m_elevationMip.SetCount(start);
+
+	for (ndInt32 i = 0; i < ndInt32(m_mipLevels.GetCount()); ++i)
+	{
+		const ndMipLevel& level = m_mipLevels[i];
+		BuildMipTiles(i, 0, 0, level.m_width - 1, level.m_height - 1);
 	}
 
-	m_minBox = ndVector(ndFloat32(0.0f), ndFloat32 (y0), ndFloat32(0.0f), ndFloat32(0.0f));
-	m_maxBox = ndVector(ndFloat32(m_width-1) * m_horizontalScale_x, ndFloat32(y1), ndFloat32(m_height-1) * m_horizontalScale_z, ndFloat32(0.0f));
+	const ndElevationRange& root = m_elevationMip[m_elevationMip.GetCount() - 1];
+	m_minBox = ndVector(ndFloat32(0.0f), ndFloat32 (root.m_min), ndFloat32(0.0f), ndFloat32(0.0f));
+	m_maxBox = ndVector(ndFloat32(m_width-1) * m_horizontalScale_x, ndFloat32(root.m_max), ndFloat32(m_height-1) * m_horizontalScale_z, ndFloat32(0.0f));
 
 	m_boxSize = (m_maxBox - m_minBox) * ndVector::m_half;
 	m_boxOrigin = (m_maxBox + m_minBox) * ndVector::m_half;
 }
 
+void ndShapeHeightfield::BuildMipTiles(ndInt32 levelIndex, ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1)
+{
+	const ndMipLevel& level = m_mipLevels[levelIndex];
+	ndElevationRange* const tiles = &m_elevationMip[level.m_start];
+	if (levelIndex == 0)
+	{
+		// the base tiles include the vertices shared with the next tile
+		for (ndInt32 z = z0; z <= z1; ++z)
+		{
+			const ndInt32 vz0 = z << D_HEIGHTFIELD_MIP_TILE_SHIFT;
+			const ndInt32 vz1 = ndMin((z + 1) << D_HEIGHTFIELD_MIP_TILE_SHIFT, m_height - 1);
+			for (ndInt32 x = x0; x <= x1; ++x)
+			{
+				const ndInt32 vx0 = x << D_HEIGHTFIELD_MIP_TILE_SHIFT;
+				const ndInt32 vx1 = ndMin((x + 1) << D_HEIGHTFIELD_MIP_TILE_SHIFT, m_width - 1);
+				ndElevationRange range;
+				range.m_min = ndReal(1.0e10f);
+				range.m_max = -ndReal(1.0e10f);
+				for (ndInt32 vz = vz0; vz <= vz1; ++vz)
+				{
+					const ndReal* const row = &m_elevationMap[vz * m_width];
+					for (ndInt32 vx = vx0; vx <= vx1; ++vx)
+					{
+						range.m_min = ndMin(range.m_min, row[vx]);
+						range.m_max = ndMax(range.m_max, row[vx]);
+					}
+				}
+				tiles[z * level.m_width + x] = range;
+			}
+		}
+	}
+	else
+	{
+		const ndMipLevel& childLevel = m_mipLevels[levelIndex - 1];
+		const ndElevationRange* const children = &m_elevationMip[childLevel.m_start];
+		for (ndInt32 z = z0; z <= z1; ++z)
+		{
+			const ndInt32 cz1 = ndMin(2 * z + 1, childLevel.m_height - 1);
+			for (ndInt32 x = x0; x <= x1; ++x)
+			{
+				const ndInt32 cx1 = ndMin(2 * x + 1, childLevel.m_width - 1);
+				ndElevationRange range(children[2 * z * childLevel.m_width + 2 * x]);
+				for (ndInt32 cz = 2 * z; cz <= cz1; ++cz)
+				{
+					for (ndInt32 cx = 2 * x; cx <= cx1; ++cx)
+					{
+						const ndElevationRange& child = children[cz * childLevel.m_width + cx];
+						range.m_min = ndMin(range.m_min, child.m_min);
+						range.m_max = ndMax(range.m_max, child.m_max);
+					}
+				}
+				tiles[z * level.m_width + x] = range;
+			}
+		}
+	}
+}
+
 void ndShapeHeightfield::UpdateElevationMapAabb()
 {
 	CalculateLocalObb();
 }
 
+void ndShapeHeightfield::UpdateElevationMapAabb(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1)
+{
+	ndAssert(x0 <= x1);
+	ndAssert(z0 <= z1);
+	ndAssert(m_mipLevels.GetCount());
+
+	// an edited vertex belongs to the cells on both of its sides
+	ndInt32 tx0 = ndClamp(x0 - 1, 0, m_width - 2) >> D_HEIGHTFIELD_MIP_TILE_SHIFT;
+	ndInt32 tx1 = ndClamp(x1, 0, m_width - 2) >> D_HEIGHTFIELD_MIP_TILE_SHIFT;
+	ndInt32 tz0 = ndClamp(z0 - 1, 0, m_height - 2) >> D_HEIGHTFIELD_MIP_TILE_SHIFT;
+	ndInt32 tz1 = ndClamp(z1, 0, m_height - 2) >> D_HEIGHTFIELD_MIP_TILE_SHIFT;
+	for (ndInt32 i = 0; i < ndInt32(m_mipLevels.GetCount()); ++i)
+	{
+		BuildMipTiles(i, tx0, tz0, tx1, tz1);
+		tx0 = tx0 >> 1;
+		tx1 = tx1 >> 1;
+		tz0 = tz0 >> 1;
+		tz1 = tz1 >> 1;
+	}
+
+	const ndElevationRange& root = m_elevationMip[m_elevationMip.GetCount() - 1];
+	m_minBox.m_y = ndFloat32(root.m_min);
+	m_maxBox.m_y = ndFloat32(root.m_max);
+	m_boxSize = (m_maxBox - m_minBox) * ndVector::m_half;
+	m_boxOrigin = (m_maxBox + m_minBox) * ndVector::m_half;
+}
+
 const ndInt32* ndShapeHeightfield::GetIndexList() const
 {
 	return &m_cellIndices[(m_diagonalMode == m_normalDiagonals) ? 0 : 1][0];
@@ -425,10 +534,35 @@ ndFloat32 ndShapeHeightfield::RayCast(ndRayCastNotify&, const ndVector& localP0,
 		ndInt32 xIndex0 = ix0;
 		ndInt32 zIndex0 = iz0;
 		ndFastRay ray(localP0, localP1);
+		ndFloat32 tEnter = ndFloat32(0.0f);
 	
 		// for each cell touched by the line
-		do 
+		while (tEnter <= ndFloat32(1.0f))
 		{
+			ndInt32 nodeBox[4];
+			if (RayMissMipNode(p0, dp, xIndex0, zIndex0, tEnter, nodeBox))
+			{
+				// the line passes above or below the whole tile, continue at the tile exit
+				const ndFloat32 txExit = (xInc > 0) ? (scale_x * ndFloat32(nodeBox[1] + 1) - p0.m_x) / dp.m_x : (xInc < 0) ? (scale_x * ndFloat32(nodeBox[0]) - p0.m_x) / dp.m_x : ndFloat32(1.0e10f);
+				const ndFloat32 tzExit = (zInc > 0) ? (scale_z * ndFloat32(nodeBox[3] + 1) - p0.m_z) / dp.m_z : (zInc < 0) ? (scale_z * ndFloat32(nodeBox[2]) - p0.m_z) / dp.m_z : ndFloat32(1.0e10f);
+				tEnter = ndMax(ndMin(txExit, tzExit), tEnter);
+
+				const ndVector exitPoint(p0 + dp.Scale(tEnter));
+				xIndex0 = ndClamp(FastInt(exitPoint.m_x * invScale_x), nodeBox[0], nodeBox[1]);
+				zIndex0 = ndClamp(FastInt(exitPoint.m_z * invScale_z), nodeBox[2], nodeBox[3]);
+				if (txExit <= tEnter)
+				{
+					xIndex0 = (xInc > 0) ? nodeBox[1] + 1 : nodeBox[0] - 1;
+				}
+				if (tzExit <= tEnter)
+				{
+					zIndex0 = (zInc > 0) ? nodeBox[3] + 1 : nodeBox[2] - 1;
+				}
+				txAcc = (xInc > 0) ? (scale_x * ndFloat32(xIndex0 + 1) - p0.m_x) / dp.m_x : (xInc < 0) ? (scale_x * ndFloat32(xIndex0) - p0.m_x) / dp.m_x : ndFloat32(1.0e10f);
+				tzAcc = (zInc > 0) ? (scale_z * ndFloat32(zIndex0 + 1) - p0.m_z) / dp.m_z : (zInc < 0) ? (scale_z * ndFloat32(zIndex0) - p0.m_z) / dp.m_z : ndFloat32(1.0e10f);
+				continue;
+			}
+
 			ndFloat32 t = RayCastCell(ray, xIndex0, zIndex0, normalOut, maxT);
 			if (t < maxT) 
 			{
@@ -444,41 +578,219 @@ ndFloat32 ndShapeHeightfield::RayCast(ndRayCastNotify&, const ndVector& localP0,
 			if (txAcc < tzAcc) 
 			{
 				xIndex0 += xInc;
-				tx = txAcc;
+				tEnter = txAcc;
 				txAcc += stepX;
 			}
 			else 
 			{
 				zIndex0 += zInc;
-				tz = tzAcc;
+				tEnter = tzAcc;
 				tzAcc += stepZ;
 			}
-		} while ((tx <= ndFloat32(1.0f)) || (tz <= ndFloat32(1.0f)));
+		}
 	}
 	
 	// if no cell was hit, return a large value
 	return ndFloat32(1.2f);
 }
 
+bool ndShapeHeightfield::RayMissMipNode(const ndVector& p0, const ndVector& dp, ndInt32 xIndex, ndInt32 zIndex, ndFloat32 tEnter, ndInt32* const nodeBox) const
+{
+	if ((xIndex < 0) || (zIndex < 0) || (xIndex >= (m_width - 1)) || (zIndex >= (m_height - 1)))
+	{
+		return false;
+	}
+
+	// a parent tile can only be skipped if its child is, so climb while the line misses
+	bool miss = false;
+	for (ndInt32 i = 0; i < ndInt32(m_mipLevels.GetCount()); ++i)
+	{
+		const ndMipLevel& level = m_mipLevels[i];
+		const ndInt32 shift = D_HEIGHTFIELD_MIP_TILE_SHIFT + i;
+		const ndInt32 nodeX = xIndex >> shift;
+		const ndInt32 nodeZ = zIndex >> shift;
+		const ndElevationRange& range = m_elevationMip[level.m_start + nodeZ * level.m_width + nodeX];
+
+		const ndInt32 x0 = nodeX << shift;
+		const ndInt32 z0 = nodeZ << shift;
+		const ndInt32 x1 = ndMin((nodeX + 1) << shift, m_width - 1);
+		const ndInt32 z1 = ndMin((nodeZ + 1) << shift, m_height - 1);
+		const ndFloat32 tx = (dp.m_x > ndFloat32(0.0f)) ? (m_horizontalScale_x * ndFloat32(x1) - p0.m_x) / dp.m_x : (dp.m_x < ndFloat32(0.0f)) ? (m_horizontalScale_x * ndFloat32(x0) - p0.m_x) / dp.m_x : ndFloat32(1.0e10f);
+		const ndFloat32 tz = (dp.m_z > ndFloat32(0.0f)) ? (m_horizontalScale_z * ndFloat32(z1) - p0.m_z) / dp.m_z : (dp.m_z < ndFloat32(0.0f)) ? (m_horizontalScale_z * ndFloat32(z0) - p0.m_z) / dp.m_z : ndFloat32(1.0e10f);
+		const ndFloat32 tExit = ndMin(ndMin(tx, tz), ndFloat32(1.0f));
+
+		const ndFloat32 y0 = p0.m_y + dp.m_y * tEnter;
+		const ndFloat32 y1 = p0.m_y + dp.m_y * tExit;
+		const ndFloat32 padding = ndFloat32(1.0e-3f);
+		if ((ndMin(y0, y1) <= (ndFloat32(range.m_max) + padding)) && (ndMax(y0, y1) >= (ndFloat32(range.m_min) - padding)))
+		{
+			break;
+		}
+
+		miss = true;
+		nodeBox[0] = x0;
+		nodeBox[1] = x1 - 1;
+		nodeBox[2] = z0;
+		nodeBox[3] = z1 - 1;
+	}
+	return miss;
+}
+
+void ndShapeHeightfield::ElevationRange(ndInt32 levelIndex, ndInt32 nodeX, ndInt32 nodeZ, ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndReal& minVal, ndReal& maxVal) const
+{
+	const ndInt32 shift = D_HEIGHTFIELD_MIP_TILE_SHIFT + levelIndex;
+	const ndInt32 nodeX0 = nodeX << shift;
+	const ndInt32 nodeZ0 = nodeZ << shift;
+	const ndInt32 nodeX1 = ndMin((nodeX + 1) << shift, m_width - 1) - 1;
+	const ndInt32 nodeZ1 = ndMin((nodeZ + 1) << shift, m_height - 1) - 1;
+	if ((nodeX0 > x1) || (nodeX1 < x0) || (nodeZ0 > z1) || (nodeZ1 < z0))
+	{
+		return;
+	}
+
+	const ndMipLevel& level = m_mipLevels[levelIndex];
+	if ((nodeX0 >= x0) && (nodeX1 <= x1) && (nodeZ0 >= z0) && (nodeZ1 <= z1))
+	{
+		const ndElevationRange& range = m_elevationMip[level.m_start + nodeZ * level.m_width + nodeX];
+		minVal = ndMin(minVal, range.m_min);
+		maxVal = ndMax(maxVal, range.m_max);
+	}
+	else if (levelIndex == 0)
+	{
+		// partially covered base tile, scan the vertices of the covered cells
+		const ndInt32 vx0 = ndMax(nodeX0, x0);
+		const ndInt32 vx1 = ndMin(nodeX1, x1) + 1;
+		const ndInt32 vz1 = ndMin(nodeZ1, z1) + 1;
+		for (ndInt32 z = ndMax(nodeZ0, z0); z <= vz1; ++z)
+		{
+			const ndReal* const row = &m_elevationMap[z * m_width];
+			for (ndInt32 x = vx0; x <= vx1; ++x)
+			{
+				minVal = ndMin(minVal, row[x]);
+				maxVal = ndMax(maxVal, row[x]);
+			}
+		}
+	}
+	else
+	{
+		const ndMipLevel& childLevel = m_mipLevels[levelIndex - 1];
+		const ndInt32 cx1 = ndMin(2 * nodeX + 1, childLevel.m_width - 1);
+		const ndInt32 cz1 = ndMin(2 * nodeZ + 1, childLevel.m_height - 1);
+		for (ndInt32 cz = 2 * nodeZ; cz <= cz1; ++cz)
+		{
+			for (ndInt32 cx = 2 * nodeX; cx <= cx1; ++cx)
+			{
+				ElevationRange(levelIndex - 1, cx, cz, x0, x1, z0, z1, minVal, maxVal);
+			}
+		}
+	}
+}
+
 void ndShapeHeightfield::CalculateMinAndMaxElevation(ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndFloat32& minHeight, ndFloat32& maxHeight) const
 {
 	ndReal minVal = ndReal(1.0e10f);
 	ndReal maxVal = -ndReal(1.0e10f);
 
-	ndInt32 base = z0 * m_width;
-	for (ndInt32 z = z0; z <= z1; ++z) 
+	// the vertex range maps to the cells in between, a degenerated range takes the next cell
+	const ndInt32 cx0 = ndClamp(x0, 0, m_width - 2);
+	const ndInt32 cz0 = ndClamp(z0, 0, m_height - 2);
+	const ndInt32 cx1 = ndClamp(x1 - 1, cx0, m_width - 2);
+	const ndInt32 cz1 = ndClamp(z1 - 1, cz0, m_height - 2);
+	ElevationRange(ndInt32(m_mipLevels.GetCount()) - 1, 0, 0, cx0, cx1, cz0, cz1, minVal, maxVal);
+
+	minHeight = minVal;
+	maxHeight = maxVal;
+}
+
+void ndShapeHeightfield::ElevationClip(ndInt32 levelIndex, ndInt32 nodeX, ndInt32 nodeZ, ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndFloat32 minHeight, ndFloat32 maxHeight, ndInt32* const clipBox) const
+{
+	const ndInt32 shift = D_HEIGHTFIELD_MIP_TILE_SHIFT + levelIndex;
+	const ndInt32 nodeX0 = ndMax(nodeX << shift, x0);
+	const ndInt32 nodeZ0 = ndMax(nodeZ << shift, z0);
+	const ndInt32 nodeX1 = ndMin(ndMin((nodeX + 1) << shift, m_width - 1) - 1, x1);
+	const ndInt32 nodeZ1 = ndMin(ndMin((nodeZ + 1) << shift, m_height - 1) - 1, z1);
+	if ((nodeX0 > nodeX1) || (nodeZ0 > nodeZ1))
+	{
+		return;
+	}
+	if ((nodeX0 >= clipBox[0]) && (nodeX1 <= clipBox[1]) && (nodeZ0 >= clipBox[2]) && (nodeZ1 <= clipBox[3]))
+	{
+		// nothing in this tile can grow the clip box
+		return;
+	}
+
+	const ndMipLevel& level = m_mipLevels[levelIndex];
+	const ndElevationRange& range = m_elevationMip[level.m_start + nodeZ * level.m_width + nodeX];
+	if ((ndFloat32(range.m_max) < minHeight) || (ndFloat32(range.m_min) > maxHeight))
+	{
+		return;
+	}
+
+	if ((ndFloat32(range.m_min) >= minHeight) && (ndFloat32(range.m_max) <= maxHeight))
+	{
+		// every cell of the tile is in the elevation range
+		clipBox[0] = ndMin(clipBox[0], nodeX0);
+		clipBox[1] = ndMax(clipBox[1], nodeX1);
+		clipBox[2] = ndMin(clipBox[2], nodeZ0);
+		clipBox[3] = ndMax(clipBox[3], nodeZ1);
+	}
+	else if (levelIndex == 0)
 	{
-		for (ndInt32 x = x0; x <= x1; ++x) 
+		for (ndInt32 z = nodeZ0; z <= nodeZ1; ++z)
 		{
-			ndReal high = m_elevationMap[base + x];
-			minVal = ndMin(high, minVal);
-			maxVal = ndMax(high, maxVal);
+			const ndReal* const row0 = &m_elevationMap[z * m_width];
+			const ndReal* const row1 = row0 + m_width;
+			for (ndInt32 x = nodeX0; x <= nodeX1; ++x)
+			{
+				const ndFloat32 cellMin = ndFloat32(ndMin(ndMin(row0[x], row0[x + 1]), ndMin(row1[x], row1[x + 1])));
+				const ndFloat32 cellMax = ndFloat32(ndMax(ndMax(row0[x], row0[x + 1]), ndMax(row1[x], row1[x + 1])));
+				if ((cellMax >= minHeight) && (cellMin <= maxHeight))
+				{
+					clipBox[0] = ndMin(clipBox[0], x);
+					clipBox[1] = ndMax(clipBox[1], x);
+					clipBox[2] = ndMin(clipBox[2], z);
+					clipBox[3] = ndMax(clipBox[3], z);
+				}
+			}
 		}
-		base += m_width;
 	}
+	else
+	{
+		const ndMipLevel& childLevel = m_mipLevels[levelIndex - 1];
+		const ndInt32 cx1 = ndMin(2 * nodeX + 1, childLevel.m_width - 1);
+		const ndInt32 cz1 = ndMin(2 * nodeZ + 1, childLevel.m_height - 1);
+		for (ndInt32 cz = 2 * nodeZ; cz <= cz1; ++cz)
+		{
+			for (ndInt32 cx = 2 * nodeX; cx <= cx1; ++cx)
+			{
+				ElevationClip(levelIndex - 1, cx, cz, x0, x1, z0, z1, minHeight, maxHeight, clipBox);
+			}
+		}
+	}
+}
 
-	minHeight = minVal;
-	maxHeight = maxVal;
+bool ndShapeHeightfield::ClipCellsToElevation(ndInt32& x0, ndInt32& x1, ndInt32& z0, ndInt32& z1, ndFloat32 minHeight, ndFloat32 maxHeight) const
+{
+	ndAssert(x1 > x0);
+	ndAssert(z1 > z0);
+
+	// shrink the vertex range to the cells that overlap the elevation range
+	ndInt32 clipBox[4];
+	clipBox[0] = x1;
+	clipBox[1] = x0 - 1;
+	clipBox[2] = z1;
+	clipBox[3] = z0 - 1;
+	ElevationClip(ndInt32(m_mipLevels.GetCount()) - 1, 0, 0, x0, x1 - 1, z0, z1 - 1, minHeight, maxHeight, clipBox);
+	if (clipBox[0] > clipBox[1])
+	{
+		return false;
+	}
+
+	x0 = clipBox[0];
+	x1 = clipBox[1] + 1;
+	z0 = clipBox[2];
+	z1 = clipBox[3] + 1;
+	return true;
 }
 
 void ndShapeHeightfield::GetCollidingFaces(ndPolygonMeshDesc* const data) const
@@ -513,12 +825,10 @@ void ndShapeHeightfield::GetCollidingFaces(ndPolygonMeshDesc* const data) const
 		return;
 	}
 
-	ndFloat32 minHeight = ndFloat32(1.0e10f);
-	ndFloat32 maxHeight = ndFloat32(-1.0e10f);
 	data->SetSeparatingDistance(ndFloat32(0.0f));
-	CalculateMinAndMaxElevation(x0, x1, z0, z1, minHeight, maxHeight);
 
-	if (!((maxHeight < boxP0.m_y) || (minHeight > boxP1.m_y))) 
+	// cells entirely above or below the query box can not make contacts
+	if (ClipCellsToElevation(x0, x1, z0, z1, boxP0.m_y, boxP1.m_y))
 	{
 		ndPolygonMeshDesc::ndStaticMeshFaceQuery& query = *data->m_staticMeshQuery;
 		ndArray<ndVector>& vertex = data->m_proceduralStaticMeshFaceQuery->m_vertex;
@@ -25,6 +25,9 @@
 #include "ndCollisionStdafx.h"
 #include "ndShapeStaticMesh.h"
 
+// cells per side of the base tiles of the elevation min max pyramid, as a power of two
+#define D_HEIGHTFIELD_MIP_TILE_SHIFT	2
+
 class ndShapeHeightfield: public ndShapeStaticMesh
 {
 	public:
@@ -65,7 +68,10 @@ class ndShapeHeightfield: public ndShapeStaticMesh
 	D_COLLISION_API ndArray<ndInt8>& GetAttributeMap();
 	D_COLLISION_API const ndArray<ndInt8>& GetAttributeMap() const;
 
+	// must be called after editing the elevation map, it rebuilds the min max pyramid.
 	D_COLLISION_API void UpdateElevationMapAabb();
+	// only rebuilds the pyramid tiles touched by the edited vertex rectangle (inclusive)
+	D_COLLISION_API void UpdateElevationMapAabb(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1);
 	D_COLLISION_API void GetLocalAabb(const ndVector& p0, const ndVector& p1, ndVector& boxP0, ndVector& boxP1) const;
 
 	protected:
@@ -77,7 +83,27 @@ class ndShapeHeightfield: public ndShapeStaticMesh
 	virtual void GetCollidingFaces(ndPolygonMeshDesc* const data) const;
 
 	private: 
+	class ndElevationRange
+	{
+		public:
+		ndReal m_min;
+		ndReal m_max;
+	};
+
+	class ndMipLevel
+	{
+		public:
+		ndInt32 m_start;
+		ndInt32 m_width;
+		ndInt32 m_height;
+	};
+
 	void CalculateLocalObb();
+	void BuildMipTiles(ndInt32 level, ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1);
+	void ElevationRange(ndInt32 level, ndInt32 nodeX, ndInt32 nodeZ, ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndReal& minVal, ndReal& maxVal) const;
+	void ElevationClip(ndInt32 level, ndInt32 nodeX, ndInt32 nodeZ, ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndFloat32 minHeight, ndFloat32 maxHeight, ndInt32* const clipBox) const;
+	bool RayMissMipNode(const ndVector& p0, const ndVector& dp, ndInt32 xIndex, ndInt32 zIndex, ndFloat32 tEnter, ndInt32* const nodeBox) const;
+	bool ClipCellsToElevation(ndInt32& x0, ndInt32& x1, ndInt32& z0, ndInt32& z1, ndFloat32 minHeight, ndFloat32 maxHeight) const;
 	ndInt32 FastInt(ndFloat32 x) const;
 	const ndInt32* GetIndexList() const;
 	void CalculateMinExtend2d(const ndVector& p0, const ndVector& p1, ndVector& boxP0, ndVector& boxP1) const;
@@ -89,6 +115,8 @@ class ndShapeHeightfield: public ndShapeStaticMesh
 	ndVector m_maxBox;
 	ndArray<ndInt8> m_attributeMap;
 	ndArray<ndReal> m_elevationMap;
+	ndArray<ndElevationRange> m_elevationMip;
+	ndArray<ndMipLevel> m_mipLevels;
 	ndFloat32 m_horizontalScale_x;
 	ndFloat32 m_horizontalScale_z;
 	ndFloat32 m_horizontalScaleInv_x;
@@ -212,6 +212,29 @@ ndVector ndShapeInstance::SupportVertexSpecial(const ndVector& inDir) const
 	}
 }
 
+ndVector ndShapeInstance::SupportVertexSpecial(const ndVector& inDir, ndInt32* const vertexCache) const
+{
+	const ndVector dir(inDir & ndVector::m_triplexMask);
+	ndAssert(dir.m_w == ndFloat32(0.0f));
+	ndAssert(ndAbs(dir.DotProduct(dir).GetScalar() - ndFloat32(1.0f)) < ndFloat32(1.0e-2f));
+	switch (m_scaleType)
+	{
+	case m_unit:
+	{
+		return m_shape->SupportVertexSpecialCached(dir, m_skinMargin, vertexCache);
+	}
+	case m_uniform:
+	{
+		return m_scale * m_shape->SupportVertexSpecialCached(dir, m_skinMargin, vertexCache);
+	}
+
+	case m_global:
+	case m_nonUniform:
+	default:
+		return SupportVertex(dir);
+	}
+}
+
 ndVector ndShapeInstance::SupportVertexSpecialProjectPoint(const ndVector& point, const ndVector& inDir) const
 {
 	const ndVector dir(inDir & ndVector::m_triplexMask);
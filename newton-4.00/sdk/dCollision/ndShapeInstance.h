@@ -135,6 +135,7 @@ class ndShapeInstance: public ndContainersFreeListAlloc<ndShapeInstance>
 	D_COLLISION_API ndVector SupportVertex(const ndVector& dir) const;
 	D_COLLISION_API ndMatrix GetScaledTransform(const ndMatrix& matrix) const;
 	D_COLLISION_API ndVector SupportVertexSpecial(const ndVector& dir) const;
+	D_COLLISION_API ndVector SupportVertexSpecial(const ndVector& dir, ndInt32* const vertexCache) const;
 	D_COLLISION_API ndVector SupportVertexSpecialProjectPoint(const ndVector& point, const ndVector& dir) const;
 
 	D_COLLISION_API const ndMatrix& GetLocalMatrix() const;
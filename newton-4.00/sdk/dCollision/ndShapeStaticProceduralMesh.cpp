@@ -27,8 +27,80 @@
 #include "ndPolygonMeshDesc.h"
 #include "ndShapeStaticProceduralMesh.h"
 
+template <class T>
+static void ndCopyArray(ndArray<T>& dst, const ndArray<T>& src)
+{
+	dst.SetCount(src.GetCount());
+	if (src.GetCount())
+	{
+		ndMemCpy(&dst[0], &src[0], src.GetCount());
+	}
+}
+
+ndShapeStaticProceduralMesh::ndFaceCacheStatistics::ndFaceCacheStatistics()
+	:m_hits(0)
+	,m_misses(0)
+	,m_evictions(0)
+	,m_entries(0)
+	,m_memory(0)
+{
+}
+
+ndShapeStaticProceduralMesh::ndFaceCacheFaces::ndFaceCacheFaces()
+	:ndClassAlloc()
+	,m_vertex()
+	,m_faceList()
+	,m_faceMaterial()
+	,m_indexList()
+	,m_refCount(1)
+{
+}
+
+size_t ndShapeStaticProceduralMesh::ndFaceCacheFaces::GetMemory() const
+{
+	size_t memory = size_t(m_vertex.GetCapacity()) * sizeof(ndVector);
+	memory += size_t(m_faceList.GetCapacity() + m_faceMaterial.GetCapacity() + m_indexList.GetCapacity()) * sizeof(ndInt32);
+	return memory;
+}
+
+void ndShapeStaticProceduralMesh::ndFaceCacheFaces::AddRef()
+{
+	m_refCount.fetch_add(1);
+}
+
+void ndShapeStaticProceduralMesh::ndFaceCacheFaces::Release()
+{
+	if (m_refCount.fetch_add(-1) == 1)
+	{
+		delete this;
+	}
+}
+
+ndShapeStaticProceduralMesh::ndFaceCacheEntry::ndFaceCacheEntry()
+	:m_minBox(ndVector::m_zero)
+	,m_maxBox(ndVector::m_zero)
+	,m_faces(nullptr)
+	,m_key(0)
+	,m_memory(0)
+{
+}
+
+ndShapeStaticProceduralMesh::ndFaceCacheEntry::~ndFaceCacheEntry()
+{
+	if (m_faces)
+	{
+		m_faces->Release();
+	}
+}
+
 ndShapeStaticProceduralMesh::ndShapeStaticProceduralMesh(ndFloat32 sizex, ndFloat32 sizey, ndFloat32 sizez)
 	:ndShapeStaticMesh(m_staticProceduralMesh)
+	,m_faceCache()
+	,m_faceCacheMap()
+	,m_faceCacheStats()
+	,m_faceCacheLock()
+	,m_faceCacheCellSize(ndFloat32(1.0f))
+	,m_faceCacheMaxEntries(0)
 {
 	m_boxOrigin = ndVector::m_zero;
 	m_boxSize = ndVector(sizex, sizey, sizez, ndFloat32 (0.0f)) * ndVector::m_half;
@@ -38,6 +110,147 @@ ndShapeStaticProceduralMesh::~ndShapeStaticProceduralMesh(void)
 {
 }
 
+void ndShapeStaticProceduralMesh::SetFaceCache(ndFloat32 cellSize, ndInt32 maxEntries)
+{
+	ndAssert(cellSize > ndFloat32(0.0f));
+	InvalidateFaceCache();
+	m_faceCacheCellSize = ndMax(cellSize, ndFloat32(1.0e-3f));
+	m_faceCacheMaxEntries = ndMax(maxEntries, 0);
+}
+
+void ndShapeStaticProceduralMesh::InvalidateFaceCache()
+{
+	ndScopeSpinLock lock(m_faceCacheLock);
+	m_faceCache.RemoveAll();
+	m_faceCacheMap.RemoveAll();
+	m_faceCacheStats.m_entries = 0;
+	m_faceCacheStats.m_memory = 0;
+}
+
+void ndShapeStaticProceduralMesh::InvalidateFaceCache(const ndVector& minBox, const ndVector& maxBox)
+{
+	ndScopeSpinLock lock(m_faceCacheLock);
+	ndFaceCache::ndNode* nextNode;
+	for (ndFaceCache::ndNode* node = m_faceCache.GetFirst(); node; node = nextNode)
+	{
+		nextNode = node->GetNext();
+		const ndFaceCacheEntry& entry = node->GetInfo();
+		const ndVector test((minBox > entry.m_maxBox) | (maxBox < entry.m_minBox));
+		if (!(test.GetSignMask() & 0x07))
+		{
+			RemoveFaceCacheEntry(node);
+		}
+	}
+}
+
+void ndShapeStaticProceduralMesh::RemoveFaceCacheEntry(ndFaceCache::ndNode* const node) const
+{
+	const ndFaceCacheEntry& entry = node->GetInfo();
+	m_faceCacheStats.m_entries--;
+	m_faceCacheStats.m_memory -= entry.m_memory;
+	m_faceCacheMap.Remove(entry.m_key);
+	m_faceCache.Remove(node);
+}
+
+ndShapeStaticProceduralMesh::ndFaceCacheStatistics ndShapeStaticProceduralMesh::GetFaceCacheStatistics() const
+{
+	ndScopeSpinLock lock(m_faceCacheLock);
+	return m_faceCacheStats;
+}
+
+void ndShapeStaticProceduralMesh::ResetFaceCacheStatistics()
+{
+	ndScopeSpinLock lock(m_faceCacheLock);
+	m_faceCacheStats.m_hits = 0;
+	m_faceCacheStats.m_misses = 0;
+	m_faceCacheStats.m_evictions = 0;
+}
+
+void ndShapeStaticProceduralMesh::GetCachedFaces(const ndVector& minBox, const ndVector& maxBox, ndArray<ndVector>& vertex, ndArray<ndInt32>& faceList, ndArray<ndInt32>& faceMaterial, ndArray<ndInt32>& indexList) const
+{
+	const ndVector cellSize(m_faceCacheCellSize);
+	const ndVector invCellSize(ndFloat32(1.0f) / m_faceCacheCellSize);
+	const ndVector cellMin((minBox * invCellSize).Floor());
+	const ndVector cellMax((maxBox * invCellSize).Floor());
+	const ndVector cellMinBox((cellMin * cellSize) & ndVector::m_triplexMask);
+	const ndVector cellMaxBox((cellMax * cellSize + cellSize) & ndVector::m_triplexMask);
+
+	const ndInt32 cells[] = 
+	{
+		ndInt32(cellMin.m_x), ndInt32(cellMin.m_y), ndInt32(cellMin.m_z),
+		ndInt32(cellMax.m_x), ndInt32(cellMax.m_y), ndInt32(cellMax.m_z),
+	};
+	const ndUnsigned64 key = ndCRC64(cells, ndInt32(sizeof(cells)), 0);
+
+	ndFaceCacheFaces* faces = nullptr;
+	{
+		ndScopeSpinLock lock(m_faceCacheLock);
+		ndFaceCacheMap::ndNode* const mapNode = m_faceCacheMap.Find(key);
+		if (mapNode)
+		{
+			ndFaceCache::ndNode* const node = mapNode->GetInfo();
+			const ndFaceCacheEntry& entry = node->GetInfo();
+			// a hash collision is just a miss
+			const ndVector test((cellMinBox == entry.m_minBox) & (cellMaxBox == entry.m_maxBox));
+			if ((test.GetSignMask() & 0x07) == 0x07)
+			{
+				faces = entry.m_faces;
+				faces->AddRef();
+				m_faceCache.RotateToBegin(node);
+				m_faceCacheStats.m_hits++;
+			}
+		}
+		if (!faces)
+		{
+			m_faceCacheStats.m_misses++;
+		}
+	}
+
+	if (faces)
+	{
+		// the reference keeps the faces alive if the region is evicted during the copy
+		ndCopyArray(vertex, faces->m_vertex);
+		ndCopyArray(faceList, faces->m_faceList);
+		ndCopyArray(faceMaterial, faces->m_faceMaterial);
+		ndCopyArray(indexList, faces->m_indexList);
+		faces->Release();
+		return;
+	}
+
+	// the callback and the copy run outside the lock, other threads can still read the cache
+	GetCollidingFaces(cellMinBox, cellMaxBox, vertex, faceList, faceMaterial, indexList);
+	faces = new ndFaceCacheFaces();
+	ndCopyArray(faces->m_vertex, vertex);
+	ndCopyArray(faces->m_faceList, faceList);
+	ndCopyArray(faces->m_faceMaterial, faceMaterial);
+	ndCopyArray(faces->m_indexList, indexList);
+	const size_t memory = faces->GetMemory();
+
+	ndScopeSpinLock lock(m_faceCacheLock);
+	ndFaceCacheMap::ndNode* const mapNode = m_faceCacheMap.Find(key);
+	if (mapNode)
+	{
+		// another thread cached this region, or a colliding one, while the faces were generated
+		RemoveFaceCacheEntry(mapNode->GetInfo());
+	}
+	while (m_faceCache.GetCount() >= m_faceCacheMaxEntries)
+	{
+		RemoveFaceCacheEntry(m_faceCache.GetLast());
+		m_faceCacheStats.m_evictions++;
+	}
+
+	ndFaceCache::ndNode* const node = m_faceCache.Addtop();
+	ndFaceCacheEntry& entry = node->GetInfo();
+	entry.m_minBox = cellMinBox;
+	entry.m_maxBox = cellMaxBox;
+	entry.m_faces = faces;
+	entry.m_key = key;
+	entry.m_memory = memory;
+	m_faceCacheMap.Insert(node, key);
+	m_faceCacheStats.m_memory += memory;
+	m_faceCacheStats.m_entries++;
+}
+
 ndShapeInfo ndShapeStaticProceduralMesh::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeStaticMesh::GetShapeInfo());
@@ -54,7 +267,14 @@ void ndShapeStaticProceduralMesh::GetCollidingFaces(ndPolygonMeshDesc* const dat
 	ndArray<ndInt32>& faceList = query.m_faceIndexCount;
 	ndArray<ndInt32>& indexList = meshPatch.m_indexListList;
 	ndArray<ndInt32>& faceMaterialList = meshPatch.m_faceMaterial;
-	GetCollidingFaces(data->GetOrigin(), data->GetTarget(), vertex, faceList, faceMaterialList, indexList);
+	if (m_faceCacheMaxEntries)
+	{
+		GetCachedFaces(data->GetOrigin(), data->GetTarget(), vertex, faceList, faceMaterialList, indexList);
+	}
+	else
+	{
+		GetCollidingFaces(data->GetOrigin(), data->GetTarget(), vertex, faceList, faceMaterialList, indexList);
+	}
 
 	if (faceList.GetCount() == 0)
 	{
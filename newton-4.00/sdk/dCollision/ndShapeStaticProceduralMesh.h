@@ -56,10 +56,34 @@ class ndShapeStaticProceduralMesh: public ndShapeStaticMesh
 		ndEdgeMap();
 	};
 
+	class ndFaceCacheStatistics
+	{
+		public:
+		ndFaceCacheStatistics();
+
+		ndUnsigned64 m_hits;
+		ndUnsigned64 m_misses;
+		ndUnsigned64 m_evictions;
+		ndInt32 m_entries;
+		size_t m_memory;
+	};
+
 	D_CLASS_REFLECTION(ndShapeStaticProceduralMesh, ndShapeStaticMesh)
 	D_COLLISION_API ndShapeStaticProceduralMesh(ndFloat32 sizex, ndFloat32 sizey, ndFloat32 sizez);
 	D_COLLISION_API virtual ~ndShapeStaticProceduralMesh();
 
+	// cache the faces generated by the user callback. query boxes are snapped
+	// outward to a grid of cellSize, so a body that barely moves keeps hitting
+	// the same region. the regions are found by a hash of their cells, and the
+	// least recently used region is evicted when the cache is full.
+	// zero entries disables the cache, which is the default.
+	D_COLLISION_API void SetFaceCache(ndFloat32 cellSize, ndInt32 maxEntries);
+	// must be called when the procedural surface changes
+	D_COLLISION_API void InvalidateFaceCache();
+	D_COLLISION_API void InvalidateFaceCache(const ndVector& minBox, const ndVector& maxBox);
+	D_COLLISION_API ndFaceCacheStatistics GetFaceCacheStatistics() const;
+	D_COLLISION_API void ResetFaceCacheStatistics();
+
 	virtual ndShapeStaticProceduralMesh* GetAsShapeStaticProceduralMesh() { return this; }
 	virtual void GetCollidingFaces(const ndVector& minBox, const ndVector& maxBox, ndArray<ndVector>& vertex, ndArray<ndInt32>& faceList, ndArray<ndInt32>& faceMaterial, ndArray<ndInt32>& indexListList) const;
 
@@ -70,6 +94,59 @@ class ndShapeStaticProceduralMesh: public ndShapeStaticMesh
 	D_COLLISION_API virtual void GetCollidingFaces(ndPolygonMeshDesc* const data) const;
 
 	private:
+	// the faces of a region are reference counted, so that a reader can copy
+	// them outside the lock while another thread evicts the region.
+	class ndFaceCacheFaces: public ndClassAlloc
+	{
+		public:
+		ndFaceCacheFaces();
+		size_t GetMemory() const;
+		void AddRef();
+		void Release();
+
+		ndArray<ndVector> m_vertex;
+		ndArray<ndInt32> m_faceList;
+		ndArray<ndInt32> m_faceMaterial;
+		ndArray<ndInt32> m_indexList;
+		ndAtomic<ndInt32> m_refCount;
+	};
+
+	class ndFaceCacheEntry
+	{
+		public:
+		ndFaceCacheEntry();
+		~ndFaceCacheEntry();
+
+		ndVector m_minBox;
+		ndVector m_maxBox;
+		ndFaceCacheFaces* m_faces;
+		ndUnsigned64 m_key;
+		size_t m_memory;
+	};
+
+	class ndFaceCache: public ndList<ndFaceCacheEntry, ndContainersFreeListAlloc<ndFaceCacheEntry>>
+	{
+		public:
+		ndFaceCache();
+	};
+
+	class ndFaceCacheMap: public ndTree<ndFaceCache::ndNode*, ndUnsigned64, ndContainersFreeListAlloc<ndFaceCache::ndNode*>>
+	{
+		public:
+		ndFaceCacheMap();
+	};
+
+	void RemoveFaceCacheEntry(ndFaceCache::ndNode* const node) const;
+
+	void GetCachedFaces(const ndVector& minBox, const ndVector& maxBox, ndArray<ndVector>& vertex, ndArray<ndInt32>& faceList, ndArray<ndInt32>& faceMaterial, ndArray<ndInt32>& indexListList) const;
+
+	mutable ndFaceCache m_faceCache;
+	mutable ndFaceCacheMap m_faceCacheMap;
+	mutable ndFaceCacheStatistics m_faceCacheStats;
+	mutable ndSpinLock m_faceCacheLock;
+	ndFloat32 m_faceCacheCellSize;
+	ndInt32 m_faceCacheMaxEntries;
+
 	friend class ndContactSolver;
 };
 
@@ -101,6 +178,16 @@ inline bool ndShapeStaticProceduralMesh::ndEdge::operator> (const ndEdge& edge)
 	return m_key > edge.m_key;
 }
 
+inline ndShapeStaticProceduralMesh::ndFaceCache::ndFaceCache()
+	:ndList<ndFaceCacheEntry, ndContainersFreeListAlloc<ndFaceCacheEntry>>()
+{
+}
+
+inline ndShapeStaticProceduralMesh::ndFaceCacheMap::ndFaceCacheMap()
+	:ndTree<ndFaceCache::ndNode*, ndUnsigned64, ndContainersFreeListAlloc<ndFaceCache::ndNode*>>()
+{
+}
+
 inline ndShapeStaticProceduralMesh::ndEdgeMap::ndEdgeMap()
 	:ndTree<ndInt32, ndEdge, ndContainersFreeListAlloc<ndInt32>>()
 {
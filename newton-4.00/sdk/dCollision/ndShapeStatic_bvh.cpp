@@ -61,20 +61,49 @@ ndShapeStatic_bvh::ndShapeStatic_bvh()
 {
 }
 
-ndShapeStatic_bvh::ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder)
+ndShapeStatic_bvh::ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder, bool compressedTree)
 	:ndShapeStaticMesh(m_boundingBoxHierachy)
 	,ndAabbPolygonSoup()
 	,m_trianglesCount(0)
 {
 	Create(builder);
 	CalculateAdjacent();
+	if (compressedTree)
+	{
+		CreateCompressedTree();
+	}
+	CalculateBoundingBox();
+	m_trianglesCount = CalculateTrianglesCount();
+}
+
+ndShapeStatic_bvh::ndShapeStatic_bvh(const char* const path, bool mapFile)
+	:ndShapeStaticMesh(m_boundingBoxHierachy)
+	,ndAabbPolygonSoup()
+	,m_trianglesCount(0)
+{
+	// fall back to a private copy for files that can not be mapped
+	if (!(mapFile && MapFile(path)))
+	{
+		if (!Deserialize(path))
+		{
+			ndTrace(("can not load static mesh %s\n", path));
+		}
+	}
+	CalculateBoundingBox();
+	m_trianglesCount = CalculateTrianglesCount();
+}
 
+void ndShapeStatic_bvh::CalculateBoundingBox()
+{
 	ndVector p0;
 	ndVector p1;
 	GetAABB(p0, p1);
 	m_boxSize = (p1 - p0) * ndVector::m_half;
 	m_boxOrigin = (p1 + p0) * ndVector::m_half;
+}
 
+ndInt32 ndShapeStatic_bvh::CalculateTrianglesCount() const
+{
 	ndMeshVertexListIndexList data;
 	data.m_indexList = nullptr;
 	data.m_userDataList = nullptr;
@@ -83,7 +112,7 @@ ndShapeStatic_bvh::ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder)
 	ndVector zero(ndVector::m_zero);
 	ndFastAabb box(ndGetIdentityMatrix(), ndVector(ndFloat32(1.0e15f)));
 	ForAllSectors(box, zero, ndFloat32(1.0f), GetTriangleCount, &data);
-	m_trianglesCount = data.m_triangleCount;
+	return data.m_triangleCount;
 }
 
 ndShapeStatic_bvh::~ndShapeStatic_bvh(void)
@@ -31,7 +31,8 @@ class ndShapeStatic_bvh: public ndShapeStaticMesh, public ndAabbPolygonSoup
 	D_CLASS_REFLECTION(ndShapeStatic_bvh,ndShapeStaticMesh)
 
 	D_COLLISION_API ndShapeStatic_bvh();
-	D_COLLISION_API ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder);
+	D_COLLISION_API ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder, bool compressedTree = false);
+	D_COLLISION_API ndShapeStatic_bvh(const char* const path, bool mapFile = true);
 	D_COLLISION_API virtual ~ndShapeStatic_bvh();
 	D_COLLISION_API void *operator new (size_t size);
 	D_COLLISION_API void operator delete (void* ptr);
@@ -51,6 +52,8 @@ class ndShapeStatic_bvh: public ndShapeStaticMesh, public ndAabbPolygonSoup
 	static ndIntersectStatus GetPolygon(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
 
 	private: 
+	void CalculateBoundingBox();
+	ndInt32 CalculateTrianglesCount() const;
 	static ndIntersectStatus CalculateHash (
 			void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes,
 			const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
@@ -29,7 +29,104 @@
 #include "ndAabbPolygonSoup.h"
 #include "ndPolygonSoupBuilder.h"
 
+#if !(defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
 #define DG_STACK_DEPTH 512
+#define D_COMPRESSED_QUANTIZATION	ndFloat32 (65535.0f)
+#define D_COMPRESSED_LEAF_PADDING	ndFloat32 (1.0e-3f)
+
+#define D_POLYGON_SOUP_FILE_ID		"ndBvh002"
+#define D_POLYGON_SOUP_FILE_ID_001	"ndBvh001"
+#define D_POLYGON_SOUP_FILE_ALIGN	size_t(64)
+#define D_POLYGON_SOUP_FILE_ALIGNED(size) ((size_t(size) + D_POLYGON_SOUP_FILE_ALIGN - 1) & ~(D_POLYGON_SOUP_FILE_ALIGN - 1))
+
+// compact face format: id low, id high, faceSize low, faceSize high, i0, i1, i2, ... , normal, e0Normal, e1Normal, e2Normal, ...
+// the edge normals keep the concave flag in the top bit, so the indices must fit in 15 bits.
+#define D_COMPACT_INDEX_LIMIT		0x7fff
+#define D_COMPACT_CONCAVE_EDGE		0x8000
+#define D_COMPACT_EMPTY_EDGE		0xffff
+// a decoded face, plus the offset of its compact record after the face size
+#define D_COMPACT_FACE_BUFFER		(2 * (1 << DG_INDEX_COUNT_BITS) + 4)
+
+// all sections are stored at aligned offsets from the start of the file,
+// the element sizes reject files written by a build with a different layout.
+class ndPolygonSoupFileHeader
+{
+	public:
+	char m_id[8];
+	ndInt32 m_vertexSize;
+	ndInt32 m_nodeSize;
+	ndInt32 m_compressedNodeSize;
+	ndInt32 m_vertexCount;
+	ndInt32 m_indexCount;
+	ndInt32 m_nodesCount;
+	ndInt32 m_compressedNodesCount;
+	// zero in ndBvh001 files, which always store 32 bit indices
+	ndInt32 m_indexSize;
+	ndUnsigned64 m_vertexOffset;
+	ndUnsigned64 m_indexOffset;
+	ndUnsigned64 m_nodeOffset;
+	ndUnsigned64 m_compressedNodeOffset;
+	ndUnsigned64 m_fileSize;
+	// root box of the compressed hierarchy, for files without the binary one
+	ndTriplex m_compressedBox[2];
+};
+
+static void* ndMapFileCopyOnWrite(const char* const path, size_t& size)
+{
+	void* data = nullptr;
+	size = 0;
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart)
+		{
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping)
+			{
+				data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				size = data ? size_t(fileSize.QuadPart) : 0;
+				// the view keeps the mapping alive
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	ndInt32 file = open(path, O_RDONLY);
+	if (file >= 0)
+	{
+		struct stat info;
+		if (!fstat(file, &info) && info.st_size)
+		{
+			data = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+			if (data == MAP_FAILED)
+			{
+				data = nullptr;
+			}
+			size = data ? size_t(info.st_size) : 0;
+		}
+		close(file);
+	}
+#endif
+	return data;
+}
+
+static void ndUnmapFile(void* const data, size_t size)
+{
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	size = 0;
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
 
 D_MSV_NEWTON_ALIGN_32
 class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
@@ -117,6 +214,15 @@ class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
 	const ndInt32* m_faceIndices;
 } D_GCC_NEWTON_ALIGN_32;
 
+D_MSV_NEWTON_ALIGN_32
+class ndAabbPolygonSoup::ndCompressedBuilder
+{
+	public:
+	ndVector m_p0;
+	ndVector m_p1;
+	ndUnsigned32 m_node;
+} D_GCC_NEWTON_ALIGN_32;
+
 class ndAabbPolygonSoup::ndSplitInfo
 {
 	public:
@@ -232,18 +338,47 @@ ndAabbPolygonSoup::ndAabbPolygonSoup ()
 	:ndPolygonSoupDatabase()
 	,m_aabb(nullptr)
 	,m_indices(nullptr)
+	,m_compactIndices(nullptr)
+	,m_compressedNodes(nullptr)
+	,m_mappedFile(nullptr)
+	,m_mappedSize(0)
 	,m_nodesCount(0)
 	,m_indexCount(0)
+	,m_compressedNodesCount(0)
 {
 }
 
 ndAabbPolygonSoup::~ndAabbPolygonSoup ()
 {
-	if (m_aabb) 
+	ReleaseCompressedTree();
+	if (m_mappedFile)
 	{
-		ndMemory::Free(m_aabb);
-		ndMemory::Free(m_indices);
+		// the arrays live in the mapping, nothing to free.
+		ndUnmapFile(m_mappedFile, m_mappedSize);
+		m_localVertex = nullptr;
 	}
+	else 
+	{
+		// a compressed tree releases the binary nodes and one of the index streams
+		if (m_aabb)
+		{
+			ndMemory::Free(m_aabb);
+		}
+		if (m_indices)
+		{
+			ndMemory::Free(m_indices);
+		}
+		if (m_compactIndices)
+		{
+			ndMemory::Free(m_compactIndices);
+		}
+	}
+}
+
+bool ndAabbPolygonSoup::IsMappedMemory(const void* const ptr) const
+{
+	const char* const base = (char*)m_mappedFile;
+	return m_mappedFile && ((const char*)ptr >= base) && ((const char*)ptr < (base + m_mappedSize));
 }
 
 ndFloat32 ndAabbPolygonSoup::CalculateFaceMaxDiagonal (const ndVector* const vertex, ndInt32 indexCount, const ndInt32* const indexArray) const
@@ -285,6 +420,11 @@ void ndAabbPolygonSoup::GetAABB (ndVector& p0, ndVector& p1) const
 	{ 
 		GetNodeAabb (m_aabb, p0, p1);
 	} 
+	else if (m_compressedNodes)
+	{
+		p0 = ndVector(&m_compressedBox[0].m_x) & ndVector::m_triplexMask;
+		p1 = ndVector(&m_compressedBox[1].m_x) & ndVector::m_triplexMask;
+	}
 	else 
 	{
 		p0 = ndVector::m_zero;
@@ -771,54 +911,206 @@ void ndAabbPolygonSoup::Serialize (const char* const path) const
 	FILE* const file = fopen(path, "wb");
 	if (file)
 	{
-		fwrite(&m_vertexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_indexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_nodesCount, sizeof(ndInt32), 1, file);
-		if (m_aabb)
+		const size_t indexSize = m_compactIndices ? sizeof(ndUnsigned16) : sizeof(ndInt32);
+
+		ndPolygonSoupFileHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.m_id, D_POLYGON_SOUP_FILE_ID, sizeof(header.m_id));
+		header.m_vertexSize = ndInt32(sizeof(ndTriplex));
+		header.m_nodeSize = ndInt32(sizeof(ndNode));
+		header.m_compressedNodeSize = ndInt32(sizeof(ndCompressedNode));
+		header.m_indexSize = ndInt32(indexSize);
+		header.m_vertexCount = m_localVertex ? m_vertexCount : 0;
+		header.m_indexCount = m_localVertex ? m_indexCount : 0;
+		header.m_nodesCount = m_localVertex ? m_nodesCount : 0;
+		header.m_compressedNodesCount = m_localVertex ? m_compressedNodesCount : 0;
+		header.m_compressedBox[0] = m_compressedBox[0];
+		header.m_compressedBox[1] = m_compressedBox[1];
+
+		header.m_vertexOffset = D_POLYGON_SOUP_FILE_ALIGNED(sizeof(header));
+		header.m_indexOffset = D_POLYGON_SOUP_FILE_ALIGNED(header.m_vertexOffset + sizeof(ndTriplex) * size_t(header.m_vertexCount));
+		header.m_nodeOffset = D_POLYGON_SOUP_FILE_ALIGNED(header.m_indexOffset + indexSize * size_t(header.m_indexCount));
+		header.m_compressedNodeOffset = D_POLYGON_SOUP_FILE_ALIGNED(header.m_nodeOffset + sizeof(ndNode) * size_t(header.m_nodesCount));
+		// the tail padding keeps the unaligned vector loads of the last section inside the file
+		header.m_fileSize = D_POLYGON_SOUP_FILE_ALIGNED(header.m_compressedNodeOffset + sizeof(ndCompressedNode) * size_t(header.m_compressedNodesCount) + sizeof(ndVector));
+
+		const char padding[D_POLYGON_SOUP_FILE_ALIGN] = {};
+		const ndUnsigned64 offsets[] = { header.m_vertexOffset, header.m_indexOffset, header.m_nodeOffset, header.m_compressedNodeOffset, header.m_fileSize };
+		const void* const indices = m_compactIndices ? (void*)m_compactIndices : (void*)m_indices;
+		const void* const sections[] = { m_localVertex, indices, m_aabb, m_compressedNodes };
+		const size_t sectionSizes[] = 
+		{
+			sizeof(ndTriplex) * size_t(header.m_vertexCount),
+			indexSize * size_t(header.m_indexCount),
+			sizeof(ndNode) * size_t(header.m_nodesCount),
+			sizeof(ndCompressedNode) * size_t(header.m_compressedNodesCount),
+		};
+
+		fwrite(&header, sizeof(header), 1, file);
+		size_t position = sizeof(header);
+		for (ndInt32 i = 0; i < 4; ++i)
 		{
-			fwrite(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
-			fwrite(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
-			fwrite(m_aabb, sizeof(ndNode) * m_nodesCount, 1, file);
+			fwrite(padding, size_t(offsets[i]) - position, 1, file);
+			if (sectionSizes[i])
+			{
+				fwrite(sections[i], sectionSizes[i], 1, file);
+			}
+			position = size_t(offsets[i]) + sectionSizes[i];
 		}
+		fwrite(padding, size_t(offsets[4]) - position, 1, file);
 		fclose(file);
 	}
 }
 
-void ndAabbPolygonSoup::Deserialize (const char* const path)
+bool ndAabbPolygonSoup::Deserialize (const char* const path)
 {
+	ndAssert(!m_aabb);
 	FILE* const file = fopen(path, "rb");
-	if (file)
+	if (!file)
 	{
-		size_t readValues = 0; 
-		readValues++;
-		m_strideInBytes = sizeof(ndTriplex);
+		return false;
+	}
+
+	size_t readValues = 0; 
+	readValues++;
+	m_strideInBytes = sizeof(ndTriplex);
+
+	ndPolygonSoupFileHeader header;
+	memset(&header, 0, sizeof(header));
+	readValues = fread(&header, sizeof(header), 1, file);
+	if (!memcmp(header.m_id, D_POLYGON_SOUP_FILE_ID, sizeof(header.m_id)) || !memcmp(header.m_id, D_POLYGON_SOUP_FILE_ID_001, sizeof(header.m_id)))
+	{
+		const ndInt32 indexSize = header.m_indexSize ? header.m_indexSize : ndInt32(sizeof(ndInt32));
+		bool valid = (header.m_vertexSize == ndInt32(sizeof(ndTriplex)));
+		valid = valid && (header.m_nodeSize == ndInt32(sizeof(ndNode)));
+		valid = valid && (header.m_compressedNodeSize == ndInt32(sizeof(ndCompressedNode)));
+		valid = valid && ((indexSize == ndInt32(sizeof(ndUnsigned16))) || (indexSize == ndInt32(sizeof(ndInt32))));
+		if (!valid)
+		{
+			ndTrace(("%s was written by a build with a different layout\n", path));
+			fclose(file);
+			return false;
+		}
+		m_vertexCount = header.m_vertexCount;
+		m_indexCount = header.m_indexCount;
+		m_nodesCount = header.m_nodesCount;
+		m_compressedNodesCount = header.m_compressedNodesCount;
+		m_compressedBox[0] = header.m_compressedBox[0];
+		m_compressedBox[1] = header.m_compressedBox[1];
+	}
+	else
+	{
+		// files written before the aligned layout
+		fseek(file, 0, SEEK_SET);
 		readValues = fread(&m_vertexCount, sizeof(ndInt32), 1, file);
 		readValues = fread(&m_indexCount, sizeof(ndInt32), 1, file);
 		readValues = fread(&m_nodesCount, sizeof(ndInt32), 1, file);
+		header.m_indexSize = 0;
+		header.m_vertexOffset = 3 * sizeof(ndInt32);
+		header.m_indexOffset = header.m_vertexOffset + sizeof(ndTriplex) * size_t(m_vertexCount);
+		header.m_nodeOffset = header.m_indexOffset + sizeof(ndInt32) * size_t(m_indexCount);
+	}
+
+	if (m_vertexCount) 
+	{
+		m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
+		fseek(file, long(header.m_vertexOffset), SEEK_SET);
+		readValues = fread(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
 
-		if (m_vertexCount) 
+		fseek(file, long(header.m_indexOffset), SEEK_SET);
+		if (header.m_indexSize == ndInt32(sizeof(ndUnsigned16)))
+		{
+			m_compactIndices = (ndUnsigned16*)ndMemory::Malloc(sizeof(ndUnsigned16) * m_indexCount);
+			readValues = fread(m_compactIndices, sizeof(ndUnsigned16) * m_indexCount, 1, file);
+		}
+		else
 		{
-			m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
 			m_indices = (ndInt32*)ndMemory::Malloc(sizeof(ndInt32) * m_indexCount);
-			m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode) * m_nodesCount);
-
-			readValues = fread(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
 			readValues = fread(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
+		}
+
+		if (m_nodesCount)
+		{
+			m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode) * m_nodesCount);
+			fseek(file, long(header.m_nodeOffset), SEEK_SET);
 			readValues = fread(m_aabb, sizeof(ndNode) * m_nodesCount, 1, file);
 		}
-		else 
+		if (m_compressedNodesCount)
 		{
-			m_localVertex = nullptr;
-			m_indices = nullptr;
-			m_aabb = nullptr;
+			m_compressedNodes = (ndCompressedNode*)ndMemory::Malloc(sizeof(ndCompressedNode) * m_compressedNodesCount);
+			fseek(file, long(header.m_compressedNodeOffset), SEEK_SET);
+			readValues = fread(m_compressedNodes, sizeof(ndCompressedNode) * m_compressedNodesCount, 1, file);
 		}
+	}
+	else 
+	{
+		m_localVertex = nullptr;
+		m_indices = nullptr;
+		m_compactIndices = nullptr;
+		m_aabb = nullptr;
+		m_compressedNodes = nullptr;
+		m_compressedNodesCount = 0;
+	}
 
-		fclose(file);
+	fclose(file);
+	return true;
+}
+
+bool ndAabbPolygonSoup::MapFile (const char* const path)
+{
+	ndAssert(!m_aabb);
+	ndAssert(!m_mappedFile);
+
+	size_t size = 0;
+	char* const data = (char*)ndMapFileCopyOnWrite(path, size);
+	if (!data)
+	{
+		return false;
 	}
+
+	const ndPolygonSoupFileHeader& header = *((ndPolygonSoupFileHeader*)data);
+	const size_t indexSize = header.m_indexSize ? size_t(header.m_indexSize) : sizeof(ndInt32);
+	bool valid = (size >= sizeof(header)) && (!memcmp(header.m_id, D_POLYGON_SOUP_FILE_ID, sizeof(header.m_id)) || !memcmp(header.m_id, D_POLYGON_SOUP_FILE_ID_001, sizeof(header.m_id)));
+	valid = valid && (header.m_vertexSize == ndInt32(sizeof(ndTriplex)));
+	valid = valid && (header.m_nodeSize == ndInt32(sizeof(ndNode)));
+	valid = valid && (header.m_compressedNodeSize == ndInt32(sizeof(ndCompressedNode)));
+	valid = valid && ((indexSize == sizeof(ndUnsigned16)) || (indexSize == sizeof(ndInt32)));
+	valid = valid && (header.m_fileSize <= size);
+	valid = valid && (header.m_vertexOffset + sizeof(ndTriplex) * size_t(header.m_vertexCount) <= header.m_fileSize);
+	valid = valid && (header.m_indexOffset + indexSize * size_t(header.m_indexCount) <= header.m_fileSize);
+	valid = valid && (header.m_nodeOffset + sizeof(ndNode) * size_t(header.m_nodesCount) <= header.m_fileSize);
+	valid = valid && (header.m_compressedNodeOffset + sizeof(ndCompressedNode) * size_t(header.m_compressedNodesCount) <= header.m_fileSize);
+	if (!valid)
+	{
+		ndTrace(("%s is not a mappable polygon soup file\n", path));
+		ndUnmapFile(data, size);
+		return false;
+	}
+
+	m_mappedFile = data;
+	m_mappedSize = size;
+	m_strideInBytes = sizeof(ndTriplex);
+	m_vertexCount = header.m_vertexCount;
+	m_indexCount = header.m_indexCount;
+	m_nodesCount = header.m_nodesCount;
+	m_compressedNodesCount = header.m_compressedNodesCount;
+	m_compressedBox[0] = header.m_compressedBox[0];
+	m_compressedBox[1] = header.m_compressedBox[1];
+	m_localVertex = m_vertexCount ? (ndFloat32*)(data + header.m_vertexOffset) : nullptr;
+	m_indices = (m_vertexCount && (indexSize == sizeof(ndInt32))) ? (ndInt32*)(data + header.m_indexOffset) : nullptr;
+	m_compactIndices = (m_vertexCount && (indexSize == sizeof(ndUnsigned16))) ? (ndUnsigned16*)(data + header.m_indexOffset) : nullptr;
+	m_aabb = (m_vertexCount && m_nodesCount) ? (ndNode*)(data + header.m_nodeOffset) : nullptr;
+	m_compressedNodes = m_compressedNodesCount ? (ndCompressedNode*)(data + header.m_compressedNodeOffset) : nullptr;
+	return true;
 }
 
 ndVector ndAabbPolygonSoup::ForAllSectorsSupportVertex (const ndVector& dir) const
 {
+	if (m_compressedNodes)
+	{
+		return ForAllSectorsSupportVertexCompressed(dir);
+	}
+
 	ndVector supportVertex (ndFloat32 (0.0f));
 	if (m_aabb) 
 	{
@@ -971,6 +1263,16 @@ void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32
 	ndFloat32 distance[DG_STACK_DEPTH];
 	ndFastRay ray (raySrc);
 
+	if (m_compressedNodes)
+	{
+		ForAllSectorsRayHitCompressed(ray, maxParam, callback, context);
+		return;
+	}
+	if (!m_aabb)
+	{
+		return;
+	}
+
 	ndInt32 stack = 1;
 	const ndTriplex* const vertexArray = (ndTriplex*) m_localVertex;
 
@@ -1075,7 +1377,11 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 	ndAssert (ndAbs(ndAbs(obbAabbInfo[0][2]) - obbAabbInfo.m_absDir[2][0]) < ndFloat32 (1.0e-4f));
 	ndAssert (ndAbs(ndAbs(obbAabbInfo[1][2]) - obbAabbInfo.m_absDir[2][1]) < ndFloat32 (1.0e-4f));
 
-	if (m_aabb) 
+	if (m_compressedNodes)
+	{
+		ForAllSectorsCompressed(obbAabbInfo, boxDistanceTravel, callback, context);
+	}
+	else if (m_aabb) 
 	{
 		ndFloat32 distance[DG_STACK_DEPTH];
 		const ndNode* stackPool[DG_STACK_DEPTH];
@@ -1464,3 +1770,747 @@ void ndAabbPolygonSoup::ForThisSector(const ndAabbPolygonSoup::ndNode* const nod
 		}
 	}
 }
+
+void ndAabbPolygonSoup::GetLeafAabb(ndNode::ndLeafNodePtr leaf, ndVector& p0, ndVector& p1) const
+{
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+	const ndInt32* const indices = &m_indices[leaf.GetIndex()];
+	const ndInt32 vCount = ndInt32(leaf.GetCount());
+
+	ndVector minP(ndFloat32(1.0e15f));
+	ndVector maxP(ndFloat32(-1.0e15f));
+	for (ndInt32 i = 0; i < vCount; ++i)
+	{
+		const ndVector p(vertexArray[indices[i]].m_x, vertexArray[indices[i]].m_y, vertexArray[indices[i]].m_z, ndFloat32(0.0f));
+		minP = minP.GetMin(p);
+		maxP = maxP.GetMax(p);
+	}
+	// same padding the builder uses for the face boxes
+	p0 = (minP - ndVector(D_COMPRESSED_LEAF_PADDING)) & ndVector::m_triplexMask;
+	p1 = (maxP + ndVector(D_COMPRESSED_LEAF_PADDING)) & ndVector::m_triplexMask;
+}
+
+ndVector ndAabbPolygonSoup::CalculateCompressedScale(const ndVector& p0, const ndVector& p1)
+{
+	// the largest quantized value lands slightly past the max corner
+	const ndVector scale((p1 - p0) * ndVector(ndFloat32(1.0f) / (D_COMPRESSED_QUANTIZATION - ndFloat32(16.0f))));
+	return scale.GetMax(ndVector(ndFloat32(1.0e-6f))) & ndVector::m_triplexMask;
+}
+
+void ndAabbPolygonSoup::DecodeCompressedNode(const ndCompressedNode& node, const ndVector& p0, const ndVector& scale, ndVector* const boxMin, ndVector* const boxMax)
+{
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		const ndVector origin(p0[i]);
+		const ndVector step(scale[i]);
+		const ndUnsigned16* const q0 = node.m_min[i];
+		const ndUnsigned16* const q1 = node.m_max[i];
+		boxMin[i] = origin + ndVector(ndFloat32(q0[0]), ndFloat32(q0[1]), ndFloat32(q0[2]), ndFloat32(q0[3])) * step;
+		boxMax[i] = origin + ndVector(ndFloat32(q1[0]), ndFloat32(q1[1]), ndFloat32(q1[2]), ndFloat32(q1[3])) * step;
+	}
+}
+
+ndVector ndAabbPolygonSoup::RayCompressedDistance(const ndFastRay& ray, const ndVector* const boxMin, const ndVector* const boxMax)
+{
+	// slab test of the four children at once, same as ndFastRay::BoxIntersect
+	ndVector t0(ray.m_minT);
+	ndVector t1(ray.m_maxT);
+	ndVector reject(ndVector::m_zero);
+	const ndInt32 parallelMask = ray.m_isParallel.GetSignMask();
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		const ndVector origin(ray.m_p0[i]);
+		if (parallelMask & (1 << i))
+		{
+			reject = reject | (origin <= boxMin[i]) | (origin >= boxMax[i]);
+		}
+		const ndVector dpInv(ray.m_dpInv[i]);
+		const ndVector tt0(dpInv * (boxMin[i] - origin));
+		const ndVector tt1(dpInv * (boxMax[i] - origin));
+		t0 = t0.GetMax(tt0.GetMin(tt1));
+		t1 = t1.GetMin(tt0.GetMax(tt1));
+	}
+	const ndVector mask((t0 < t1).AndNot(reject));
+	return ndVector(ndFloat32(1.2f)).Select(t0, mask);
+}
+
+void ndAabbPolygonSoup::ReleaseCompressedTree()
+{
+	if (m_compressedNodes && !IsMappedMemory(m_compressedNodes))
+	{
+		ndMemory::Free(m_compressedNodes);
+	}
+	m_compressedNodes = nullptr;
+	m_compressedNodesCount = 0;
+}
+
+void ndAabbPolygonSoup::CreateCompressedTree()
+{
+	if (!m_aabb)
+	{
+		// the binary hierarchy is gone once a compressed tree is built
+		return;
+	}
+	ReleaseCompressedTree();
+
+	// each binary node collapses its largest descendants until it has four children,
+	// the compressed nodes are enumerated breadth first, so siblings are contiguous.
+	ndArray<ndCompressedNode> nodes;
+	ndArray<ndCompressedBuilder> queue;
+
+	ndCompressedBuilder root;
+	GetNodeAabb(m_aabb, root.m_p0, root.m_p1);
+	root.m_node = 0;
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		(&m_compressedBox[0].m_x)[i] = root.m_p0[i];
+		(&m_compressedBox[1].m_x)[i] = root.m_p1[i];
+	}
+	queue.PushBack(root);
+
+	ndVector boxMin[3];
+	ndVector boxMax[3];
+	const ndVector quantizationMax(D_COMPRESSED_QUANTIZATION);
+	for (ndInt32 entryIndex = 0; entryIndex < ndInt32(queue.GetCount()); ++entryIndex)
+	{
+		const ndCompressedBuilder entry(queue[entryIndex]);
+
+		ndInt32 slotCount = 0;
+		ndCompressedBuilder slots[4];
+		ndUnsigned32 stack[4];
+		stack[0] = m_aabb[entry.m_node].m_left.m_node;
+		stack[1] = m_aabb[entry.m_node].m_right.m_node;
+		ndInt32 stackCount = 2;
+		while (stackCount)
+		{
+			stackCount--;
+			const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)stack[stackCount];
+			ndCompressedBuilder& slot = slots[slotCount];
+			slot.m_node = ptr.m_node;
+			if (ptr.IsLeaf())
+			{
+				if (ptr.GetCount())
+				{
+					GetLeafAabb(ptr, slot.m_p0, slot.m_p1);
+					slotCount++;
+				}
+			}
+			else
+			{
+				GetNodeAabb(ptr.GetNode(m_aabb), slot.m_p0, slot.m_p1);
+				slotCount++;
+			}
+
+			if (!stackCount && (slotCount < 4))
+			{
+				// open the non leaf child with the largest surface area
+				ndInt32 bestSlot = -1;
+				ndFloat32 bestArea = ndFloat32(-1.0f);
+				for (ndInt32 i = 0; i < slotCount; ++i)
+				{
+					if (!((ndNode::ndLeafNodePtr&)slots[i].m_node).IsLeaf())
+					{
+						const ndVector size(slots[i].m_p1 - slots[i].m_p0);
+						const ndFloat32 area = size.m_x * size.m_y + size.m_y * size.m_z + size.m_z * size.m_x;
+						if (area > bestArea)
+						{
+							bestArea = area;
+							bestSlot = i;
+						}
+					}
+				}
+				if (bestSlot >= 0)
+				{
+					const ndNode* const node = ((ndNode::ndLeafNodePtr&)slots[bestSlot].m_node).GetNode(m_aabb);
+					slotCount--;
+					slots[bestSlot] = slots[slotCount];
+					stack[0] = node->m_left.m_node;
+					stack[1] = node->m_right.m_node;
+					stackCount = 2;
+				}
+			}
+		}
+
+		ndCompressedNode compressedNode;
+		for (ndInt32 i = 0; i < 4; ++i)
+		{
+			compressedNode.m_child[i] = 0;
+			for (ndInt32 j = 0; j < 3; ++j)
+			{
+				compressedNode.m_min[j][i] = 0;
+				compressedNode.m_max[j][i] = 0;
+			}
+		}
+
+		// quantize conservatively, one extra step on each side
+		const ndVector scale(CalculateCompressedScale(entry.m_p0, entry.m_p1));
+		const ndVector invScale(ndVector::m_one.Select(scale.Reciproc(), ndVector::m_triplexMask));
+		for (ndInt32 i = 0; i < slotCount; ++i)
+		{
+			const ndVector q0((((slots[i].m_p0 - entry.m_p0) * invScale).Floor() - ndVector::m_one).GetMax(ndVector::m_zero).GetMin(quantizationMax));
+			const ndVector q1((((slots[i].m_p1 - entry.m_p0) * invScale).Floor() + ndVector::m_two).GetMax(ndVector::m_zero).GetMin(quantizationMax));
+			for (ndInt32 j = 0; j < 3; ++j)
+			{
+				compressedNode.m_min[j][i] = ndUnsigned16(q0[j]);
+				compressedNode.m_max[j][i] = ndUnsigned16(q1[j]);
+			}
+		}
+
+		// make sure the decoded boxes contain the children, regardless of rounding
+		for (bool contained = false; !contained; )
+		{
+			contained = true;
+			DecodeCompressedNode(compressedNode, entry.m_p0, scale, boxMin, boxMax);
+			for (ndInt32 i = 0; i < slotCount; ++i)
+			{
+				for (ndInt32 j = 0; j < 3; ++j)
+				{
+					if ((boxMin[j][i] > slots[i].m_p0[j]) && compressedNode.m_min[j][i])
+					{
+						compressedNode.m_min[j][i]--;
+						contained = false;
+					}
+					if ((boxMax[j][i] < slots[i].m_p1[j]) && (compressedNode.m_max[j][i] < 0xffff))
+					{
+						compressedNode.m_max[j][i]++;
+						contained = false;
+					}
+				}
+			}
+		}
+
+		for (ndInt32 i = 0; i < slotCount; ++i)
+		{
+			const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)slots[i].m_node;
+			if (ptr.IsLeaf())
+			{
+				compressedNode.m_child[i] = ptr.m_node;
+			}
+			else
+			{
+				// children are quantized relative to the decoded box, which is what the queries see
+				ndCompressedBuilder child;
+				child.m_p0 = ndVector(boxMin[0][i], boxMin[1][i], boxMin[2][i], ndFloat32(0.0f));
+				child.m_p1 = ndVector(boxMax[0][i], boxMax[1][i], boxMax[2][i], ndFloat32(0.0f));
+				child.m_node = ptr.m_node;
+				compressedNode.m_child[i] = ndUnsigned32(queue.GetCount());
+				queue.PushBack(child);
+			}
+		}
+		nodes.PushBack(compressedNode);
+	}
+
+	m_compressedNodesCount = ndInt32(nodes.GetCount());
+	m_compressedNodes = (ndCompressedNode*)ndMemory::Malloc(sizeof(ndCompressedNode) * m_compressedNodesCount);
+	ndMemCpy(m_compressedNodes, &nodes[0], m_compressedNodesCount);
+
+	if (!m_mappedFile)
+	{
+		ReleaseBinaryTree();
+		if (m_vertexCount <= D_COMPACT_INDEX_LIMIT)
+		{
+			CompactFaceIndices();
+		}
+	}
+}
+
+void ndAabbPolygonSoup::ReleaseBinaryTree()
+{
+	// the box corners of the binary nodes sit between the face normals and
+	// the edge normals added by CalculateAdjacent, nothing else indexes them.
+	ndInt32 boxStart = m_vertexCount;
+	ndInt32 boxEnd = 0;
+	for (ndInt32 i = 0; i < m_nodesCount; ++i)
+	{
+		const ndNode& node = m_aabb[i];
+		boxStart = ndMin(boxStart, ndMin(node.m_indexBox0, node.m_indexBox1));
+		boxEnd = ndMax(boxEnd, ndMax(node.m_indexBox0, node.m_indexBox1) + 1);
+	}
+
+	const ndInt32 boxCount = boxEnd - boxStart;
+	if (boxCount > 0)
+	{
+		for (ndInt32 i = 0; i < m_compressedNodesCount; ++i)
+		{
+			const ndCompressedNode& node = m_compressedNodes[i];
+			for (ndInt32 j = 0; j < 4; ++j)
+			{
+				const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)node.m_child[j];
+				if (node.m_child[j] && ptr.IsLeaf())
+				{
+					const ndInt32 vCount = ndInt32(ptr.GetCount());
+					ndInt32* const face = &m_indices[ptr.GetIndex()];
+					ndAssert(face[vCount + 1] < boxStart);
+					for (ndInt32 k = 0; k < vCount; ++k)
+					{
+						ndAssert(face[k] < boxStart);
+						const ndInt32 edge = face[vCount + 2 + k];
+						const ndInt32 edgeIndex = edge & (~D_CONCAVE_EDGE_MASK);
+						if ((edge != -1) && (edgeIndex >= boxEnd))
+						{
+							face[vCount + 2 + k] = (edge & D_CONCAVE_EDGE_MASK) | (edgeIndex - boxCount);
+						}
+					}
+				}
+			}
+		}
+
+		const ndTriplex* const srcPoints = (ndTriplex*)m_localVertex;
+		ndTriplex* const dstPoints = (ndTriplex*)ndMemory::Malloc(sizeof(ndTriplex) * (m_vertexCount - boxCount));
+		ndMemCpy(dstPoints, srcPoints, boxStart);
+		ndMemCpy(&dstPoints[boxStart], &srcPoints[boxEnd], m_vertexCount - boxEnd);
+		ndMemory::Free(m_localVertex);
+		m_localVertex = &dstPoints[0].m_x;
+		m_vertexCount -= boxCount;
+	}
+
+	ndMemory::Free(m_aabb);
+	m_aabb = nullptr;
+	m_nodesCount = 0;
+}
+
+void ndAabbPolygonSoup::CompactFaceIndices()
+{
+	ndInt32 wordCount = 0;
+	for (ndInt32 i = 0; i < m_compressedNodesCount; ++i)
+	{
+		const ndCompressedNode& node = m_compressedNodes[i];
+		for (ndInt32 j = 0; j < 4; ++j)
+		{
+			const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)node.m_child[j];
+			if (node.m_child[j] && ptr.IsLeaf())
+			{
+				wordCount += ndInt32(ptr.GetCount()) * 2 + 5;
+			}
+		}
+	}
+
+	ndUnsigned16* const compactIndices = (ndUnsigned16*)ndMemory::Malloc(sizeof(ndUnsigned16) * ndMax(wordCount, 1));
+	ndInt32 offset = 0;
+	for (ndInt32 i = 0; i < m_compressedNodesCount; ++i)
+	{
+		ndCompressedNode& node = m_compressedNodes[i];
+		for (ndInt32 j = 0; j < 4; ++j)
+		{
+			const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)node.m_child[j];
+			if (node.m_child[j] && ptr.IsLeaf())
+			{
+				const ndInt32 vCount = ndInt32(ptr.GetCount());
+				const ndInt32* const face = &m_indices[ptr.GetIndex()];
+				ndUnsigned16* const record = &compactIndices[offset];
+
+				const ndUnsigned32 id = ndUnsigned32(face[vCount]);
+				const ndUnsigned32 faceSize = ndUnsigned32(face[vCount * 2 + 2]);
+				record[0] = ndUnsigned16(id & 0xffff);
+				record[1] = ndUnsigned16(id >> 16);
+				record[2] = ndUnsigned16(faceSize & 0xffff);
+				record[3] = ndUnsigned16(faceSize >> 16);
+				for (ndInt32 k = 0; k < vCount; ++k)
+				{
+					ndAssert(face[k] < D_COMPACT_INDEX_LIMIT);
+					record[4 + k] = ndUnsigned16(face[k]);
+
+					const ndInt32 edge = face[vCount + 2 + k];
+					const ndInt32 edgeIndex = edge & (~D_CONCAVE_EDGE_MASK);
+					ndAssert((edge == -1) || (edgeIndex < D_COMPACT_INDEX_LIMIT));
+					record[5 + vCount + k] = (edge == -1) ? ndUnsigned16(D_COMPACT_EMPTY_EDGE) : ndUnsigned16(((edge & D_CONCAVE_EDGE_MASK) ? D_COMPACT_CONCAVE_EDGE : 0) | edgeIndex);
+				}
+				ndAssert(face[vCount + 1] < D_COMPACT_INDEX_LIMIT);
+				record[4 + vCount] = ndUnsigned16(face[vCount + 1]);
+
+				node.m_child[j] = ndNode::ndLeafNodePtr(ndUnsigned32(vCount), ndUnsigned32(offset)).m_node;
+				offset += vCount * 2 + 5;
+			}
+		}
+	}
+	ndAssert(offset == wordCount);
+
+	ndMemory::Free(m_indices);
+	m_indices = nullptr;
+	m_compactIndices = compactIndices;
+	m_indexCount = wordCount;
+}
+
+const ndInt32* ndAabbPolygonSoup::GetLeafFace(ndNode::ndLeafNodePtr leaf, ndInt32* const buffer) const
+{
+	const ndInt32 index = ndInt32(leaf.GetIndex());
+	if (!m_compactIndices)
+	{
+		return &m_indices[index];
+	}
+
+	const ndInt32 vCount = ndInt32(leaf.GetCount());
+	const ndUnsigned16* const record = &m_compactIndices[index];
+	for (ndInt32 i = 0; i < vCount; ++i)
+	{
+		buffer[i] = record[4 + i];
+		const ndUnsigned32 edge = record[5 + vCount + i];
+		buffer[vCount + 2 + i] = (edge == D_COMPACT_EMPTY_EDGE) ? -1 : ndInt32((edge & D_COMPACT_CONCAVE_EDGE) ? (ndUnsigned32(D_CONCAVE_EDGE_MASK) | (edge & D_COMPACT_INDEX_LIMIT)) : edge);
+	}
+	buffer[vCount] = ndInt32(ndUnsigned32(record[0]) | (ndUnsigned32(record[1]) << 16));
+	buffer[vCount + 1] = record[4 + vCount];
+	buffer[vCount * 2 + 2] = ndInt32(ndUnsigned32(record[2]) | (ndUnsigned32(record[3]) << 16));
+	buffer[vCount * 2 + 3] = index;
+	return buffer;
+}
+
+void ndAabbPolygonSoup::SetTagId(const ndInt32* const face, ndInt32 indexCount, ndUnsigned32 newID) const
+{
+	ndPolygonSoupDatabase::SetTagId(face, indexCount, newID);
+	if (m_compactIndices)
+	{
+		// the callbacks only see decoded copies, which carry the offset of their record
+		ndUnsigned16* const record = &m_compactIndices[face[indexCount * 2 + 3]];
+		record[0] = ndUnsigned16(newID & 0xffff);
+		record[1] = ndUnsigned16(newID >> 16);
+	}
+}
+
+ndVector ndAabbPolygonSoup::ForAllSectorsSupportVertexCompressed(const ndVector& dir) const
+{
+	ndVector stackBox[DG_STACK_DEPTH][2];
+	ndFloat32 aabbProjection[DG_STACK_DEPTH];
+	ndInt32 stackPool[DG_STACK_DEPTH];
+	ndInt32 faceBuffer[D_COMPACT_FACE_BUFFER];
+
+	ndVector boxMin[3];
+	ndVector boxMax[3];
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+
+	ndInt32 stack = 1;
+	stackPool[0] = 0;
+	aabbProjection[0] = ndFloat32(1.0e10f);
+	ndAabbPolygonSoup::GetAABB(stackBox[0][0], stackBox[0][1]);
+
+	ndFloat32 maxProj = ndFloat32(-1.0e20f);
+	ndVector supportVertex(ndFloat32(0.0f));
+	while (stack)
+	{
+		stack--;
+		if (aabbProjection[stack] > maxProj)
+		{
+			const ndVector p0(stackBox[stack][0]);
+			const ndVector p1(stackBox[stack][1]);
+			const ndCompressedNode& node = m_compressedNodes[stackPool[stack]];
+			DecodeCompressedNode(node, p0, CalculateCompressedScale(p0, p1), boxMin, boxMax);
+
+			// support distance of the four children at once
+			ndVector projection(ndVector::m_zero);
+			for (ndInt32 i = 0; i < 3; ++i)
+			{
+				projection += ((dir[i] > ndFloat32(0.0f)) ? boxMax[i] : boxMin[i]) * ndVector(dir[i]);
+			}
+
+			for (ndInt32 i = 0; i < 4; ++i)
+			{
+				if (!node.m_child[i] || (projection[i] <= maxProj))
+				{
+					continue;
+				}
+
+				const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)node.m_child[i];
+				if (ptr.IsLeaf())
+				{
+					const ndInt32 vCount = ndInt32(ptr.GetCount());
+					const ndInt32* const indices = GetLeafFace(ptr, faceBuffer);
+					for (ndInt32 j = 0; j < vCount; ++j)
+					{
+						const ndVector p(ndVector(&vertexArray[indices[j]].m_x) & ndVector::m_triplexMask);
+						const ndFloat32 dist = p.DotProduct(dir).GetScalar();
+						if (dist > maxProj)
+						{
+							maxProj = dist;
+							supportVertex = p;
+						}
+					}
+				}
+				else
+				{
+					// the child with the largest projection is visited first
+					const ndFloat32 dist1 = projection[i];
+					ndInt32 j = stack;
+					for (; j && (dist1 < aabbProjection[j - 1]); j--)
+					{
+						stackPool[j] = stackPool[j - 1];
+						aabbProjection[j] = aabbProjection[j - 1];
+						stackBox[j][0] = stackBox[j - 1][0];
+						stackBox[j][1] = stackBox[j - 1][1];
+					}
+					ndAssert(stack < DG_STACK_DEPTH);
+					stackPool[j] = ndInt32(ptr.m_node);
+					aabbProjection[j] = dist1;
+					stackBox[j][0] = ndVector(boxMin[0][i], boxMin[1][i], boxMin[2][i], ndFloat32(0.0f));
+					stackBox[j][1] = ndVector(boxMax[0][i], boxMax[1][i], boxMax[2][i], ndFloat32(0.0f));
+					stack++;
+				}
+			}
+		}
+	}
+	return supportVertex;
+}
+
+void ndAabbPolygonSoup::ForAllSectorsRayHitCompressed(const ndFastRay& ray, ndFloat32 maxParam, ndRayIntersectCallback callback, void* const context) const
+{
+	ndVector stackBox[DG_STACK_DEPTH][2];
+	ndFloat32 distance[DG_STACK_DEPTH];
+	ndInt32 stackPool[DG_STACK_DEPTH];
+	ndInt32 faceBuffer[D_COMPACT_FACE_BUFFER];
+
+	ndVector boxMin[3];
+	ndVector boxMax[3];
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+
+	ndInt32 stack = 1;
+	stackPool[0] = 0;
+	ndAabbPolygonSoup::GetAABB(stackBox[0][0], stackBox[0][1]);
+	distance[0] = ray.BoxIntersect(stackBox[0][0], stackBox[0][1]);
+	while (stack)
+	{
+		stack--;
+		if (distance[stack] > maxParam)
+		{
+			break;
+		}
+
+		const ndVector p0(stackBox[stack][0]);
+		const ndVector p1(stackBox[stack][1]);
+		const ndCompressedNode& node = m_compressedNodes[stackPool[stack]];
+		DecodeCompressedNode(node, p0, CalculateCompressedScale(p0, p1), boxMin, boxMax);
+		const ndVector dist(RayCompressedDistance(ray, boxMin, boxMax));
+		for (ndInt32 i = 0; i < 4; ++i)
+		{
+			const ndFloat32 dist1 = dist[i];
+			if (node.m_child[i] && (dist1 < maxParam))
+			{
+				const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)node.m_child[i];
+				if (ptr.IsLeaf())
+				{
+					ndInt32 vCount = ndInt32(ptr.GetCount());
+					const ndInt32* const indices = GetLeafFace(ptr, faceBuffer);
+					ndFloat32 param = callback(context, &vertexArray[0].m_x, sizeof(ndTriplex), indices, vCount);
+					ndAssert(param >= ndFloat32(0.0f));
+					if (param < maxParam)
+					{
+						maxParam = param;
+						if (maxParam == ndFloat32(0.0f))
+						{
+							return;
+						}
+					}
+				}
+				else
+				{
+					ndInt32 j = stack;
+					for (; j && (dist1 > distance[j - 1]); j--)
+					{
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+						stackBox[j][0] = stackBox[j - 1][0];
+						stackBox[j][1] = stackBox[j - 1][1];
+					}
+					ndAssert(stack < DG_STACK_DEPTH);
+					stackPool[j] = ndInt32(ptr.m_node);
+					distance[j] = dist1;
+					stackBox[j][0] = ndVector(boxMin[0][i], boxMin[1][i], boxMin[2][i], ndFloat32(0.0f));
+					stackBox[j][1] = ndVector(boxMax[0][i], boxMax[1][i], boxMax[2][i], ndFloat32(0.0f));
+					stack++;
+				}
+			}
+		}
+	}
+}
+
+void ndAabbPolygonSoup::ForAllSectorsCompressed(const ndFastAabb& obbAabbInfo, const ndVector& boxDistanceTravel, ndAaabbIntersectCallback callback, void* const context) const
+{
+	ndVector stackBox[DG_STACK_DEPTH][2];
+	ndFloat32 distance[DG_STACK_DEPTH];
+	ndInt32 stackPool[DG_STACK_DEPTH];
+	ndInt32 faceBuffer[D_COMPACT_FACE_BUFFER];
+
+	ndVector boxMin[3];
+	ndVector boxMax[3];
+	const ndInt32 stride = sizeof(ndTriplex) / sizeof(ndFloat32);
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+
+	ndInt32 stack = 1;
+	stackPool[0] = 0;
+	ndAabbPolygonSoup::GetAABB(stackBox[0][0], stackBox[0][1]);
+
+	ndAssert(boxDistanceTravel.m_w == ndFloat32(0.0f));
+	if (boxDistanceTravel.DotProduct(boxDistanceTravel).GetScalar() < ndFloat32(1.0e-8f))
+	{
+		distance[0] = ndNode::BoxPenetration(obbAabbInfo, stackBox[0][0], stackBox[0][1]);
+		if (distance[0] <= ndFloat32(0.0f))
+		{
+			obbAabbInfo.m_separationDistance = ndMin(obbAabbInfo.m_separationDistance[0], -distance[0]);
+		}
+		while (stack)
+		{
+			stack--;
+			if (distance[stack] > ndFloat32(0.0f))
+			{
+				const ndVector p0(stackBox[stack][0]);
+				const ndVector p1(stackBox[stack][1]);
+				const ndCompressedNode& node = m_compressedNodes[stackPool[stack]];
+				DecodeCompressedNode(node, p0, CalculateCompressedScale(p0, p1), boxMin, boxMax);
+
+				// test the four children against the aabb of the obb,
+				// the separation of the rejected ones is the distance between the boxes.
+				ndVector overlap(ndVector::m_xyzwMask);
+				ndVector separation2(ndVector::m_zero);
+				for (ndInt32 i = 0; i < 3; ++i)
+				{
+					const ndVector minBox(boxMin[i] - ndVector(obbAabbInfo.m_p1[i]));
+					const ndVector maxBox(boxMax[i] - ndVector(obbAabbInfo.m_p0[i]));
+					const ndVector mask((minBox * maxBox) < ndVector::m_zero);
+					const ndVector gap(minBox.Abs().GetMin(maxBox.Abs()).AndNot(mask));
+					separation2 += gap * gap;
+					overlap = overlap & mask;
+				}
+				const ndInt32 overlapMask = overlap.GetSignMask();
+
+				for (ndInt32 i = 0; i < 4; ++i)
+				{
+					if (!node.m_child[i])
+					{
+						continue;
+					}
+					if (!(overlapMask & (1 << i)))
+					{
+						obbAabbInfo.m_separationDistance = ndMin(obbAabbInfo.m_separationDistance[0], ndSqrt(separation2[i]));
+						continue;
+					}
+
+					const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)node.m_child[i];
+					if (ptr.IsLeaf())
+					{
+						ndInt32 vCount = ndInt32(ptr.GetCount());
+						const ndInt32* const indices = GetLeafFace(ptr, faceBuffer);
+						ndInt32 normalIndex = indices[vCount + 1];
+						ndVector faceNormal(&vertexArray[normalIndex].m_x);
+						faceNormal = faceNormal & ndVector::m_triplexMask;
+						ndFloat32 dist1 = obbAabbInfo.PolygonBoxDistance(faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
+						if (dist1 > ndFloat32(0.0f))
+						{
+							obbAabbInfo.m_separationDistance = ndFloat32(0.0f);
+							ndAssert(vCount >= 3);
+							if (callback(context, &vertexArray[0].m_x, sizeof(ndTriplex), indices, vCount, dist1) == m_stopSearch)
+							{
+								return;
+							}
+						}
+						else
+						{
+							obbAabbInfo.m_separationDistance = ndMin(obbAabbInfo.m_separationDistance[0], -dist1);
+						}
+					}
+					else
+					{
+						const ndVector q0(boxMin[0][i], boxMin[1][i], boxMin[2][i], ndFloat32(0.0f));
+						const ndVector q1(boxMax[0][i], boxMax[1][i], boxMax[2][i], ndFloat32(0.0f));
+						ndFloat32 dist1 = ndNode::BoxPenetration(obbAabbInfo, q0, q1);
+						if (dist1 > ndFloat32(0.0f))
+						{
+							ndInt32 j = stack;
+							for (; j && (dist1 > distance[j - 1]); j--)
+							{
+								stackPool[j] = stackPool[j - 1];
+								distance[j] = distance[j - 1];
+								stackBox[j][0] = stackBox[j - 1][0];
+								stackBox[j][1] = stackBox[j - 1][1];
+							}
+							ndAssert(stack < DG_STACK_DEPTH);
+							stackPool[j] = ndInt32(ptr.m_node);
+							distance[j] = dist1;
+							stackBox[j][0] = q0;
+							stackBox[j][1] = q1;
+							stack++;
+						}
+						else
+						{
+							obbAabbInfo.m_separationDistance = ndMin(obbAabbInfo.m_separationDistance[0], -dist1);
+						}
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		ndFastRay ray(ndVector::m_zero, boxDistanceTravel);
+		ndFastRay obbRay(ndVector::m_zero, obbAabbInfo.UnrotateVector(boxDistanceTravel));
+		distance[0] = ndNode::BoxIntersect(ray, obbRay, obbAabbInfo, stackBox[0][0], stackBox[0][1]);
+
+		ndVector sweptMin[3];
+		ndVector sweptMax[3];
+		while (stack)
+		{
+			stack--;
+			if (distance[stack] < ndFloat32(1.0f))
+			{
+				const ndVector p0(stackBox[stack][0]);
+				const ndVector p1(stackBox[stack][1]);
+				const ndCompressedNode& node = m_compressedNodes[stackPool[stack]];
+				DecodeCompressedNode(node, p0, CalculateCompressedScale(p0, p1), boxMin, boxMax);
+
+				// sweep the aabb of the obb against the four children at once
+				for (ndInt32 i = 0; i < 3; ++i)
+				{
+					sweptMin[i] = boxMin[i] - ndVector(obbAabbInfo.m_p1[i]);
+					sweptMax[i] = boxMax[i] - ndVector(obbAabbInfo.m_p0[i]);
+				}
+				const ndVector dist(RayCompressedDistance(ray, sweptMin, sweptMax));
+
+				for (ndInt32 i = 0; i < 4; ++i)
+				{
+					if (!node.m_child[i] || (dist[i] >= ndFloat32(1.0f)))
+					{
+						continue;
+					}
+
+					const ndNode::ndLeafNodePtr& ptr = (ndNode::ndLeafNodePtr&)node.m_child[i];
+					if (ptr.IsLeaf())
+					{
+						ndInt32 vCount = ndInt32(ptr.GetCount());
+						const ndInt32* const indices = GetLeafFace(ptr, faceBuffer);
+						ndInt32 normalIndex = indices[vCount + 1];
+						ndVector faceNormal(&vertexArray[normalIndex].m_x);
+						faceNormal = faceNormal & ndVector::m_triplexMask;
+						ndFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance(faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
+						if (hitDistance < ndFloat32(1.0f))
+						{
+							ndAssert(vCount >= 3);
+							if (callback(context, &vertexArray[0].m_x, sizeof(ndTriplex), indices, vCount, hitDistance) == m_stopSearch)
+							{
+								return;
+							}
+						}
+					}
+					else
+					{
+						const ndVector q0(boxMin[0][i], boxMin[1][i], boxMin[2][i], ndFloat32(0.0f));
+						const ndVector q1(boxMax[0][i], boxMax[1][i], boxMax[2][i], ndFloat32(0.0f));
+						ndFloat32 dist1 = ndNode::BoxIntersect(ray, obbRay, obbAabbInfo, q0, q1);
+						if (dist1 < ndFloat32(1.0f))
+						{
+							ndInt32 j = stack;
+							for (; j && (dist1 > distance[j - 1]); j--)
+							{
+								stackPool[j] = stackPool[j - 1];
+								distance[j] = distance[j - 1];
+								stackBox[j][0] = stackBox[j - 1][0];
+								stackBox[j][1] = stackBox[j - 1][1];
+							}
+							ndAssert(stack < DG_STACK_DEPTH);
+							stackPool[j] = ndInt32(ptr.m_node);
+							distance[j] = dist1;
+							stackBox[j][0] = q0;
+							stackBox[j][1] = q1;
+							stack++;
+						}
+					}
+				}
+			}
+		}
+	}
+}
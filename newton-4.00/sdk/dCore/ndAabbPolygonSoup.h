@@ -133,6 +133,20 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			ndVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & ndVector::m_triplexMask;
 			p1 = p1 & ndVector::m_triplexMask;
+			return BoxPenetration(obb, p0, p1);
+		}
+
+		inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndTriplex* const vertexArray) const
+		{
+			ndVector p0 (&vertexArray[m_indexBox0].m_x);
+			ndVector p1 (&vertexArray[m_indexBox1].m_x);
+			p0 = p0 & ndVector::m_triplexMask;
+			p1 = p1 & ndVector::m_triplexMask;
+			return BoxIntersect(ray, obbRay, obb, p0, p1);
+		}
+
+		static inline ndFloat32 BoxPenetration (const ndFastAabb& obb, const ndVector& p0, const ndVector& p1)
+		{
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			ndAssert(maxBox.m_x >= minBox.m_x);
@@ -173,13 +187,8 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			return	dist.GetScalar();
 		}
 
-		inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndTriplex* const vertexArray) const
+		static inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndVector& p0, const ndVector& p1)
 		{
-			ndVector p0 (&vertexArray[m_indexBox0].m_x);
-			ndVector p1 (&vertexArray[m_indexBox1].m_x);
-			p0 = p0 & ndVector::m_triplexMask;
-			p1 = p1 & ndVector::m_triplexMask;
-
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			ndFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -207,17 +216,73 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 		ndLeafNodePtr m_right;
 	};
 
+	/// node of the optional compressed four wide hierarchy, one cache line per node.
+	/// the boxes of the children are quantized to 16 bits relative to the box of
+	/// the node, and stored as struct of arrays, so that the queries can test all
+	/// four children at once. children use the ndLeafNodePtr encoding, non leaf
+	/// children index the compressed node array, and zero marks an empty slot.
+	class ndCompressedNode
+	{
+		public:
+		ndUnsigned16 m_min[3][4];
+		ndUnsigned16 m_max[3][4];
+		ndUnsigned32 m_child[4];
+	};
+
 	class ndSplitInfo;
 	class ndNodeBuilder;
+	class ndCompressedBuilder;
 
 	/// get the root node bounding box of the mesh.
 	D_CORE_API virtual void GetAABB (ndVector& p0, ndVector& p1) const;
 
+	/// build the compressed hierarchy, all sector queries use it from then on.
+	/// the binary hierarchy and its box vertices are released, and when the mesh
+	/// has fewer than 32k vertices the faces are stored with 16 bit indices.
+	/// the callbacks get a decoded copy of those faces.
+	/// a mapped file keeps its binary hierarchy.
+	D_CORE_API void CreateCompressedTree ();
+
+	/// return the number of nodes of the compressed hierarchy, zero if there is not one.
+	inline ndInt32 GetCompressedNodesCount() const
+	{
+		return m_compressedNodesCount;
+	}
+
+	/// return the number of nodes of the binary hierarchy, zero if it was released.
+	inline ndInt32 GetNodesCount() const
+	{
+		return m_nodesCount;
+	}
+
+	/// return the size in bytes of the face index stream.
+	inline size_t GetIndexBufferSize() const
+	{
+		return size_t(m_indexCount) * (m_compactIndices ? sizeof(ndUnsigned16) : sizeof(ndInt32));
+	}
+
+	/// changes the face attribute, it also works on the decoded copy of a compact face.
+	D_CORE_API virtual void SetTagId(const ndInt32* const face, ndInt32 indexCount, ndUnsigned32 newID) const;
+
 	/// writes the entire database to a binary file named path.
+	/// the sections are aligned and position independent, so that MapFile can use the file in place.
 	D_CORE_API virtual void Serialize (const char* const path) const;
 
 	/// Reads a previously saved database binary file named path.
-	D_CORE_API virtual void Deserialize (const char* const path);
+	/// returns false if the file can not be read, or if it was written by a build with a different layout.
+	D_CORE_API virtual bool Deserialize (const char* const path);
+
+	/// maps a file written by Serialize and uses it in place, without parsing or copying.
+	/// the mapping is copy on write, so all the processes that map the same file share
+	/// the physical pages, unless a face tag is changed. returns false if the file can
+	/// not be mapped, or if it was written by a build with a different layout.
+	D_CORE_API virtual bool MapFile (const char* const path);
+
+	/// return true if the database is used in place from a mapped file.
+	inline bool IsMapped() const
+	{
+		return m_mappedFile ? true : false;
+	}
 
 	protected:
 	D_CORE_API ndAabbPolygonSoup ();
@@ -231,7 +296,7 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 	D_CORE_API virtual void ForThisSector(const ndAabbPolygonSoup::ndNode* const node, const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndFloat32 maxT, ndAaabbIntersectCallback callback, void* const context) const;
 
 	public:
-	/// Get the root node of the hierarchy.
+	/// Get the root node of the binary hierarchy, nullptr if only the compressed one is left.
 	inline ndNode* GetRootNode() const
 	{
 		return m_aabb;
@@ -261,14 +326,33 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 	}
 
 	private:
+	void ForAllSectorsCompressed (const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndAaabbIntersectCallback callback, void* const context) const;
+	void ForAllSectorsRayHitCompressed (const ndFastRay& ray, ndFloat32 maxT, ndRayIntersectCallback callback, void* const context) const;
+	ndVector ForAllSectorsSupportVertexCompressed (const ndVector& dir) const;
+	void ReleaseCompressedTree ();
+	void CompactFaceIndices ();
+	void ReleaseBinaryTree ();
+	const ndInt32* GetLeafFace (ndNode::ndLeafNodePtr leaf, ndInt32* const buffer) const;
+	void GetLeafAabb (ndNode::ndLeafNodePtr leaf, ndVector& p0, ndVector& p1) const;
+	bool IsMappedMemory (const void* const ptr) const;
+	static ndVector CalculateCompressedScale (const ndVector& p0, const ndVector& p1);
+	static void DecodeCompressedNode (const ndCompressedNode& node, const ndVector& p0, const ndVector& scale, ndVector* const boxMin, ndVector* const boxMax);
+	static ndVector RayCompressedDistance (const ndFastRay& ray, const ndVector* const boxMin, const ndVector* const boxMax);
+
 	ndNodeBuilder* BuildTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator) const;
 	ndFloat32 CalculateFaceMaxDiagonal (const ndVector* const vertex, ndInt32 indexCount, const ndInt32* const indexArray) const;
 	static ndIntersectStatus CalculateAllFaceEdgeNormals(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
 	
 	ndNode* m_aabb;
 	ndInt32* m_indices;
+	ndUnsigned16* m_compactIndices;
+	ndCompressedNode* m_compressedNodes;
+	ndTriplex m_compressedBox[2];
+	void* m_mappedFile;
+	size_t m_mappedSize;
 	ndInt32 m_nodesCount;
 	ndInt32 m_indexCount;
+	ndInt32 m_compressedNodesCount;
 	friend class ndContactSolver;
 };
 
@@ -27,7 +27,9 @@
 #include "ndContainersAlloc.h"
 #include "ndThreadSyncUtils.h"
 
-#define D_FREELIST_DICTIONARY_SIZE 64
+#define D_FREELIST_DICTIONARY_SIZE	64
+#define D_FREELIST_MAGAZINE_SIZE	32
+#define D_FREELIST_MAGAZINE_BATCH	(D_FREELIST_MAGAZINE_SIZE / 2)
 
 class ndFreeListEntry
 {
@@ -38,17 +40,136 @@ class ndFreeListEntry
 class ndFreeListHeader
 {
 	public:
+	ndFreeListHeader()
+		:m_count(0)
+		,m_schunkSize(0)
+		,m_headPointer(nullptr)
+		,m_refills(0)
+		,m_returns(0)
+	{
+	}
+
+	ndFreeListHeader(ndInt32 size)
+		:m_count(0)
+		,m_schunkSize(size)
+		,m_headPointer(nullptr)
+		,m_refills(0)
+		,m_returns(0)
+	{
+	}
+
+	ndInt32 m_count;
+	ndInt32 m_schunkSize;
+	ndFreeListEntry* m_headPointer;
+	ndUnsigned64 m_refills;
+	ndUnsigned64 m_returns;
+};
+
+class ndFreeListMagazine
+{
+	public:
+	ndFreeListMagazine()
+		:m_count(0)
+		,m_schunkSize(0)
+		,m_headPointer(nullptr)
+		,m_allocations(0)
+		,m_cacheHits(0)
+	{
+	}
+
+	ndFreeListMagazine(ndInt32 size)
+		:m_count(0)
+		,m_schunkSize(size)
+		,m_headPointer(nullptr)
+		,m_allocations(0)
+		,m_cacheHits(0)
+	{
+	}
+
 	ndInt32 m_count;
 	ndInt32 m_schunkSize;
 	ndFreeListEntry* m_headPointer;
+	ndUnsigned64 m_allocations;
+	ndUnsigned64 m_cacheHits;
 };
 
+// size classes are kept sorted by chunk size
+template<class T>
+static T* ndFindFreeListEntry(ndFixSizeArray<T, D_FREELIST_DICTIONARY_SIZE>& array, ndInt32 size)
+{
+	ndInt32 i0 = 0;
+	ndInt32 i1 = array.GetCount() - 1;
+	while ((i1 - i0 > 4))
+	{
+		ndInt32 mid = (i1 + i0) / 2;
+		if (array[mid].m_schunkSize <= size)
+		{
+			i0 = mid;
+		}
+		else
+		{
+			i1 = mid;
+		}
+	}
+
+	for (ndInt32 i = i0; i <= i1; ++i)
+	{
+		if (array[i].m_schunkSize == size)
+		{
+			return &array[i];
+		}
+	}
+
+	#ifdef _DEBUG
+		for (ndInt32 i = 0; i < array.GetCount(); ++i)
+		{
+			ndAssert(array[i].m_schunkSize != size);
+		}
+	#endif
+
+	const T header(size);
+	array.PushBack(header);
+	ndInt32 index = array.GetCount() - 1;
+	for (ndInt32 i = array.GetCount() - 2; i >= 0; --i)
+	{
+		if (size < array[i].m_schunkSize)
+		{
+			array[i + 1] = array[i];
+			array[i + 0] = header;
+			index = i;
+		}
+		else
+		{
+			break;
+		}
+	}
+	return &array[index];
+}
+
+static void ndFreeListRelease(ndFreeListEntry* const list)
+{
+	ndFreeListEntry* next;
+	for (ndFreeListEntry* node = list; node; node = next)
+	{
+		next = node->m_next;
+		ndMemory::Free(node);
+	}
+}
+
+class ndFreeListThreadCache;
+
+// set once the thread cache is destroyed, objects released later
+// in the thread exit go straight to the shared lists.
+static thread_local bool ndFreeListCacheReleased = false;
+
 class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_DICTIONARY_SIZE>
 {
 	public:
 	ndFreeListDictionary()
 		:ndFixSizeArray<ndFreeListHeader, D_FREELIST_DICTIONARY_SIZE>()
 		,m_lock()
+		,m_cacheLock()
+		,m_caches(nullptr)
 	{
 	}
 
@@ -65,12 +186,7 @@ class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_D
 
 	void Flush(ndFreeListHeader* const header)
 	{
-		ndFreeListEntry* next;
-		for (ndFreeListEntry* node = header->m_headPointer; node; node = next)
-		{
-			next = node->m_next;
-			ndMemory::Free(node);
-		}
+		ndFreeListRelease(header->m_headPointer);
 		header->m_count = 0;
 		header->m_headPointer = nullptr;
 	}
@@ -79,7 +195,7 @@ class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_D
 	{
 		{
 			ndScopeSpinLock lock(m_lock);
-			ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::CalculateBufferSize(size_t(size))));
+			ndFreeListHeader* const header = ndFindFreeListEntry(*this, ndInt32(ndMemory::CalculateBufferSize(size_t(size))));
 			ndAssert(header->m_count >= 0);
 			if (header->m_count)
 			{
@@ -97,8 +213,7 @@ class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_D
 	void Free(void* ptr)
 	{
 		ndScopeSpinLock lock(m_lock);
-		ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::GetSize(ptr)));
-		ndAssert(header);
+		ndFreeListHeader* const header = ndFindFreeListEntry(*this, ndInt32(ndMemory::GetSize(ptr)));
 		ndFreeListEntry* const self = (ndFreeListEntry*)ptr;
 
 		self->m_next = header->m_headPointer;
@@ -106,84 +221,286 @@ class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_D
 		header->m_headPointer = self;
 	}
 
-	void Flush()
+	// move up to one batch of chunks from the shared list to the magazine
+	void Refill(ndFreeListMagazine* const magazine)
 	{
+		ndAssert(!magazine->m_count);
 		ndScopeSpinLock lock(m_lock);
-		ndFreeListDictionary& me = *this;
-		for (ndInt32 i = 0; i < GetCount(); ++i)
+		ndFreeListHeader* const header = ndFindFreeListEntry(*this, magazine->m_schunkSize);
+		ndAssert(header->m_count >= 0);
+		const ndInt32 count = ndMin(header->m_count, ndInt32(D_FREELIST_MAGAZINE_BATCH));
+		if (count)
 		{
-			ndFreeListHeader* const header = &me[i];
-			Flush(header);
+			ndFreeListEntry* const first = header->m_headPointer;
+			ndFreeListEntry* last = first;
+			for (ndInt32 i = 1; i < count; ++i)
+			{
+				last = last->m_next;
+			}
+			header->m_headPointer = last->m_next;
+			header->m_count -= count;
+			header->m_refills++;
+
+			last->m_next = nullptr;
+			magazine->m_headPointer = first;
+			magazine->m_count = count;
 		}
-		SetCount(0);
 	}
 
-	void Flush(ndInt32 size)
+	// move a list of chunks from a magazine to the shared list
+	void Return(ndInt32 size, ndFreeListEntry* const first, ndFreeListEntry* const last, ndInt32 count)
 	{
 		ndScopeSpinLock lock(m_lock);
-		ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::CalculateBufferSize(size_t(size))));
-		Flush(header);
+		ndFreeListHeader* const header = ndFindFreeListEntry(*this, size);
+		last->m_next = header->m_headPointer;
+		header->m_headPointer = first;
+		header->m_count += count;
+		header->m_returns++;
 	}
 
-	private:
-	ndFreeListHeader* FindEntry(ndInt32 size)
+	void Flush();
+	void Flush(ndInt32 size);
+	ndInt32 GetStatistics(ndFreeListStatistics* const stats, ndInt32 maxCount);
+
+	ndSpinLock m_lock;
+	ndSpinLock m_cacheLock;
+	ndFreeListThreadCache* m_caches;
+};
+
+// lock order is: m_cacheLock, cache m_lock, dictionary m_lock.
+// the cache lock is only contended while another thread is flushing.
+class ndFreeListThreadCache: public ndFixSizeArray<ndFreeListMagazine, D_FREELIST_DICTIONARY_SIZE>
+{
+	public:
+	ndFreeListThreadCache()
+		:ndFixSizeArray<ndFreeListMagazine, D_FREELIST_DICTIONARY_SIZE>()
+		,m_lock()
+		,m_prev(nullptr)
+		,m_next(nullptr)
 	{
-		ndInt32 i0 = 0;
-		ndInt32 i1 = GetCount() - 1;
-		ndFreeListDictionary& me = *this;
-		while ((i1 - i0 > 4))
+		ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
+		ndScopeSpinLock lock(dictionary.m_cacheLock);
+		m_next = dictionary.m_caches;
+		if (m_next)
 		{
-			ndInt32 mid = (i1 + i0) / 2;
-			if (me[mid].m_schunkSize <= size)
+			m_next->m_prev = this;
+		}
+		dictionary.m_caches = this;
+	}
+
+	~ndFreeListThreadCache()
+	{
+		ndFreeListCacheReleased = true;
+		ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
+		{
+			ndScopeSpinLock lock(dictionary.m_cacheLock);
+			if (m_prev)
 			{
-				i0 = mid;
+				m_prev->m_next = m_next;
 			}
 			else
 			{
-				i1 = mid;
+				dictionary.m_caches = m_next;
+			}
+			if (m_next)
+			{
+				m_next->m_prev = m_prev;
 			}
 		}
 
-		for (ndInt32 i = i0; i <= i1; ++i)
+		// the chunks outlive the thread, hand them over to the shared lists
+		ndFreeListThreadCache& me = *this;
+		for (ndInt32 i = 0; i < GetCount(); ++i)
 		{
-			if (me[i].m_schunkSize == size)
+			ndFreeListMagazine* const magazine = &me[i];
+			if (magazine->m_count)
 			{
-				return &me[i];
+				ndFreeListEntry* last = magazine->m_headPointer;
+				while (last->m_next)
+				{
+					last = last->m_next;
+				}
+				dictionary.Return(magazine->m_schunkSize, magazine->m_headPointer, last, magazine->m_count);
+				magazine->m_count = 0;
+				magazine->m_headPointer = nullptr;
 			}
 		}
+	}
 
-		#ifdef _DEBUG
-			for (ndInt32 i = 0; i < GetCount(); ++i)
-			{
-				ndAssert(me[i].m_schunkSize != size);
-			}
-		#endif
+	static ndFreeListThreadCache* GetCache()
+	{
+		if (ndFreeListCacheReleased)
+		{
+			return nullptr;
+		}
+		thread_local ndFreeListThreadCache cache;
+		return &cache;
+	}
 
-		ndFreeListHeader header;
-		header.m_count = 0;
-		header.m_schunkSize = size;
-		header.m_headPointer = nullptr;
-		PushBack(header);
-		ndInt32 index = GetCount() - 1;
-		for (ndInt32 i = GetCount() - 2; i >= 0; --i)
+	void Flush(ndFreeListMagazine* const magazine)
+	{
+		ndFreeListRelease(magazine->m_headPointer);
+		magazine->m_count = 0;
+		magazine->m_headPointer = nullptr;
+	}
+
+	void* Malloc(ndInt32 size)
+	{
+		const ndInt32 chunkSize = ndInt32(ndMemory::CalculateBufferSize(size_t(size)));
 		{
-			if (size < me[i].m_schunkSize)
+			ndScopeSpinLock lock(m_lock);
+			ndFreeListMagazine* const magazine = ndFindFreeListEntry(*this, chunkSize);
+			ndAssert(magazine->m_count >= 0);
+			magazine->m_allocations++;
+			if (magazine->m_count)
 			{
-				me[i + 1] = me[i];
-				me[i + 0] = header;
-				index = i;
+				magazine->m_cacheHits++;
 			}
 			else
 			{
-				break;
+				ndFreeListDictionary::GetHeader().Refill(magazine);
+			}
+			if (magazine->m_count)
+			{
+				magazine->m_count--;
+				ndFreeListEntry* const self = magazine->m_headPointer;
+				magazine->m_headPointer = self->m_next;
+				return self;
+			}
+		}
+		void* const ptr = ndMemory::Malloc(size_t(size));
+		ndAssert(ndMemory::GetSize(ptr) == size_t(chunkSize));
+		return ptr;
+	}
+
+	void Free(void* ptr)
+	{
+		ndScopeSpinLock lock(m_lock);
+		ndFreeListMagazine* const magazine = ndFindFreeListEntry(*this, ndInt32(ndMemory::GetSize(ptr)));
+		ndFreeListEntry* const self = (ndFreeListEntry*)ptr;
+
+		self->m_next = magazine->m_headPointer;
+		magazine->m_count++;
+		magazine->m_headPointer = self;
+
+		if (magazine->m_count > D_FREELIST_MAGAZINE_SIZE)
+		{
+			// the magazine is full, return one batch to the shared list
+			ndFreeListEntry* const first = magazine->m_headPointer;
+			ndFreeListEntry* last = first;
+			for (ndInt32 i = 1; i < D_FREELIST_MAGAZINE_BATCH; ++i)
+			{
+				last = last->m_next;
 			}
+			magazine->m_headPointer = last->m_next;
+			magazine->m_count -= D_FREELIST_MAGAZINE_BATCH;
+			ndFreeListDictionary::GetHeader().Return(magazine->m_schunkSize, first, last, D_FREELIST_MAGAZINE_BATCH);
 		}
-		return &me[index];
 	}
 
 	ndSpinLock m_lock;
+	ndFreeListThreadCache* m_prev;
+	ndFreeListThreadCache* m_next;
 };
 
+void ndFreeListDictionary::Flush()
+{
+	{
+		ndScopeSpinLock cacheLock(m_cacheLock);
+		for (ndFreeListThreadCache* cache = m_caches; cache; cache = cache->m_next)
+		{
+			ndScopeSpinLock lock(cache->m_lock);
+			ndFreeListThreadCache& magazines = *cache;
+			for (ndInt32 i = 0; i < magazines.GetCount(); ++i)
+			{
+				cache->Flush(&magazines[i]);
+			}
+		}
+	}
+
+	ndScopeSpinLock lock(m_lock);
+	ndFreeListDictionary& me = *this;
+	for (ndInt32 i = 0; i < GetCount(); ++i)
+	{
+		ndFreeListHeader* const header = &me[i];
+		Flush(header);
+	}
+	SetCount(0);
+}
+
+void ndFreeListDictionary::Flush(ndInt32 size)
+{
+	const ndInt32 chunkSize = ndInt32(ndMemory::CalculateBufferSize(size_t(size)));
+	{
+		ndScopeSpinLock cacheLock(m_cacheLock);
+		for (ndFreeListThreadCache* cache = m_caches; cache; cache = cache->m_next)
+		{
+			ndScopeSpinLock lock(cache->m_lock);
+			cache->Flush(ndFindFreeListEntry(*cache, chunkSize));
+		}
+	}
+
+	ndScopeSpinLock lock(m_lock);
+	ndFreeListHeader* const header = ndFindFreeListEntry(*this, chunkSize);
+	Flush(header);
+}
+
+ndInt32 ndFreeListDictionary::GetStatistics(ndFreeListStatistics* const stats, ndInt32 maxCount)
+{
+	ndInt32 count = 0;
+	ndScopeSpinLock cacheLock(m_cacheLock);
+	{
+		ndScopeSpinLock lock(m_lock);
+		ndFreeListDictionary& me = *this;
+		for (ndInt32 i = 0; (i < GetCount()) && (count < maxCount); ++i)
+		{
+			const ndFreeListHeader& header = me[i];
+			ndFreeListStatistics& entry = stats[count];
+			entry.m_allocations = 0;
+			entry.m_cacheHits = 0;
+			entry.m_refills = header.m_refills;
+			entry.m_returns = header.m_returns;
+			entry.m_chunkSize = header.m_schunkSize;
+			entry.m_sharedCount = header.m_count;
+			entry.m_cachedCount = 0;
+			count++;
+		}
+	}
+
+	for (ndFreeListThreadCache* cache = m_caches; cache; cache = cache->m_next)
+	{
+		ndScopeSpinLock lock(cache->m_lock);
+		const ndFreeListThreadCache& magazines = *cache;
+		for (ndInt32 i = 0; i < magazines.GetCount(); ++i)
+		{
+			const ndFreeListMagazine& magazine = magazines[i];
+			ndInt32 index = 0;
+			for (; (index < count) && (stats[index].m_chunkSize != magazine.m_schunkSize); ++index);
+			if (index == count)
+			{
+				if (count >= maxCount)
+				{
+					continue;
+				}
+				ndFreeListStatistics& entry = stats[count];
+				entry.m_allocations = 0;
+				entry.m_cacheHits = 0;
+				entry.m_refills = 0;
+				entry.m_returns = 0;
+				entry.m_chunkSize = magazine.m_schunkSize;
+				entry.m_sharedCount = 0;
+				entry.m_cachedCount = 0;
+				count++;
+			}
+			ndFreeListStatistics& entry = stats[index];
+			entry.m_allocations += magazine.m_allocations;
+			entry.m_cacheHits += magazine.m_cacheHits;
+			entry.m_cachedCount += magazine.m_count;
+		}
+	}
+	return count;
+}
+
 void ndFreeListAlloc::Flush()
 {
 	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
@@ -192,14 +509,27 @@ void ndFreeListAlloc::Flush()
 
 void* ndFreeListAlloc::operator new (size_t size)
 {
+	ndFreeListThreadCache* const cache = ndFreeListThreadCache::GetCache();
+	if (cache)
+	{
+		return cache->Malloc(ndInt32(size));
+	}
 	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
-	return dictionary.Malloc(ndInt32 (size));
+	return dictionary.Malloc(ndInt32(size));
 }
 
 void ndFreeListAlloc::operator delete (void* ptr)
 {
-	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
-	dictionary.Free(ptr);
+	ndFreeListThreadCache* const cache = ndFreeListThreadCache::GetCache();
+	if (cache)
+	{
+		cache->Free(ptr);
+	}
+	else
+	{
+		ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
+		dictionary.Free(ptr);
+	}
 }
 
 void ndFreeListAlloc::Flush(ndInt32 size)
@@ -208,3 +538,8 @@ void ndFreeListAlloc::Flush(ndInt32 size)
 	dictionary.Flush(size);
 }
 
+ndInt32 ndFreeListAlloc::GetStatistics(ndFreeListStatistics* const stats, ndInt32 maxCount)
+{
+	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
+	return dictionary.GetStatistics(stats, maxCount);
+}
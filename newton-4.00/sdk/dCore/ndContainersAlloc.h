@@ -41,12 +41,29 @@ class ndContainersAlloc: public ndClassAlloc
 	}
 };
 
+// per size class counters of the free list allocator
+class ndFreeListStatistics
+{
+	public:
+	ndUnsigned64 m_allocations;
+	ndUnsigned64 m_cacheHits;
+	ndUnsigned64 m_refills;
+	ndUnsigned64 m_returns;
+	ndInt32 m_chunkSize;
+	ndInt32 m_sharedCount;
+	ndInt32 m_cachedCount;
+};
+
+// each thread keeps a small magazine of free chunks per size class in front
+// of the shared free lists, magazines are refilled from and returned to
+// the shared lists in batches, so the shared lock is rarely taken.
 class ndFreeListAlloc
 {
 	public:
 	ndFreeListAlloc();
 	D_CORE_API static void Flush();
 	D_CORE_API static void Flush(ndInt32 size);
+	D_CORE_API static ndInt32 GetStatistics(ndFreeListStatistics* const stats, ndInt32 maxCount);
 	D_CORE_API void *operator new (size_t size);
 	D_CORE_API void operator delete (void* ptr);
 };
@@ -138,6 +138,22 @@ ndFloat64 ndConvexHull3dFace::Evalue (const ndBigVector* const pointArray, const
 	const ndBigVector& p1 = pointArray[m_index[1]];
 	const ndBigVector& p2 = pointArray[m_index[2]];
 
+	// single precision fast path, the edges are subtracted in double and only the products are done in float.
+	// the bound is a few times larger than the worse rounding of the float products,
+	// so only nearly coplanar points fall through to the double and the exact tests.
+	const ndVector e0(p1 - p0);
+	const ndVector e1(p2 - p0);
+	const ndVector e2(point - p0);
+	const ndVector a0(e0.Abs());
+	const ndVector a1(e1.Abs());
+	const ndVector permanent(a0.ShiftTripleLeft() * a1.ShiftTripleRight() + a0.ShiftTripleRight() * a1.ShiftTripleLeft());
+	const ndFloat32 det32 = e0.CrossProduct(e1).DotProduct(e2).GetScalar();
+	const ndFloat32 error32 = permanent.DotProduct(e2.Abs()).GetScalar();
+	if (ndAbs(det32) > error32 * ndFloat32(1.0f / (1 << 18)))
+	{
+		return ndFloat64(det32);
+	}
+
 	ndFloat64 matrix[3][3];
 	for (ndInt32 i = 0; i < 3; ++i) 
 	{
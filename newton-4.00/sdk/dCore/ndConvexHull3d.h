@@ -40,11 +40,13 @@ class ndConvexHull3dFace
 	public:
 	D_CORE_API ndConvexHull3dFace();
 
+	// signed volume of the face and the point, the sign is exact.
+	D_CORE_API ndFloat64 Evalue (const ndBigVector* const pointArray, const ndBigVector& point) const;
+
 	private:
 	void SetMark(ndInt32 mark) { m_mark = mark; }
 	ndInt32 GetMark() const { return m_mark; }
 	ndList<ndConvexHull3dFace>::ndNode* GetTwin(ndInt32 index) const;
-	ndFloat64 Evalue (const ndBigVector* const pointArray, const ndBigVector& point) const;
 	ndBigPlane GetPlaneEquation (const ndBigVector* const pointArray, bool& isvalid) const;
 
 	public:
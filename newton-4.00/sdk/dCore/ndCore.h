@@ -53,6 +53,7 @@
 #include <ndQuaternion.h>
 #include <ndProbability.h>
 #include <ndPerlinNoise.h>
+#include <ndFrameArena.h>
 #include <ndFixSizeArray.h>
 #include <ndConvexHull2d.h>
 #include <ndConvexHull3d.h>
@@ -0,0 +1,170 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndMemory.h"
+#include "ndFrameArena.h"
+
+#define D_FRAME_ARENA_ALIGN(size) ((size_t(size) + D_MEMORY_ALIGMNET - 1) & ~size_t(D_MEMORY_ALIGMNET - 1))
+
+ndFrameArena::ndFrameArena(size_t blockSize)
+	:ndClassAlloc()
+	,m_freeBlocks(nullptr)
+	,m_blockSize(D_FRAME_ARENA_ALIGN(ndMax(blockSize, size_t(4096))))
+	,m_capacity(0)
+	,m_frameUsage(0)
+	,m_highWaterMark(0)
+	,m_trimPeak(0)
+	,m_trimFrames(0)
+	,m_trimCounter(0)
+	,m_lock()
+{
+	ndAssert(sizeof(ndBlock) == D_FRAME_ARENA_ALIGN(sizeof(ndBlock)));
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		m_threadBlocks[i] = nullptr;
+	}
+}
+
+ndFrameArena::~ndFrameArena()
+{
+	Reset();
+	Trim(0);
+	ndAssert(!m_capacity);
+}
+
+ndFrameArena::ndBlock* ndFrameArena::NewBlock(size_t size)
+{
+	// reuse the first free block that is large enough
+	{
+		ndScopeSpinLock lock(m_lock);
+		ndBlock* prev = nullptr;
+		for (ndBlock* block = m_freeBlocks; block; block = block->m_next)
+		{
+			if (block->m_size >= size)
+			{
+				if (prev)
+				{
+					prev->m_next = block->m_next;
+				}
+				else
+				{
+					m_freeBlocks = block->m_next;
+				}
+				block->m_next = nullptr;
+				block->m_used = 0;
+				return block;
+			}
+			prev = block;
+		}
+	}
+
+	const size_t blockSize = ndMax(size, m_blockSize);
+	ndBlock* const block = (ndBlock*)ndMemory::Malloc(sizeof(ndBlock) + blockSize);
+	block->m_next = nullptr;
+	block->m_size = blockSize;
+	block->m_used = 0;
+
+	ndScopeSpinLock lock(m_lock);
+	m_capacity += blockSize;
+	return block;
+}
+
+void* ndFrameArena::Alloc(size_t size, ndInt32 threadIndex)
+{
+	ndAssert(threadIndex >= 0);
+	ndAssert(threadIndex < D_MAX_THREADS_COUNT);
+
+	size = D_FRAME_ARENA_ALIGN(ndMax(size, size_t(1)));
+	ndBlock* block = m_threadBlocks[threadIndex];
+	if (!block || ((block->m_used + size) > block->m_size))
+	{
+		// the full block stays in the thread chain until the next reset
+		ndBlock* const newBlock = NewBlock(size);
+		newBlock->m_next = block;
+		m_threadBlocks[threadIndex] = newBlock;
+		block = newBlock;
+	}
+
+	char* const ptr = (char*)(block + 1) + block->m_used;
+	block->m_used += size;
+	return ptr;
+}
+
+size_t ndFrameArena::GetUsage() const
+{
+	size_t usage = 0;
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		for (ndBlock* block = m_threadBlocks[i]; block; block = block->m_next)
+		{
+			usage += block->m_used;
+		}
+	}
+	return usage;
+}
+
+void ndFrameArena::Reset()
+{
+	m_frameUsage = GetUsage();
+	m_highWaterMark = ndMax(m_highWaterMark, m_frameUsage);
+
+	{
+		ndScopeSpinLock lock(m_lock);
+		for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+		{
+			ndBlock* next;
+			for (ndBlock* block = m_threadBlocks[i]; block; block = next)
+			{
+				next = block->m_next;
+				block->m_used = 0;
+				block->m_next = m_freeBlocks;
+				m_freeBlocks = block;
+			}
+			m_threadBlocks[i] = nullptr;
+		}
+	}
+
+	if (m_trimFrames)
+	{
+		m_trimPeak = ndMax(m_trimPeak, m_frameUsage);
+		m_trimCounter++;
+		if (m_trimCounter >= m_trimFrames)
+		{
+			// keep one spare block for the per thread fragmentation
+			Trim(m_trimPeak + m_blockSize);
+			m_trimPeak = 0;
+			m_trimCounter = 0;
+		}
+	}
+}
+
+void ndFrameArena::Trim(size_t maxCapacity)
+{
+	ndScopeSpinLock lock(m_lock);
+	while (m_freeBlocks && (m_capacity > maxCapacity))
+	{
+		ndBlock* const block = m_freeBlocks;
+		m_freeBlocks = block->m_next;
+		m_capacity -= block->m_size;
+		ndMemory::Free(block);
+	}
+}
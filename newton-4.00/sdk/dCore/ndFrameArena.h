@@ -0,0 +1,139 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_FRAME_ARENA_H__
+#define __ND_FRAME_ARENA_H__
+
+#include "ndCoreStdafx.h"
+#include "ndTypes.h"
+#include "ndArray.h"
+#include "ndClassAlloc.h"
+#include "ndThreadPool.h"
+#include "ndThreadSyncUtils.h"
+
+#define D_FRAME_ARENA_BLOCK_SIZE	(256 * 1024)
+
+/// Linear allocator for transient buffers that only live for one step.
+/// each thread of a pool bump allocates from its own sub arena, so
+/// allocations never take a lock unless a sub arena needs a new block.
+/// Reset releases all allocations at once and keeps the blocks for the
+/// next step. memory is only returned to the system by Trim, or by the
+/// trim policy, which trims to the peak usage of the last few frames.
+class ndFrameArena: public ndClassAlloc
+{
+	class ndBlock
+	{
+		public:
+		ndBlock* m_next;
+		size_t m_size;
+		size_t m_used;
+		size_t m_padd;
+	};
+
+	public:
+	D_CORE_API ndFrameArena(size_t blockSize = D_FRAME_ARENA_BLOCK_SIZE);
+	D_CORE_API ~ndFrameArena();
+
+	/// allocate size bytes, aligned to D_MEMORY_ALIGMNET, from the sub arena of threadIndex.
+	/// the memory is valid until the next call to Reset.
+	D_CORE_API void* Alloc(size_t size, ndInt32 threadIndex = 0);
+
+	template <class T>
+	T* Alloc(ndInt64 count, ndInt32 threadIndex = 0);
+
+	/// point array to count elements of arena memory, the old content is discarded.
+	/// the array does not own the memory, call ResetMembers before it is destroyed.
+	template <class T>
+	void Bind(ndArray<T>& array, ndInt64 count, ndInt32 threadIndex = 0);
+
+	/// release all allocations, must not be called while other threads are allocating.
+	D_CORE_API void Reset();
+
+	/// release the free blocks until the capacity is not larger than maxCapacity.
+	D_CORE_API void Trim(size_t maxCapacity);
+
+	/// trim the arena to its peak usage every framesCount resets, zero disables trimming.
+	void SetTrimPolicy(ndInt32 framesCount);
+	ndInt32 GetTrimPolicy() const;
+
+	/// bytes reserved from the system
+	size_t GetCapacity() const;
+	/// bytes used by the last frame before Reset
+	size_t GetFrameUsage() const;
+	/// largest frame usage since the arena was created
+	size_t GetHighWaterMark() const;
+
+	private:
+	ndBlock* NewBlock(size_t size);
+	size_t GetUsage() const;
+
+	ndBlock* m_threadBlocks[D_MAX_THREADS_COUNT];
+	ndBlock* m_freeBlocks;
+	size_t m_blockSize;
+	size_t m_capacity;
+	size_t m_frameUsage;
+	size_t m_highWaterMark;
+	size_t m_trimPeak;
+	ndInt32 m_trimFrames;
+	ndInt32 m_trimCounter;
+	ndSpinLock m_lock;
+};
+
+template <class T>
+inline T* ndFrameArena::Alloc(ndInt64 count, ndInt32 threadIndex)
+{
+	return (T*)Alloc(size_t(count) * sizeof(T), threadIndex);
+}
+
+template <class T>
+inline void ndFrameArena::Bind(ndArray<T>& array, ndInt64 count, ndInt32 threadIndex)
+{
+	array.SetMembers(count, Alloc<T>(count + 1, threadIndex));
+}
+
+inline void ndFrameArena::SetTrimPolicy(ndInt32 framesCount)
+{
+	m_trimFrames = ndMax(framesCount, 0);
+	m_trimCounter = 0;
+	m_trimPeak = 0;
+}
+
+inline ndInt32 ndFrameArena::GetTrimPolicy() const
+{
+	return m_trimFrames;
+}
+
+inline size_t ndFrameArena::GetCapacity() const
+{
+	return m_capacity;
+}
+
+inline size_t ndFrameArena::GetFrameUsage() const
+{
+	return m_frameUsage;
+}
+
+inline size_t ndFrameArena::GetHighWaterMark() const
+{
+	return m_highWaterMark;
+}
+
+#endif
@@ -25,11 +25,18 @@
 #include "ndVector.h"
 #include "ndMatrix.h"
 #include "ndProfiler.h"
+#include "ndThreadPool.h"
 #include "ndIsoSurface.h"
 
 // adapted from code by written by Paul Bourke may 1994
 //http://paulbourke.net/geometry/polygonise/
 
+#define D_ISO_BLOCK_BITS		3
+#define D_ISO_BLOCK_SIZE		(1 << D_ISO_BLOCK_BITS)
+#define D_ISO_BLOCK_FIELD		(D_ISO_BLOCK_SIZE + 1)
+#define D_ISO_BLOCK_WORDS		((D_ISO_BLOCK_FIELD * D_ISO_BLOCK_FIELD * D_ISO_BLOCK_FIELD + 63) / 64)
+#define D_ISO_BLOCK_KEY_BIAS	(1 << 15)
+
 class ndIsoSurface::ndImplementation : public ndClassAlloc
 {
 	public:
@@ -47,6 +54,44 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 		ndVector m_isoValues[8];
 	};
 
+	// a block of D_ISO_BLOCK_SIZE^3 cells, the occupancy field includes
+	// the first layer of lattice points of the blocks on the positive side.
+	class ndIsoBlock : public ndClassAlloc
+	{
+		public:
+		ndIsoBlock(ndUnsigned64 key)
+			:ndClassAlloc()
+			,m_key(key)
+			,m_triangles(64)
+			,m_start(0)
+			,m_valid(false)
+		{
+			for (ndInt32 i = 0; i < D_ISO_BLOCK_WORDS; ++i)
+			{
+				m_occupancy[i] = 0;
+			}
+		}
+
+		ndInt32 GetCoordinate(ndInt32 axis) const
+		{
+			return ndInt32((m_key >> (axis * 16)) & 0xffff) - D_ISO_BLOCK_KEY_BIAS;
+		}
+
+		ndUnsigned64 m_key;
+		ndUnsigned64 m_occupancy[D_ISO_BLOCK_WORDS];
+		ndArray<ndVector> m_triangles;
+		ndInt32 m_start;
+		bool m_valid;
+	};
+
+	class ndWeldEntry
+	{
+		public:
+		ndUnsigned64 m_key;
+		ndInt32 m_index;
+		ndInt32 m_vertex;
+	};
+
 	ndImplementation();
 	~ndImplementation();
 
@@ -59,6 +104,11 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 		ndInt32* const indexList, ndInt32 strideInFloats, 
 		ndReal* const posit, ndReal* const normals);
 
+	void BuildBlockMesh(ndIsoSurface* const me, ndThreadPool* const threadPool, const ndArray<ndVector>& pointCloud, ndFloat32 gridSize);
+	ndInt32 GenerateBlockIndexList(const ndIsoSurface* const me, ndThreadPool* const threadPool,
+		ndInt32* const indexList, ndInt32 strideInFloats,
+		ndReal* const posit, ndReal* const normals);
+
 	private:
 	class ndGridHash
 	{
@@ -171,6 +221,10 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 	void CalculateNormals(ndIsoSurface* const me);
 	
 	void GenerateHighResIndexList(ndIsoSurface* const me);
+	void ClearBlocks();
+	void PolygonizeBlock(ndIsoBlock* const block) const;
+	ndUnsigned64 PackBlockKey(ndInt32 x, ndInt32 y, ndInt32 z) const;
+	ndInt32 FindOccupiedBlock(ndUnsigned64 key) const;
 	void RemoveDuplicates(const ndArray<ndVector>& points);
 	void CalculateAabb(const ndArray<ndVector>& points, ndFloat32 gridSize);
 	void GenerateHighResIsoSurface(ndCalculateIsoValue* const computeIsoValue);
@@ -187,6 +241,21 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 	ndArray<ndVector> m_triangles;
 	ndArray<ndVector> m_trianglesScratchBuffer;
 
+	// block pipeline, the blocks are sorted by key and persist between calls
+	ndArray<ndIsoBlock*> m_blocks;
+	ndArray<ndIsoBlock*> m_blocksScratch;
+	ndArray<ndUnsigned64> m_blockKeys;
+	ndArray<ndUnsigned64> m_voxelKeys;
+	ndArray<ndUnsigned64> m_voxelKeysScratch;
+	ndArray<ndUnsigned64> m_occupiedBlocks;
+	ndArray<ndInt32> m_occupiedStart;
+	ndArray<ndWeldEntry> m_weldEntries;
+	ndArray<ndWeldEntry> m_weldEntriesScratch;
+	ndArray<ndInt32> m_weldRuns;
+	ndArray<ndVector> m_faceNormals;
+	ndInt32 m_blockOrigin[3];
+	ndInt32 m_blockBits[3];
+
 	ndFloat32 m_isoValue;
 	ndInt32 m_volumeSizeX;
 	ndInt32 m_volumeSizeY;
@@ -2591,6 +2660,17 @@ inline ndIsoSurface::ndImplementation::ndImplementation()
 	,m_hashGridMapScratchBuffer(256)
 	,m_triangles(256)
 	,m_trianglesScratchBuffer(256)
+	,m_blocks(256)
+	,m_blocksScratch(256)
+	,m_blockKeys(256)
+	,m_voxelKeys(256)
+	,m_voxelKeysScratch(256)
+	,m_occupiedBlocks(256)
+	,m_occupiedStart(256)
+	,m_weldEntries(256)
+	,m_weldEntriesScratch(256)
+	,m_weldRuns(256)
+	,m_faceNormals(256)
 	,m_isoValue(ndFloat32 (0.5f))
 	//,m_worlToGridOrigin(ndFloat32(1.0f))
 	//,m_worlToGridScale(ndFloat32(1.0f))
@@ -2599,10 +2679,25 @@ inline ndIsoSurface::ndImplementation::ndImplementation()
 	,m_volumeSizeZ(1)
 	,m_upperDigitsIsValid()
 {
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		m_blockOrigin[i] = 0;
+		m_blockBits[i] = 1;
+	}
 }
 
 ndIsoSurface::ndImplementation::~ndImplementation()
 {
+	ClearBlocks();
+}
+
+void ndIsoSurface::ndImplementation::ClearBlocks()
+{
+	for (ndInt32 i = 0; i < ndInt32(m_blocks.GetCount()); ++i)
+	{
+		delete m_blocks[i];
+	}
+	m_blocks.SetCount(0);
 }
 
 ndVector ndIsoSurface::ndImplementation::GetOrigin() const
@@ -3381,6 +3476,599 @@ void ndIsoSurface::ndImplementation::BuildLowResolutionMesh(ndIsoSurface* const
 	ClearBuffers();
 }
 
+ndUnsigned64 ndIsoSurface::ndImplementation::PackBlockKey(ndInt32 x, ndInt32 y, ndInt32 z) const
+{
+	// block coordinates relative to the block origin, z major
+	ndAssert(x >= 0);
+	ndAssert(y >= 0);
+	ndAssert(z >= 0);
+	return (((ndUnsigned64(z) << m_blockBits[1]) | ndUnsigned64(y)) << m_blockBits[0]) | ndUnsigned64(x);
+}
+
+ndInt32 ndIsoSurface::ndImplementation::FindOccupiedBlock(ndUnsigned64 key) const
+{
+	ndInt32 i0 = 0;
+	ndInt32 i1 = ndInt32(m_occupiedBlocks.GetCount()) - 1;
+	while (i0 <= i1)
+	{
+		const ndInt32 mid = (i0 + i1) >> 1;
+		const ndUnsigned64 midKey = m_occupiedBlocks[mid];
+		if (midKey == key)
+		{
+			return mid;
+		}
+		else if (midKey < key)
+		{
+			i0 = mid + 1;
+		}
+		else
+		{
+			i1 = mid - 1;
+		}
+	}
+	return -1;
+}
+
+void ndIsoSurface::ndImplementation::PolygonizeBlock(ndIsoBlock* const block) const
+{
+	// lattice offset of each cell corner, the corners are at origin + m_gridCorners
+	ndInt32 cornerOffsets[8];
+	for (ndInt32 j = 0; j < 8; ++j)
+	{
+		const ndInt32 x = ndInt32(m_gridCorners[j].m_x) + 1;
+		const ndInt32 y = ndInt32(m_gridCorners[j].m_y) + 1;
+		const ndInt32 z = ndInt32(m_gridCorners[j].m_z) + 1;
+		cornerOffsets[j] = (z * D_ISO_BLOCK_FIELD + y) * D_ISO_BLOCK_FIELD + x;
+	}
+
+	const ndInt32 baseX = block->GetCoordinate(0) * D_ISO_BLOCK_SIZE;
+	const ndInt32 baseY = block->GetCoordinate(1) * D_ISO_BLOCK_SIZE;
+	const ndInt32 baseZ = block->GetCoordinate(2) * D_ISO_BLOCK_SIZE;
+
+	ndArray<ndVector>& triangles = block->m_triangles;
+	triangles.SetCount(0);
+	for (ndInt32 z = 0; z < D_ISO_BLOCK_SIZE; ++z)
+	{
+		for (ndInt32 y = 0; y < D_ISO_BLOCK_SIZE; ++y)
+		{
+			for (ndInt32 x = 0; x < D_ISO_BLOCK_SIZE; ++x)
+			{
+				const ndInt32 cellBit = (z * D_ISO_BLOCK_FIELD + y) * D_ISO_BLOCK_FIELD + x;
+				ndInt32 tableIndex = 0;
+				for (ndInt32 j = 0; j < 8; ++j)
+				{
+					const ndInt32 bit = cellBit + cornerOffsets[j];
+					tableIndex |= ndInt32((block->m_occupancy[bit >> 6] >> (bit & 63)) & 1) << j;
+				}
+				if (!tableIndex || (tableIndex == 0xff))
+				{
+					continue;
+				}
+
+				const ndVector origin(ndFloat32(baseX + x + 1), ndFloat32(baseY + y + 1), ndFloat32(baseZ + z + 1), ndFloat32(0.0f));
+				ndVector vertlist[12];
+				const ndInt32 start = m_edgeScan[tableIndex];
+				const ndInt32 edgeCount = m_edgeScan[tableIndex + 1] - start;
+				for (ndInt32 i = 0; i < edgeCount; ++i)
+				{
+					const ndEdge& edge = m_edges[start + i];
+					const ndVector p0(origin + m_gridCorners[edge.m_p0]);
+					const ndVector p1(origin + m_gridCorners[edge.m_p1]);
+					vertlist[edge.m_midPoint] = (p0 + p1) * ndVector::m_half;
+				}
+
+				const ndInt32 faceStart = m_facesScan[tableIndex];
+				const ndInt32 faceCount = m_facesScan[tableIndex + 1] - faceStart;
+				for (ndInt32 i = 0; i < faceCount; ++i)
+				{
+					triangles.PushBack(vertlist[m_faces[faceStart + i][0]]);
+					triangles.PushBack(vertlist[m_faces[faceStart + i][1]]);
+					triangles.PushBack(vertlist[m_faces[faceStart + i][2]]);
+				}
+			}
+		}
+	}
+}
+
+void ndIsoSurface::ndImplementation::BuildBlockMesh(ndIsoSurface* const me, ndThreadPool* const threadPool, const ndArray<ndVector>& points, ndFloat32 gridSize)
+{
+	D_TRACKTIME();
+	class ndKeyByte
+	{
+		public:
+		ndKeyByte(void* const context)
+			:m_shift(*((ndInt32*)context))
+		{
+		}
+
+		ndInt32 GetKey(const ndUnsigned64& key) const
+		{
+			return ndInt32((key >> m_shift) & 0xff);
+		}
+
+		ndInt32 m_shift;
+	};
+
+	class ndCompareKey
+	{
+		public:
+		ndCompareKey(void* const)
+		{
+		}
+
+		ndInt32 Compare(const ndUnsigned64& keyA, const ndUnsigned64& keyB) const
+		{
+			if (keyA < keyB)
+			{
+				return -1;
+			}
+			else if (keyA > keyB)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	// if the grid size changes all cached blocks are invalid
+	if (m_gridSize.m_x != gridSize)
+	{
+		ClearBlocks();
+	}
+	m_isoValue = ndFloat32(0.5f);
+	m_gridSize = ndVector::m_triplexMask & ndVector(gridSize);
+	m_invGridSize = ndVector::m_triplexMask & ndVector(ndFloat32(1.0f) / gridSize);
+
+	const ndInt32 threadCount = threadPool->GetThreadCount();
+	const ndInt32 pointCount = ndInt32(points.GetCount());
+
+	ndVector boxes[D_MAX_THREADS_COUNT * 2];
+	auto CalculateAabb = ndMakeObject::ndFunction([&points, &boxes](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CalculateAabb);
+		ndVector boxP0(ndFloat32(1.0e10f));
+		ndVector boxP1(ndFloat32(-1.0e10f));
+		const ndStartEnd startEnd(ndInt32(points.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			boxP0 = boxP0.GetMin(points[i]);
+			boxP1 = boxP1.GetMax(points[i]);
+		}
+		boxes[threadIndex * 2 + 0] = boxP0;
+		boxes[threadIndex * 2 + 1] = boxP1;
+	});
+	threadPool->ParallelExecute(CalculateAabb);
+
+	ndVector boxP0(ndFloat32(1.0e10f));
+	ndVector boxP1(ndFloat32(-1.0e10f));
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		boxP0 = boxP0.GetMin(boxes[i * 2 + 0]);
+		boxP1 = boxP1.GetMax(boxes[i * 2 + 1]);
+	}
+
+	// one empty block of padding on the negative side, 
+	// for the cells that have a corner in the first block
+	const ndVector voxel0((boxP0 * m_invGridSize).Floor().GetInt());
+	const ndVector voxel1((boxP1 * m_invGridSize).Floor().GetInt());
+	ndInt32 keyBits = D_ISO_BLOCK_BITS * 3;
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		m_blockOrigin[i] = (ndInt32(voxel0.m_i[i]) >> D_ISO_BLOCK_BITS) - 1;
+		const ndInt32 extent = (ndInt32(voxel1.m_i[i]) >> D_ISO_BLOCK_BITS) - m_blockOrigin[i] + 2;
+		ndAssert((m_blockOrigin[i] + extent + D_ISO_BLOCK_KEY_BIAS) < (1 << 16));
+		ndAssert((m_blockOrigin[i] + D_ISO_BLOCK_KEY_BIAS) >= 0);
+		m_blockBits[i] = 1;
+		while ((1 << m_blockBits[i]) <= extent)
+		{
+			m_blockBits[i]++;
+		}
+		keyBits += m_blockBits[i];
+	}
+	const ndVector originGrid(
+		ndFloat32(m_blockOrigin[0] * D_ISO_BLOCK_SIZE), 
+		ndFloat32(m_blockOrigin[1] * D_ISO_BLOCK_SIZE), 
+		ndFloat32(m_blockOrigin[2] * D_ISO_BLOCK_SIZE), ndFloat32(0.0f));
+	m_boxP0 = originGrid * m_gridSize;
+	m_boxP1 = ndVector(ndFloat32(voxel1.m_ix + 2), ndFloat32(voxel1.m_iy + 2), ndFloat32(voxel1.m_iz + 2), ndFloat32(0.0f)) * m_gridSize;
+	m_volumeSizeX = ndInt32(voxel1.m_ix) + 2 - m_blockOrigin[0] * D_ISO_BLOCK_SIZE;
+	m_volumeSizeY = ndInt32(voxel1.m_iy) + 2 - m_blockOrigin[1] * D_ISO_BLOCK_SIZE;
+	m_volumeSizeZ = ndInt32(voxel1.m_iz) + 2 - m_blockOrigin[2] * D_ISO_BLOCK_SIZE;
+
+	// voxelize, each key is the block key followed by the voxel index in the block
+	m_voxelKeys.SetCount(pointCount);
+	auto CalculateVoxelKeys = ndMakeObject::ndFunction([this, &points](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CalculateVoxelKeys);
+		const ndStartEnd startEnd(ndInt32(points.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndVector voxel((points[i] * m_invGridSize).Floor().GetInt());
+			const ndInt32 x = ndInt32(voxel.m_ix);
+			const ndInt32 y = ndInt32(voxel.m_iy);
+			const ndInt32 z = ndInt32(voxel.m_iz);
+			const ndUnsigned64 blockKey = PackBlockKey((x >> D_ISO_BLOCK_BITS) - m_blockOrigin[0], (y >> D_ISO_BLOCK_BITS) - m_blockOrigin[1], (z >> D_ISO_BLOCK_BITS) - m_blockOrigin[2]);
+			const ndInt32 mask = D_ISO_BLOCK_SIZE - 1;
+			const ndUnsigned64 local = ndUnsigned64((((z & mask) << D_ISO_BLOCK_BITS) + (y & mask)) << D_ISO_BLOCK_BITS) + ndUnsigned64(x & mask);
+			m_voxelKeys[i] = (blockKey << (D_ISO_BLOCK_BITS * 3)) | local;
+		}
+	});
+	threadPool->ParallelExecute(CalculateVoxelKeys);
+
+	for (ndInt32 shift = 0; shift < keyBits; shift += 8)
+	{
+		ndCountingSort<ndUnsigned64, ndKeyByte, 8>(*threadPool, m_voxelKeys, m_voxelKeysScratch, nullptr, &shift);
+	}
+
+	// find the runs of voxels of each occupied block, with a prefix sum
+	ndInt32 scans[D_MAX_THREADS_COUNT + 1];
+	auto CountBlocks = ndMakeObject::ndFunction([this, &scans](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CountBlocks);
+		ndInt32 count = 0;
+		const ndUnsigned64* const keys = &m_voxelKeys[0];
+		const ndStartEnd startEnd(ndInt32(m_voxelKeys.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			count += (!i || ((keys[i] >> (D_ISO_BLOCK_BITS * 3)) != (keys[i - 1] >> (D_ISO_BLOCK_BITS * 3)))) ? 1 : 0;
+		}
+		scans[threadIndex] = count;
+	});
+
+	auto ScatterBlocks = ndMakeObject::ndFunction([this, &scans](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(ScatterBlocks);
+		ndInt32 index = scans[threadIndex];
+		const ndUnsigned64* const keys = &m_voxelKeys[0];
+		const ndStartEnd startEnd(ndInt32(m_voxelKeys.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndUnsigned64 blockKey = keys[i] >> (D_ISO_BLOCK_BITS * 3);
+			if (!i || (blockKey != (keys[i - 1] >> (D_ISO_BLOCK_BITS * 3))))
+			{
+				m_occupiedBlocks[index] = blockKey;
+				m_occupiedStart[index] = i;
+				index++;
+			}
+		}
+	});
+
+	threadPool->ParallelExecute(CountBlocks);
+	ndInt32 occupiedCount = 0;
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		const ndInt32 count = scans[i];
+		scans[i] = occupiedCount;
+		occupiedCount += count;
+	}
+	m_occupiedBlocks.SetCount(occupiedCount);
+	m_occupiedStart.SetCount(occupiedCount + 1);
+	threadPool->ParallelExecute(ScatterBlocks);
+	m_occupiedStart[occupiedCount] = pointCount;
+
+	// the blocks to polygonize are the occupied blocks and their negative neighbors
+	const ndUnsigned64 maskX = (ndUnsigned64(1) << m_blockBits[0]) - 1;
+	const ndUnsigned64 maskY = (ndUnsigned64(1) << m_blockBits[1]) - 1;
+	m_blockKeys.SetCount(0);
+	for (ndInt32 i = 0; i < occupiedCount; ++i)
+	{
+		const ndUnsigned64 key = m_occupiedBlocks[i];
+		const ndInt32 x = ndInt32(key & maskX);
+		const ndInt32 y = ndInt32((key >> m_blockBits[0]) & maskY);
+		const ndInt32 z = ndInt32(key >> (m_blockBits[0] + m_blockBits[1]));
+		for (ndInt32 j = 0; j < 8; ++j)
+		{
+			m_blockKeys.PushBack(PackBlockKey(x - (j & 1), y - ((j >> 1) & 1), z - ((j >> 2) & 1)));
+		}
+	}
+	ndSort<ndUnsigned64, ndCompareKey>(&m_blockKeys[0], ndInt32(m_blockKeys.GetCount()), nullptr);
+
+	// match the blocks against the ones of the last call, both lists are sorted
+	ndInt32 cacheIndex = 0;
+	m_blocksScratch.SetCount(0);
+	for (ndInt32 i = 0; i < ndInt32(m_blockKeys.GetCount()); ++i)
+	{
+		const ndUnsigned64 key = m_blockKeys[i];
+		if (i && (key == m_blockKeys[i - 1]))
+		{
+			continue;
+		}
+		const ndInt32 x = ndInt32(key & maskX) + m_blockOrigin[0] + D_ISO_BLOCK_KEY_BIAS;
+		const ndInt32 y = ndInt32((key >> m_blockBits[0]) & maskY) + m_blockOrigin[1] + D_ISO_BLOCK_KEY_BIAS;
+		const ndInt32 z = ndInt32(key >> (m_blockBits[0] + m_blockBits[1])) + m_blockOrigin[2] + D_ISO_BLOCK_KEY_BIAS;
+		const ndUnsigned64 blockKey = (ndUnsigned64(z) << 32) | (ndUnsigned64(y) << 16) | ndUnsigned64(x);
+
+		while ((cacheIndex < ndInt32(m_blocks.GetCount())) && (m_blocks[cacheIndex]->m_key < blockKey))
+		{
+			delete m_blocks[cacheIndex];
+			cacheIndex++;
+		}
+		if ((cacheIndex < ndInt32(m_blocks.GetCount())) && (m_blocks[cacheIndex]->m_key == blockKey))
+		{
+			m_blocksScratch.PushBack(m_blocks[cacheIndex]);
+			cacheIndex++;
+		}
+		else
+		{
+			m_blocksScratch.PushBack(new ndIsoBlock(blockKey));
+		}
+	}
+	for (; cacheIndex < ndInt32(m_blocks.GetCount()); ++cacheIndex)
+	{
+		delete m_blocks[cacheIndex];
+	}
+	m_blocks.Swap(m_blocksScratch);
+	m_blocksScratch.SetCount(0);
+
+	// gather the occupancy of each block and polygonize the ones that changed
+	ndInt32 reused[D_MAX_THREADS_COUNT];
+	auto PolygonizeBlocks = ndMakeObject::ndFunction([this, &reused](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(PolygonizeBlocks);
+		ndInt32 reusedCount = 0;
+		const ndInt32 mask = D_ISO_BLOCK_SIZE - 1;
+		const ndStartEnd startEnd(ndInt32(m_blocks.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			ndIsoBlock* const block = m_blocks[i];
+			const ndInt32 x0 = block->GetCoordinate(0) - m_blockOrigin[0];
+			const ndInt32 y0 = block->GetCoordinate(1) - m_blockOrigin[1];
+			const ndInt32 z0 = block->GetCoordinate(2) - m_blockOrigin[2];
+
+			ndUnsigned64 occupancy[D_ISO_BLOCK_WORDS];
+			for (ndInt32 j = 0; j < D_ISO_BLOCK_WORDS; ++j)
+			{
+				occupancy[j] = 0;
+			}
+			for (ndInt32 j = 0; j < 8; ++j)
+			{
+				const ndInt32 dx = j & 1;
+				const ndInt32 dy = (j >> 1) & 1;
+				const ndInt32 dz = (j >> 2) & 1;
+				if (((x0 + dx) >> m_blockBits[0]) || ((y0 + dy) >> m_blockBits[1]) || ((z0 + dz) >> m_blockBits[2]))
+				{
+					continue;
+				}
+				const ndInt32 index = FindOccupiedBlock(PackBlockKey(x0 + dx, y0 + dy, z0 + dz));
+				if (index < 0)
+				{
+					continue;
+				}
+				for (ndInt32 k = m_occupiedStart[index]; k < m_occupiedStart[index + 1]; ++k)
+				{
+					const ndInt32 local = ndInt32(m_voxelKeys[k] & ((1 << (D_ISO_BLOCK_BITS * 3)) - 1));
+					const ndInt32 x = (local & mask) + dx * D_ISO_BLOCK_SIZE;
+					const ndInt32 y = ((local >> D_ISO_BLOCK_BITS) & mask) + dy * D_ISO_BLOCK_SIZE;
+					const ndInt32 z = (local >> (D_ISO_BLOCK_BITS * 2)) + dz * D_ISO_BLOCK_SIZE;
+					if ((x < D_ISO_BLOCK_FIELD) && (y < D_ISO_BLOCK_FIELD) && (z < D_ISO_BLOCK_FIELD))
+					{
+						const ndInt32 bit = (z * D_ISO_BLOCK_FIELD + y) * D_ISO_BLOCK_FIELD + x;
+						occupancy[bit >> 6] |= ndUnsigned64(1) << (bit & 63);
+					}
+				}
+			}
+
+			bool unchanged = block->m_valid;
+			for (ndInt32 j = 0; unchanged && (j < D_ISO_BLOCK_WORDS); ++j)
+			{
+				unchanged = (occupancy[j] == block->m_occupancy[j]);
+			}
+			if (unchanged)
+			{
+				reusedCount++;
+			}
+			else
+			{
+				for (ndInt32 j = 0; j < D_ISO_BLOCK_WORDS; ++j)
+				{
+					block->m_occupancy[j] = occupancy[j];
+				}
+				PolygonizeBlock(block);
+				block->m_valid = true;
+			}
+		}
+		reused[threadIndex] = reusedCount;
+	});
+	threadPool->ParallelExecute(PolygonizeBlocks);
+
+	ndInt32 reusedCount = 0;
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		reusedCount += reused[i];
+	}
+
+	ndInt32 vertexCount = 0;
+	for (ndInt32 i = 0; i < ndInt32(m_blocks.GetCount()); ++i)
+	{
+		m_blocks[i]->m_start = vertexCount;
+		vertexCount += ndInt32(m_blocks[i]->m_triangles.GetCount());
+	}
+
+	// copy the triangles relative to the origin
+	ndArray<ndVector>& output = me->m_points;
+	output.SetCount(vertexCount);
+	auto CopyTriangles = ndMakeObject::ndFunction([this, &output, &originGrid](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CopyTriangles);
+		const ndStartEnd startEnd(ndInt32(m_blocks.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndIsoBlock* const block = m_blocks[i];
+			ndVector* const dst = &output[0] + block->m_start;
+			for (ndInt32 j = 0; j < ndInt32(block->m_triangles.GetCount()); ++j)
+			{
+				dst[j] = (block->m_triangles[j] - originGrid) * m_gridSize;
+			}
+		}
+	});
+	if (vertexCount)
+	{
+		threadPool->ParallelExecute(CopyTriangles);
+	}
+
+	me->m_blockCount = ndInt32(m_blocks.GetCount());
+	me->m_reusedBlockCount = reusedCount;
+}
+
+ndInt32 ndIsoSurface::ndImplementation::GenerateBlockIndexList(
+	const ndIsoSurface* const me, ndThreadPool* const threadPool,
+	ndInt32* const indexList, ndInt32 strideInFloats,
+	ndReal* const posit, ndReal* const normals)
+{
+	D_TRACKTIME();
+	class ndKeyByte
+	{
+		public:
+		ndKeyByte(void* const context)
+			:m_shift(*((ndInt32*)context))
+		{
+		}
+
+		ndInt32 GetKey(const ndWeldEntry& entry) const
+		{
+			return ndInt32((entry.m_key >> m_shift) & 0xff);
+		}
+
+		ndInt32 m_shift;
+	};
+
+	const ndArray<ndVector>& points = me->m_points;
+	const ndInt32 count = ndInt32(points.GetCount());
+	if (!count)
+	{
+		return 0;
+	}
+
+	// the vertices are at the middle of the lattice edges, 
+	// so twice their grid coordinates are integers
+	ndInt32 bits[3];
+	const ndInt32 sizes[3] = { me->m_volumeSizeX, me->m_volumeSizeY, me->m_volumeSizeZ };
+	ndInt32 keyBits = 0;
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		bits[i] = 1;
+		while ((1 << bits[i]) <= (sizes[i] * 2 + 2))
+		{
+			bits[i]++;
+		}
+		keyBits += bits[i];
+	}
+	ndAssert(keyBits < 64);
+
+	m_weldEntries.SetCount(count);
+	auto CalculateKeys = ndMakeObject::ndFunction([this, &points, &bits, me](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CalculateKeys);
+		const ndVector scale(ndFloat32(2.0f) / me->m_gridSize);
+		const ndStartEnd startEnd(ndInt32(points.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndVector q((points[i] * scale + ndVector::m_half).Floor().GetInt());
+			ndAssert((q.m_ix >= 0) && (q.m_iy >= 0) && (q.m_iz >= 0));
+			ndWeldEntry& entry = m_weldEntries[i];
+			entry.m_key = (((ndUnsigned64(q.m_iz) << bits[1]) | ndUnsigned64(q.m_iy)) << bits[0]) | ndUnsigned64(q.m_ix);
+			entry.m_index = i;
+			entry.m_vertex = 0;
+		}
+	});
+	threadPool->ParallelExecute(CalculateKeys);
+
+	for (ndInt32 shift = 0; shift < keyBits; shift += 8)
+	{
+		ndCountingSort<ndWeldEntry, ndKeyByte, 8>(*threadPool, m_weldEntries, m_weldEntriesScratch, nullptr, &shift);
+	}
+
+	// each run of equal keys is one vertex, the prefix sum gives the vertex index
+	ndInt32 scans[D_MAX_THREADS_COUNT + 1];
+	auto CountVertices = ndMakeObject::ndFunction([this, &scans](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CountVertices);
+		ndInt32 vertexCount = 0;
+		const ndWeldEntry* const entries = &m_weldEntries[0];
+		const ndStartEnd startEnd(ndInt32(m_weldEntries.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			vertexCount += (!i || (entries[i].m_key != entries[i - 1].m_key)) ? 1 : 0;
+		}
+		scans[threadIndex] = vertexCount;
+	});
+
+	auto AssignVertices = ndMakeObject::ndFunction([this, &scans, indexList](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(AssignVertices);
+		ndInt32 vertex = scans[threadIndex] - 1;
+		ndWeldEntry* const entries = &m_weldEntries[0];
+		const ndStartEnd startEnd(ndInt32(m_weldEntries.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			if (!i || (entries[i].m_key != entries[i - 1].m_key))
+			{
+				vertex++;
+				m_weldRuns[vertex] = i;
+			}
+			entries[i].m_vertex = vertex;
+			indexList[entries[i].m_index] = vertex;
+		}
+	});
+
+	const ndInt32 threadCount = threadPool->GetThreadCount();
+	threadPool->ParallelExecute(CountVertices);
+	ndInt32 vertexCount = 0;
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		const ndInt32 vertices = scans[i];
+		scans[i] = vertexCount;
+		vertexCount += vertices;
+	}
+	m_weldRuns.SetCount(vertexCount + 1);
+	threadPool->ParallelExecute(AssignVertices);
+	m_weldRuns[vertexCount] = count;
+
+	// area weighted vertex normals, each vertex adds the faces of its run
+	m_faceNormals.SetCount(count / 3);
+	auto CalculateFaceNormals = ndMakeObject::ndFunction([this, &points](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CalculateFaceNormals);
+		const ndStartEnd startEnd(ndInt32(m_faceNormals.GetCount()), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndVector p0(points[i * 3 + 0] & ndVector::m_triplexMask);
+			const ndVector p1(points[i * 3 + 1] & ndVector::m_triplexMask);
+			const ndVector p2(points[i * 3 + 2] & ndVector::m_triplexMask);
+			m_faceNormals[i] = (p1 - p0).CrossProduct(p2 - p0);
+		}
+	});
+
+	auto CalculateVertices = ndMakeObject::ndFunction([this, &points, posit, normals, strideInFloats](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(CalculateVertices);
+		const ndWeldEntry* const entries = &m_weldEntries[0];
+		const ndStartEnd startEnd(ndInt32(m_weldRuns.GetCount()) - 1, threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			ndVector normal(ndVector::m_zero);
+			for (ndInt32 j = m_weldRuns[i]; j < m_weldRuns[i + 1]; ++j)
+			{
+				normal += m_faceNormals[entries[j].m_index / 3];
+			}
+			normal = normal * normal.InvMagSqrt();
+
+			const ndVector& point = points[entries[m_weldRuns[i]].m_index];
+			const ndInt32 k = strideInFloats * i;
+			posit[k + 0] = ndReal(point.m_x);
+			posit[k + 1] = ndReal(point.m_y);
+			posit[k + 2] = ndReal(point.m_z);
+			normals[k + 0] = ndReal(normal.m_x);
+			normals[k + 1] = ndReal(normal.m_y);
+			normals[k + 2] = ndReal(normal.m_z);
+		}
+	});
+
+	threadPool->ParallelExecute(CalculateFaceNormals);
+	threadPool->ParallelExecute(CalculateVertices);
+	return vertexCount;
+}
+
 ndIsoSurface::ndIsoSurface()
 	:m_origin(ndVector::m_zero)
 	,m_points(1024)
@@ -3389,6 +4077,8 @@ ndIsoSurface::ndIsoSurface()
 	,m_volumeSizeX(1)
 	,m_volumeSizeY(1)
 	,m_volumeSizeZ(1)
+	,m_blockCount(0)
+	,m_reusedBlockCount(0)
 	,m_isLowRes(true)
 {
 }
@@ -3437,4 +4127,28 @@ ndInt32 ndIsoSurface::GenerateListIndexList(ndInt32* const indexList, ndInt32 st
 		ndAssert(0);
 	}
 	return vertexCount;
-}
\ No newline at end of file
+}
+
+void ndIsoSurface::GenerateMesh(ndThreadPool* const threadPool, const ndArray<ndVector>& pointCloud, ndFloat32 gridSize)
+{
+	if (pointCloud.GetCount())
+	{
+		m_isLowRes = true;
+		threadPool->Begin();
+		m_implementation->BuildBlockMesh(this, threadPool, pointCloud, gridSize);
+		threadPool->End();
+		m_gridSize = gridSize;
+		m_origin = m_implementation->GetOrigin();
+		m_volumeSizeX = m_implementation->m_volumeSizeX;
+		m_volumeSizeY = m_implementation->m_volumeSizeY;
+		m_volumeSizeZ = m_implementation->m_volumeSizeZ;
+	}
+}
+
+ndInt32 ndIsoSurface::GenerateListIndexList(ndThreadPool* const threadPool, ndInt32* const indexList, ndInt32 strideInFloats, ndReal* const posit, ndReal* const normals) const
+{
+	threadPool->Begin();
+	const ndInt32 vertexCount = m_implementation->GenerateBlockIndexList(this, threadPool, indexList, strideInFloats, posit, normals);
+	threadPool->End();
+	return vertexCount;
+}
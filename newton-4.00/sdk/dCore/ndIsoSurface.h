@@ -27,6 +27,8 @@
 #include "ndArray.h"
 #include "ndTree.h"
 
+class ndThreadPool;
+
 class ndIsoSurface: public ndClassAlloc
 {
 	public:
@@ -55,6 +57,16 @@ class ndIsoSurface: public ndClassAlloc
 	D_CORE_API void GenerateMesh(const ndArray<ndVector>& pointCloud, ndFloat32 gridSize, ndCalculateIsoValue* const computeIsoValue = nullptr);
 	D_CORE_API ndInt32 GenerateListIndexList(ndInt32 * const indexList, ndInt32 strideInFloat32, ndReal* const posit, ndReal* const normals) const;
 
+	// parallel pipeline: the cells are binned in sparse blocks that are polygonized
+	// independently, blocks with the same occupancy as in the previous call
+	// reuse their triangles. the pool must be idle, the call wakes its workers.
+	D_CORE_API void GenerateMesh(ndThreadPool* const threadPool, const ndArray<ndVector>& pointCloud, ndFloat32 gridSize);
+	// weld the vertices with a parallel sort and prefix sums
+	D_CORE_API ndInt32 GenerateListIndexList(ndThreadPool* const threadPool, ndInt32* const indexList, ndInt32 strideInFloat32, ndReal* const posit, ndReal* const normals) const;
+
+	ndInt32 GetBlockCount() const;
+	ndInt32 GetReusedBlockCount() const;
+
 	private:
 	ndVector m_origin;
 	ndArray<ndVector> m_points;
@@ -63,6 +75,8 @@ class ndIsoSurface: public ndClassAlloc
 	ndInt32 m_volumeSizeX;
 	ndInt32 m_volumeSizeY;
 	ndInt32 m_volumeSizeZ;
+	ndInt32 m_blockCount;
+	ndInt32 m_reusedBlockCount;
 	bool m_isLowRes;
 };
 
@@ -76,5 +90,15 @@ inline ndVector ndIsoSurface::GetOrigin() const
 	return m_origin;
 }
 
+inline ndInt32 ndIsoSurface::GetBlockCount() const
+{
+	return m_blockCount;
+}
+
+inline ndInt32 ndIsoSurface::GetReusedBlockCount() const
+{
+	return m_reusedBlockCount;
+}
+
 #endif
 
@@ -36,7 +36,7 @@ class ndPolygonSoupDatabase: public ndClassAlloc
 	D_CORE_API ndFloat32* GetLocalVertexPool() const;
 
 	D_CORE_API ndUnsigned32 GetTagId(const ndInt32* const face, ndInt32 indexCount) const;
-	D_CORE_API void SetTagId(const ndInt32* const face, ndInt32 indexCount, ndUnsigned32 newID) const;
+	D_CORE_API virtual void SetTagId(const ndInt32* const face, ndInt32 indexCount, ndUnsigned32 newID) const;
 		
 	protected:
 	D_CORE_API ndPolygonSoupDatabase(const char* const name = nullptr);
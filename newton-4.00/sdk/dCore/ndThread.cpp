@@ -37,7 +37,16 @@ ndThread::ndThread()
 #ifndef D_USE_THREAD_EMULATION
 	,ndAtomic<bool>(true)
 	,std::condition_variable()
-	,std::thread(&ndThread::ThreadFunctionCallback, this)
+	// the thread can start before the vtable is set, so it must not make
+	// the virtual call until the constructor was fully initialized.
+	,std::thread([this]()
+	{
+		while (load())
+		{
+			ndThreadYield();
+		}
+		ThreadFunctionCallback();
+	})
 #endif
 {
 	strcpy (m_name.m_name, "newtonWorker");
@@ -36,6 +36,14 @@ ndThreadBackgroundWorker::ndThreadBackgroundWorker()
 	,m_queueSemaphore()
 {
 	Signal();
+	#ifndef D_USE_THREAD_EMULATION
+	// the loop must be running before any task is queued, otherwise a
+	// worker terminated right away would quit without draining the queue.
+	while (!m_inLoop)
+	{
+		ndThreadYield();
+	}
+	#endif
 }
 
 ndThreadBackgroundWorker::~ndThreadBackgroundWorker()
@@ -83,22 +91,41 @@ void ndThreadBackgroundWorker::SendTask(ndBackgroundTask* const task)
 	#endif
 }
 
+ndBackgroundTask* ndThreadBackgroundWorker::PopTask()
+{
+	ndScopeSpinLock lock(m_lock);
+	ndNode* const node = GetFirst();
+	ndBackgroundTask* const task = node ? node->GetInfo() : nullptr;
+	if (node)
+	{
+		Remove(node);
+	}
+	return task;
+}
+
+void ndThreadBackgroundWorker::ExecuteTask(ndBackgroundTask* const task)
+{
+	Begin();
+	task->Execute(this);
+	End();
+	task->m_taskState.store(ndBackgroundTask::m_taskCompleted);
+}
+
 void ndThreadBackgroundWorker::ThreadFunction()
 {
 	m_inLoop.store(true);
 	while (!m_queueSemaphore.Wait() && !m_teminate)
 	{
-		ndBackgroundTask* task;
-		{
-			ndScopeSpinLock lock(m_lock);
-			ndNode* const node = GetFirst();
-			task = node->GetInfo();
-			Remove(node);
-		}
-		Begin();
-		task->Execute(this);
-		End();
-		task->m_taskState.store(ndBackgroundTask::m_taskCompleted);
+		ndBackgroundTask* const task = PopTask();
+		ndAssert(task);
+		ExecuteTask(task);
+	}
+
+	// the owners of the queued tasks may be waiting on them in Sync,
+	// so the queue is drained before the worker quits.
+	for (ndBackgroundTask* task = PopTask(); task; task = PopTask())
+	{
+		ExecuteTask(task);
 	}
 	m_inLoop.store(false);
-}
\ No newline at end of file
+}
@@ -69,11 +69,14 @@ class ndThreadBackgroundWorker: public ndThreadPool, public ndList<ndBackgroundT
 	D_CORE_API ndThreadBackgroundWorker();
 	D_CORE_API ~ndThreadBackgroundWorker();
 
+	/// stops the worker after running the tasks still in the queue.
 	D_CORE_API void Terminate();
 	D_CORE_API void SendTask(ndBackgroundTask* const job);
 	
 	private:
 	virtual void ThreadFunction();
+	ndBackgroundTask* PopTask();
+	void ExecuteTask(ndBackgroundTask* const task);
 
 	ndSpinLock m_lock;
 	ndAtomic<bool> m_inLoop;
@@ -220,6 +220,13 @@ typedef double ndFloat64;
 #else
 	typedef float ndFloat32;
 #endif
+
+// mixed precision keeps jacobians and solver rows in single precision, 
+// but body positions and force accumulators use compensated summation.
+// it is meaningless in a double precision build, so it is ignored there.
+#if defined (D_NEWTON_USE_MIXED_PRECISION) && defined (D_NEWTON_USE_DOUBLE)
+	#undef D_NEWTON_USE_MIXED_PRECISION
+#endif
 	
 #define ndPi	 		ndFloat32 (3.141592f)
 //#define ndEXP		 	ndFloat32 (2.7182818f)
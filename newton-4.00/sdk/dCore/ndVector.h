@@ -40,4 +40,33 @@
 	#include "ndVectorScalar.h"
 #endif
 
+/// Add value to sum using Kahan compensated summation.
+/// \param sum: running sum
+/// \param error: running compensation term, must start at zero
+/// \param value: value to accumulate
+/// in mixed precision mode the low order bits lost by each addition are 
+/// carried in error and fed back on the next call, otherwise is a plain sum. 
+#ifdef D_NEWTON_USE_MIXED_PRECISION
+// the compensation is algebraically zero, so fast math modes like 
+// msvc /fp:fast are allowed to remove it, force precise semantics here.
+#ifdef _MSC_VER
+	#pragma float_control(precise, on, push)
+#endif
+inline void ndKahanAdd(ndVector& sum, ndVector& error, const ndVector& value)
+{
+	const ndVector y(value - error);
+	const ndVector t(sum + y);
+	error = (t - sum) - y;
+	sum = t;
+}
+#ifdef _MSC_VER
+	#pragma float_control(pop)
+#endif
+#else
+inline void ndKahanAdd(ndVector& sum, ndVector&, const ndVector& value)
+{
+	sum += value;
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,247 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "ndModelStdafx.h"
+#include "ndAnimationPose.h"
+#include "ndAnimationBakedSequence.h"
+
+#define D_BAKED_ROTATION_SCALE	ndFloat32 (32767.0f)
+
+ndAnimationBakedSequence::ndAnimationBakedSequence(const ndAnimationSequence& source, ndFloat32 framesPerSecond)
+	:ndAnimationSequence()
+	,m_keys()
+	,m_positOrigin()
+	,m_positScale()
+	,m_hasPosition()
+	,m_hasRotation()
+	,m_framesPerSecond(ndMax(framesPerSecond, ndFloat32(1.0f)))
+	,m_boneCount(0)
+	,m_boneStride(0)
+	,m_frameCount(0)
+{
+	Bake(source);
+}
+
+ndAnimationBakedSequence::~ndAnimationBakedSequence()
+{
+}
+
+ndInt32 ndAnimationBakedSequence::GetBoneCount() const
+{
+	return m_boneCount;
+}
+
+ndInt32 ndAnimationBakedSequence::GetFrameCount() const
+{
+	return m_frameCount;
+}
+
+ndFloat32 ndAnimationBakedSequence::GetFramesPerSecond() const
+{
+	return m_framesPerSecond;
+}
+
+void ndAnimationBakedSequence::Bake(const ndAnimationSequence& source)
+{
+	m_name = source.GetName();
+	m_duration = source.GetDuration();
+
+	// the root translation track is only sampled by the player, keep it as it is.
+	const ndAnimationKeyFramesTrack& translationTrack = source.GetTranslationTrack();
+	m_translationTrack.SetName(translationTrack.GetName());
+	for (ndInt32 i = 0; i < ndInt32(translationTrack.m_position.GetCount()); ++i)
+	{
+		m_translationTrack.m_position.PushBack(translationTrack.m_position[i]);
+		m_translationTrack.m_position.m_time.PushBack(translationTrack.m_position.m_time[i]);
+	}
+	for (ndInt32 i = 0; i < ndInt32(translationTrack.m_rotation.GetCount()); ++i)
+	{
+		m_translationTrack.m_rotation.PushBack(translationTrack.m_rotation[i]);
+		m_translationTrack.m_rotation.m_time.PushBack(translationTrack.m_rotation.m_time[i]);
+	}
+
+	const ndList<ndAnimationKeyFramesTrack>& tracks = source.GetTracks();
+	m_boneCount = ndInt32(tracks.GetCount());
+	m_boneStride = (m_boneCount + 3) & -4;
+	// round the rate up so that a whole number of intervals spans the
+	// duration, the last frame is then sampled at exactly m_duration.
+	const ndInt32 intervals = ndMax(ndInt32(ndCeil(m_duration * m_framesPerSecond - ndFloat32(1.0e-3f))), 1);
+	m_frameCount = intervals + 1;
+	if (m_duration > ndFloat32(0.0f))
+	{
+		m_framesPerSecond = ndFloat32(intervals) / m_duration;
+	}
+	if (!m_boneCount)
+	{
+		return;
+	}
+
+	// the track list only keeps the bone names, in the source order.
+	m_hasPosition.SetCount(m_boneStride);
+	m_hasRotation.SetCount(m_boneStride);
+	const ndAnimationKeyFramesTrack** const trackArray = ndAlloca(const ndAnimationKeyFramesTrack*, m_boneStride);
+	ndInt32 bone = 0;
+	for (ndList<ndAnimationKeyFramesTrack>::ndNode* node = tracks.GetFirst(); node; node = node->GetNext())
+	{
+		const ndAnimationKeyFramesTrack& track = node->GetInfo();
+		AddTrack()->SetName(track.GetName());
+		trackArray[bone] = &track;
+		m_hasPosition[bone] = track.m_position.GetCount() ? 1 : 0;
+		m_hasRotation[bone] = track.m_rotation.GetCount() ? 1 : 0;
+		bone++;
+	}
+	for (ndInt32 i = m_boneCount; i < m_boneStride; ++i)
+	{
+		m_hasPosition[i] = 0;
+		m_hasRotation[i] = 0;
+	}
+
+	// resample all tracks at the uniform rate
+	ndArray<ndVector> positions;
+	ndArray<ndQuaternion> rotations;
+	positions.SetCount(m_frameCount * m_boneStride);
+	rotations.SetCount(m_frameCount * m_boneStride);
+	for (ndInt32 frame = 0; frame < m_frameCount; ++frame)
+	{
+		const ndFloat32 time = (frame == intervals) ? m_duration : ndFloat32(frame) / m_framesPerSecond;
+		for (ndInt32 i = 0; i < m_boneStride; ++i)
+		{
+			ndVector& posit = positions[frame * m_boneStride + i];
+			ndQuaternion& rotation = rotations[frame * m_boneStride + i];
+			posit = ndVector::m_wOne;
+			rotation = ndQuaternion();
+			if (i < m_boneCount)
+			{
+				trackArray[i]->InterpolatePosition(time, posit);
+				trackArray[i]->InterpolateRotation(time, rotation);
+				if (frame)
+				{
+					// keep consecutive keys in the same hemisphere, so that nlerp takes the short path
+					const ndQuaternion& prevRotation = rotations[(frame - 1) * m_boneStride + i];
+					if (rotation.DotProduct(prevRotation).GetScalar() < ndFloat32(0.0f))
+					{
+						rotation = rotation.Scale(ndFloat32(-1.0f));
+					}
+				}
+			}
+		}
+	}
+
+	// calculate the quantization range of each position channel
+	m_positOrigin.SetCount(3 * m_boneStride);
+	m_positScale.SetCount(3 * m_boneStride);
+	for (ndInt32 i = 0; i < m_boneStride; ++i)
+	{
+		ndVector minBox(ndFloat32(1.0e10f));
+		ndVector maxBox(ndFloat32(-1.0e10f));
+		for (ndInt32 frame = 0; frame < m_frameCount; ++frame)
+		{
+			const ndVector& posit = positions[frame * m_boneStride + i];
+			minBox = minBox.GetMin(posit);
+			maxBox = maxBox.GetMax(posit);
+		}
+		for (ndInt32 j = 0; j < 3; ++j)
+		{
+			const ndFloat32 scale = (maxBox[j] - minBox[j]) / ndFloat32(65535.0f);
+			m_positScale[j * m_boneStride + i] = scale;
+			m_positOrigin[j * m_boneStride + i] = minBox[j] + ndFloat32(32768.0f) * scale;
+		}
+	}
+
+	// quantize the keys, one struct of arrays block per frame
+	m_keys.SetCount(m_frameCount * m_channelCount * m_boneStride);
+	for (ndInt32 frame = 0; frame < m_frameCount; ++frame)
+	{
+		ndInt16* const keys = &m_keys[frame * m_channelCount * m_boneStride];
+		for (ndInt32 i = 0; i < m_boneStride; ++i)
+		{
+			const ndVector& posit = positions[frame * m_boneStride + i];
+			const ndQuaternion& rotation = rotations[frame * m_boneStride + i];
+			for (ndInt32 j = 0; j < 3; ++j)
+			{
+				const ndFloat32 scale = m_positScale[j * m_boneStride + i];
+				const ndFloat32 origin = m_positOrigin[j * m_boneStride + i];
+				const ndFloat32 value = (scale > ndFloat32(0.0f)) ? (posit[j] - origin) / scale : ndFloat32(0.0f);
+				keys[(m_positX + j) * m_boneStride + i] = ndInt16(ndClamp(ndFloor(value + ndFloat32(0.5f)), ndFloat32(-32768.0f), ndFloat32(32767.0f)));
+			}
+			for (ndInt32 j = 0; j < 4; ++j)
+			{
+				const ndFloat32 value = rotation[j] * D_BAKED_ROTATION_SCALE;
+				keys[(m_rotationX + j) * m_boneStride + i] = ndInt16(ndClamp(ndFloor(value + ndFloat32(0.5f)), -D_BAKED_ROTATION_SCALE, D_BAKED_ROTATION_SCALE));
+			}
+		}
+	}
+}
+
+inline ndVector ndAnimationBakedSequence::LoadKeys(const ndInt16* const keys) const
+{
+	return ndVector(ndFloat32(keys[0]), ndFloat32(keys[1]), ndFloat32(keys[2]), ndFloat32(keys[3]));
+}
+
+void ndAnimationBakedSequence::CalculatePose(ndAnimationPose& output, ndFloat32 param) const
+{
+	const ndInt32 count = ndMin(ndInt32(output.GetCount()), m_boneCount);
+	if (!count)
+	{
+		return;
+	}
+
+	const ndFloat32 frameParam = ndClamp(param, ndFloat32(0.0f), m_duration) * m_framesPerSecond;
+	const ndInt32 frame0 = ndMin(ndInt32(frameParam), m_frameCount - 1);
+	const ndInt32 frame1 = ndMin(frame0 + 1, m_frameCount - 1);
+	const ndVector t(ndClamp(frameParam - ndFloat32(frame0), ndFloat32(0.0f), ndFloat32(1.0f)));
+	const ndVector rotationScale(ndFloat32(1.0f) / D_BAKED_ROTATION_SCALE);
+
+	const ndInt32 stride = m_boneStride;
+	const ndInt16* const keys0 = &m_keys[frame0 * m_channelCount * stride];
+	const ndInt16* const keys1 = &m_keys[frame1 * m_channelCount * stride];
+	ndAnimKeyframe* const keyFrames = &output[0];
+
+	for (ndInt32 base = 0; base < count; base += 4)
+	{
+		ndVector channels[m_channelCount];
+		for (ndInt32 j = m_positX; j <= m_positZ; ++j)
+		{
+			const ndVector q0(LoadKeys(&keys0[j * stride + base]));
+			const ndVector q1(LoadKeys(&keys1[j * stride + base]));
+			const ndVector origin(&m_positOrigin[j * stride + base]);
+			const ndVector scale(&m_positScale[j * stride + base]);
+			channels[j] = origin + scale * (q0 + (q1 - q0) * t);
+		}
+
+		for (ndInt32 j = m_rotationX; j <= m_rotationW; ++j)
+		{
+			const ndVector q0(LoadKeys(&keys0[j * stride + base]));
+			const ndVector q1(LoadKeys(&keys1[j * stride + base]));
+			channels[j] = (q0 + (q1 - q0) * t) * rotationScale;
+		}
+		const ndVector mag2(channels[m_rotationX] * channels[m_rotationX] + channels[m_rotationY] * channels[m_rotationY] + channels[m_rotationZ] * channels[m_rotationZ] + channels[m_rotationW] * channels[m_rotationW]);
+		const ndVector invMag(mag2.GetMax(ndVector(ndFloat32(1.0e-12f))).InvSqrt());
+		for (ndInt32 j = m_rotationX; j <= m_rotationW; ++j)
+		{
+			channels[j] = channels[j] * invMag;
+		}
+
+		const ndInt32 lanes = ndMin(count - base, 4);
+		for (ndInt32 i = 0; i < lanes; ++i)
+		{
+			ndAnimKeyframe& keyFrame = keyFrames[base + i];
+			if (m_hasPosition[base + i])
+			{
+				keyFrame.m_posit = ndVector(channels[m_positX][i], channels[m_positY][i], channels[m_positZ][i], ndFloat32(1.0f));
+			}
+			if (m_hasRotation[base + i])
+			{
+				keyFrame.m_rotation = ndQuaternion(ndVector(channels[m_rotationX][i], channels[m_rotationY][i], channels[m_rotationZ][i], channels[m_rotationW][i]));
+			}
+		}
+	}
+}
@@ -0,0 +1,64 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#ifndef __ND_ANIMIMATION_BAKED_SEQUENCE_h__
+#define __ND_ANIMIMATION_BAKED_SEQUENCE_h__
+
+#include "ndAnimationSequence.h"
+
+// animation sequence resampled at a uniform frame rate.
+// the requested rate is rounded up so that the last frame falls exactly
+// on the sequence duration, GetFramesPerSecond returns the rate in use.
+// each frame stores the keys of all bones in one block of 16 bit quantized
+// values, laid out as struct of arrays (all x, then all y, ...), so sampling
+// a pose is a linear pass over two frame blocks, four bones at a time,
+// with no per track key search.
+// rotations are interpolated with normalized lerp.
+class ndAnimationBakedSequence : public ndAnimationSequence
+{
+	public:
+	ndAnimationBakedSequence(const ndAnimationSequence& source, ndFloat32 framesPerSecond);
+	virtual ~ndAnimationBakedSequence();
+
+	ndInt32 GetBoneCount() const;
+	ndInt32 GetFrameCount() const;
+	ndFloat32 GetFramesPerSecond() const;
+
+	virtual void CalculatePose(ndAnimationPose& output, ndFloat32 param) const;
+
+	private:
+	enum ndChannel
+	{
+		m_positX,
+		m_positY,
+		m_positZ,
+		m_rotationX,
+		m_rotationY,
+		m_rotationZ,
+		m_rotationW,
+		m_channelCount,
+	};
+
+	void Bake(const ndAnimationSequence& source);
+	ndVector LoadKeys(const ndInt16* const keys) const;
+
+	ndArray<ndInt16> m_keys;
+	ndArray<ndFloat32> m_positOrigin;
+	ndArray<ndFloat32> m_positScale;
+	ndArray<ndUnsigned8> m_hasPosition;
+	ndArray<ndUnsigned8> m_hasRotation;
+	ndFloat32 m_framesPerSecond;
+	ndInt32 m_boneCount;
+	ndInt32 m_boneStride;
+	ndInt32 m_frameCount;
+};
+
+#endif
@@ -46,11 +46,21 @@ ndAnimationKeyFramesTrack& ndAnimationSequence::GetTranslationTrack()
 	return m_translationTrack;
 }
 
+const ndAnimationKeyFramesTrack& ndAnimationSequence::GetTranslationTrack() const
+{
+	return m_translationTrack;
+}
+
 ndList<ndAnimationKeyFramesTrack>& ndAnimationSequence::GetTracks()
 {
 	return m_tracks;
 }
 
+const ndList<ndAnimationKeyFramesTrack>& ndAnimationSequence::GetTracks() const
+{
+	return m_tracks;
+}
+
 ndAnimationKeyFramesTrack* ndAnimationSequence::AddTrack()
 {
 	ndList<ndAnimationKeyFramesTrack>::ndNode* const node = m_tracks.Append();
@@ -28,7 +28,9 @@ class ndAnimationSequence : public ndContainersFreeListAlloc<ndAnimationSequence
 
 	ndAnimationKeyFramesTrack* AddTrack();
 	ndList<ndAnimationKeyFramesTrack>& GetTracks();
+	const ndList<ndAnimationKeyFramesTrack>& GetTracks() const;
 	ndAnimationKeyFramesTrack& GetTranslationTrack();
+	const ndAnimationKeyFramesTrack& GetTranslationTrack() const;
 
 	virtual ndVector GetTranslation(ndFloat32 param) const;
 	virtual void CalculatePose(ndAnimationPose& output, ndFloat32 param) const;
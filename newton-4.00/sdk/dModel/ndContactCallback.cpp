@@ -30,6 +30,11 @@ ndApplicationMaterial& ndContactCallback::RegisterMaterial(const ndApplicationMa
 	{
 		ndApplicationMaterial* const materialCopy = material.Clone();
 		node = m_materialGraph.Insert(materialCopy, key);
+		if ((id0 < D_MAX_DENSE_MATERIAL_ID) && (id1 < D_MAX_DENSE_MATERIAL_ID))
+		{
+			// small ids are also resolved by the engine table, without the tree search
+			m_materialPairTable.SetMaterial(ndInt32(id0), ndInt32(id1), materialCopy);
+		}
 	}
 	return *node->GetInfo();
 }
@@ -10,6 +10,8 @@
 */
 #ifndef __ND_CONTACT_CALLBACK_H__
 #define __ND_CONTACT_CALLBACK_H__
+
+#define D_MAX_DENSE_MATERIAL_ID	256
 		  
 class ndApplicationMaterial : public ndMaterial
 {
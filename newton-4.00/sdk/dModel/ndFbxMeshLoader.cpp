@@ -12,6 +12,7 @@
 #include "ndModelStdafx.h"
 #include "ndFbxMeshLoader.h"
 #include "ndAnimationSequence.h"
+#include "ndAnimationBakedSequence.h"
 
 using namespace ofbx;
 
@@ -1102,4 +1103,10 @@ ndAnimationSequence* ndFbxMeshLoader::LoadAnimation(const char* const fullPathNa
 	ndSharedPtr<ndMesh> mesh(LoadMesh(fullPathName, true));
 	ndAnimationSequence* const sequence = CreateSequence(*mesh, fullPathName);
 	return sequence;
-}
\ No newline at end of file
+}
+
+ndAnimationBakedSequence* ndFbxMeshLoader::LoadBakedAnimation(const char* const fullPathName, ndFloat32 framesPerSecond)
+{
+	ndSharedPtr<ndAnimationSequence> sequence(LoadAnimation(fullPathName));
+	return new ndAnimationBakedSequence(**sequence, framesPerSecond);
+}
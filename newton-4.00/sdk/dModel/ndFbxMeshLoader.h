@@ -14,6 +14,7 @@
 
 #include "ndMesh.h"
 class ndAnimationSequence;
+class ndAnimationBakedSequence;
 
 using namespace ofbx;
 
@@ -28,6 +29,7 @@ class ndFbxMeshLoader : public ndClassAlloc
 	virtual ~ndFbxMeshLoader();
 
 	virtual ndAnimationSequence* LoadAnimation(const char* const fullPathName);
+	virtual ndAnimationBakedSequence* LoadBakedAnimation(const char* const fullPathName, ndFloat32 framesPerSecond);
 	virtual ndMesh* LoadMesh(const char* const fullPathName, bool loadAnimation);
 
 	private:
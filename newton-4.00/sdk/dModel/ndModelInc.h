@@ -30,6 +30,7 @@
 #include <ndContactCallback.h>
 #include <ndModelBodyNotify.h>
 #include <ndAnimationSequence.h>
+#include <ndAnimationBakedSequence.h>
 #include <ndModelPassiveRagdoll.h>
 #include <ndAnimationTwoWayBlend.h>
 #include <ndAnimationBlendTreeNode.h>
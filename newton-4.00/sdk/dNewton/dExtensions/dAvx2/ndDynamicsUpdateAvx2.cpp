@@ -727,8 +727,9 @@ void ndDynamicsUpdateAvx2::SortJoints()
 	});
 	scene->ParallelExecute(SetRowStarts);
 
-	m_leftHandSide.SetCount(rowsCount);
-	m_rightHandSide.SetCount(rowsCount);
+	ndFrameArena& arena = m_world->GetFrameArena();
+	arena.Bind(m_leftHandSide, rowsCount);
+	arena.Bind(m_rightHandSide, rowsCount);
 	m_avxMassMatrixArray->SetCount(soaJointRowCount);
 
 	#ifdef _DEBUG
@@ -762,7 +763,7 @@ void ndDynamicsUpdateAvx2::SortIslands()
 	const ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
 	ndArray<ndBodyKinematic*>& activeBodyArray = GetBodyIslandOrder();
 	GetInternalForces().SetCount(bodyArray.GetCount());
-	activeBodyArray.SetCount(bodyArray.GetCount());
+	m_world->GetFrameArena().Bind(activeBodyArray, bodyArray.GetCount());
 
 	ndInt32 histogram[D_MAX_THREADS_COUNT][3];
 	auto Scan0 = ndMakeObject::ndFunction([&bodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
@@ -1236,6 +1237,8 @@ void ndDynamicsUpdateAvx2::InitJacobianMatrix()
 			{
 				ndVector force(zero);
 				ndVector torque(zero);
+				ndVector forceError(zero);
+				ndVector torqueError(zero);
 
 				const ndInt32 m = i + j;
 				const ndInt32 index = bodyIndex[m];
@@ -1250,8 +1253,8 @@ void ndDynamicsUpdateAvx2::InitJacobianMatrix()
 				for (ndInt32 k = 0; k < count; ++k)
 				{
 					const ndInt32 jointIndex = jointBodyPairIndexBuffer[index + k].m_joint;
-					force += jointInternalForces[jointIndex].m_linear;
-					torque += jointInternalForces[jointIndex].m_angular;
+					ndKahanAdd(force, forceError, jointInternalForces[jointIndex].m_linear);
+					ndKahanAdd(torque, torqueError, jointInternalForces[jointIndex].m_angular);
 				}
 				internalForces[m].m_linear = force;
 				internalForces[m].m_angular = torque;
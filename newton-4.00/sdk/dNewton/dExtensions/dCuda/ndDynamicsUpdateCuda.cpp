@@ -409,8 +409,9 @@ void ndDynamicsUpdateCuda::SortJoints()
 		rowCount += joint->m_rowCount;
 	}
 
-	m_leftHandSide.SetCount(rowCount);
-	m_rightHandSide.SetCount(rowCount);
+	ndFrameArena& arena = m_world->GetFrameArena();
+	arena.Bind(m_leftHandSide, rowCount);
+	arena.Bind(m_rightHandSide, rowCount);
 
 #ifdef _DEBUG
 	ndAssert(m_activeJointCount <= jointArray.GetCount());
@@ -454,7 +455,7 @@ void ndDynamicsUpdateCuda::SortIslands()
 	const ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
 	ndArray<ndBodyKinematic*>& activeBodyArray = GetBodyIslandOrder();
 	GetInternalForces().SetCount(bodyArray.GetCount());
-	activeBodyArray.SetCount(bodyArray.GetCount());
+	m_world->GetFrameArena().Bind(activeBodyArray, bodyArray.GetCount());
 
 	ndInt32 histogram[D_MAX_THREADS_COUNT][3];
 	auto Scan0 = ndMakeObject::ndFunction([this, &bodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
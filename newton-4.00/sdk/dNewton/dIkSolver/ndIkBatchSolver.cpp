@@ -0,0 +1,177 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndIkSolver.h"
+#include "ndIkBatchSolver.h"
+#include "ndSkeletonContainer.h"
+#include "ndJointBilateralConstraint.h"
+
+ndIkBatchSolver::ndIkBatchSolver()
+	:ndClassAlloc()
+	,m_requests(256)
+	,m_maxAccel(ndFloat32(1.0e3f))
+	,m_maxAlpha(ndFloat32(1.0e4f))
+{
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		m_solvers[i] = nullptr;
+	}
+}
+
+ndIkBatchSolver::~ndIkBatchSolver()
+{
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		if (m_solvers[i])
+		{
+			delete m_solvers[i];
+		}
+	}
+}
+
+void ndIkBatchSolver::SetMaxAccel(ndFloat32 maxAccel, ndFloat32 maxAlpha)
+{
+	m_maxAlpha = ndAbs(maxAlpha);
+	m_maxAccel = ndAbs(maxAccel);
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		if (m_solvers[i])
+		{
+			m_solvers[i]->SetMaxAccel(m_maxAccel, m_maxAlpha);
+		}
+	}
+}
+
+void ndIkBatchSolver::Clear()
+{
+	m_requests.SetCount(0);
+}
+
+ndInt32 ndIkBatchSolver::GetCount() const
+{
+	return ndInt32(m_requests.GetCount());
+}
+
+ndUnsigned64 ndIkBatchSolver::CalculateTopologyKey(const ndSkeletonContainer* const skeleton, ndJointBilateralConstraint* const* effectors, ndInt32 effectorCount) const
+{
+	ndUnsigned64 rowCount = 0;
+	ndUnsigned64 nodeCount = 0;
+	const ndSkeletonContainer::ndNodeList& nodeList = skeleton->GetNodeList();
+	for (ndSkeletonContainer::ndNodeList::ndNode* node = nodeList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndJointBilateralConstraint* const joint = node->GetInfo().m_joint;
+		if (joint)
+		{
+			rowCount += joint->GetRowsCount();
+		}
+		nodeCount++;
+	}
+
+	ndUnsigned64 effectorRows = 0;
+	for (ndInt32 i = 0; i < effectorCount; ++i)
+	{
+		effectorRows += effectors[i]->GetRowsCount();
+	}
+
+	// rigs with the same key build mass matrices of the same size and layout
+	return (ndMin(nodeCount, ndUnsigned64(0xffff)) << 48) + (ndMin(rowCount, ndUnsigned64(0xffff)) << 32) + (ndMin(ndUnsigned64(effectorCount), ndUnsigned64(0xffff)) << 16) + ndMin(effectorRows, ndUnsigned64(0xffff));
+}
+
+void ndIkBatchSolver::AddRequest(ndSkeletonContainer* const skeleton, ndJointBilateralConstraint* const* effectors, ndInt32 effectorCount)
+{
+	ndAssert(skeleton);
+	ndAssert(effectorCount >= 0);
+
+	ndRequest request;
+	request.m_skeleton = skeleton;
+	request.m_effectors = effectors;
+	request.m_effectorCount = effectorCount;
+	request.m_topologyKey = CalculateTopologyKey(skeleton, effectors, effectorCount);
+	m_requests.PushBack(request);
+}
+
+void ndIkBatchSolver::Solve(ndWorld* const world, ndFloat32 timestep)
+{
+	D_TRACKTIME();
+	class ndCompareTopology
+	{
+		public:
+		ndCompareTopology(void*)
+		{
+		}
+
+		ndInt32 Compare(const ndRequest& requestA, const ndRequest& requestB) const
+		{
+			if (requestA.m_topologyKey < requestB.m_topologyKey)
+			{
+				return -1;
+			}
+			else if (requestA.m_topologyKey > requestB.m_topologyKey)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	const ndInt32 count = ndInt32(m_requests.GetCount());
+	if (!count)
+	{
+		return;
+	}
+
+	world->Sync();
+	ndSort<ndRequest, ndCompareTopology>(&m_requests[0], count, nullptr);
+
+	ndScene* const scene = world->GetScene();
+	const ndInt32 workers = scene->GetThreadCount();
+	for (ndInt32 i = 0; i < workers; ++i)
+	{
+		if (!m_solvers[i])
+		{
+			m_solvers[i] = new ndIkSolver;
+			m_solvers[i]->SetMaxAccel(m_maxAccel, m_maxAlpha);
+		}
+	}
+
+	// each worker takes a contiguous run of the sorted requests,
+	// so identical rigs reuse the same solver buffers with no reallocation.
+	auto SolveRequests = ndMakeObject::ndFunction([this, world, timestep, count](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(SolveRequests);
+		ndIkSolver& solver = *m_solvers[threadIndex];
+		const ndStartEnd startEnd(count, threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndRequest& request = m_requests[i];
+			solver.SolverBegin(request.m_skeleton, request.m_effectors, request.m_effectorCount, world, timestep);
+			solver.Solve();
+			solver.SolverEnd();
+		}
+	});
+
+	scene->ndThreadPool::Begin();
+	scene->ParallelExecute(SolveRequests);
+	scene->ndThreadPool::End();
+}
@@ -0,0 +1,74 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_IK_BATCH_SOLVER_H__
+#define __ND_IK_BATCH_SOLVER_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+class ndIkSolver;
+class ndSkeletonContainer;
+class ndJointBilateralConstraint;
+
+// solves the inverse dynamics of many skeletons in parallel using the world thread pool.
+// requests are sorted by topology, so that rigs with the same structure are
+// solved back to back by the same worker, reusing the same solver buffers.
+// skeletons in one batch can not share dynamics bodies, and Solve must
+// be called outside the world update.
+class ndIkBatchSolver: public ndClassAlloc
+{
+	public:
+	class ndRequest
+	{
+		public:
+		ndSkeletonContainer* m_skeleton;
+		// not copied, points to the caller's array
+		ndJointBilateralConstraint* const* m_effectors;
+		ndUnsigned64 m_topologyKey;
+		ndInt32 m_effectorCount;
+	};
+
+	D_NEWTON_API ndIkBatchSolver();
+	D_NEWTON_API ~ndIkBatchSolver();
+
+	D_NEWTON_API void SetMaxAccel(ndFloat32 maxAccel, ndFloat32 maxAlpha);
+
+	D_NEWTON_API void Clear();
+	D_NEWTON_API ndInt32 GetCount() const;
+	// the batch keeps only the pointer to the effectors array, it does not copy it.
+	// the caller owns the array and the effector joints, and both must stay
+	// alive and unchanged until Solve returns or the batch is cleared.
+	D_NEWTON_API void AddRequest(ndSkeletonContainer* const skeleton, ndJointBilateralConstraint* const* effectors, ndInt32 effectorCount);
+
+	D_NEWTON_API void Solve(ndWorld* const world, ndFloat32 timestep);
+
+	private:
+	ndUnsigned64 CalculateTopologyKey(const ndSkeletonContainer* const skeleton, ndJointBilateralConstraint* const* effectors, ndInt32 effectorCount) const;
+
+	ndArray<ndRequest> m_requests;
+	ndIkSolver* m_solvers[D_MAX_THREADS_COUNT];
+	ndFloat32 m_maxAccel;
+	ndFloat32 m_maxAlpha;
+};
+
+#endif
+
@@ -133,6 +133,7 @@ class ndMultiBodyVehicle: public ndModel
 	ndDownForce m_downForce;
 	
 	friend class ndMultiBodyVehicleMotor;
+	friend class ndMultiBodyVehicleFleet;
 	friend class ndMultiBodyVehicleGearBox;
 	friend class ndMultiBodyVehicleTireJoint;
 	friend class ndMultiBodyVehicleTorsionBar;
@@ -0,0 +1,318 @@
+/* Copyright (c) <2003-2022> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndBodyKinematic.h"
+#include "ndMultiBodyVehicle.h"
+#include "ndMultiBodyVehicleFleet.h"
+#include "ndMultiBodyVehicleTireJoint.h"
+
+#define D_FLEET_CONTACT_SPEED_TRESHOLD  ndFloat32 (0.25f)
+
+ndMultiBodyVehicleFleet::ndFleetNotify::ndFleetNotify()
+	:ndModelNotify()
+{
+}
+
+void ndMultiBodyVehicleFleet::ndFleetNotify::Update(ndWorld* const world, ndFloat32 timestep)
+{
+	ndMultiBodyVehicleFleet* const fleet = (ndMultiBodyVehicleFleet*)GetModel();
+	ndAssert(fleet);
+	fleet->Update(world, timestep);
+}
+
+ndMultiBodyVehicleFleet::ndBrushLanes::ndBrushLanes()
+	:m_contact(256)
+	,m_tireIndex(256)
+	,m_relSpeed(256)
+	,m_contactSpeed(256)
+	,m_sideSpeed(256)
+	,m_lateralStiffness(256)
+	,m_longitudinalStiffness(256)
+	,m_maxFriction(256)
+	,m_lateralSlip(256)
+	,m_longitudinalSlip(256)
+	,m_lateralForce(256)
+	,m_longitudinalForce(256)
+{
+}
+
+void ndMultiBodyVehicleFleet::ndBrushLanes::SetCount(ndInt32 count)
+{
+	m_contact.SetCount(count);
+	m_tireIndex.SetCount(count);
+	m_relSpeed.SetCount(count);
+	m_contactSpeed.SetCount(count);
+	m_sideSpeed.SetCount(count);
+	m_lateralStiffness.SetCount(count);
+	m_longitudinalStiffness.SetCount(count);
+	m_maxFriction.SetCount(count);
+	m_lateralSlip.SetCount(count);
+	m_longitudinalSlip.SetCount(count);
+	m_lateralForce.SetCount(count);
+	m_longitudinalForce.SetCount(count);
+}
+
+ndMultiBodyVehicleFleet::ndMultiBodyVehicleFleet()
+	:ndModel()
+	,m_tires(64)
+	,m_lanes()
+	,m_perVehicleTireModel(false)
+{
+	SetNotifyCallback(ndSharedPtr<ndModelNotify>(new ndFleetNotify()));
+}
+
+ndMultiBodyVehicleFleet::~ndMultiBodyVehicleFleet()
+{
+}
+
+void ndMultiBodyVehicleFleet::AddTire(ndMultiBodyVehicleTireJoint* const tire)
+{
+	#ifdef _DEBUG
+	for (ndInt32 i = ndInt32(m_tires.GetCount()) - 1; i >= 0; --i)
+	{
+		ndAssert(m_tires[i] != tire);
+	}
+	#endif
+	m_tires.PushBack(tire);
+}
+
+void ndMultiBodyVehicleFleet::RemoveTire(ndMultiBodyVehicleTireJoint* const tire)
+{
+	for (ndInt32 i = ndInt32(m_tires.GetCount()) - 1; i >= 0; --i)
+	{
+		if (m_tires[i] == tire)
+		{
+			m_tires[i] = m_tires[m_tires.GetCount() - 1];
+			m_tires.SetCount(m_tires.GetCount() - 1);
+			break;
+		}
+	}
+}
+
+ndInt32 ndMultiBodyVehicleFleet::GetTireCount() const
+{
+	return ndInt32(m_tires.GetCount());
+}
+
+bool ndMultiBodyVehicleFleet::GetPerVehicleTireModel() const
+{
+	return m_perVehicleTireModel;
+}
+
+void ndMultiBodyVehicleFleet::SetPerVehicleTireModel(bool state)
+{
+	m_perVehicleTireModel = state;
+}
+
+void ndMultiBodyVehicleFleet::CoulombTireModel(ndContactMaterial& contactPoint) const
+{
+	const ndFloat32 frictionCoefficient = contactPoint.m_material.m_staticFriction0;
+	const ndFloat32 normalForce = contactPoint.m_normal_Force.GetInitialGuess() + ndFloat32(1.0f);
+	const ndFloat32 maxForceForce = frictionCoefficient * normalForce;
+
+	contactPoint.m_material.m_staticFriction0 = maxForceForce;
+	contactPoint.m_material.m_dynamicFriction0 = maxForceForce;
+	contactPoint.m_material.m_staticFriction1 = maxForceForce;
+	contactPoint.m_material.m_dynamicFriction1 = maxForceForce;
+	contactPoint.m_material.m_flags = contactPoint.m_material.m_flags | m_override0Friction | m_override1Friction;
+}
+
+void ndMultiBodyVehicleFleet::GatherTireContacts()
+{
+	D_TRACKTIME();
+	ndInt32 laneCount = 0;
+	m_lanes.SetCount(0);
+	for (ndInt32 i = 0; i < ndInt32(m_tires.GetCount()); ++i)
+	{
+		ndMultiBodyVehicleTireJoint* const tire = m_tires[i];
+		tire->m_lateralSlip = ndFloat32(0.0f);
+		tire->m_longitudinalSlip = ndFloat32(0.0f);
+		tire->m_normalizedAligningTorque = ndFloat32(0.0f);
+
+		ndBodyKinematic* const tireBody = tire->GetBody0();
+		const ndBodyKinematic* const chassis = (tire->m_vehicle && tire->m_vehicle->m_chassis) ? tire->m_vehicle->m_chassis : tire->GetBody1();
+		const ndFloat32 vehicleMass = chassis->GetMassMatrix().m_w;
+		const ndTireFrictionModel& info = tire->m_frictionModel;
+		const bool brushTire = (info.m_frictionModel != ndTireFrictionModel::m_coulomb);
+
+		ndMatrix tireBasisMatrix(tire->GetLocalMatrix1() * tire->GetBody1()->GetMatrix());
+		tireBasisMatrix.m_posit = tireBody->GetMatrix().m_posit;
+
+		ndBodyKinematic::ndContactMap& contactMap = tireBody->GetContactMap();
+		ndBodyKinematic::ndContactMap::Iterator it(contactMap);
+		for (it.Begin(); it; it++)
+		{
+			ndContact* const contact = it.GetNode()->GetInfo();
+			if (!contact->IsActive())
+			{
+				continue;
+			}
+
+			const ndMaterial* const material = contact->GetMaterial();
+			const bool useBrushModel = brushTire && (material->m_flags & m_useBrushTireModel);
+			const ndBodyKinematic* const otherBody = (contact->GetBody0() == tireBody) ? contact->GetBody1() : contact->GetBody0();
+
+			ndContactPointList& contactPoints = contact->GetContactPoints();
+			for (ndContactPointList::ndNode* contactNode = contactPoints.GetFirst(); contactNode; contactNode = contactNode->GetNext())
+			{
+				ndContactMaterial& contactPoint = contactNode->GetInfo();
+				const ndFloat32 contactPathLocation = ndAbs(contactPoint.m_normal.DotProduct(tireBasisMatrix.m_front).GetScalar());
+				// contact are consider on the contact patch strip only if the are less than
+				// 45 degree angle from the tire axle
+				if (contactPathLocation < ndFloat32(0.71f))
+				{
+					// align tire friction direction
+					const ndVector longitudinalDir(contactPoint.m_normal.CrossProduct(tireBasisMatrix.m_front).Normalize());
+					const ndVector lateralDir(longitudinalDir.CrossProduct(contactPoint.m_normal));
+					contactPoint.m_dir1 = lateralDir;
+					contactPoint.m_dir0 = longitudinalDir;
+
+					const ndVector dir(contactPoint.m_point - tireBasisMatrix.m_posit);
+					ndAssert(dir.DotProduct(dir).GetScalar() > ndFloat32(0.0f));
+					const ndFloat32 contactPatch = tireBasisMatrix.m_up.DotProduct(dir.Normalize()).GetScalar();
+					if (!useBrushModel || (contactPatch > ndFloat32(-0.71f)))
+					{
+						CoulombTireModel(contactPoint);
+						continue;
+					}
+
+					// the brush model is not defined for stationary tires
+					const ndVector contactVeloc1(otherBody->GetVelocityAtPoint(contactPoint.m_point));
+					const ndVector relVeloc(tireBody->GetVelocity() - contactVeloc1);
+					const ndFloat32 relSpeed = ndAbs(relVeloc.DotProduct(longitudinalDir).GetScalar());
+					if (relSpeed <= D_FLEET_CONTACT_SPEED_TRESHOLD)
+					{
+						CoulombTireModel(contactPoint);
+						continue;
+					}
+
+					const ndVector contactVeloc(tireBody->GetVelocityAtPoint(contactPoint.m_point) - contactVeloc1);
+					const ndFloat32 frictionCoefficient = contactPoint.m_material.m_staticFriction0;
+					const ndFloat32 normalForce = contactPoint.m_normal_Force.GetInitialGuess() + ndFloat32(1.0f);
+
+					m_lanes.SetCount(laneCount + 1);
+					m_lanes.m_contact[laneCount] = &contactPoint;
+					m_lanes.m_tireIndex[laneCount] = i;
+					m_lanes.m_relSpeed[laneCount] = relSpeed;
+					m_lanes.m_contactSpeed[laneCount] = contactVeloc.DotProduct(longitudinalDir).GetScalar();
+					m_lanes.m_sideSpeed[laneCount] = relVeloc.DotProduct(lateralDir).GetScalar();
+					m_lanes.m_lateralStiffness[laneCount] = vehicleMass * info.m_laterialStiffness;
+					m_lanes.m_longitudinalStiffness[laneCount] = vehicleMass * info.m_longitudinalStiffness;
+					m_lanes.m_maxFriction[laneCount] = frictionCoefficient * normalForce;
+					laneCount++;
+				}
+			}
+		}
+	}
+
+	// pad to a multiple of the vector width with benign lanes
+	const ndInt32 paddedCount = (laneCount + 3) & -4;
+	m_lanes.SetCount(paddedCount);
+	for (ndInt32 i = laneCount; i < paddedCount; ++i)
+	{
+		m_lanes.m_contact[i] = nullptr;
+		m_lanes.m_tireIndex[i] = -1;
+		m_lanes.m_relSpeed[i] = ndFloat32(1.0f);
+		m_lanes.m_contactSpeed[i] = ndFloat32(0.0f);
+		m_lanes.m_sideSpeed[i] = ndFloat32(0.0f);
+		m_lanes.m_lateralStiffness[i] = ndFloat32(0.0f);
+		m_lanes.m_longitudinalStiffness[i] = ndFloat32(0.0f);
+		m_lanes.m_maxFriction[i] = ndFloat32(1.0f);
+	}
+}
+
+void ndMultiBodyVehicleFleet::EvaluateBrushModel()
+{
+	D_TRACKTIME();
+	const ndVector one(ndFloat32(1.0f));
+	const ndVector three(ndFloat32(3.0f));
+	const ndVector twentySeven(ndFloat32(27.0f));
+	const ndVector minGamma(ndFloat32(1.0e-8f));
+
+	const ndInt32 count = ndInt32(m_lanes.m_relSpeed.GetCount());
+	ndAssert((count & 3) == 0);
+	for (ndInt32 i = 0; i < count; i += 4)
+	{
+		const ndVector relSpeed(&m_lanes.m_relSpeed[i]);
+		const ndVector contactSpeed(&m_lanes.m_contactSpeed[i]);
+		const ndVector sideSpeed(&m_lanes.m_sideSpeed[i]);
+		const ndVector lateralStiffness(&m_lanes.m_lateralStiffness[i]);
+		const ndVector longitudinalStiffness(&m_lanes.m_longitudinalStiffness[i]);
+		const ndVector maxFriction(&m_lanes.m_maxFriction[i]);
+
+		const ndVector longitudinalSlip(contactSpeed.Abs().Divide(relSpeed));
+		const ndVector lateralSlip(sideSpeed.Abs().Divide(relSpeed + one));
+
+		const ndVector den(one.Divide(longitudinalSlip + one));
+		const ndVector cz(lateralStiffness * lateralSlip * den);
+		const ndVector cx(longitudinalStiffness * longitudinalSlip * den);
+		const ndVector gamma((cx * cx + cz * cz).Sqrt().GetMax(minGamma));
+
+		// cubic brush friction law, saturating at the coulomb limit
+		const ndVector b(one.Divide(three * maxFriction));
+		const ndVector c(one.Divide(twentySeven * maxFriction * maxFriction));
+		const ndVector cubic(gamma * (one - b * gamma + c * gamma * gamma));
+		const ndVector f(maxFriction.Select(cubic, gamma < three * maxFriction));
+		const ndVector scale(f.Divide(gamma));
+
+		longitudinalSlip.Store(&m_lanes.m_longitudinalSlip[i]);
+		lateralSlip.Store(&m_lanes.m_lateralSlip[i]);
+		(scale * cx).Store(&m_lanes.m_longitudinalForce[i]);
+		(scale * cz).Store(&m_lanes.m_lateralForce[i]);
+	}
+}
+
+void ndMultiBodyVehicleFleet::ScatterTireForces(ndFloat32 timestep)
+{
+	D_TRACKTIME();
+	const ndFloat32 invTimestep = ndFloat32(1.0f) / timestep;
+	const ndInt32 count = ndInt32(m_lanes.m_contact.GetCount());
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		ndContactMaterial* const contactPoint = m_lanes.m_contact[i];
+		if (!contactPoint)
+		{
+			break;
+		}
+		ndMultiBodyVehicleTireJoint* const tire = m_tires[m_lanes.m_tireIndex[i]];
+		if (tire->m_vehicle && m_perVehicleTireModel)
+		{
+			// reference path, the owning vehicle evaluates the contact by itself
+			tire->m_vehicle->BrushTireModel(tire, *contactPoint, timestep);
+			continue;
+		}
+		// the vehicle aligning torque model is not implemented yet, the batched
+		// path leaves m_normalizedAligningTorque at zero
+
+		tire->m_lateralSlip = ndMax(tire->m_lateralSlip, m_lanes.m_lateralSlip[i]);
+		tire->m_longitudinalSlip = ndMax(tire->m_longitudinalSlip, m_lanes.m_longitudinalSlip[i]);
+
+		const ndFloat32 lateralForce = m_lanes.m_lateralForce[i];
+		const ndFloat32 longitudinalForce = m_lanes.m_longitudinalForce[i];
+		contactPoint->OverrideFriction0Accel(-m_lanes.m_contactSpeed[i] * invTimestep);
+		contactPoint->m_material.m_staticFriction0 = longitudinalForce;
+		contactPoint->m_material.m_dynamicFriction0 = longitudinalForce;
+		contactPoint->m_material.m_staticFriction1 = lateralForce;
+		contactPoint->m_material.m_dynamicFriction1 = lateralForce;
+		contactPoint->m_material.m_flags = contactPoint->m_material.m_flags | m_override0Friction | m_override1Friction;
+	}
+}
+
+void ndMultiBodyVehicleFleet::Update(ndWorld* const, ndFloat32 timestep)
+{
+	D_TRACKTIME();
+	GatherTireContacts();
+	EvaluateBrushModel();
+	ScatterTireForces(timestep);
+}
@@ -0,0 +1,89 @@
+/* Copyright (c) <2003-2022> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#ifndef __ND_MULTIBODY_VEHICLE_FLEET_H__
+#define __ND_MULTIBODY_VEHICLE_FLEET_H__
+
+#include "ndNewtonStdafx.h"
+#include "dModels/ndModel.h"
+#include "dModels/ndModelNotify.h"
+
+class ndContactMaterial;
+class ndMultiBodyVehicleTireJoint;
+
+// evaluates the tire friction of many vehicles in one model update.
+// tire contacts are gathered into struct of arrays buffers, the brush
+// model is evaluated four contacts at a time with ndVector, and the
+// resulting friction limits and slips are scattered back to the contacts
+// and the tire joints.
+class ndMultiBodyVehicleFleet: public ndModel
+{
+	public:
+	D_CLASS_REFLECTION(ndMultiBodyVehicleFleet, ndModel)
+
+	D_NEWTON_API ndMultiBodyVehicleFleet();
+	D_NEWTON_API virtual ~ndMultiBodyVehicleFleet();
+
+	D_NEWTON_API void AddTire(ndMultiBodyVehicleTireJoint* const tire);
+	D_NEWTON_API void RemoveTire(ndMultiBodyVehicleTireJoint* const tire);
+	D_NEWTON_API ndInt32 GetTireCount() const;
+
+	// when set, the contacts of tires that belong to a vehicle are evaluated
+	// one at a time by the vehicle brush model. slow, only for validation.
+	D_NEWTON_API bool GetPerVehicleTireModel() const;
+	D_NEWTON_API void SetPerVehicleTireModel(bool state);
+
+	D_NEWTON_API virtual void Update(ndWorld* const world, ndFloat32 timestep);
+
+	private:
+	class ndFleetNotify: public ndModelNotify
+	{
+		public:
+		ndFleetNotify();
+		virtual void Update(ndWorld* const world, ndFloat32 timestep);
+	};
+
+	class ndBrushLanes
+	{
+		public:
+		ndBrushLanes();
+		void SetCount(ndInt32 count);
+
+		ndArray<ndContactMaterial*> m_contact;
+		ndArray<ndInt32> m_tireIndex;
+
+		// inputs
+		ndArray<ndFloat32> m_relSpeed;
+		ndArray<ndFloat32> m_contactSpeed;
+		ndArray<ndFloat32> m_sideSpeed;
+		ndArray<ndFloat32> m_lateralStiffness;
+		ndArray<ndFloat32> m_longitudinalStiffness;
+		ndArray<ndFloat32> m_maxFriction;
+
+		// outputs
+		ndArray<ndFloat32> m_lateralSlip;
+		ndArray<ndFloat32> m_longitudinalSlip;
+		ndArray<ndFloat32> m_lateralForce;
+		ndArray<ndFloat32> m_longitudinalForce;
+	};
+
+	void GatherTireContacts();
+	void EvaluateBrushModel();
+	void ScatterTireForces(ndFloat32 timestep);
+	void CoulombTireModel(ndContactMaterial& contactPoint) const;
+
+	ndArray<ndMultiBodyVehicleTireJoint*> m_tires;
+	ndBrushLanes m_lanes;
+	bool m_perVehicleTireModel;
+};
+
+#endif
+
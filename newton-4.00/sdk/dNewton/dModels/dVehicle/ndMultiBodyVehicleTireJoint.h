@@ -71,6 +71,7 @@ class ndMultiBodyVehicleTireJoint: public ndJointWheel
 	ndFloat32 m_longitudinalSlip;
 	ndFloat32 m_normalizedAligningTorque;
 	friend class ndMultiBodyVehicle;
+	friend class ndMultiBodyVehicleFleet;
 };
 
 
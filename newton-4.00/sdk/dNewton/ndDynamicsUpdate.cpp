@@ -32,14 +32,14 @@
 
 ndDynamicsUpdate::ndDynamicsUpdate(ndWorld* const world)
 	:m_velocTol(ndFloat32(1.0e-8f))
-	,m_islands(D_DEFAULT_BUFFER_SIZE)
+	,m_islands()
 	,m_jointForcesIndex(D_DEFAULT_BUFFER_SIZE)
 	,m_internalForces(D_DEFAULT_BUFFER_SIZE)
-	,m_leftHandSide(D_DEFAULT_BUFFER_SIZE * 4)
-	,m_rightHandSide(D_DEFAULT_BUFFER_SIZE)
+	,m_leftHandSide()
+	,m_rightHandSide()
 	,m_tempInternalForces(D_DEFAULT_BUFFER_SIZE)
-	,m_bodyIslandOrder(D_DEFAULT_BUFFER_SIZE)
-	,m_jointBodyPairIndexBuffer(D_DEFAULT_BUFFER_SIZE)
+	,m_bodyIslandOrder()
+	,m_jointBodyPairIndexBuffer()
 	,m_world(world)
 	,m_timestep(ndFloat32(0.0f))
 	,m_invTimestep(ndFloat32(0.0f))
@@ -65,14 +65,16 @@ const char* ndDynamicsUpdate::GetStringId() const
 
 void ndDynamicsUpdate::Clear()
 {
-	m_islands.Resize(D_DEFAULT_BUFFER_SIZE);
-	m_rightHandSide.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_internalForces.Resize(D_DEFAULT_BUFFER_SIZE);
-	m_bodyIslandOrder.Resize(D_DEFAULT_BUFFER_SIZE);
-	m_leftHandSide.Resize(D_DEFAULT_BUFFER_SIZE * 4);
 	m_tempInternalForces.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_jointForcesIndex.Resize(D_DEFAULT_BUFFER_SIZE);
-	m_jointBodyPairIndexBuffer.Resize(D_DEFAULT_BUFFER_SIZE);
+
+	// the frame arena owns the memory of these
+	m_islands.ResetMembers();
+	m_leftHandSide.ResetMembers();
+	m_rightHandSide.ResetMembers();
+	m_bodyIslandOrder.ResetMembers();
+	m_jointBodyPairIndexBuffer.ResetMembers();
 }
 
 void ndDynamicsUpdate::SortBodyJointScan()
@@ -140,8 +142,7 @@ void ndDynamicsUpdate::SortBodyJointScan()
 	});
 	scene->ParallelExecute(EnumerateJointBodyPairs);
 
-	scene->GetScratchBuffer().SetCount(bodyJointPairs.GetCount() * ndInt32 (sizeof (ndJointBodyPairIndex)));
-	ndJointBodyPairIndex* const tempBuffer = (ndJointBodyPairIndex*)&scene->GetScratchBuffer()[0];
+	ndJointBodyPairIndex* const tempBuffer = m_world->GetFrameArena().Alloc<ndJointBodyPairIndex>(bodyJointPairs.GetCount());
 
 	ndCountingSort<ndJointBodyPairIndex, ndEvaluateKey0, D_MAX_BODY_RADIX_BIT>(*scene, &bodyJointPairs[0], tempBuffer, ndInt32 (bodyJointPairs.GetCount()), nullptr, nullptr);
 	ndCountingSort<ndJointBodyPairIndex, ndEvaluateKey1, D_MAX_BODY_RADIX_BIT>(*scene, tempBuffer, &bodyJointPairs[0], ndInt32 (bodyJointPairs.GetCount()), nullptr, nullptr);
@@ -235,6 +236,13 @@ void ndDynamicsUpdate::SortJointsScan()
 
 	ndScene* const scene = m_world->GetScene();
 
+	// the solver rebinds these with their final size, until then
+	// they must not point to the arena memory of a previous step
+	ndFrameArena& arena = m_world->GetFrameArena();
+	arena.Bind(m_leftHandSide, 0);
+	arena.Bind(m_rightHandSide, 0);
+	arena.Bind(m_jointBodyPairIndexBuffer, 0);
+
 	for (ndSkeletonList::ndNode* node = m_world->GetSkeletonList().GetFirst(); node; node = node->GetNext())
 	{
 		ndSkeletonContainer* const skeleton = &node->GetInfo();
@@ -258,7 +266,7 @@ void ndDynamicsUpdate::SortJointsScan()
 	}
 	jointArray.SetCount(jointCount);
 	
-	m_leftHandSide.SetCount(jointArray.GetCount() + 32);
+	ndConstraint** const tempJointBuffer = arena.Alloc<ndConstraint*>(jointArray.GetCount() + 32);
 	
 	ndInt32 histogram[D_MAX_THREADS_COUNT][2];
 	ndInt32 movingJoints[D_MAX_THREADS_COUNT];
@@ -326,12 +334,11 @@ void ndDynamicsUpdate::SortJointsScan()
 		movingJoints[threadIndex] = activeJointCount;
 	});
 	
-	auto Scan0 = ndMakeObject::ndFunction([&jointArray, &histogram, scene](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Scan0 = ndMakeObject::ndFunction([&jointArray, &histogram, tempJointBuffer](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME_NAMED(Scan0);
 		ndInt32* const hist = &histogram[threadIndex][0];
-		ndAssert(scene->GetScratchBuffer().GetCount() >= ndInt32 (jointArray.GetCount() * sizeof(ndConstraint*)));
-		ndConstraint** const dstBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
+		ndConstraint** const dstBuffer = tempJointBuffer;
 	
 		hist[0] = 0;
 		hist[1] = 0;
@@ -349,12 +356,11 @@ void ndDynamicsUpdate::SortJointsScan()
 		}
 	});
 	
-	auto Sort0 = ndMakeObject::ndFunction([&jointArray, &histogram, scene](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Sort0 = ndMakeObject::ndFunction([&jointArray, &histogram, tempJointBuffer](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME_NAMED(Sort0);
 		ndInt32* const hist = &histogram[threadIndex][0];
-		ndAssert(scene->GetScratchBuffer().GetCount() >= ndInt32 (jointArray.GetCount() * sizeof (ndConstraint*)));
-		ndConstraint** const dstBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
+		ndConstraint** const dstBuffer = tempJointBuffer;
 	
 		const ndStartEnd startEnd(ndInt32 (jointArray.GetCount()), threadIndex, threadCount);
 		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
@@ -369,8 +375,6 @@ void ndDynamicsUpdate::SortJointsScan()
 		}
 	});
 	
-	scene->GetScratchBuffer().SetCount((jointArray.GetCount() + 32) * ndInt32 (sizeof (ndConstraint*)));
-	ndConstraint** const tempJointBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
 	
 	scene->ParallelExecute(MarkFence0);
 	scene->ParallelExecute(MarkFence1);
@@ -424,7 +428,7 @@ void ndDynamicsUpdate::SortJointsScan()
 	
 	m_activeJointCount = movingJointCount;
 	GetTempInternalForces().SetCount(jointArray.GetCount() * 2);
-	GetJointBodyPairIndexBuffer().SetCount(jointArray.GetCount() * 2);
+	arena.Bind(GetJointBodyPairIndexBuffer(), jointArray.GetCount() * 2);
 	ndCountingSort<ndConstraint*, ndEvaluateCountRows, 7>(*scene, tempJointBuffer, &jointArray[0], ndInt32 (jointArray.GetCount()), nullptr, nullptr);
 }
 
@@ -448,8 +452,9 @@ void ndDynamicsUpdate::SortJoints()
 		rowCount += joint->m_rowCount;
 	}
 
-	m_leftHandSide.SetCount(rowCount);
-	m_rightHandSide.SetCount(rowCount);
+	ndFrameArena& arena = m_world->GetFrameArena();
+	arena.Bind(m_leftHandSide, rowCount);
+	arena.Bind(m_rightHandSide, rowCount);
 
 #ifdef _DEBUG
 	ndAssert(m_activeJointCount <= jointArray.GetCount());
@@ -493,7 +498,7 @@ void ndDynamicsUpdate::SortIslands()
 	const ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
 	ndArray<ndBodyKinematic*>& activeBodyArray = GetBodyIslandOrder();
 	GetInternalForces().SetCount(bodyArray.GetCount());
-	activeBodyArray.SetCount(bodyArray.GetCount());
+	m_world->GetFrameArena().Bind(activeBodyArray, bodyArray.GetCount());
 
 	ndInt32 histogram[D_MAX_THREADS_COUNT][3];
 	auto Scan0 = ndMakeObject::ndFunction([&bodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
@@ -946,6 +951,8 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 			{
 				ndVector force(zero);
 				ndVector torque(zero);
+				ndVector forceError(zero);
+				ndVector torqueError(zero);
 
 				const ndInt32 index = bodyIndex[i + j];
 				const ndJointBodyPairIndex& scan = jointBodyPairIndexBuffer[index];
@@ -959,8 +966,8 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 				for (ndInt32 k = 0; k < count; ++k)
 				{
 					const ndInt32 jointIndex = jointBodyPairIndexBuffer[index + k].m_joint;
-					force += jointInternalForces[jointIndex].m_linear;
-					torque += jointInternalForces[jointIndex].m_angular;
+					ndKahanAdd(force, forceError, jointInternalForces[jointIndex].m_linear);
+					ndKahanAdd(torque, torqueError, jointInternalForces[jointIndex].m_angular);
 				}
 				internalForces[i + j].m_linear = force;
 				internalForces[i + j].m_angular = torque;
@@ -1467,6 +1474,8 @@ void ndDynamicsUpdate::CalculateJointsForce()
 			{
 				ndVector force(zero);
 				ndVector torque(zero);
+				ndVector forceError(zero);
+				ndVector torqueError(zero);
 				const ndInt32 m = i + j;
 				const ndBodyKinematic* const body = bodyArray[m];
 
@@ -1476,8 +1485,8 @@ void ndDynamicsUpdate::CalculateJointsForce()
 				for (ndInt32 k = 0; k < count; ++k)
 				{
 					const ndInt32 index = jointBodyPairIndexBuffer[startIndex + k].m_joint;
-					force += jointInternalForces[index].m_linear;
-					torque += jointInternalForces[index].m_angular;
+					ndKahanAdd(force, forceError, jointInternalForces[index].m_linear);
+					ndKahanAdd(torque, torqueError, jointInternalForces[index].m_angular);
 				}
 				internalForces[m].m_linear = force;
 				internalForces[m].m_angular = torque;
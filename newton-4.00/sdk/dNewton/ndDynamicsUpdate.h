@@ -119,6 +119,8 @@ class ndDynamicsUpdate : public ndClassAlloc
 	ndBodyKinematic* FindRootAndSplit(ndBodyKinematic* const body);
 
 	ndVector m_velocTol;
+	// m_islands, m_leftHandSide, m_rightHandSide, m_bodyIslandOrder and m_jointBodyPairIndexBuffer
+	// point to frame arena memory, they are rebound every step and never own their array.
 	ndArray<ndIsland> m_islands;
 	ndArray<ndInt32> m_jointForcesIndex;
 	ndArray<ndJacobian> m_internalForces;
@@ -211,8 +211,9 @@ void ndDynamicsUpdateSoa::SortJoints()
 	});
 
 	scene->ParallelExecute(SetRowStarts);
-	m_leftHandSide.SetCount(rowsCount);
-	m_rightHandSide.SetCount(rowsCount);
+	ndFrameArena& arena = m_world->GetFrameArena();
+	arena.Bind(m_leftHandSide, rowsCount);
+	arena.Bind(m_rightHandSide, rowsCount);
 	m_soaMassMatrix.SetCount(soaJointRowCount);
 
 	#ifdef _DEBUG
@@ -247,7 +248,7 @@ void ndDynamicsUpdateSoa::SortIslands()
 	const ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
 	ndArray<ndBodyKinematic*>& activeBodyArray = GetBodyIslandOrder();
 	GetInternalForces().SetCount(bodyArray.GetCount());
-	activeBodyArray.SetCount(bodyArray.GetCount());
+	m_world->GetFrameArena().Bind(activeBodyArray, bodyArray.GetCount());
 
 	ndInt32 histogram[D_MAX_THREADS_COUNT][3];
 	auto Scan0 = ndMakeObject::ndFunction([&bodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
@@ -731,6 +732,8 @@ void ndDynamicsUpdateSoa::InitJacobianMatrix()
 			{
 				ndVector force(zero);
 				ndVector torque(zero);
+				ndVector forceError(zero);
+				ndVector torqueError(zero);
 
 				const ndInt32 m = i + j;
 				const ndInt32 index = bodyIndex[m];
@@ -745,8 +748,8 @@ void ndDynamicsUpdateSoa::InitJacobianMatrix()
 				for (ndInt32 k = 0; k < count; ++k)
 				{
 					const ndInt32 jointIndex = jointBodyPairIndexBuffer[index + k].m_joint;
-					force += jointInternalForces[jointIndex].m_linear;
-					torque += jointInternalForces[jointIndex].m_angular;
+					ndKahanAdd(force, forceError, jointInternalForces[jointIndex].m_linear);
+					ndKahanAdd(torque, torqueError, jointInternalForces[jointIndex].m_angular);
 				}
 				internalForces[m].m_linear = force;
 				internalForces[m].m_angular = torque;
@@ -1682,6 +1685,8 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 			{
 				ndVector force(zero);
 				ndVector torque(zero);
+				ndVector forceError(zero);
+				ndVector torqueError(zero);
 				const ndInt32 m = i + j;
 				const ndBodyKinematic* const body = bodyArray[m];
 
@@ -1691,8 +1696,8 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 				for (ndInt32 k = 0; k < count; ++k)
 				{
 					const ndInt32 index = jointBodyPairIndexBuffer[startIndex + k].m_joint;
-					force += jointInternalForces[index].m_linear;
-					torque += jointInternalForces[index].m_angular;
+					ndKahanAdd(force, forceError, jointInternalForces[index].m_linear);
+					ndKahanAdd(torque, torqueError, jointInternalForces[index].m_angular);
 				}
 				internalForces[m].m_linear = force;
 				internalForces[m].m_angular = torque;
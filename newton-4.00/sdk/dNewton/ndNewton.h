@@ -29,6 +29,7 @@
 
 #include <ndNewtonStdafx.h>
 #include <ndWorld.h>
+#include <ndTiledStaticWorld.h>
 #include <ndJointList.h>
 #include <ndWorldScene.h>
 #include <ndConstraint.h>
@@ -61,6 +62,7 @@
 #include <dJoints/ndJointKinematicController.h>
 
 #include <dIkSolver/ndIkSolver.h>
+#include <dIkSolver/ndIkBatchSolver.h>
 #include <dIkSolver/ndIkJointHinge.h>
 #include <dIkSolver/ndIk6DofEffector.h>
 #include <dIkSolver/ndIkJointSpherical.h>
@@ -73,6 +75,7 @@
 #include <dModels/ndModelNotify.h>
 #include <dModels/ndModelArticulation.h>
 #include <dModels/dVehicle/ndMultiBodyVehicle.h>
+#include <dModels/dVehicle/ndMultiBodyVehicleFleet.h>
 #include <dModels/dVehicle/ndMultiBodyVehicleMotor.h>
 #include <dModels/dVehicle/ndMultiBodyVehicleGearBox.h>
 #include <dModels/dVehicle/ndMultiBodyVehicleTireJoint.h>
@@ -0,0 +1,339 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndBodyDynamic.h"
+#include "ndTiledStaticWorld.h"
+
+ndTiledStaticWorld::ndTile::ndTile(const ndVector& minBox, const ndVector& maxBox, size_t memorySize)
+	:ndBackgroundTask()
+	,m_minBox(minBox & ndVector::m_triplexMask)
+	,m_maxBox(maxBox & ndVector::m_triplexMask)
+	,m_body()
+	,m_memorySize(memorySize)
+	,m_requestTime(0)
+	,m_loadTime(0)
+	,m_distance(ndFloat32(0.0f))
+	,m_state(m_unloaded)
+{
+	ndAssert(m_minBox.m_x <= m_maxBox.m_x);
+	ndAssert(m_minBox.m_y <= m_maxBox.m_y);
+	ndAssert(m_minBox.m_z <= m_maxBox.m_z);
+}
+
+ndTiledStaticWorld::ndTile::~ndTile()
+{
+	ndAssert(TaskState() == m_taskCompleted);
+}
+
+void ndTiledStaticWorld::ndTile::Execute(ndThreadPool* const)
+{
+	D_TRACKTIME();
+	const ndUnsigned64 start = ndGetTimeInMicroseconds();
+	m_body = Load();
+	m_loadTime = ndGetTimeInMicroseconds() - start;
+}
+
+ndTiledStaticWorld::ndStatistics::ndStatistics()
+	:m_residentMemory(0)
+	,m_loadedCount(0)
+	,m_loadingCount(0)
+	,m_loadsCompleted(0)
+	,m_unloadsCompleted(0)
+	,m_evictions(0)
+	,m_lastLoadLatency(ndFloat32(0.0f))
+	,m_averageLoadLatency(ndFloat32(0.0f))
+	,m_maxLoadLatency(ndFloat32(0.0f))
+	,m_averageLoadTime(ndFloat32(0.0f))
+	,m_lastInsertTime(ndFloat32(0.0f))
+	,m_maxInsertTime(ndFloat32(0.0f))
+{
+}
+
+ndTiledStaticWorld::ndTiledStaticWorld(ndWorld* const world)
+	:ndClassAlloc()
+	,m_world(world)
+	,m_tiles()
+	,m_focusPoints()
+	,m_candidates()
+	,m_statistics()
+	,m_memoryBudget(size_t(-1))
+	,m_loadRadius(ndFloat32(100.0f))
+	,m_unloadRadius(ndFloat32(120.0f))
+	,m_maxInsertions(2)
+	,m_maxLoadsInFlight(4)
+{
+	ndAssert(m_world);
+}
+
+ndTiledStaticWorld::~ndTiledStaticWorld()
+{
+	// the manager must be destroyed before the world
+	for (ndInt32 i = 0; i < ndInt32(m_tiles.GetCount()); ++i)
+	{
+		ndTile* const tile = m_tiles[i];
+		tile->Sync();
+		if (tile->m_state == ndTile::m_loaded)
+		{
+			UnloadTile(tile);
+		}
+		delete tile;
+	}
+}
+
+void ndTiledStaticWorld::AddTile(ndTile* const tile)
+{
+	ndAssert(tile->m_state == ndTile::m_unloaded);
+	m_tiles.PushBack(tile);
+}
+
+ndInt32 ndTiledStaticWorld::GetTileCount() const
+{
+	return ndInt32(m_tiles.GetCount());
+}
+
+ndTiledStaticWorld::ndTile* ndTiledStaticWorld::GetTile(ndInt32 index) const
+{
+	return m_tiles[index];
+}
+
+void ndTiledStaticWorld::SetRadius(ndFloat32 loadRadius, ndFloat32 unloadRadius)
+{
+	m_loadRadius = ndMax(loadRadius, ndFloat32(0.0f));
+	m_unloadRadius = ndMax(unloadRadius, m_loadRadius);
+}
+
+void ndTiledStaticWorld::SetMemoryBudget(size_t bytes)
+{
+	m_memoryBudget = bytes;
+}
+
+void ndTiledStaticWorld::SetMaxInsertionsPerUpdate(ndInt32 count)
+{
+	m_maxInsertions = ndMax(count, 1);
+}
+
+void ndTiledStaticWorld::SetMaxLoadsInFlight(ndInt32 count)
+{
+	m_maxLoadsInFlight = ndMax(count, 1);
+}
+
+const ndTiledStaticWorld::ndStatistics& ndTiledStaticWorld::GetStatistics() const
+{
+	return m_statistics;
+}
+
+void ndTiledStaticWorld::CalculateTileDistances()
+{
+	// sleeping bodies are focus points too, they still need the ground under them
+	m_focusPoints.SetCount(0);
+	const ndBodyListView& bodyList = m_world->GetBodyList();
+	for (ndBodyListView::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		ndBodyKinematic* const body = node->GetInfo()->GetAsBodyKinematic();
+		if (body && (body->GetInvMass() > ndFloat32(0.0f)))
+		{
+			m_focusPoints.PushBack(body->GetMatrix().m_posit & ndVector::m_triplexMask);
+		}
+	}
+
+	for (ndInt32 i = 0; i < ndInt32(m_tiles.GetCount()); ++i)
+	{
+		ndTile* const tile = m_tiles[i];
+		ndFloat32 dist2 = ndFloat32(1.0e20f);
+		for (ndInt32 j = 0; j < ndInt32(m_focusPoints.GetCount()); ++j)
+		{
+			const ndVector& point = m_focusPoints[j];
+			const ndVector step((tile->m_minBox - point).GetMax(point - tile->m_maxBox).GetMax(ndVector::m_zero));
+			dist2 = ndMin(dist2, step.DotProduct(step).GetScalar());
+		}
+		tile->m_distance = ndSqrt(dist2);
+	}
+}
+
+void ndTiledStaticWorld::InsertLoadedTiles(ndInt32 maxCount)
+{
+	ndInt32 count = 0;
+	const ndUnsigned64 start = ndGetTimeInMicroseconds();
+	for (ndInt32 i = 0; (i < ndInt32(m_tiles.GetCount())) && (count < maxCount); ++i)
+	{
+		ndTile* const tile = m_tiles[i];
+		if ((tile->m_state != ndTile::m_loading) || (tile->TaskState() != ndBackgroundTask::m_taskCompleted))
+		{
+			continue;
+		}
+
+		m_statistics.m_loadingCount--;
+		if (!*tile->m_body)
+		{
+			ndTrace(("tile load failed\n"));
+			tile->m_state = ndTile::m_unloaded;
+			m_statistics.m_residentMemory -= tile->m_memorySize;
+			continue;
+		}
+
+		ndAssert(tile->m_body->GetInvMass() == ndFloat32(0.0f));
+		m_world->AddBody(tile->m_body);
+		tile->m_state = ndTile::m_loaded;
+		count++;
+
+		ndStatistics& stats = m_statistics;
+		const ndFloat32 weight = ndFloat32(1.0f) / ndFloat32(stats.m_loadsCompleted + 1);
+		const ndFloat32 latency = ndFloat32(ndGetTimeInMicroseconds() - tile->m_requestTime) * ndFloat32(1.0e-6f);
+		const ndFloat32 loadTime = ndFloat32(tile->m_loadTime) * ndFloat32(1.0e-6f);
+		stats.m_lastLoadLatency = latency;
+		stats.m_maxLoadLatency = ndMax(stats.m_maxLoadLatency, latency);
+		stats.m_averageLoadLatency += (latency - stats.m_averageLoadLatency) * weight;
+		stats.m_averageLoadTime += (loadTime - stats.m_averageLoadTime) * weight;
+		stats.m_loadsCompleted++;
+		stats.m_loadedCount++;
+	}
+	m_statistics.m_lastInsertTime = ndFloat32(ndGetTimeInMicroseconds() - start) * ndFloat32(1.0e-6f);
+	m_statistics.m_maxInsertTime = ndMax(m_statistics.m_maxInsertTime, m_statistics.m_lastInsertTime);
+}
+
+void ndTiledStaticWorld::UnloadTile(ndTile* const tile)
+{
+	ndAssert(tile->m_state == ndTile::m_loaded);
+	// the world defers the removal to its next update, and it keeps the body alive until then
+	m_world->RemoveBody(*tile->m_body);
+	tile->m_body = ndSharedPtr<ndBody>();
+	tile->m_state = ndTile::m_unloaded;
+	m_statistics.m_residentMemory -= tile->m_memorySize;
+	m_statistics.m_loadedCount--;
+	m_statistics.m_unloadsCompleted++;
+}
+
+void ndTiledStaticWorld::UnloadFarTiles()
+{
+	for (ndInt32 i = 0; i < ndInt32(m_tiles.GetCount()); ++i)
+	{
+		ndTile* const tile = m_tiles[i];
+		if ((tile->m_state == ndTile::m_loaded) && (tile->m_distance > m_unloadRadius))
+		{
+			UnloadTile(tile);
+		}
+	}
+}
+
+bool ndTiledStaticWorld::EvictTiles(size_t bytes, ndFloat32 distance)
+{
+	// evict the farthest tiles in the hysteresis band, as long as they
+	// are farther than the tile that needs the memory
+	while ((m_statistics.m_residentMemory + bytes) > m_memoryBudget)
+	{
+		ndTile* farTile = nullptr;
+		ndFloat32 farDistance = ndMax(distance, m_loadRadius);
+		for (ndInt32 i = 0; i < ndInt32(m_tiles.GetCount()); ++i)
+		{
+			ndTile* const tile = m_tiles[i];
+			if ((tile->m_state == ndTile::m_loaded) && (tile->m_distance > farDistance))
+			{
+				farTile = tile;
+				farDistance = tile->m_distance;
+			}
+		}
+		if (!farTile)
+		{
+			return false;
+		}
+		UnloadTile(farTile);
+		m_statistics.m_evictions++;
+	}
+	return true;
+}
+
+void ndTiledStaticWorld::RequestLoads()
+{
+	class ndCompareKey
+	{
+		public:
+		ndCompareKey(void* const)
+		{
+		}
+
+		ndInt32 Compare(const ndTile* const tileA, const ndTile* const tileB) const
+		{
+			if (tileA->m_distance < tileB->m_distance)
+			{
+				return -1;
+			}
+			else if (tileA->m_distance > tileB->m_distance)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	m_candidates.SetCount(0);
+	for (ndInt32 i = 0; i < ndInt32(m_tiles.GetCount()); ++i)
+	{
+		ndTile* const tile = m_tiles[i];
+		if ((tile->m_state == ndTile::m_unloaded) && (tile->m_distance <= m_loadRadius))
+		{
+			m_candidates.PushBack(tile);
+		}
+	}
+	if (!m_candidates.GetCount())
+	{
+		return;
+	}
+
+	// closest tiles first
+	ndSort<ndTile*, ndCompareKey>(&m_candidates[0], ndInt32(m_candidates.GetCount()), nullptr);
+	for (ndInt32 i = 0; (i < ndInt32(m_candidates.GetCount())) && (m_statistics.m_loadingCount < m_maxLoadsInFlight); ++i)
+	{
+		ndTile* const tile = m_candidates[i];
+		if (!EvictTiles(tile->m_memorySize, tile->m_distance))
+		{
+			// no room left for this tile, farther tiles would take the memory of closer ones
+			break;
+		}
+
+		tile->m_state = ndTile::m_loading;
+		tile->m_requestTime = ndGetTimeInMicroseconds();
+		m_statistics.m_residentMemory += tile->m_memorySize;
+		m_statistics.m_loadingCount++;
+		m_world->SendBackgroundTask(tile);
+	}
+}
+
+void ndTiledStaticWorld::Update()
+{
+	D_TRACKTIME();
+	CalculateTileDistances();
+	InsertLoadedTiles(m_maxInsertions);
+	UnloadFarTiles();
+	RequestLoads();
+}
+
+void ndTiledStaticWorld::Flush()
+{
+	D_TRACKTIME();
+	for (ndInt32 i = 0; i < ndInt32(m_tiles.GetCount()); ++i)
+	{
+		m_tiles[i]->Sync();
+	}
+	InsertLoadedTiles(ndInt32(m_tiles.GetCount()));
+}
@@ -0,0 +1,169 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_TILED_STATIC_WORLD_H__
+#define __ND_TILED_STATIC_WORLD_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+
+// streams the static collision of a large level that is split in tiles.
+// a tile is loaded on the background worker of the scene when a dynamic body
+// gets within the load radius of the tile box, and it is removed from the
+// world when no dynamic body is within the unload radius.
+// completed tiles are added to the world a few at a time, so that a burst of
+// loads does not stall a frame, and the resident memory is capped by a budget.
+class ndTiledStaticWorld: public ndClassAlloc
+{
+	public:
+	// the application implements Load, which runs on the background worker
+	// and returns the static body of the tile, or a null pointer on failure.
+	// memorySize is the application estimate of the memory used by the tile.
+	class ndTile: public ndBackgroundTask
+	{
+		public:
+		enum ndState
+		{
+			m_unloaded,
+			m_loading,
+			m_loaded,
+		};
+
+		D_NEWTON_API ndTile(const ndVector& minBox, const ndVector& maxBox, size_t memorySize);
+		D_NEWTON_API virtual ~ndTile();
+
+		ndState GetState() const;
+		size_t GetMemorySize() const;
+		const ndVector& GetMinBox() const;
+		const ndVector& GetMaxBox() const;
+		const ndSharedPtr<ndBody>& GetBody() const;
+
+		protected:
+		virtual ndSharedPtr<ndBody> Load() = 0;
+
+		private:
+		D_NEWTON_API virtual void Execute(ndThreadPool* const threadPool);
+
+		ndVector m_minBox;
+		ndVector m_maxBox;
+		ndSharedPtr<ndBody> m_body;
+		size_t m_memorySize;
+		ndUnsigned64 m_requestTime;
+		ndUnsigned64 m_loadTime;
+		ndFloat32 m_distance;
+		ndState m_state;
+
+		friend class ndTiledStaticWorld;
+	};
+
+	class ndStatistics
+	{
+		public:
+		ndStatistics();
+
+		size_t m_residentMemory;
+		ndInt32 m_loadedCount;
+		ndInt32 m_loadingCount;
+		ndInt32 m_loadsCompleted;
+		ndInt32 m_unloadsCompleted;
+		ndInt32 m_evictions;
+		// seconds from the load request to the insertion in the world
+		ndFloat32 m_lastLoadLatency;
+		ndFloat32 m_averageLoadLatency;
+		ndFloat32 m_maxLoadLatency;
+		// seconds spent in Load by the background worker
+		ndFloat32 m_averageLoadTime;
+		// seconds spent adding tiles to the world by the last Update
+		ndFloat32 m_lastInsertTime;
+		ndFloat32 m_maxInsertTime;
+	};
+
+	D_NEWTON_API ndTiledStaticWorld(ndWorld* const world);
+	D_NEWTON_API virtual ~ndTiledStaticWorld();
+
+	// the manager takes ownership of the tile
+	D_NEWTON_API void AddTile(ndTile* const tile);
+	D_NEWTON_API ndInt32 GetTileCount() const;
+	D_NEWTON_API ndTile* GetTile(ndInt32 index) const;
+
+	// the unload radius is clamped to be no smaller than the load radius,
+	// the band in between prevents tiles from thrashing at the border.
+	D_NEWTON_API void SetRadius(ndFloat32 loadRadius, ndFloat32 unloadRadius);
+	D_NEWTON_API void SetMemoryBudget(size_t bytes);
+	D_NEWTON_API void SetMaxInsertionsPerUpdate(ndInt32 count);
+	D_NEWTON_API void SetMaxLoadsInFlight(ndInt32 count);
+
+	D_NEWTON_API const ndStatistics& GetStatistics() const;
+
+	// must be called from the application thread between world updates,
+	// after ndWorld::Sync
+	D_NEWTON_API void Update();
+
+	// wait for all the loads in flight and add them to the world
+	D_NEWTON_API void Flush();
+
+	private:
+	void CalculateTileDistances();
+	void InsertLoadedTiles(ndInt32 maxCount);
+	void UnloadFarTiles();
+	void RequestLoads();
+	void UnloadTile(ndTile* const tile);
+	bool EvictTiles(size_t bytes, ndFloat32 distance);
+
+	ndWorld* m_world;
+	ndArray<ndTile*> m_tiles;
+	ndArray<ndVector> m_focusPoints;
+	ndArray<ndTile*> m_candidates;
+	ndStatistics m_statistics;
+	size_t m_memoryBudget;
+	ndFloat32 m_loadRadius;
+	ndFloat32 m_unloadRadius;
+	ndInt32 m_maxInsertions;
+	ndInt32 m_maxLoadsInFlight;
+};
+
+inline ndTiledStaticWorld::ndTile::ndState ndTiledStaticWorld::ndTile::GetState() const
+{
+	return m_state;
+}
+
+inline size_t ndTiledStaticWorld::ndTile::GetMemorySize() const
+{
+	return m_memorySize;
+}
+
+inline const ndVector& ndTiledStaticWorld::ndTile::GetMinBox() const
+{
+	return m_minBox;
+}
+
+inline const ndVector& ndTiledStaticWorld::ndTile::GetMaxBox() const
+{
+	return m_maxBox;
+}
+
+inline const ndSharedPtr<ndBody>& ndTiledStaticWorld::ndTile::GetBody() const
+{
+	return m_body;
+}
+
+#endif
@@ -112,6 +112,7 @@ ndWorld::ndWorld()
 	,m_averageTimestepAcc(ndFloat32(0.0f))
 	,m_averageFramesCount(ndFloat32(0.0f))
 	,m_lastExecutionTime(ndFloat32(0.0f))
+	,m_frameStateHash(0)
 	,m_subSteps(1)
 	,m_solverMode(ndStandardSolver)
 	,m_solverIterations(4)
@@ -165,6 +166,8 @@ ndWorld::~ndWorld()
 void ndWorld::CleanUp()
 {
 	Sync();
+	// bodies and joints removed since the last update are still in the deferred lists
+	DeleteDeferredObjects();
 	//m_scene->m_backgroundThread.Terminate();
 	m_scene->PrepareCleanup();
 
@@ -233,8 +236,12 @@ void ndWorld::SetThreadCount(ndInt32 count)
 
 	if (m_scene->m_backgroundThread)
 	{
+		// a terminated worker does not restart, so it is deleted here, after it runs
+		// the queued tasks, and the scene creates a new one with the new thread count
+		// the next time a background task is sent.
 		m_scene->m_backgroundThread->Terminate();
-		m_scene->m_backgroundThread->SetThreadCount(count);
+		delete m_scene->m_backgroundThread;
+		m_scene->m_backgroundThread = nullptr;
 	}
 }
 
@@ -263,6 +270,39 @@ void ndWorld::SetSolverIterations(ndInt32 iterations)
 	m_solverIterations = ndInt32(ndMax(4, iterations));
 }
 
+bool ndWorld::IsDeterministic() const
+{
+	return m_scene->IsDeterministic();
+}
+
+void ndWorld::SetDeterministic(bool state)
+{
+	m_scene->SetDeterministic(state);
+}
+
+ndUnsigned64 ndWorld::GetFrameStateHash() const
+{
+	return m_frameStateHash;
+}
+
+ndUnsigned64 ndWorld::CalculateStateHash() const
+{
+	// crc of the state of all bodies, in body list order.
+	ndUnsigned64 hash = 0;
+	const ndBodyListView& bodyList = m_scene->GetBodyList();
+	for (ndBodyListView::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndBodyKinematic* const body = node->GetInfo()->GetAsBodyKinematic();
+		const ndMatrix& matrix = body->GetMatrix();
+		const ndVector veloc(body->GetVelocity());
+		const ndVector omega(body->GetOmega());
+		hash = ndCRC64(&matrix[0][0], ndInt32(sizeof(ndMatrix)), hash);
+		hash = ndCRC64(&veloc[0], ndInt32(sizeof(ndVector)), hash);
+		hash = ndCRC64(&omega[0], ndInt32(sizeof(ndVector)), hash);
+	}
+	return hash;
+}
+
 ndContactNotify* ndWorld::GetContactNotify() const
 {
 	return m_scene->GetContactNotify();
@@ -518,6 +558,11 @@ void ndWorld::ThreadFunction()
 	UpdateTransforms();
 	PostModelTransform();
 	PostUpdate(m_timestep);
+
+	if (m_scene->IsDeterministic())
+	{
+		m_frameStateHash = CalculateStateHash();
+	}
 	m_inUpdate = false;
 
 	m_scene->End();
@@ -526,6 +571,16 @@ void ndWorld::ThreadFunction()
 	CalculateAverageUpdateTime();
 }
 
+ndFrameArena& ndWorld::GetFrameArena()
+{
+	return m_scene->GetFrameArena();
+}
+
+void ndWorld::SetFrameArenaTrimPolicy(ndInt32 framesCount)
+{
+	m_scene->GetFrameArena().SetTrimPolicy(framesCount);
+}
+
 void ndWorld::CalculateAverageUpdateTime()
 {
 	m_averageFramesCount += ndFloat32 (1.0f);
@@ -546,6 +601,9 @@ void ndWorld::SubStepUpdate(ndFloat32 timestep)
 {
 	D_TRACKTIME();
 
+	// transient buffers only live for one step
+	m_scene->GetFrameArena().Reset();
+
 	// do physics step
 	OnSubStepPreUpdate(timestep);
 
@@ -743,8 +801,7 @@ void ndWorld::UpdateSkeletons()
 	
 		// find all root nodes for all independent joint arrangements
 		ndInt32 inslandCount = 0;
-		solverUpdate.m_leftHandSide.SetCount(ndMax(ndInt32 (bodyArray.GetCount()) + 256, 1024));
-		ndIslandMember* const islands = (ndIslandMember*)&solverUpdate.m_leftHandSide[0];
+		ndIslandMember* const islands = m_scene->GetFrameArena().Alloc<ndIslandMember>(bodyArray.GetCount());
 		for (ndInt32 i = 0; i < bodyArray.GetCount(); ++i)
 		{
 			ndBodyKinematic* const body = bodyArray[i];
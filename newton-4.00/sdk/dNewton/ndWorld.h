@@ -101,7 +101,16 @@ class ndWorld: public ndClassAlloc
 
 	D_NEWTON_API ndInt32 GetSolverIterations() const;
 	D_NEWTON_API void SetSolverIterations(ndInt32 iterations);
+
+	D_NEWTON_API bool IsDeterministic() const;
+	D_NEWTON_API void SetDeterministic(bool state);
+
+	D_NEWTON_API ndUnsigned64 GetFrameStateHash() const;
+	D_NEWTON_API ndUnsigned64 CalculateStateHash() const;
 	
+	D_NEWTON_API ndFrameArena& GetFrameArena();
+	D_NEWTON_API void SetFrameArenaTrimPolicy(ndInt32 framesCount);
+
 	D_NEWTON_API ndFloat32 GetUpdateTime() const;
 	D_NEWTON_API ndUnsigned32 GetFrameNumber() const;
 	D_NEWTON_API ndUnsigned32 GetSubFrameNumber() const;
@@ -183,6 +192,7 @@ class ndWorld: public ndClassAlloc
 	ndFloat32 m_averageFramesCount;
 	ndFloat32 m_lastExecutionTime;
 	dgSolverProgressiveSleepEntry m_sleepTable[D_SLEEP_ENTRIES];
+	ndUnsigned64 m_frameStateHash;
 
 	ndInt32 m_subSteps;
 	ndSolverModes m_solverMode;
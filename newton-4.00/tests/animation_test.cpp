@@ -0,0 +1,78 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include "ndModelInc.h"
+#include <gtest/gtest.h>
+
+class ndTestSequence: public ndAnimationSequence
+{
+	public:
+	ndTestSequence(ndFloat32 duration)
+		:ndAnimationSequence()
+	{
+		m_duration = duration;
+	}
+};
+
+/* The baked sequence must reproduce the source poses at any time,
+ * including the last frame interval when the duration is not a multiple
+ * of the frame period. */
+TEST(Animation, BakedSequenceMatchesSource)
+{
+	const ndInt32 boneCount = 5;
+	const ndFloat32 duration = ndFloat32(1.05f);
+	ndTestSequence source(duration);
+
+	// dense keys of a constant speed motion, so the resampling is exact
+	// and only the quantization and the baked frame times show in the error
+	const ndInt32 keyCount = 43;
+	for (ndInt32 i = 0; i < boneCount; ++i)
+	{
+		ndAnimationKeyFramesTrack* const track = source.AddTrack();
+		track->SetName("bone");
+		for (ndInt32 j = 0; j < keyCount; ++j)
+		{
+			const ndFloat32 time = duration * ndFloat32(j) / ndFloat32(keyCount - 1);
+			const ndFloat32 speed = ndFloat32(i + 1);
+			track->m_position.PushBack(ndVector(speed * time, ndFloat32(i), -speed * time, ndFloat32(1.0f)));
+			track->m_position.m_time.PushBack(time);
+			track->m_rotation.PushBack(ndQuaternion(ndVector(ndFloat32(0.0f), ndFloat32(1.0f), ndFloat32(0.0f), ndFloat32(0.0f)), time * ndFloat32(0.5f)));
+			track->m_rotation.m_time.PushBack(time);
+		}
+	}
+
+	const ndAnimationBakedSequence baked(source, ndFloat32(30.0f));
+	EXPECT_EQ(baked.GetBoneCount(), boneCount);
+	EXPECT_FLOAT_EQ(ndFloat32(baked.GetFrameCount() - 1) / baked.GetFramesPerSecond(), duration);
+
+	ndAnimationPose sourcePose;
+	ndAnimationPose bakedPose;
+	sourcePose.SetCount(boneCount);
+	bakedPose.SetCount(boneCount);
+
+	ndSetRandSeed(42);
+	const ndInt32 sampleCount = 256;
+	for (ndInt32 i = 0; i < sampleCount; ++i)
+	{
+		// the last few samples land in the final frame interval
+		const ndFloat32 time = (i < sampleCount - 8) ? ndRand() * duration : duration - ndFloat32(i - sampleCount + 9) * ndFloat32(0.003f);
+		source.CalculatePose(sourcePose, time);
+		baked.CalculatePose(bakedPose, time);
+		for (ndInt32 j = 0; j < boneCount; ++j)
+		{
+			const ndVector error(sourcePose[j].m_posit - bakedPose[j].m_posit);
+			EXPECT_LT(ndSqrt(error.DotProduct(error & ndVector::m_triplexMask).GetScalar()), ndFloat32(1.0e-3f));
+			const ndFloat32 dot = ndAbs(sourcePose[j].m_rotation.DotProduct(bakedPose[j].m_rotation).GetScalar());
+			EXPECT_GT(dot, ndFloat32(0.9999f));
+		}
+	}
+}
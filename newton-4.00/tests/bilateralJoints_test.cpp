@@ -81,3 +81,125 @@ TEST(BilateralJoints, CreateWorld)
 	world->CleanUp();
 	delete world;
 }
+
+static ndIkJointHinge* AddIkHingeLink(ndWorld* const world, const ndShapeInstance& shape, ndBodyKinematic* const parent, ndFloat32 length)
+{
+	ndMatrix matrix(parent->GetMatrix());
+	matrix.m_posit.m_y -= length;
+
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetCollisionShape(shape);
+	body->SetMatrix(matrix);
+	body->SetMassMatrix(1, shape);
+	ndSharedPtr<ndBody> bodyPtr(body);
+	world->AddBody(bodyPtr);
+
+	ndMatrix pivot(ndGetIdentityMatrix());
+	pivot.m_posit = parent->GetMatrix().m_posit;
+	ndIkJointHinge* const hinge = new ndIkJointHinge(pivot, body, parent);
+	ndSharedPtr<ndJointBilateralConstraint> hingePtr(hinge);
+	world->AddJoint(hingePtr);
+	return hinge;
+}
+
+TEST(BilateralJoints, IkBatchSolverMatchesIkSolver)
+{
+	ndWorld* world = new ndWorld();
+	world->SetThreadCount(4);
+	ndShapeInstance shape(new ndShapeSphere(0.25));
+
+	// rigs with one and two links interleaved, so that the batch reorders them by topology
+	const ndInt32 rigCount = 6;
+	ndBodyDynamic* roots[rigCount];
+	ndIkJointHinge* hinges[rigCount][2];
+	ndIk6DofEffector* effectors[rigCount];
+	ndSharedPtr<ndJointBilateralConstraint> effectorPtrs[rigCount];
+	for (ndInt32 i = 0; i < rigCount; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32(i) * ndFloat32(4.0f);
+		matrix.m_posit.m_y = ndFloat32(4.0f);
+
+		roots[i] = new ndBodyDynamic();
+		roots[i]->SetCollisionShape(shape);
+		roots[i]->SetMatrix(matrix);
+		roots[i]->SetMassMatrix(10, shape);
+		ndSharedPtr<ndBody> rootPtr(roots[i]);
+		world->AddBody(rootPtr);
+
+		ndBodyKinematic* parent = roots[i];
+		hinges[i][1] = nullptr;
+		for (ndInt32 j = 0; j < (i & 1) + 1; ++j)
+		{
+			hinges[i][j] = AddIkHingeLink(world, shape, parent, ndFloat32(1.0f));
+			parent = hinges[i][j]->GetBody0();
+		}
+
+		// the effector pulls the tip toward a different target on each rig
+		ndMatrix tipFrame(ndGetIdentityMatrix());
+		tipFrame.m_posit = parent->GetMatrix().m_posit;
+		effectors[i] = new ndIk6DofEffector(tipFrame, roots[i]->GetMatrix(), parent, roots[i]);
+		effectors[i]->EnableRotationAxis(ndIk6DofEffector::m_disabled);
+		ndMatrix target(effectors[i]->GetOffsetMatrix());
+		target.m_posit.m_x += ndFloat32(0.1f) * ndFloat32(i + 1);
+		effectors[i]->SetOffsetMatrix(target);
+		effectors[i]->SetLinearSpringDamper(ndFloat32(1.0e-3f), ndFloat32(2000.0f), ndFloat32(50.0f));
+		effectorPtrs[i] = ndSharedPtr<ndJointBilateralConstraint>(effectors[i]);
+	}
+
+	// build the skeletons
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+	world->Update(timestep);
+	world->Sync();
+
+	ndJacobian expected[rigCount][2][2];
+	for (ndInt32 i = 0; i < rigCount; ++i)
+	{
+		ndSkeletonContainer* const skeleton = roots[i]->GetSkeleton();
+		ASSERT_TRUE(skeleton != nullptr);
+
+		ndIkSolver solver;
+		ndJointBilateralConstraint* const effector = effectors[i];
+		solver.SolverBegin(skeleton, &effector, 1, world, timestep);
+		solver.Solve();
+		solver.SolverEnd();
+		for (ndInt32 j = 0; (j < 2) && hinges[i][j]; ++j)
+		{
+			expected[i][j][0] = hinges[i][j]->m_accel0;
+			expected[i][j][1] = hinges[i][j]->m_accel1;
+			hinges[i][j]->m_accel0.m_linear = ndVector::m_zero;
+			hinges[i][j]->m_accel0.m_angular = ndVector::m_zero;
+			hinges[i][j]->m_accel1.m_linear = ndVector::m_zero;
+			hinges[i][j]->m_accel1.m_angular = ndVector::m_zero;
+		}
+	}
+
+	// the effector arrays are owned by the caller and must outlive Solve
+	ndJointBilateralConstraint* effectorArrays[rigCount];
+	ndIkBatchSolver batch;
+	for (ndInt32 i = 0; i < rigCount; ++i)
+	{
+		effectorArrays[i] = effectors[i];
+		batch.AddRequest(roots[i]->GetSkeleton(), &effectorArrays[i], 1);
+	}
+	batch.Solve(world, timestep);
+
+	for (ndInt32 i = 0; i < rigCount; ++i)
+	{
+		for (ndInt32 j = 0; (j < 2) && hinges[i][j]; ++j)
+		{
+			for (ndInt32 k = 0; k < 3; ++k)
+			{
+				EXPECT_NEAR(hinges[i][j]->m_accel0.m_linear[k], expected[i][j][0].m_linear[k], 1.0e-4f);
+				EXPECT_NEAR(hinges[i][j]->m_accel0.m_angular[k], expected[i][j][0].m_angular[k], 1.0e-4f);
+				EXPECT_NEAR(hinges[i][j]->m_accel1.m_linear[k], expected[i][j][1].m_linear[k], 1.0e-4f);
+				EXPECT_NEAR(hinges[i][j]->m_accel1.m_angular[k], expected[i][j][1].m_angular[k], 1.0e-4f);
+			}
+		}
+	}
+	// the targets differ, so the rigs must not all produce the same answer
+	EXPECT_GT(ndAbs(expected[1][0][0].m_linear.m_x - expected[3][0][0].m_linear.m_x), ndFloat32(1.0e-3f));
+
+	world->CleanUp();
+	delete world;
+}
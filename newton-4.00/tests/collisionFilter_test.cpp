@@ -0,0 +1,78 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Collision layers: bodies whose category is not in the other body mask never make contacts. */
+TEST(CollisionFilter, CollisionLayers)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+
+	ndShapeInstance floorShape(new ndShapeBox(ndFloat32(40.0f), ndFloat32(1.0f), ndFloat32(40.0f)));
+	ndBodyKinematic* const floor = new ndBodyKinematic();
+	floor->SetCollisionShape(floorShape);
+	floor->SetMatrix(ndGetIdentityMatrix());
+	floor->SetCollisionLayers(1 << 0, ~ndUnsigned32(1 << 1));
+	world.AddBody(ndSharedPtr<ndBody>(floor));
+
+	ndShapeInstance boxShape(new ndShapeBox(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f)));
+	ndBodyDynamic* boxes[2];
+	for (ndInt32 i = 0; i < 2; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32(i * 2);
+		matrix.m_posit.m_y = ndFloat32(1.0f);
+
+		ndBodyDynamic* const box = new ndBodyDynamic();
+		box->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+		box->SetCollisionShape(boxShape);
+		box->SetMatrix(matrix);
+		box->SetMassMatrix(ndFloat32(1.0f), boxShape);
+		box->SetCollisionLayers(ndUnsigned32(1 << (i + 1)), ~ndUnsigned32(0));
+		world.AddBody(ndSharedPtr<ndBody>(box));
+		boxes[i] = box;
+	}
+
+	for (ndInt32 i = 0; i < 60; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+
+	// layer 2 collides with the floor, layer 1 is filtered out and falls through
+	EXPECT_GT(boxes[1]->GetMatrix().m_posit.m_y, ndFloat32(0.0f));
+	EXPECT_LT(boxes[0]->GetMatrix().m_posit.m_y, ndFloat32(0.0f));
+	world.CleanUp();
+}
+
+/* Material pair table: pairs in the table resolve without the virtual GetMaterial call. */
+TEST(CollisionFilter, MaterialPairTable)
+{
+	ndContactNotify notify(nullptr);
+	ndMaterial material;
+	material.m_restitution = ndFloat32(0.0f);
+
+	ndShapeInstance shape0(new ndShapeBox(ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f)));
+	ndShapeInstance shape1(new ndShapeBox(ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f)));
+	shape0.m_shapeMaterial.m_userId = 2;
+	shape1.m_shapeMaterial.m_userId = 5;
+
+	ndMaterial* const defaultMaterial = notify.FindMaterial(nullptr, shape0, shape1);
+	notify.GetMaterialPairTable().SetMaterial(5, 2, &material);
+	EXPECT_EQ(notify.GetMaterialPairTable().GetCount(), 6);
+	EXPECT_EQ(notify.FindMaterial(nullptr, shape0, shape1), &material);
+	EXPECT_EQ(notify.FindMaterial(nullptr, shape1, shape0), &material);
+
+	notify.GetMaterialPairTable().SetOverride(2, 5, true);
+	EXPECT_EQ(notify.FindMaterial(nullptr, shape0, shape1), defaultMaterial);
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include <vector>
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Convex hulls: every input point is inside the hull, the face tests take the float fast path on most points. */
+TEST(ConvexHull, ContainsPoints)
+{
+	const ndInt32 hullCount = 96;
+	const ndInt32 pointsPerHull = 200;
+	ndSetRandSeed(12345);
+	std::vector<ndBigVector> points(hullCount * pointsPerHull);
+	for (ndInt32 i = 0; i < hullCount; ++i)
+	{
+		for (ndInt32 j = 0; j < pointsPerHull; ++j)
+		{
+			ndBigVector& p = points[i * pointsPerHull + j];
+			if (i & 1)
+			{
+				// points on a coarse lattice, lots of coplanar faces for the exact fallback
+				p = ndBigVector(ndFloat64(ndRandInt() % 5), ndFloat64(ndRandInt() % 5), ndFloat64(ndRandInt() % 5), ndFloat64(0.0f));
+			}
+			else
+			{
+				p = ndBigVector(ndRand() - 0.5f, ndRand() - 0.5f, ndRand() - 0.5f, 0.0f).Scale(ndFloat64(i + 1));
+			}
+		}
+	}
+
+	for (ndInt32 i = 0; i < hullCount; ++i)
+	{
+		const ndConvexHull3d hull(&points[i * pointsPerHull].m_x, sizeof(ndBigVector), pointsPerHull, 0.0);
+		ASSERT_GE(hull.GetCount(), 4);
+
+		const ndArray<ndBigVector>& vertex = hull.GetVertexPool();
+		const ndFloat64 tol = hull.GetDiagonal() * 1.0e-6;
+		for (ndConvexHull3d::ndNode* node = hull.GetFirst(); node; node = node->GetNext())
+		{
+			const ndConvexHull3dFace& face = node->GetInfo();
+			const ndBigVector& p0 = vertex[face.m_index[0]];
+			const ndBigVector normal((vertex[face.m_index[1]] - p0).CrossProduct(vertex[face.m_index[2]] - p0));
+			const ndFloat64 mag = sqrt(normal.DotProduct(normal).GetScalar());
+			for (ndInt32 j = 0; j < pointsPerHull; ++j)
+			{
+				const ndFloat64 dist = normal.DotProduct(points[i * pointsPerHull + j] - p0).GetScalar();
+				EXPECT_LE(dist, tol * mag);
+			}
+		}
+	}
+}
+
+/* Convex hull face test: the sign of the orientation test matches the exact determinant on nearly coplanar points. */
+TEST(ConvexHull, FaceSignMatchesExact)
+{
+	ndSetRandSeed(2468);
+	ndConvexHull3dFace face;
+	face.m_index[0] = 0;
+	face.m_index[1] = 1;
+	face.m_index[2] = 2;
+
+	ndInt32 positives = 0;
+	ndInt32 negatives = 0;
+	for (ndInt32 i = 0; i < 400; ++i)
+	{
+		const ndFloat64 scale = (i & 1) ? 1000.0 : 1.0;
+		ndBigVector triangle[3];
+		for (ndInt32 j = 0; j < 3; ++j)
+		{
+			triangle[j] = ndBigVector(ndRand() - 0.5f, ndRand() - 0.5f, ndRand() - 0.5f, 0.0f).Scale(scale);
+		}
+		const ndBigVector e0(triangle[1] - triangle[0]);
+		const ndBigVector e1(triangle[2] - triangle[0]);
+		ndBigVector normal(e0.CrossProduct(e1));
+		normal = normal.Scale(1.0 / sqrt(normal.DotProduct(normal).GetScalar()));
+
+		// offsets from well above to well below the float rounding of the products
+		for (ndInt32 k = 0; k <= 16; ++k)
+		{
+			const ndFloat64 offset = (k == 16) ? 0.0 : scale * pow(10.0, -ndFloat64(k + 1)) * ((k & 1) ? 1.0 : -1.0);
+			const ndBigVector point(triangle[0] + e0.Scale(ndRand()) + e1.Scale(ndRand()) + normal.Scale(offset));
+
+			ndGoogol exactMatrix[3][3];
+			for (ndInt32 j = 0; j < 3; ++j)
+			{
+				exactMatrix[0][j] = ndGoogol(triangle[2][j]) - ndGoogol(triangle[0][j]);
+				exactMatrix[1][j] = ndGoogol(triangle[1][j]) - ndGoogol(triangle[0][j]);
+				exactMatrix[2][j] = ndGoogol(point[j]) - ndGoogol(triangle[0][j]);
+			}
+			const ndFloat64 exact = Determinant3x3(exactMatrix);
+			const ndFloat64 value = face.Evalue(triangle, point);
+			const ndInt32 exactSign = (exact > 0.0) ? 1 : ((exact < 0.0) ? -1 : 0);
+			const ndInt32 valueSign = (value > 0.0) ? 1 : ((value < 0.0) ? -1 : 0);
+			EXPECT_EQ(valueSign, exactSign) << "triangle " << i << " offset " << offset;
+			positives += (exactSign > 0) ? 1 : 0;
+			negatives += (exactSign < 0) ? 1 : 0;
+		}
+	}
+	EXPECT_GT(positives, 1000);
+	EXPECT_GT(negatives, 1000);
+}
@@ -0,0 +1,129 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include <string>
+#include <algorithm>
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Fracture asset: the baked pieces tile the box, a saved asset loads back with shared piece shapes, and corrupted files are rejected. */
+TEST(FractureAsset, BakeAndLoad)
+{
+	ndWorld world;
+	world.SetThreadCount(4);
+	ndShapeInstance box(new ndShapeBox(2.0f, 2.0f, 2.0f));
+
+	ndFractureAsset::ndDesc desc;
+	ndSetRandSeed(2024);
+	for (ndInt32 i = 0; i < 64; ++i)
+	{
+		desc.m_pointCloud.PushBack(ndVector(ndRand() * 1.8f - 0.9f, ndRand() * 1.8f - 0.9f, ndRand() * 1.8f - 0.9f, 0.0f));
+	}
+	desc.m_outerShape = &box;
+	desc.m_threadPool = world.GetScene();
+
+	ndFractureAsset asset;
+	ASSERT_TRUE(asset.Build(desc));
+
+	const ndInt32 pieceCount = asset.GetPieceCount();
+	EXPECT_GT(pieceCount, 1);
+	ndFloat32 volume = 0.0f;
+	ndFloat32 massFraction = 0.0f;
+	for (ndInt32 i = 0; i < pieceCount; ++i)
+	{
+		const ndFractureAsset::ndPiece& piece = asset.GetPiece(i);
+		volume += piece.m_volume;
+		massFraction += piece.m_massFraction;
+		EXPECT_GE(piece.m_hullPointCount, 4);
+		EXPECT_GT(piece.m_outerIndexCount + piece.m_innerIndexCount, 0);
+		// every cell of a partition of a solid has a cut face and touches another cell
+		EXPECT_GT(piece.m_innerIndexCount, 0);
+		EXPECT_GT(piece.m_neighborCount, 0);
+		const ndInt32* const neighbors = asset.GetNeighbors(i);
+		for (ndInt32 j = 0; j < piece.m_neighborCount; ++j)
+		{
+			const ndFractureAsset::ndPiece& other = asset.GetPiece(neighbors[j]);
+			const ndInt32* const otherNeighbors = asset.GetNeighbors(neighbors[j]);
+			EXPECT_NE(std::find(otherNeighbors, otherNeighbors + other.m_neighborCount, i), otherNeighbors + other.m_neighborCount);
+		}
+	}
+	EXPECT_NEAR(volume, 8.0f, 1.0e-2f);
+	EXPECT_NEAR(massFraction, 1.0f, 1.0e-4f);
+
+	const std::string path(testing::TempDir() + "fractureBox.frac");
+	ASSERT_TRUE(asset.Save(path.c_str()));
+
+	ndFractureAsset loaded;
+	ASSERT_TRUE(loaded.Load(path.c_str(), world.GetScene()));
+
+	ASSERT_EQ(loaded.GetPieceCount(), pieceCount);
+	for (ndInt32 i = 0; i < pieceCount; ++i)
+	{
+		const ndFractureAsset::ndPiece& piece = asset.GetPiece(i);
+		const ndFractureAsset::ndPiece& loadedPiece = loaded.GetPiece(i);
+		EXPECT_EQ(loadedPiece.m_vertexCount, piece.m_vertexCount);
+		EXPECT_EQ(loadedPiece.m_neighborCount, piece.m_neighborCount);
+		EXPECT_EQ(memcmp(loaded.GetIndices(i), asset.GetIndices(i), size_t(piece.m_outerIndexCount + piece.m_innerIndexCount) * sizeof(ndUnsigned16)), 0);
+
+		ndShapeInstance* const instance0 = loaded.CreatePieceInstance(i);
+		ndShapeInstance* const instance1 = loaded.CreatePieceInstance(i);
+		EXPECT_EQ(instance0->GetShape(), instance1->GetShape());
+		EXPECT_EQ(instance0->GetShape(), loaded.GetPieceShape(i));
+		EXPECT_NEAR(instance0->GetVolume(), piece.m_volume, 1.0e-4f);
+		delete instance0;
+		delete instance1;
+	}
+
+	// the neighbors are the last section and the indices come right before them
+	ndInt32 neighborCount = 0;
+	for (ndInt32 i = 0; i < pieceCount; ++i)
+	{
+		neighborCount += asset.GetPiece(i).m_neighborCount;
+	}
+	const ndInt32 badNeighbor = pieceCount;
+	FILE* file = fopen(path.c_str(), "r+b");
+	ASSERT_TRUE(file != nullptr);
+	fseek(file, -long(sizeof(ndInt32)), SEEK_END);
+	fwrite(&badNeighbor, sizeof(ndInt32), 1, file);
+	fclose(file);
+	EXPECT_FALSE(loaded.Load(path.c_str()));
+	EXPECT_EQ(loaded.GetPieceCount(), 0);
+
+	ASSERT_TRUE(asset.Save(path.c_str()));
+	const ndUnsigned16 badIndex = 0xffff;
+	file = fopen(path.c_str(), "r+b");
+	ASSERT_TRUE(file != nullptr);
+	fseek(file, -long(neighborCount * sizeof(ndInt32) + sizeof(ndUnsigned16)), SEEK_END);
+	fwrite(&badIndex, sizeof(ndUnsigned16), 1, file);
+	fclose(file);
+	EXPECT_FALSE(loaded.Load(path.c_str()));
+	EXPECT_EQ(loaded.GetPieceCount(), 0);
+
+	// a vertex count larger than the file is rejected before the section is allocated,
+	// the counts follow the 8 byte id and the two record sizes
+	ASSERT_TRUE(asset.Save(path.c_str()));
+	const ndInt32 hugeCount = 0x7fffffff;
+	file = fopen(path.c_str(), "r+b");
+	ASSERT_TRUE(file != nullptr);
+	fseek(file, long(8 + 4 * sizeof(ndInt32)), SEEK_SET);
+	fwrite(&hugeCount, sizeof(ndInt32), 1, file);
+	fclose(file);
+	EXPECT_FALSE(loaded.Load(path.c_str()));
+	EXPECT_EQ(loaded.GetPieceCount(), 0);
+	remove(path.c_str());
+
+	const std::string badDirectory(testing::TempDir() + "fractureMissingDir/fractureBox.frac");
+	EXPECT_FALSE(asset.Save(badDirectory.c_str()));
+
+	const std::string badPath(testing::TempDir() + "fractureMissing.frac");
+	EXPECT_FALSE(loaded.Load(badPath.c_str()));
+	EXPECT_EQ(loaded.GetPieceCount(), 0);
+}
@@ -0,0 +1,85 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Free list allocator: thread magazines, statistics and flush. */
+class ndTestFreeListObject : public ndContainersFreeListAlloc<ndTestFreeListObject>
+{
+	public:
+	char m_data[1500];
+};
+
+static ndFreeListStatistics FindFreeListStatistics(ndInt32 chunkSize)
+{
+	ndFreeListStatistics stats[128];
+	const ndInt32 count = ndFreeListAlloc::GetStatistics(stats, 128);
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		if (stats[i].m_chunkSize == chunkSize)
+		{
+			return stats[i];
+		}
+	}
+	ndFreeListStatistics empty;
+	memset(&empty, 0, sizeof(empty));
+	empty.m_chunkSize = chunkSize;
+	return empty;
+}
+
+TEST(FreeListAlloc, StatisticsAndFlush)
+{
+	const ndInt32 chunkSize = ndInt32(ndMemory::CalculateBufferSize(sizeof(ndTestFreeListObject)));
+	const ndInt32 objectCount = 100;
+	ndTestFreeListObject* objects[objectCount];
+
+	ndFreeListAlloc::Flush();
+	const ndFreeListStatistics start(FindFreeListStatistics(chunkSize));
+	EXPECT_EQ(start.m_sharedCount, 0);
+	EXPECT_EQ(start.m_cachedCount, 0);
+
+	for (ndInt32 i = 0; i < objectCount; ++i)
+	{
+		objects[i] = new ndTestFreeListObject;
+	}
+	for (ndInt32 i = 0; i < objectCount; ++i)
+	{
+		delete objects[i];
+	}
+
+	// every freed chunk is either in this thread magazine or in the shared list,
+	// and the full magazine handed batches back to the shared list
+	const ndFreeListStatistics freed(FindFreeListStatistics(chunkSize));
+	EXPECT_EQ(freed.m_allocations - start.m_allocations, ndUnsigned64(objectCount));
+	EXPECT_EQ(freed.m_cachedCount + freed.m_sharedCount, objectCount);
+	EXPECT_GT(freed.m_returns, ndUnsigned64(0));
+
+	// allocating again reuses the cached chunks and refills from the shared list
+	for (ndInt32 i = 0; i < objectCount; ++i)
+	{
+		objects[i] = new ndTestFreeListObject;
+	}
+	const ndFreeListStatistics reused(FindFreeListStatistics(chunkSize));
+	EXPECT_EQ(reused.m_allocations - start.m_allocations, ndUnsigned64(2 * objectCount));
+	EXPECT_GT(reused.m_cacheHits, freed.m_cacheHits);
+	EXPECT_GT(reused.m_refills, ndUnsigned64(0));
+	EXPECT_EQ(reused.m_cachedCount + reused.m_sharedCount, 0);
+
+	for (ndInt32 i = 0; i < objectCount; ++i)
+	{
+		delete objects[i];
+	}
+	ndFreeListAlloc::Flush();
+	const ndFreeListStatistics flushed(FindFreeListStatistics(chunkSize));
+	EXPECT_EQ(flushed.m_sharedCount, 0);
+	EXPECT_EQ(flushed.m_cachedCount, 0);
+}
@@ -0,0 +1,108 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include "ndBrainInc.h"
+#include <gtest/gtest.h>
+
+// run a batch of random inputs through the brain and the fused plan
+static void CompareFusedPrediction(const ndBrain& brain, ndInt32 expectedFusedSteps)
+{
+	ndBrainFusedInference fused(brain);
+	ASSERT_EQ(fused.GetInputSize(), brain.GetInputSize());
+	ASSERT_EQ(fused.GetOutputSize(), brain.GetOutputSize());
+	EXPECT_EQ(fused.GetFusedStepsCount(), expectedFusedSteps);
+
+	ndBrainVector input;
+	ndBrainVector output;
+	ndBrainVector fusedOutput;
+	ndBrainVector workingBuffer;
+	input.SetCount(brain.GetInputSize());
+	output.SetCount(brain.GetOutputSize());
+	fusedOutput.SetCount(brain.GetOutputSize());
+	for (ndInt32 i = 0; i < 16; ++i)
+	{
+		for (ndInt32 j = 0; j < input.GetCount(); ++j)
+		{
+			input[j] = ndBrainFloat(ndGaussianRandom(ndFloat32(0.0f), ndFloat32(1.0f)));
+		}
+		brain.MakePrediction(input, output);
+
+		// both the alloca and the caller working buffer paths
+		fused.MakePrediction(input, fusedOutput);
+		for (ndInt32 j = 0; j < output.GetCount(); ++j)
+		{
+			EXPECT_NEAR(fusedOutput[j], output[j], ndBrainFloat(1.0e-6f));
+		}
+		fused.MakePrediction(input, fusedOutput, workingBuffer);
+		for (ndInt32 j = 0; j < output.GetCount(); ++j)
+		{
+			EXPECT_NEAR(fusedOutput[j], output[j], ndBrainFloat(1.0e-6f));
+		}
+	}
+}
+
+TEST(FusedInference, LinearRelu)
+{
+	ndSetRandSeed(42);
+	ndBrain brain;
+	brain.AddLayer(new ndBrainLayerLinear(13, 150));
+	brain.AddLayer(new ndBrainLayerActivationRelu(150));
+	brain.AddLayer(new ndBrainLayerLinear(150, 9));
+	brain.AddLayer(new ndBrainLayerActivationRelu(9));
+	brain.InitWeights();
+	CompareFusedPrediction(brain, 2);
+}
+
+TEST(FusedInference, LinearTanh)
+{
+	ndSetRandSeed(43);
+	ndBrain brain;
+	brain.AddLayer(new ndBrainLayerLinear(21, 70));
+	brain.AddLayer(new ndBrainLayerActivationTanh(70));
+	brain.AddLayer(new ndBrainLayerLinear(70, 70));
+	brain.AddLayer(new ndBrainLayerActivationTanh(70));
+	brain.AddLayer(new ndBrainLayerLinear(70, 5));
+	brain.AddLayer(new ndBrainLayerActivationTanh(5));
+	brain.InitWeights();
+	CompareFusedPrediction(brain, 3);
+}
+
+TEST(FusedInference, LinearSigmoid)
+{
+	ndSetRandSeed(44);
+	ndBrain brain;
+	brain.AddLayer(new ndBrainLayerLinear(8, 65));
+	brain.AddLayer(new ndBrainLayerActivationSigmoid(65));
+	brain.AddLayer(new ndBrainLayerLinear(65, 3));
+	brain.AddLayer(new ndBrainLayerActivationSigmoid(3));
+	brain.InitWeights();
+	CompareFusedPrediction(brain, 2);
+}
+
+TEST(FusedInference, MixedStack)
+{
+	// the last linear layer has no activation and runs unfused
+	ndSetRandSeed(45);
+	ndBrain brain;
+	brain.AddLayer(new ndBrainLayerLinear(10, 32));
+	brain.AddLayer(new ndBrainLayerActivationRelu(32));
+	brain.AddLayer(new ndBrainLayerLinear(32, 32));
+	brain.AddLayer(new ndBrainLayerActivationTanh(32));
+	brain.AddLayer(new ndBrainLayerLinear(32, 32));
+	brain.AddLayer(new ndBrainLayerActivationSigmoid(32));
+	brain.AddLayer(new ndBrainLayerLinear(32, 4));
+	brain.InitWeights();
+	CompareFusedPrediction(brain, 3);
+
+	ndBrainFusedInference fused(brain);
+	EXPECT_EQ(fused.GetStepsCount(), 4);
+}
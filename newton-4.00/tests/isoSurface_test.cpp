@@ -0,0 +1,112 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static void GetIsoSurfaceTriangles(const ndIsoSurface& isoSurface, ndFloat32 gridSize, std::vector<std::array<ndInt32, 9>>& triangles)
+{
+	// snap the vertices to the half grid lattice in world space
+	const ndArray<ndVector>& points = isoSurface.GetPoints();
+	const ndVector origin(isoSurface.GetOrigin());
+	triangles.clear();
+	for (ndInt32 i = 0; i < ndInt32(points.GetCount()); i += 3)
+	{
+		std::array<ndInt32, 9> triangle;
+		for (ndInt32 j = 0; j < 3; ++j)
+		{
+			const ndVector p(points[i + j] + origin);
+			for (ndInt32 k = 0; k < 3; ++k)
+			{
+				triangle[j * 3 + k] = ndInt32(ndFloor(p[k] * ndFloat32(2.0f) / gridSize + ndFloat32(0.5f)));
+			}
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+}
+
+TEST(IsoSurface, Blocks)
+{
+	ndWorld world;
+	world.SetThreadCount(4);
+	ndThreadPool* const threadPool = world.GetScene();
+
+	// two separated clouds, with jitter inside the cells
+	const ndFloat32 gridSize = ndFloat32(0.25f);
+	ndArray<ndVector> cloud;
+	for (ndInt32 z = 0; z < 20; ++z)
+	{
+		for (ndInt32 y = 0; y < 12; ++y)
+		{
+			for (ndInt32 x = 0; x < 24; ++x)
+			{
+				if (((x * 7 + y * 3 + z * 5) % 11) == 0)
+				{
+					continue;
+				}
+				const ndFloat32 offset = (x >= 12) ? ndFloat32(3.0f) : ndFloat32(-1.0f);
+				const ndFloat32 jitter = ndFloat32(((x * 13 + y * 7 + z * 3) % 5) - 2) * ndFloat32(0.05f);
+				cloud.PushBack(ndVector((ndFloat32(x) + ndFloat32(0.5f) + jitter) * gridSize + offset, (ndFloat32(y) + ndFloat32(0.5f) - jitter) * gridSize, (ndFloat32(z) + ndFloat32(0.5f)) * gridSize - ndFloat32(2.0f), ndFloat32(0.0f)));
+			}
+		}
+	}
+
+	ndIsoSurface serialSurface;
+	ndIsoSurface parallelSurface;
+	std::vector<std::array<ndInt32, 9>> serialTriangles;
+	std::vector<std::array<ndInt32, 9>> parallelTriangles;
+	for (ndInt32 pass = 0; pass < 2; ++pass)
+	{
+		if (pass)
+		{
+			// move a few points, most blocks must be reused
+			for (ndInt32 i = 0; i < 8; ++i)
+			{
+				cloud[i] += ndVector(ndFloat32(0.0f), gridSize * ndFloat32(2.0f), ndFloat32(0.0f), ndFloat32(0.0f));
+			}
+		}
+		serialSurface.GenerateMesh(cloud, gridSize);
+		parallelSurface.GenerateMesh(threadPool, cloud, gridSize);
+		GetIsoSurfaceTriangles(serialSurface, gridSize, serialTriangles);
+		GetIsoSurfaceTriangles(parallelSurface, gridSize, parallelTriangles);
+		ASSERT_GT(serialTriangles.size(), size_t(0));
+		EXPECT_TRUE(serialTriangles == parallelTriangles);
+
+		const ndInt32 indexCount = ndInt32(serialSurface.GetPoints().GetCount());
+		std::vector<ndInt32> serialIndex(indexCount);
+		std::vector<ndInt32> parallelIndex(indexCount);
+		std::vector<ndReal> serialPosit(indexCount * 3);
+		std::vector<ndReal> serialNormal(indexCount * 3);
+		std::vector<ndReal> parallelPosit(indexCount * 3);
+		std::vector<ndReal> parallelNormal(indexCount * 3);
+		const ndInt32 serialCount = serialSurface.GenerateListIndexList(&serialIndex[0], 3, &serialPosit[0], &serialNormal[0]);
+		const ndInt32 parallelCount = parallelSurface.GenerateListIndexList(threadPool, &parallelIndex[0], 3, &parallelPosit[0], &parallelNormal[0]);
+		EXPECT_EQ(serialCount, parallelCount);
+		for (ndInt32 i = 0; i < parallelCount; ++i)
+		{
+			const ndVector n(parallelNormal[i * 3 + 0], parallelNormal[i * 3 + 1], parallelNormal[i * 3 + 2], ndFloat32(0.0f));
+			EXPECT_NEAR(n.DotProduct(n).GetScalar(), ndFloat32(1.0f), ndFloat32(1.0e-3f));
+		}
+
+		if (pass)
+		{
+			EXPECT_GT(parallelSurface.GetReusedBlockCount(), parallelSurface.GetBlockCount() / 2);
+		}
+		else
+		{
+			EXPECT_EQ(parallelSurface.GetReusedBlockCount(), 0);
+		}
+	}
+}
@@ -43,4 +43,134 @@ TEST(Collisions, KinematicCollision)
 	}
 
 	world.CleanUp();
-}
\ No newline at end of file
+}
+class ndCountingConvexHull : public ndShapeConvexHull
+{
+	public:
+	ndCountingConvexHull(ndInt32 count, const ndFloat32* const points)
+		:ndShapeConvexHull(count, ndInt32(sizeof(ndVector)), ndFloat32(0.0f), points)
+		,m_calls(0)
+	{
+	}
+
+	ndVector SupportVertexSpecialCached(const ndVector& dir, ndFloat32 skinMargin, ndInt32* const vertexCache) const
+	{
+		m_calls++;
+		return ndShapeConvexHull::SupportVertexSpecialCached(dir, skinMargin, vertexCache);
+	}
+
+	ndInt32 GetVertexCount() const
+	{
+		return m_vertexCount;
+	}
+
+	mutable ndAtomic<ndInt32> m_calls;
+};
+
+// high vertex count hull, a jittered sphere
+static ndCountingConvexHull* CreateJitteredSphereHull()
+{
+	ndArray<ndVector> points;
+	ndUnsigned32 seed = 12345;
+	for (ndInt32 i = 0; i < 4000; ++i)
+	{
+		ndVector p(ndVector::m_zero);
+		for (ndInt32 j = 0; j < 3; ++j)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			p[j] = ndFloat32(seed >> 8) / ndFloat32(1 << 24) - ndFloat32(0.5f);
+		}
+		points.PushBack(p.Normalize().Scale(ndFloat32(0.5f)) & ndVector::m_triplexMask);
+	}
+	return new ndCountingConvexHull(ndInt32(points.GetCount()), &points[0].m_x);
+}
+
+// a slowly rotating direction, like the queries of one pair over many frames
+static void CreateRotatingDirections(ndInt32 queries, ndArray<ndVector>& dirs)
+{
+	for (ndInt32 i = 0; i < queries; ++i)
+	{
+		const ndFloat32 a = ndFloat32(i) * ndFloat32(0.002f);
+		dirs.PushBack(ndVector(ndCos(a), ndSin(a * ndFloat32(0.7f)), ndSin(a), ndFloat32(0.0f)).Normalize());
+	}
+}
+
+TEST(Collisions, ConvexHullSupportHillClimbing)
+{
+	ndCountingConvexHull* const hull = CreateJitteredSphereHull();
+	ndShapeInstance shape(hull);
+	EXPECT_GT(hull->GetVertexCount(), 500);
+
+	ndArray<ndVector> dirs;
+	CreateRotatingDirections(20000, dirs);
+
+	// the cached walk must land on a vertex as far along the direction as the hierarchical search
+	ndInt32 vertexCache = 0;
+	ndFloat32 maxError = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < ndInt32(dirs.GetCount()); i += 7)
+	{
+		const ndVector p0(shape.SupportVertexSpecial(dirs[i]));
+		const ndVector p1(shape.SupportVertexSpecial(dirs[i], &vertexCache));
+		maxError = ndMax(maxError, p0.DotProduct(dirs[i]).GetScalar() - p1.DotProduct(dirs[i]).GetScalar());
+	}
+	EXPECT_LT(maxError, ndFloat32(1.0e-5f));
+
+	// a resting pair goes through the cached support path
+	ndWorld world;
+	world.SetThreadCount(1);
+	hull->m_calls = 0;
+	ndMatrix matrix(ndGetIdentityMatrix());
+	ndBodyKinematic* const floor = new ndBodyKinematic();
+	floor->SetCollisionShape(shape);
+	floor->SetMatrix(matrix);
+	world.AddBody(ndSharedPtr<ndBody>(floor));
+
+	matrix.m_posit.m_y = ndFloat32(0.99f);
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-9.81f), ndFloat32(0.0f), ndFloat32(0.0f))));
+	body->SetCollisionShape(shape);
+	body->SetMatrix(matrix);
+	body->SetMassMatrix(ndFloat32(1.0f), shape);
+	body->SetOmega(ndVector(ndFloat32(0.0f), ndFloat32(2.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+	body->SetAutoSleep(false);
+	world.AddBody(ndSharedPtr<ndBody>(body));
+
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(ndFloat32(1.0f / 60.0f));
+		world.Sync();
+	}
+	EXPECT_GT(ndInt32(hull->m_calls), 0);
+	world.CleanUp();
+}
+
+/* Timing of the hierarchical search against the cached hill climbing walk,
+   run it with --gtest_also_run_disabled_tests, the numbers go to the xml report. */
+TEST(Collisions, DISABLED_ConvexHullSupportHillClimbingBenchmark)
+{
+	ndCountingConvexHull* const hull = CreateJitteredSphereHull();
+	ndShapeInstance shape(hull);
+
+	const ndInt32 queries = 200000;
+	ndArray<ndVector> dirs;
+	CreateRotatingDirections(queries, dirs);
+
+	ndInt32 vertexCache = 0;
+	ndVector acc(ndVector::m_zero);
+	const ndUnsigned64 time0 = ndGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < queries; ++i)
+	{
+		acc += shape.SupportVertexSpecial(dirs[i]);
+	}
+	const ndUnsigned64 time1 = ndGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < queries; ++i)
+	{
+		acc += shape.SupportVertexSpecial(dirs[i], &vertexCache);
+	}
+	const ndUnsigned64 time2 = ndGetTimeInMicroseconds();
+	EXPECT_TRUE(acc.m_x == acc.m_x);
+
+	RecordProperty("hullVertices", hull->GetVertexCount());
+	RecordProperty("hierarchicalNanosecondsPerCall", ndInt32(ndFloat32(time1 - time0) * ndFloat32(1000.0f) / ndFloat32(queries)));
+	RecordProperty("hillClimbingNanosecondsPerCall", ndInt32(ndFloat32(time2 - time1) * ndFloat32(1000.0f) / ndFloat32(queries)));
+}
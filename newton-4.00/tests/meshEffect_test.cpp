@@ -0,0 +1,64 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Mesh effect: the polygons of a build are triangulated into a closed mesh. */
+TEST(MeshEffect, BuildPolygonFaces)
+{
+	const ndInt32 sides = 8;
+	ndFloat64 x[sides];
+	ndFloat64 z[sides];
+	for (ndInt32 i = 0; i < sides; ++i)
+	{
+		const ndFloat64 angle = ndFloat64(i) * 2.0 * ndPi / ndFloat64(sides);
+		x[i] = cos(angle);
+		z[i] = sin(angle);
+	}
+
+	// an octagonal prism, two octagon caps and eight quads, all facing out
+	ndMeshEffect mesh;
+	mesh.BeginBuild();
+	mesh.BeginBuildFace();
+	for (ndInt32 i = 0; i < sides; ++i)
+	{
+		mesh.AddPoint(x[i], 0.0, z[i]);
+	}
+	mesh.EndBuildFace();
+	mesh.BeginBuildFace();
+	for (ndInt32 i = sides - 1; i >= 0; --i)
+	{
+		mesh.AddPoint(x[i], 1.0, z[i]);
+	}
+	mesh.EndBuildFace();
+	for (ndInt32 i = 0; i < sides; ++i)
+	{
+		const ndInt32 j = (i + 1) % sides;
+		mesh.BeginBuildFace();
+		mesh.AddPoint(x[i], 0.0, z[i]);
+		mesh.AddPoint(x[i], 1.0, z[i]);
+		mesh.AddPoint(x[j], 1.0, z[j]);
+		mesh.AddPoint(x[j], 0.0, z[j]);
+		mesh.EndBuildFace();
+	}
+	mesh.EndBuild(false);
+
+	EXPECT_EQ(mesh.GetVertexCount(), 2 * sides);
+	EXPECT_EQ(mesh.GetFaceCount(), 2 * (sides - 2) + 2 * sides);
+	ndPolyhedra::Iterator iter(mesh);
+	for (iter.Begin(); iter; iter++)
+	{
+		const ndEdge& edge = iter.GetNode()->GetInfo();
+		EXPECT_GT(edge.m_incidentFace, 0);
+		EXPECT_EQ(edge.m_next->m_next->m_next, &edge);
+	}
+}
@@ -0,0 +1,240 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include "ndBrainInc.h"
+#include <gtest/gtest.h>
+
+// the per layer Adam update the fused optimizer replaced, the moments are
+// cloned layers and each step runs one layer operation at the time.
+class ndReferenceAdam : public ndBrainOptimizer
+{
+	public:
+	ndReferenceAdam()
+		:ndBrainOptimizer()
+		,m_u()
+		,m_v()
+		,m_v2()
+		,m_beta(0.999f)
+		,m_alpha(0.9f)
+		,m_epsilon(1.0e-6f)
+		,m_betaAcc(m_beta)
+		,m_alphaAcc(m_alpha)
+	{
+	}
+
+	~ndReferenceAdam()
+	{
+		for (ndInt32 i = 0; i < ndInt32(m_u.GetCount()); ++i)
+		{
+			delete m_u[i];
+			delete m_v[i];
+			delete m_v2[i];
+		}
+	}
+
+	void Update(ndBrainThreadPool* const, ndArray<ndBrainTrainer*>& partialGradients, ndBrainFloat learnRate)
+	{
+		ndBrainTrainer* const trainer = partialGradients[0];
+		ndBrain& brain = *trainer->GetBrain();
+		if (!m_u.GetCount())
+		{
+			for (ndInt32 i = 0; i < brain.GetCount(); ++i)
+			{
+				ndBrainLayer* const layer = brain[i];
+				m_u.PushBack(layer->HasParameters() ? layer->Clone() : nullptr);
+				m_v.PushBack(layer->HasParameters() ? layer->Clone() : nullptr);
+				m_v2.PushBack(layer->HasParameters() ? layer->Clone() : nullptr);
+				if (layer->HasParameters())
+				{
+					m_u[i]->Clear();
+					m_v[i]->Clear();
+					m_v2[i]->Clear();
+				}
+			}
+		}
+
+		for (ndInt32 i = 1; i < partialGradients.GetCount(); ++i)
+		{
+			trainer->AddGradients(partialGradients[i]);
+		}
+
+		const ndBrainFloat betaWeight = ndBrainFloat(1.0f) / (ndBrainFloat(1.0f) - m_betaAcc);
+		const ndBrainFloat alphaWeight = ndBrainFloat(1.0f) / (ndBrainFloat(1.0f) - m_alphaAcc);
+		const ndBrainFloat regularizer = -GetRegularizer();
+		const ndBrainFloat descendRate = -learnRate;
+		const ndBrainFloat den = ndBrainFloat(1.0f) / ndBrainFloat(partialGradients.GetCount());
+		for (ndInt32 i = 0; i < brain.GetCount(); ++i)
+		{
+			if (brain[i]->HasParameters())
+			{
+				ndBrainLayer& gradients = *trainer->GetGradientLayer(i);
+				gradients.Scale(den);
+				m_v[i]->Scale(m_beta);
+				m_u[i]->Scale(m_alpha);
+				m_v2[i]->Set(gradients);
+				m_v2[i]->Mul(gradients);
+				m_u[i]->ScaleAdd(gradients, ndBrainFloat(1.0f) - m_alpha);
+				m_v[i]->ScaleAdd(*m_v2[i], ndBrainFloat(1.0f) - m_beta);
+
+				if (m_betaAcc > ndBrainFloat(0.0f))
+				{
+					ndBrainLayer& vHat = gradients;
+					ndBrainLayer& uHat = *m_v2[i];
+					uHat.Set(*m_u[i]);
+					vHat.Set(*m_v[i]);
+					vHat.Scale(betaWeight);
+					uHat.Scale(alphaWeight);
+					gradients.AdamUpdate(uHat, vHat, m_epsilon);
+				}
+				else
+				{
+					gradients.AdamUpdate(*m_u[i], *m_v[i], m_epsilon);
+				}
+
+				ndBrainLayer& weights = *trainer->GetWeightsLayer(i);
+				gradients.ScaleAdd(weights, regularizer);
+				weights.ScaleAdd(gradients, descendRate);
+				weights.FlushToZero();
+			}
+		}
+
+		m_betaAcc = ndFlushToZero(m_betaAcc * m_beta);
+		m_alphaAcc = ndFlushToZero(m_alphaAcc * m_alpha);
+		if (m_betaAcc < ndBrainFloat(1.0e-6f))
+		{
+			m_betaAcc = ndBrainFloat(0.0f);
+		}
+	}
+
+	ndArray<ndBrainLayer*> m_u;
+	ndArray<ndBrainLayer*> m_v;
+	ndArray<ndBrainLayer*> m_v2;
+	ndBrainFloat m_beta;
+	ndBrainFloat m_alpha;
+	ndBrainFloat m_epsilon;
+	ndBrainFloat m_betaAcc;
+	ndBrainFloat m_alphaAcc;
+};
+
+static void TrainAdamStep(ndBrainThreadPool& threadPool, ndBrainOptimizer& optimizer, ndArray<ndBrainTrainer*>& trainers, const ndBrainMatrix& inputs, const ndBrainMatrix& truth)
+{
+	const ndInt32 outputs = truth.GetColumns();
+	ndBrainLossLeastSquaredError loss(outputs);
+	for (ndInt32 i = 0; i < ndInt32(trainers.GetCount()); ++i)
+	{
+		loss.SetTruth(truth[i]);
+		trainers[i]->BackPropagate(inputs[i], loss);
+	}
+	optimizer.Update(&threadPool, trainers, ndBrainFloat(1.0e-2f));
+}
+
+TEST(OptimizerAdam, FusedMatchesPerLayer)
+{
+	ndSetRandSeed(42);
+	const ndInt32 inputSize = 37;
+	const ndInt32 hiddenSize = 130;
+	const ndInt32 outputSize = 7;
+	const ndInt32 trainersCount = 3;
+
+	// the first layer is larger than an update chunk, and the odd sizes
+	// run the fused kernel through its simd body and its scalar tail.
+	ndBrain fusedBrain;
+	fusedBrain.AddLayer(new ndBrainLayerLinear(inputSize, hiddenSize));
+	fusedBrain.AddLayer(new ndBrainLayerActivationTanh(hiddenSize));
+	fusedBrain.AddLayer(new ndBrainLayerLinear(hiddenSize, outputSize));
+	fusedBrain.AddLayer(new ndBrainLayerActivationRelu(outputSize));
+	fusedBrain.InitWeights();
+	ndBrain referenceBrain(fusedBrain);
+
+	ndBrainMatrix inputs(trainersCount, inputSize);
+	ndBrainMatrix truth(trainersCount, outputSize);
+	for (ndInt32 i = 0; i < trainersCount; ++i)
+	{
+		for (ndInt32 j = 0; j < inputSize; ++j)
+		{
+			inputs[i][j] = ndBrainFloat(ndGaussianRandom(ndFloat32(0.0f), ndFloat32(1.0f)));
+		}
+		for (ndInt32 j = 0; j < outputSize; ++j)
+		{
+			truth[i][j] = ndBrainFloat(ndRand());
+		}
+	}
+
+	ndArray<ndBrainTrainer*> fusedTrainers;
+	ndArray<ndBrainTrainer*> referenceTrainers;
+	for (ndInt32 i = 0; i < trainersCount; ++i)
+	{
+		fusedTrainers.PushBack(new ndBrainTrainer(&fusedBrain));
+		referenceTrainers.PushBack(new ndBrainTrainer(&referenceBrain));
+	}
+
+	ndBrainThreadPool threadPool;
+	threadPool.SetThreadCount(2);
+	ndBrainOptimizerAdam fused;
+	ndReferenceAdam reference;
+	fused.SetRegularizer(ndBrainFloat(1.0e-4f));
+	reference.SetRegularizer(ndBrainFloat(1.0e-4f));
+
+	ndArray<ndBrainFloat*> fusedWeights;
+	ndArray<ndBrainFloat*> referenceWeights;
+	ndArray<ndInt32> sizes;
+	fusedTrainers[0]->GetWeightBuffers(fusedWeights, sizes);
+	sizes.SetCount(0);
+	referenceTrainers[0]->GetWeightBuffers(referenceWeights, sizes);
+	ASSERT_EQ(fusedWeights.GetCount(), referenceWeights.GetCount());
+
+	ndBrainVector initialWeights;
+	for (ndInt32 i = 0; i < ndInt32(sizes.GetCount()); ++i)
+	{
+		for (ndInt32 j = 0; j < sizes[i]; ++j)
+		{
+			initialWeights.PushBack(fusedWeights[i][j]);
+		}
+	}
+
+	for (ndInt32 step = 0; step < 20; ++step)
+	{
+		TrainAdamStep(threadPool, fused, fusedTrainers, inputs, truth);
+		TrainAdamStep(threadPool, reference, referenceTrainers, inputs, truth);
+
+		ndBrainFloat maxError = ndBrainFloat(0.0f);
+		for (ndInt32 i = 0; i < ndInt32(sizes.GetCount()); ++i)
+		{
+			for (ndInt32 j = 0; j < sizes[i]; ++j)
+			{
+				const ndBrainFloat w0 = fusedWeights[i][j];
+				const ndBrainFloat w1 = referenceWeights[i][j];
+				maxError = ndMax(maxError, ndBrainFloat(ndAbs(w0 - w1) / (ndBrainFloat(1.0f) + ndAbs(w1))));
+			}
+		}
+		EXPECT_LT(maxError, ndBrainFloat(1.0e-5f)) << "step " << step;
+	}
+
+	// the comparison is meaningful, the weights did move
+	ndInt32 index = 0;
+	ndBrainFloat maxChange = ndBrainFloat(0.0f);
+	for (ndInt32 i = 0; i < ndInt32(sizes.GetCount()); ++i)
+	{
+		for (ndInt32 j = 0; j < sizes[i]; ++j)
+		{
+			maxChange = ndMax(maxChange, ndBrainFloat(ndAbs(fusedWeights[i][j] - initialWeights[index])));
+			index++;
+		}
+	}
+	EXPECT_GT(maxChange, ndBrainFloat(1.0e-2f));
+
+	for (ndInt32 i = 0; i < trainersCount; ++i)
+	{
+		delete fusedTrainers[i];
+		delete referenceTrainers[i];
+	}
+}
@@ -0,0 +1,187 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include "ndBrainInc.h"
+#include "ndBrainAgentContinuePolicyGradient_Rollout.h"
+#include <gtest/gtest.h>
+
+#define D_ROLLOUT_TEST_SEED		100
+#define D_ROLLOUT_TEST_ACTIONS	2
+
+// a sphere in a private world, the actions drive its velocity on the xy plane
+class ndRolloutTestWorld
+{
+	public:
+	ndRolloutTestWorld(ndFloat32 x)
+		:m_world()
+		,m_body(nullptr)
+		,m_origin(x, ndFloat32(1.0f), ndFloat32(0.0f), ndFloat32(1.0f))
+	{
+		ndShapeInstance shape(new ndShapeSphere(ndFloat32(0.25f)));
+		m_body = new ndBodyDynamic();
+		m_body->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+		m_body->SetCollisionShape(shape);
+		m_body->SetMassMatrix(ndFloat32(1.0f), shape);
+		m_world.AddBody(ndSharedPtr<ndBody>(m_body));
+		ResetModel();
+	}
+
+	~ndRolloutTestWorld()
+	{
+		m_world.CleanUp();
+	}
+
+	void ResetModel()
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit = m_origin;
+		m_body->SetMatrix(matrix);
+		m_body->SetVelocity(ndVector::m_zero);
+	}
+
+	ndBrainFloat CalculateReward() const
+	{
+		const ndVector posit(m_body->GetMatrix().m_posit);
+		return ndBrainFloat(1.0f) - ndBrainFloat(0.1f) * ndBrainFloat(ndAbs(posit.m_x) + ndAbs(posit.m_y - ndFloat32(1.0f)));
+	}
+
+	void ApplyActions(const ndBrainFloat* const actions)
+	{
+		m_body->SetVelocity(ndVector(ndFloat32(actions[0]), ndFloat32(actions[1]), ndFloat32(0.0f), ndFloat32(0.0f)));
+	}
+
+	void GetObservation(ndBrainFloat* const observation) const
+	{
+		const ndVector posit(m_body->GetMatrix().m_posit);
+		const ndVector veloc(m_body->GetVelocity());
+		observation[0] = ndBrainFloat(posit.m_x);
+		observation[1] = ndBrainFloat(posit.m_y);
+		observation[2] = ndBrainFloat(veloc.m_x);
+		observation[3] = ndBrainFloat(veloc.m_y);
+	}
+
+	void Step(ndFloat32 timestep)
+	{
+		m_world.Update(timestep);
+		m_world.Sync();
+	}
+
+	ndWorld m_world;
+	ndBodyDynamic* m_body;
+	ndVector m_origin;
+};
+
+class ndRolloutTestEnvironment : public ndBrainAgentContinuePolicyGradient_Rollout::ndEnvironment
+{
+	public:
+	ndRolloutTestEnvironment(ndFloat32 x)
+		:ndBrainAgentContinuePolicyGradient_Rollout::ndEnvironment()
+		,m_model(x)
+	{
+	}
+
+	void ResetModel() { m_model.ResetModel(); }
+	bool IsTerminal() const { return false; }
+	ndBrainFloat CalculateReward() { return m_model.CalculateReward(); }
+	void ApplyActions(ndBrainFloat* const actions) { m_model.ApplyActions(actions); }
+	void GetObservation(ndBrainFloat* const observation) { m_model.GetObservation(observation); }
+	void Step(ndFloat32 timestep) { m_model.Step(timestep); }
+
+	ndRolloutTestWorld m_model;
+};
+
+// the reference, one agent per world using the per agent SelectAction path
+class ndRolloutTestAgent : public ndBrainAgentContinuePolicyGradient_Trainer
+{
+	public:
+	ndRolloutTestAgent(const ndSharedPtr<ndBrainAgentContinuePolicyGradient_TrainerMaster>& master, ndFloat32 x)
+		:ndBrainAgentContinuePolicyGradient_Trainer(master)
+		,m_model(x)
+	{
+	}
+
+	void ResetModel() { m_model.ResetModel(); }
+	ndBrainFloat CalculateReward() { return m_model.CalculateReward(); }
+	void ApplyActions(ndBrainFloat* const actions) { m_model.ApplyActions(actions); }
+	void GetObservation(ndBrainFloat* const observation) { m_model.GetObservation(observation); }
+
+	ndRolloutTestWorld m_model;
+};
+
+TEST(PolicyRollout, BatchedActionsMatchAgents)
+{
+	ndBrainAgentContinuePolicyGradient_TrainerMaster::HyperParameters hyperParameters;
+	hyperParameters.m_threadsCount = 2;
+	hyperParameters.m_numberOfLayers = 2;
+	hyperParameters.m_neuronPerLayers = 16;
+	hyperParameters.m_maxTrajectorySteps = 64;
+	hyperParameters.m_extraTrajectorySteps = 8;
+	hyperParameters.m_bashTrajectoryCount = 8;
+	hyperParameters.m_numberOfObservations = 4;
+	hyperParameters.m_numberOfActions = D_ROLLOUT_TEST_ACTIONS;
+	ndSharedPtr<ndBrainAgentContinuePolicyGradient_TrainerMaster> master(new ndBrainAgentContinuePolicyGradient_TrainerMaster(hyperParameters));
+
+	const ndInt32 worldCount = 3;
+	ndBrainAgentContinuePolicyGradient_Rollout rollout(master, D_ROLLOUT_TEST_SEED);
+	ndRolloutTestAgent* agents[worldCount];
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		const ndFloat32 x = ndFloat32(i) * ndFloat32(0.5f) - ndFloat32(0.5f);
+		rollout.AddEnvironment(ndSharedPtr<ndBrainAgentContinuePolicyGradient_Rollout::ndEnvironment>(new ndRolloutTestEnvironment(x)));
+
+		// the agent draws the same noise stream as the rollout environment
+		agents[i] = new ndRolloutTestAgent(master, x);
+		agents[i]->m_randomGenerator->m_gen.seed(D_ROLLOUT_TEST_SEED + ndUnsigned32(i));
+		agents[i]->m_randomGenerator->m_d.reset();
+	}
+	EXPECT_EQ(rollout.GetEnvironmentCount(), worldCount);
+
+	const ndInt32 steps = 20;
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+	for (ndInt32 k = 0; k < steps; ++k)
+	{
+		rollout.Step(timestep);
+		for (ndInt32 i = 0; i < worldCount; ++i)
+		{
+			agents[i]->Step();
+			agents[i]->m_model.Step(timestep);
+		}
+	}
+
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		ASSERT_EQ(rollout.GetTrajectorySteps(i), steps);
+		ASSERT_EQ(agents[i]->m_trajectory.GetCount(), steps);
+		for (ndInt32 k = 0; k < steps; ++k)
+		{
+			const ndBrainFloat* const actions = rollout.GetTrajectoryActions(i, k);
+			const ndBrainFloat* const agentActions = agents[i]->m_trajectory.GetActions(k);
+			for (ndInt32 j = 0; j < 2 * D_ROLLOUT_TEST_ACTIONS; ++j)
+			{
+				EXPECT_NEAR(actions[j], agentActions[j], ndBrainFloat(1.0e-5f));
+			}
+
+			const ndBrainFloat* const observations = rollout.GetTrajectoryObservations(i, k);
+			const ndBrainFloat* const agentObservations = agents[i]->m_trajectory.GetObservations(k);
+			for (ndInt32 j = 0; j < hyperParameters.m_numberOfObservations; ++j)
+			{
+				EXPECT_NEAR(observations[j], agentObservations[j], ndBrainFloat(1.0e-4f));
+			}
+			EXPECT_NEAR(rollout.GetTrajectoryReward(i, k), agents[i]->m_trajectory.GetReward(k), ndBrainFloat(1.0e-4f));
+		}
+	}
+
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		delete agents[i];
+	}
+}
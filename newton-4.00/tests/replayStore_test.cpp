@@ -0,0 +1,223 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include "ndBrainInc.h"
+#include <gtest/gtest.h>
+
+static void AddReplayTransitions(ndBrainReplayStore& store, ndInt32 first, ndInt32 count)
+{
+	ndBrainVector action;
+	ndBrainVector observation;
+	ndBrainVector nextObservation;
+	action.SetCount(store.GetActionSize());
+	observation.SetCount(store.GetObservationSize());
+	nextObservation.SetCount(store.GetObservationSize());
+	for (ndInt32 i = first; i < first + count; ++i)
+	{
+		action.Set(ndBrainFloat(i));
+		observation.Set(ndBrainFloat(i));
+		nextObservation.Set(ndBrainFloat(i + 1));
+		store.AddTransition(observation, action, ndBrainFloat(i), nextObservation, (i & 1) ? true : false);
+	}
+}
+
+// sample many stratified batches and return the frequency of each slot
+static void SamplePrioritizedFrequency(ndBrainReplayStore& store, ndInt32 batches, ndArray<ndBrainFloat>& frequency)
+{
+	ndArray<ndInt32> indices;
+	ndBrainVector weights;
+	frequency.SetCount(store.GetCapacity());
+	for (ndInt32 i = 0; i < store.GetCapacity(); ++i)
+	{
+		frequency[i] = ndBrainFloat(0.0f);
+	}
+
+	ndInt32 samples = 0;
+	for (ndInt32 i = 0; i < batches; ++i)
+	{
+		store.SamplePrioritized(32, ndBrainFloat(0.5f), indices, weights);
+		for (ndInt32 j = 0; j < ndInt32(indices.GetCount()); ++j)
+		{
+			ASSERT_GE(indices[j], 0);
+			ASSERT_LT(indices[j], store.GetCount());
+			frequency[indices[j]] += ndBrainFloat(1.0f);
+			samples++;
+		}
+	}
+	for (ndInt32 i = 0; i < store.GetCapacity(); ++i)
+	{
+		frequency[i] /= ndBrainFloat(samples);
+	}
+}
+
+TEST(ReplayStore, UniformSampling)
+{
+	ndSetRandSeed(42);
+	ndBrainReplayStore store(64, 3, 2);
+	AddReplayTransitions(store, 0, 40);
+	EXPECT_EQ(store.GetCount(), 40);
+
+	ndArray<ndInt32> indices;
+	ndArray<ndInt32> histogram;
+	histogram.SetCount(40);
+	for (ndInt32 i = 0; i < 40; ++i)
+	{
+		histogram[i] = 0;
+	}
+	for (ndInt32 i = 0; i < 1000; ++i)
+	{
+		store.SampleUniform(40, indices);
+		ASSERT_EQ(ndInt32(indices.GetCount()), 40);
+		for (ndInt32 j = 0; j < 40; ++j)
+		{
+			// only the written slots are sampled
+			ASSERT_GE(indices[j], 0);
+			ASSERT_LT(indices[j], 40);
+			histogram[indices[j]]++;
+		}
+	}
+	for (ndInt32 i = 0; i < 40; ++i)
+	{
+		EXPECT_GT(histogram[i], 850);
+		EXPECT_LT(histogram[i], 1150);
+	}
+
+	ndBrainMatrix observations;
+	ndBrainMatrix actions;
+	ndBrainMatrix nextObservations;
+	ndBrainVector rewards;
+	ndBrainVector terminals;
+	store.Gather(indices, observations, actions, rewards, nextObservations, terminals);
+	for (ndInt32 i = 0; i < 40; ++i)
+	{
+		const ndInt32 index = indices[i];
+		EXPECT_EQ(rewards[i], ndBrainFloat(index));
+		EXPECT_EQ(terminals[i], (index & 1) ? ndBrainFloat(0.0f) : ndBrainFloat(1.0f));
+		EXPECT_EQ(observations[i][2], ndBrainFloat(index));
+		EXPECT_EQ(actions[i][1], ndBrainFloat(index));
+		EXPECT_EQ(nextObservations[i][0], ndBrainFloat(index + 1));
+	}
+}
+
+TEST(ReplayStore, PrioritizedSampling)
+{
+	ndSetRandSeed(42);
+	ndBrainReplayStore store(6, 2, 1);
+	store.SetPriorityExponent(ndBrainFloat(1.0f));
+	AddReplayTransitions(store, 0, 5);
+	store.SetPriority(0, ndBrainFloat(1.0f));
+	store.SetPriority(1, ndBrainFloat(2.0f));
+	store.SetPriority(2, ndBrainFloat(3.0f));
+	store.SetPriority(3, ndBrainFloat(4.0f));
+	store.SetPriority(4, ndBrainFloat(10.0f));
+
+	// the empty slot is never sampled, the others in proportion to their priority
+	ndArray<ndBrainFloat> frequency;
+	SamplePrioritizedFrequency(store, 2000, frequency);
+	const ndBrainFloat expected[] = { 1.0f / 20.0f, 2.0f / 20.0f, 3.0f / 20.0f, 4.0f / 20.0f, 10.0f / 20.0f, 0.0f };
+	for (ndInt32 i = 0; i < 6; ++i)
+	{
+		EXPECT_NEAR(frequency[i], expected[i], ndBrainFloat(0.01f));
+	}
+
+	// updating the priorities after a sample updates the tree in place
+	store.SetPriority(4, ndBrainFloat(1.0f));
+	SamplePrioritizedFrequency(store, 2000, frequency);
+	const ndBrainFloat expected1[] = { 1.0f / 11.0f, 2.0f / 11.0f, 3.0f / 11.0f, 4.0f / 11.0f, 1.0f / 11.0f, 0.0f };
+	for (ndInt32 i = 0; i < 6; ++i)
+	{
+		EXPECT_NEAR(frequency[i], expected1[i], ndBrainFloat(0.01f));
+	}
+
+	// a zero exponent makes the sampling uniform
+	store.SetPriorityExponent(ndBrainFloat(0.0f));
+	SamplePrioritizedFrequency(store, 2000, frequency);
+	for (ndInt32 i = 0; i < 5; ++i)
+	{
+		EXPECT_NEAR(frequency[i], ndBrainFloat(0.2f), ndBrainFloat(0.01f));
+	}
+}
+
+TEST(ReplayStore, ImportanceWeights)
+{
+	ndSetRandSeed(42);
+	ndBrainReplayStore store(4, 1, 1);
+	store.SetPriorityExponent(ndBrainFloat(1.0f));
+	AddReplayTransitions(store, 0, 4);
+	store.SetPriority(0, ndBrainFloat(1.0f));
+	store.SetPriority(1, ndBrainFloat(1.0f));
+	store.SetPriority(2, ndBrainFloat(1.0f));
+	store.SetPriority(3, ndBrainFloat(5.0f));
+
+	// w = (N * P)^-beta / max(w), P = 1/8 for the low slots and 5/8 for the high one
+	const ndBrainFloat beta = ndBrainFloat(0.7f);
+	const ndBrainFloat lowWeight = ndBrainFloat(ndPow(ndBrainFloat(4.0f / 8.0f), -beta));
+	const ndBrainFloat highWeight = ndBrainFloat(ndPow(ndBrainFloat(20.0f / 8.0f), -beta));
+
+	ndArray<ndInt32> indices;
+	ndBrainVector weights;
+	store.SamplePrioritized(16, beta, indices, weights);
+	ASSERT_EQ(ndInt32(weights.GetCount()), 16);
+	for (ndInt32 i = 0; i < 16; ++i)
+	{
+		// the stratified sample always hits the low priority slots, so they carry the max weight
+		const ndBrainFloat expected = (indices[i] == 3) ? highWeight / lowWeight : ndBrainFloat(1.0f);
+		EXPECT_NEAR(weights[i], expected, ndBrainFloat(1.0e-4f));
+	}
+}
+
+TEST(ReplayStore, RingWraparound)
+{
+	ndSetRandSeed(42);
+	ndBrainReplayStore store(8, 2, 1);
+	store.SetPriorityExponent(ndBrainFloat(1.0f));
+	AddReplayTransitions(store, 0, 8);
+	store.SetPriority(5, ndBrainFloat(9.0f));
+
+	ndArray<ndInt32> indices;
+	ndBrainVector weights;
+	store.SamplePrioritized(8, ndBrainFloat(0.5f), indices, weights);
+
+	// three more transitions overwrite the oldest slots with the max priority
+	AddReplayTransitions(store, 8, 3);
+	EXPECT_EQ(store.GetCount(), 8);
+	for (ndInt32 i = 0; i < 8; ++i)
+	{
+		const ndInt32 expected = (i < 3) ? i + 8 : i;
+		EXPECT_EQ(store.GetReward(i), ndBrainFloat(expected));
+		EXPECT_EQ(store.GetObservation(i)[0], ndBrainFloat(expected));
+		EXPECT_EQ(store.GetNextObservation(i)[1], ndBrainFloat(expected + 1));
+		EXPECT_EQ(store.GetTerminal(i), (expected & 1) ? true : false);
+	}
+	EXPECT_EQ(store.GetPriority(0), ndBrainFloat(9.0f));
+	EXPECT_EQ(store.GetPriority(2), ndBrainFloat(9.0f));
+	EXPECT_EQ(store.GetPriority(3), ndBrainFloat(1.0f));
+
+	// the overwritten slots are folded into the sum tree by the next sample
+	ndArray<ndBrainFloat> frequency;
+	SamplePrioritizedFrequency(store, 2000, frequency);
+	for (ndInt32 i = 0; i < 8; ++i)
+	{
+		const ndBrainFloat priority = ((i < 3) || (i == 5)) ? ndBrainFloat(9.0f) : ndBrainFloat(1.0f);
+		EXPECT_NEAR(frequency[i], priority / ndBrainFloat(40.0f), ndBrainFloat(0.01f));
+	}
+
+	// a full lap past the capacity rebuilds the tree
+	AddReplayTransitions(store, 11, 20);
+	EXPECT_EQ(store.GetCount(), 8);
+	EXPECT_EQ(store.GetReward(6), ndBrainFloat(30.0f));
+	SamplePrioritizedFrequency(store, 2000, frequency);
+	for (ndInt32 i = 0; i < 8; ++i)
+	{
+		EXPECT_NEAR(frequency[i], ndBrainFloat(1.0f / 8.0f), ndBrainFloat(0.01f));
+	}
+}
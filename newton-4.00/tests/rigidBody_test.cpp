@@ -94,3 +94,30 @@ TEST(RigidBody, MoveWithUnitForce) {
   err = errVec.DotProduct(errVec & ndVector::m_triplexMask).GetScalar();
   EXPECT_NEAR(err, 0, 1E-4);
 }
+
+#ifdef D_NEWTON_USE_MIXED_PRECISION
+/* Far from the origin each integration step is smaller than half a float ulp,
+   compensated integration must still move the body the expected distance. */
+TEST(RigidBody, MixedPrecisionLargeCoordinates) {
+  ndWorld world;
+  world.SetSubSteps(2);
+
+  // Place the sphere 100 km away from the origin, the ulp there is about 8 mm.
+  ndVector spherePos = ndVector(100000.f, 0.f, 0.f, 1.f);
+  ndBodyDynamic* const body = BuildSphere(spherePos);
+  body->SetAutoSleep(false);
+  body->SetVelocity(ndVector(0.25f, 0.f, 0.f, 0.f));
+  ndSharedPtr<ndBody> sphere (body);
+  world.AddBody(sphere);
+
+  // Simulate two seconds, 1/120 seconds per sub step moves ~2 mm per step.
+  for (int i = 0; i < 120; i++) {
+    world.Update(1.0f / 60.0f);
+    world.Sync();
+  }
+
+  // Verify that the sphere moved 0.5 meters in the X-direction.
+  const ndFloat32 travel = sphere->GetMatrix().m_posit.m_x - spherePos.m_x;
+  EXPECT_NEAR(travel, 0.5f, 1.0E-2f);
+}
+#endif
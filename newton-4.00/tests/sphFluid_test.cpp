@@ -0,0 +1,283 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Persistent sph cell lists give the same result when re-sorting every
+ * frame and when only re-binning the particles that changed cell. */
+TEST(SphFluid, PersistentCells)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+
+	ndBodySphFluid* fluids[2];
+	for (ndInt32 k = 0; k < 2; ++k)
+	{
+		ndBodySphFluid* const fluid = new ndBodySphFluid();
+		fluid->SetParticleRadius(ndFloat32(0.125f));
+		fluid->SetAsynUpdate(false);
+		fluid->SetGasConstant(ndFloat32(100.0f));
+		fluid->SetPersistentCells(true, k ? 8 : 1);
+		ndArray<ndVector>& posit = fluid->GetPositions();
+		ndArray<ndVector>& veloc = fluid->GetVelocity();
+		for (ndInt32 z = 0; z < 10; ++z)
+		{
+			for (ndInt32 y = 0; y < 10; ++y)
+			{
+				for (ndInt32 x = 0; x < 10; ++x)
+				{
+					posit.PushBack(ndVector(ndFloat32(x) * 0.2f, ndFloat32(2.0f + y * 0.2f), ndFloat32(z) * 0.2f, ndFloat32(0.0f)));
+					veloc.PushBack(ndVector::m_zero);
+				}
+			}
+		}
+		world.AddBody(ndSharedPtr<ndBody>(fluid));
+		fluids[k] = fluid;
+	}
+
+	ndInt32 rebinFrames = 0;
+	ndInt32 incrementalFrames = 0;
+	for (ndInt32 i = 0; i < 30; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+		const ndInt32 rebinned = fluids[1]->GetRebinnedParticleCount();
+		EXPECT_EQ(fluids[0]->GetRebinnedParticleCount(), 1000);
+		incrementalFrames += (rebinned < 1000) ? 1 : 0;
+		rebinFrames += ((rebinned > 0) && (rebinned < 1000)) ? 1 : 0;
+	}
+	EXPECT_GT(incrementalFrames, 20);
+	EXPECT_GT(rebinFrames, 0);
+
+	// the particle order is different, compare order independent moments
+	ndVector sum[2];
+	ndVector sum2[2];
+	for (ndInt32 k = 0; k < 2; ++k)
+	{
+		const ndArray<ndVector>& posit = fluids[k]->GetPositions();
+		ASSERT_EQ(posit.GetCount(), 1000);
+		sum[k] = ndVector::m_zero;
+		sum2[k] = ndVector::m_zero;
+		for (ndInt32 i = 0; i < ndInt32(posit.GetCount()); ++i)
+		{
+			EXPECT_TRUE(ndCheckVector(posit[i]));
+			sum[k] += posit[i];
+			sum2[k] += posit[i] * posit[i];
+		}
+	}
+	for (ndInt32 j = 0; j < 3; ++j)
+	{
+		EXPECT_NEAR(sum[0][j], sum[1][j], ndFloat32(1.0e-2f));
+		EXPECT_NEAR(sum2[0][j], sum2[1][j], ndFloat32(1.0e-2f));
+	}
+	world.CleanUp();
+}
+
+// brute force reference of one fluid step, every pair inside the kernel
+// radius contributes, the same kernels and integration as the fluid body
+static void SphReferenceStep(ndArray<ndVector>& posit, ndArray<ndVector>& veloc, ndFloat32 radius, ndFloat32 restDensity, ndFloat32 gasConstant, ndFloat32 timestep)
+{
+	const ndInt32 count = ndInt32(posit.GetCount());
+	const ndFloat32 h = ndFloat32(2.0f) * radius;
+	const ndFloat32 h2 = h * h;
+	const ndFloat32 mass = ndPi * ndFloat32(4.0f / 3.0f) * radius * radius * radius * restDensity;
+	const ndFloat32 densityConst = mass * ndFloat32(315.0f) / (ndFloat32(64.0f) * ndPi * ndPow(h, ndFloat32(9.0f)));
+
+	ndArray<ndFloat32> density;
+	density.SetCount(count);
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		ndFloat32 volume = h2 * h2 * h2;
+		for (ndInt32 j = 0; j < count; ++j)
+		{
+			const ndVector p10(posit[i] - posit[j]);
+			const ndFloat32 dist2 = p10.DotProduct(p10).GetScalar();
+			if ((i != j) && (dist2 < h2))
+			{
+				const ndFloat32 w = h2 - dist2;
+				volume += w * w * w;
+			}
+		}
+		density[i] = densityConst * volume;
+	}
+
+	ndArray<ndVector> accel;
+	accel.SetCount(count);
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndFloat32 pressure0 = gasConstant * (density[i] - restDensity);
+		ndVector force(ndVector::m_zero);
+		for (ndInt32 j = 0; j < count; ++j)
+		{
+			const ndVector p10(posit[i] - posit[j]);
+			const ndFloat32 dist2 = p10.DotProduct(p10).GetScalar();
+			if ((i != j) && (dist2 < h2))
+			{
+				const ndFloat32 dist = ndSqrt(dist2);
+				const ndFloat32 pressure1 = gasConstant * (density[j] - restDensity);
+				const ndFloat32 kernel = (h - dist) * (h - dist);
+				const ndFloat32 averagePressure = ndFloat32(0.5f) * (pressure0 + pressure1) / density[j];
+				force += p10.Scale(mass * averagePressure * kernel / ndSqrt(dist2 + ndFloat32(1.0e-12f)));
+			}
+		}
+		accel[i] = force;
+	}
+
+	const ndVector step(timestep * ndFloat32(0.25f));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		veloc[i] = veloc[i] + accel[i] * step;
+		posit[i] = posit[i] + veloc[i] * step;
+		if (posit[i].m_y <= ndFloat32(1.0f))
+		{
+			posit[i].m_y = ndFloat32(1.0f);
+			veloc[i].m_y = ndFloat32(0.0f);
+		}
+	}
+}
+
+/* The persistent cell lists must find every neighbor inside the kernel
+ * radius, so the fluid moves the block like the brute force reference. */
+TEST(SphFluid, PersistentCellsMatchReference)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+
+	ndBodySphFluid* const fluid = new ndBodySphFluid();
+	fluid->SetParticleRadius(ndFloat32(0.15f));
+	fluid->SetAsynUpdate(false);
+	fluid->SetGasConstant(ndFloat32(1000.0f));
+	fluid->SetPersistentCells(true, 4);
+
+	ndArray<ndVector> referencePosit;
+	ndArray<ndVector> referenceVeloc;
+	ndArray<ndVector>& posit = fluid->GetPositions();
+	ndArray<ndVector>& veloc = fluid->GetVelocity();
+	for (ndInt32 z = 0; z < 8; ++z)
+	{
+		for (ndInt32 y = 0; y < 8; ++y)
+		{
+			for (ndInt32 x = 0; x < 8; ++x)
+			{
+				const ndVector p(ndFloat32(x) * 0.2f, ndFloat32(2.0f + y * 0.2f), ndFloat32(z) * 0.2f, ndFloat32(0.0f));
+				posit.PushBack(p);
+				veloc.PushBack(ndVector::m_zero);
+				referencePosit.PushBack(p);
+				referenceVeloc.PushBack(ndVector::m_zero);
+			}
+		}
+	}
+	world.AddBody(ndSharedPtr<ndBody>(fluid));
+
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+	for (ndInt32 i = 0; i < 30; ++i)
+	{
+		world.Update(timestep);
+		world.Sync();
+		SphReferenceStep(referencePosit, referenceVeloc, fluid->GetParticleRadius(), fluid->GetRestDensity(), fluid->GetGasConstant(), timestep);
+	}
+
+	// the persistent path reorders the particles, compare order independent moments
+	const ndArray<ndVector>* const sets[2] = { &fluid->GetPositions(), &referencePosit };
+	ndVector sum[2];
+	ndVector sum2[2];
+	for (ndInt32 k = 0; k < 2; ++k)
+	{
+		const ndArray<ndVector>& points = *sets[k];
+		ASSERT_EQ(points.GetCount(), 512);
+		sum[k] = ndVector::m_zero;
+		sum2[k] = ndVector::m_zero;
+		for (ndInt32 i = 0; i < ndInt32(points.GetCount()); ++i)
+		{
+			EXPECT_TRUE(ndCheckVector(points[i]));
+			sum[k] += points[i];
+			sum2[k] += points[i] * points[i];
+		}
+	}
+	for (ndInt32 j = 0; j < 3; ++j)
+	{
+		EXPECT_NEAR(sum[0][j], sum[1][j], ndFloat32(1.0e-2f));
+		EXPECT_NEAR(sum2[0][j], sum2[1][j], ndFloat32(1.0e-2f));
+	}
+
+	// the block spreads under its own pressure, so the reference did find neighbors,
+	// the x variance of the initial lattice is 0.21
+	const ndFloat32 spread = sum2[1][0] / 512.0f - (sum[1][0] / 512.0f) * (sum[1][0] / 512.0f);
+	EXPECT_GT(spread, ndFloat32(0.25f));
+	world.CleanUp();
+}
+
+TEST(SphFluid, RigidCoupling)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+
+	// a sphere resting on top of a fluid block, without gravity
+	ndShapeInstance shape(new ndShapeSphere(ndFloat32(0.3f)));
+	ndBodyDynamic* const sphere = new ndBodyDynamic();
+	sphere->SetNotifyCallback(new ndBodyNotify(ndVector::m_zero));
+	sphere->SetCollisionShape(shape);
+	sphere->SetMassMatrix(ndFloat32(1.0f), shape);
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = ndVector(ndFloat32(0.9f), ndFloat32(4.0f), ndFloat32(0.9f), ndFloat32(1.0f));
+	sphere->SetMatrix(matrix);
+	world.AddBody(ndSharedPtr<ndBody>(sphere));
+
+	ndBodySphFluid* fluids[2];
+	for (ndInt32 k = 0; k < 2; ++k)
+	{
+		ndBodySphFluid* const fluid = new ndBodySphFluid();
+		fluid->SetParticleRadius(ndFloat32(0.125f));
+		fluid->SetAsynUpdate(false);
+		fluid->SetGasConstant(ndFloat32(0.0f));
+		fluid->SetPersistentCells(k ? false : true);
+		fluid->SetRigidCoupling(k ? true : false);
+		ndArray<ndVector>& posit = fluid->GetPositions();
+		ndArray<ndVector>& veloc = fluid->GetVelocity();
+		for (ndInt32 z = 0; z < 10; ++z)
+		{
+			for (ndInt32 y = 0; y < 10; ++y)
+			{
+				for (ndInt32 x = 0; x < 10; ++x)
+				{
+					posit.PushBack(ndVector(ndFloat32(x) * 0.2f, ndFloat32(2.0f + y * 0.2f), ndFloat32(z) * 0.2f, ndFloat32(0.0f)));
+					veloc.PushBack(ndVector::m_zero);
+				}
+			}
+		}
+		world.AddBody(ndSharedPtr<ndBody>(fluid));
+		fluids[k] = fluid;
+	}
+	EXPECT_TRUE(fluids[1]->GetPersistentCells());
+
+	ndInt32 coupledFrames = 0;
+	for (ndInt32 i = 0; i < 10; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+		EXPECT_EQ(fluids[0]->GetCoupledParticleCount(), 0);
+		coupledFrames += fluids[1]->GetCoupledParticleCount() ? 1 : 0;
+	}
+	EXPECT_GT(coupledFrames, 0);
+
+	// the fluid pushes the sphere up, and the sphere pushes the particles down
+	EXPECT_GT(sphere->GetVelocity().m_y, ndFloat32(0.0f));
+	ndFloat32 momentum = ndFloat32(0.0f);
+	const ndArray<ndVector>& veloc = fluids[1]->GetVelocity();
+	for (ndInt32 i = 0; i < ndInt32(veloc.GetCount()); ++i)
+	{
+		EXPECT_TRUE(ndCheckVector(veloc[i]));
+		momentum += veloc[i].m_y;
+	}
+	EXPECT_LT(momentum, ndFloat32(0.0f));
+	world.CleanUp();
+}
@@ -10,7 +10,11 @@
 * freely
 */
 
+#include <array>
 #include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
 #include "ndNewton.h"
 #include <gtest/gtest.h>
 
@@ -1398,26 +1402,13 @@ constexpr int numElementsInArray(Type(&)[N]) noexcept
 constexpr ndFloat32 STATIC_MASS = 0.0f;
 constexpr ndFloat32 TIME_STEP = (1.0f / 60.0f);
 
-static ndBodyDynamic* BuildStaticBunny(const ndVector& pos, const ndVector& gravity = { -9.8f })
+static void BuildBunnyMesh(ndPolygonSoupBuilder& meshBuilder)
 {
-	// Create the rigid body
-	ndBodyDynamic* const body = new ndBodyDynamic();
-
-	// We'll set gravity but because it's a static body
-	// gravity should have no effect
-	body->SetNotifyCallback(new ndBodyNotify(gravity));
-
-	// Set the position of the bunny in the world.
-	ndMatrix matrix(ndGetIdentityMatrix());
-	matrix.m_posit = pos;
-	body->SetMatrix(matrix);
-
 	// pointer to the beginning of the float array of bunny vertices
 	const REAL* const verticesBegin = gVerticesBunny;
 
 	ndUnsigned32 triCount = numElementsInArray(gIndicesBunny);
 
-	ndPolygonSoupBuilder meshBuilder;
 	meshBuilder.Begin();
 
 	for (ndUnsigned32 i = 0; i < triCount; ++i)
@@ -1443,6 +1434,24 @@ static ndBodyDynamic* BuildStaticBunny(const ndVector& pos, const ndVector& grav
 	}
 	bool optimize = true;
 	meshBuilder.End(optimize);
+}
+
+static ndBodyDynamic* BuildStaticBunny(const ndVector& pos, const ndVector& gravity = { -9.8f })
+{
+	// Create the rigid body
+	ndBodyDynamic* const body = new ndBodyDynamic();
+
+	// We'll set gravity but because it's a static body
+	// gravity should have no effect
+	body->SetNotifyCallback(new ndBodyNotify(gravity));
+
+	// Set the position of the bunny in the world.
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = pos;
+	body->SetMatrix(matrix);
+
+	ndPolygonSoupBuilder meshBuilder;
+	BuildBunnyMesh(meshBuilder);
 
 	ndShapeInstance bunnyShape(new ndShapeStatic_bvh(meshBuilder));
 	body->SetCollisionShape(bunnyShape);
@@ -1472,4 +1481,555 @@ TEST(StaticBody, mesh)
 	EXPECT_NEAR(staticBunny->GetMatrix().m_posit.m_x, startPosition.m_x, 1E-6);
 	EXPECT_NEAR(staticBunny->GetMatrix().m_posit.m_y, startPosition.m_y, 1E-6);
 	EXPECT_NEAR(staticBunny->GetMatrix().m_posit.m_z, startPosition.m_z, 1E-6);
-}
\ No newline at end of file
+}
+
+class ndQueryStaticBvh : public ndShapeStatic_bvh
+{
+	public:
+	ndQueryStaticBvh(const ndPolygonSoupBuilder& builder, bool compressedTree)
+		:ndShapeStatic_bvh(builder, compressedTree)
+	{
+	}
+
+	ndQueryStaticBvh(const char* const path, bool mapFile)
+		:ndShapeStatic_bvh(path, mapFile)
+	{
+	}
+
+	using ndShapeStatic_bvh::GetHash;
+	using ndShapeStatic_bvh::GetShapeInfo;
+	using ndAabbPolygonSoup::ForAllSectors;
+	using ndAabbPolygonSoup::ForAllSectorsRayHit;
+	using ndAabbPolygonSoup::ForAllSectorsSupportVertex;
+};
+
+static ndIntersectStatus CollectFaces(void* const context, const ndFloat32* const, ndInt32, const ndInt32* const indexArray, ndInt32, ndFloat32)
+{
+	std::vector<std::array<ndInt32, 3>>& faces = *(std::vector<std::array<ndInt32, 3>>*)context;
+	faces.push_back({ indexArray[0], indexArray[1], indexArray[2] });
+	return m_continueSearh;
+}
+
+static ndFloat32 ClosestFace(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount)
+{
+	const ndFastRay& ray = *(ndFastRay*)context;
+	ndVector normal(&polygon[indexArray[indexCount + 1] * (strideInBytes / sizeof(ndFloat32))]);
+	normal = normal & ndVector::m_triplexMask;
+	return ray.PolygonIntersect(normal, ndFloat32(1.0f), polygon, strideInBytes, indexArray, indexCount);
+}
+
+static ndIntersectStatus SetFaceTag(void* const context, const ndFloat32* const, ndInt32, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32)
+{
+	ndPolygonSoupDatabase* const mesh = (ndPolygonSoupDatabase*)(ndQueryStaticBvh*)context;
+	mesh->SetTagId(indexArray, indexCount, 7);
+	return m_continueSearh;
+}
+
+static ndIntersectStatus CollectFaceData(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32)
+{
+	// positions instead of indices, the compressed tree drops the box corners from the vertex pool
+	std::vector<std::vector<ndFloat32>>& faces = *(std::vector<std::vector<ndFloat32>>*)context;
+	const ndInt32 stride = strideInBytes / ndInt32(sizeof(ndFloat32));
+	std::vector<ndFloat32> face;
+	face.push_back(ndFloat32(indexArray[indexCount]));
+	face.push_back(ndFloat32(indexArray[indexCount * 2 + 2]));
+	for (ndInt32 i = 0; i < indexCount + 1; ++i)
+	{
+		const ndInt32 index = indexArray[indexCount + 1 + i];
+		if (index == -1)
+		{
+			face.push_back(ndFloat32(-1.0f));
+			continue;
+		}
+		const ndFloat32* const normal = &polygon[(index & (~D_CONCAVE_EDGE_MASK)) * stride];
+		face.push_back((index & D_CONCAVE_EDGE_MASK) ? ndFloat32(1.0f) : ndFloat32(0.0f));
+		face.insert(face.end(), normal, normal + 3);
+	}
+	for (ndInt32 i = 0; i < indexCount; ++i)
+	{
+		const ndFloat32* const point = &polygon[indexArray[i] * stride];
+		face.insert(face.end(), point, point + 3);
+	}
+	faces.push_back(face);
+	return m_continueSearh;
+}
+
+static std::vector<std::array<ndInt32, 3>> QueryFaces(const ndQueryStaticBvh& mesh, const ndFastAabb& box, const ndVector& travel)
+{
+	std::vector<std::array<ndInt32, 3>> faces;
+	mesh.ForAllSectors(box, travel, ndFloat32(1.0f), CollectFaces, &faces);
+	std::sort(faces.begin(), faces.end());
+	return faces;
+}
+
+struct ndClosestHit
+{
+	const ndFastRay* m_ray;
+	ndFloat32 m_t;
+};
+
+static ndFloat32 ClosestHit(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount)
+{
+	ndClosestHit& hit = *(ndClosestHit*)context;
+	const ndFloat32 t = ClosestFace((void*)hit.m_ray, polygon, strideInBytes, indexArray, indexCount);
+	hit.m_t = ndMin(hit.m_t, t);
+	return t;
+}
+
+TEST(StaticBody, compressedBvhQueries)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	BuildBunnyMesh(meshBuilder);
+
+	ndQueryStaticBvh* const binaryMesh = new ndQueryStaticBvh(meshBuilder, false);
+	ndQueryStaticBvh* const compressedMesh = new ndQueryStaticBvh(meshBuilder, true);
+	ndShapeInstance binaryShape(binaryMesh);
+	ndShapeInstance compressedShape(compressedMesh);
+
+	EXPECT_EQ(binaryMesh->GetCompressedNodesCount(), 0);
+	EXPECT_GT(compressedMesh->GetCompressedNodesCount(), 0);
+	EXPECT_EQ(binaryMesh->GetShapeInfo().m_bvh.m_indexCount, compressedMesh->GetShapeInfo().m_bvh.m_indexCount);
+
+	ndInt32 hitCount = 0;
+	ndInt32 overlapCount = 0;
+	ndFloat32 seed = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < 200; ++i)
+	{
+		// deterministic pseudo random samples around the bunny
+		ndVector samples[4];
+		for (ndInt32 j = 0; j < 4; ++j)
+		{
+			seed += ndFloat32(0.618034f);
+			const ndFloat32 a = ndFloat32(ndSin(seed * ndFloat32(12.9898f)) * 43758.5453f);
+			const ndFloat32 b = ndFloat32(ndSin(seed * ndFloat32(78.2330f)) * 12345.6789f);
+			const ndFloat32 c = ndFloat32(ndSin(seed * ndFloat32(39.4250f)) * 24680.1357f);
+			samples[j] = ndVector(a - ndFloor(a) - ndFloat32(0.5f), b - ndFloor(b), c - ndFloor(c) - ndFloat32(0.5f), ndFloat32(0.0f)).Scale(ndFloat32(1.2f));
+		}
+
+		// the compressed boxes are looser, but they must never cull a face the binary tree finds
+		ndMatrix matrix(ndPitchMatrix(samples[0].m_x * ndFloat32(3.0f)) * ndYawMatrix(samples[0].m_y * ndFloat32(3.0f)));
+		matrix.m_posit = samples[1] | ndVector::m_wOne;
+		const ndVector size(samples[2].Abs().Scale(ndFloat32(0.2f)) + ndVector(ndFloat32(0.01f)));
+		const ndFastAabb box(matrix, size & ndVector::m_triplexMask);
+		const ndVector travel(samples[3].Scale(ndFloat32(0.5f)) & ndVector::m_triplexMask);
+		for (ndInt32 j = 0; j < 2; ++j)
+		{
+			const ndVector boxTravel(j ? travel : ndVector::m_zero);
+			const std::vector<std::array<ndInt32, 3>> faces0(QueryFaces(*binaryMesh, box, boxTravel));
+			const std::vector<std::array<ndInt32, 3>> faces1(QueryFaces(*compressedMesh, box, boxTravel));
+			EXPECT_TRUE(std::includes(faces1.begin(), faces1.end(), faces0.begin(), faces0.end()));
+			overlapCount += faces0.size() ? 1 : 0;
+		}
+
+		// rays find the same closest hit
+		const ndFastRay ray(samples[1] - samples[3].Scale(ndFloat32(2.0f)), samples[1] + samples[3].Scale(ndFloat32(2.0f)));
+		ndClosestHit hit0 = { &ray, ndFloat32(1.2f) };
+		ndClosestHit hit1 = { &ray, ndFloat32(1.2f) };
+		binaryMesh->ForAllSectorsRayHit(ray, ndFloat32(1.0f), ClosestHit, &hit0);
+		compressedMesh->ForAllSectorsRayHit(ray, ndFloat32(1.0f), ClosestHit, &hit1);
+		EXPECT_NEAR(hit0.m_t, hit1.m_t, 1.0e-6f);
+		hitCount += (hit0.m_t < ndFloat32(1.0f)) ? 1 : 0;
+	}
+	EXPECT_GT(hitCount, 0);
+	EXPECT_GT(overlapCount, 0);
+}
+
+TEST(StaticBody, mappedBvhFile)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	BuildBunnyMesh(meshBuilder);
+
+	const std::string path(testing::TempDir() + "staticBodyBunny.bvh");
+	ndQueryStaticBvh* const sourceMesh = new ndQueryStaticBvh(meshBuilder, true);
+	ndShapeInstance sourceShape(sourceMesh);
+	sourceMesh->Serialize(path.c_str());
+
+	ndQueryStaticBvh* const mappedMesh = new ndQueryStaticBvh(path.c_str(), true);
+	ndQueryStaticBvh* const copiedMesh = new ndQueryStaticBvh(path.c_str(), false);
+	ndShapeInstance mappedShape(mappedMesh);
+	ndShapeInstance copiedShape(copiedMesh);
+
+	EXPECT_FALSE(sourceMesh->IsMapped());
+	EXPECT_TRUE(mappedMesh->IsMapped());
+	EXPECT_FALSE(copiedMesh->IsMapped());
+	EXPECT_EQ(mappedMesh->GetVertexCount(), sourceMesh->GetVertexCount());
+	EXPECT_EQ(mappedMesh->GetCompressedNodesCount(), sourceMesh->GetCompressedNodesCount());
+	EXPECT_EQ(copiedMesh->GetCompressedNodesCount(), sourceMesh->GetCompressedNodesCount());
+	EXPECT_EQ(mappedMesh->GetShapeInfo().m_bvh.m_indexCount, sourceMesh->GetShapeInfo().m_bvh.m_indexCount);
+	EXPECT_EQ(copiedMesh->GetShapeInfo().m_bvh.m_indexCount, sourceMesh->GetShapeInfo().m_bvh.m_indexCount);
+
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = ndVector(ndFloat32(0.0f), ndFloat32(0.3f), ndFloat32(0.0f), ndFloat32(1.0f));
+	const ndFastAabb box(matrix, ndVector(ndFloat32(0.2f), ndFloat32(0.2f), ndFloat32(0.2f), ndFloat32(0.0f)));
+	const std::vector<std::array<ndInt32, 3>> faces(QueryFaces(*sourceMesh, box, ndVector::m_zero));
+	EXPECT_FALSE(faces.empty());
+	EXPECT_EQ(faces, QueryFaces(*mappedMesh, box, ndVector::m_zero));
+	EXPECT_EQ(faces, QueryFaces(*copiedMesh, box, ndVector::m_zero));
+
+	// the mapping is copy on write, changing a face tag must not touch the file
+	mappedMesh->ForAllSectors(box, ndVector::m_zero, ndFloat32(1.0f), SetFaceTag, mappedMesh);
+	ndQueryStaticBvh* const remappedMesh = new ndQueryStaticBvh(path.c_str(), true);
+	ndShapeInstance remappedShape(remappedMesh);
+	EXPECT_NE(mappedMesh->GetHash(0), remappedMesh->GetHash(0));
+	EXPECT_EQ(sourceMesh->GetHash(0), remappedMesh->GetHash(0));
+}
+
+TEST(StaticBody, bvhFileLayoutMismatch)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	BuildBunnyMesh(meshBuilder);
+
+	const std::string path(testing::TempDir() + "staticBodyBunnyLayout.bvh");
+	const std::string badPath(testing::TempDir() + "staticBodyBunnyBadLayout.bvh");
+	ndQueryStaticBvh* const sourceMesh = new ndQueryStaticBvh(meshBuilder, true);
+	ndShapeInstance sourceShape(sourceMesh);
+	sourceMesh->Serialize(path.c_str());
+
+	// same file, written by a build with a different node size
+	std::vector<char> data;
+	FILE* const src = fopen(path.c_str(), "rb");
+	ASSERT_NE(src, nullptr);
+	for (int ch = fgetc(src); ch != EOF; ch = fgetc(src))
+	{
+		data.push_back(char(ch));
+	}
+	fclose(src);
+	ASSERT_GT(data.size(), size_t(16));
+	const ndInt32 nodeSize = 0;
+	memcpy(&data[12], &nodeSize, sizeof(nodeSize));
+	FILE* const dst = fopen(badPath.c_str(), "wb");
+	ASSERT_NE(dst, nullptr);
+	fwrite(&data[0], data.size(), 1, dst);
+	fclose(dst);
+
+	ndQueryStaticBvh* const badMesh = new ndQueryStaticBvh(badPath.c_str(), false);
+	ndShapeInstance badShape(badMesh);
+	EXPECT_EQ(badMesh->GetVertexCount(), 0);
+	EXPECT_EQ(badMesh->GetShapeInfo().m_bvh.m_indexCount, 0);
+	EXPECT_FALSE(badMesh->Deserialize(badPath.c_str()));
+	EXPECT_FALSE(badMesh->MapFile(badPath.c_str()));
+
+	EXPECT_TRUE(badMesh->Deserialize(path.c_str()));
+	EXPECT_EQ(badMesh->GetVertexCount(), sourceMesh->GetVertexCount());
+}
+
+TEST(StaticBody, compressedBvhFootprint)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	BuildBunnyMesh(meshBuilder);
+
+	ndQueryStaticBvh* const binaryMesh = new ndQueryStaticBvh(meshBuilder, false);
+	ndQueryStaticBvh* const compressedMesh = new ndQueryStaticBvh(meshBuilder, true);
+	ndShapeInstance binaryShape(binaryMesh);
+	ndShapeInstance compressedShape(compressedMesh);
+
+	// the compressed tree drops the binary nodes and their box corners, and stores 16 bit faces
+	EXPECT_GT(binaryMesh->GetNodesCount(), 0);
+	EXPECT_EQ(compressedMesh->GetNodesCount(), 0);
+	EXPECT_EQ(compressedMesh->GetRootNode(), nullptr);
+	EXPECT_LT(compressedMesh->GetVertexCount(), binaryMesh->GetVertexCount());
+	EXPECT_LT(compressedMesh->GetIndexBufferSize(), binaryMesh->GetIndexBufferSize());
+	EXPECT_LT(compressedMesh->GetShapeInfo().m_bvh.m_vertexCount, binaryMesh->GetShapeInfo().m_bvh.m_vertexCount);
+	EXPECT_EQ(compressedMesh->GetShapeInfo().m_bvh.m_indexCount, binaryMesh->GetShapeInfo().m_bvh.m_indexCount);
+
+	ndVector p0;
+	ndVector p1;
+	ndVector q0;
+	ndVector q1;
+	binaryMesh->GetAABB(p0, p1);
+	compressedMesh->GetAABB(q0, q1);
+	EXPECT_EQ((p0 == q0).GetSignMask() & 7, 7);
+	EXPECT_EQ((p1 == q1).GetSignMask() & 7, 7);
+
+	// the decoded faces carry the same ids, normals and edge normals
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = ndVector(ndFloat32(0.0f), ndFloat32(0.3f), ndFloat32(0.0f), ndFloat32(1.0f));
+	const ndFastAabb box(matrix, ndVector(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.0f)));
+	std::vector<std::vector<ndFloat32>> faces[2];
+	ndQueryStaticBvh* const meshes[] = { binaryMesh, compressedMesh };
+	for (ndInt32 i = 0; i < 2; ++i)
+	{
+		meshes[i]->ForAllSectors(box, ndVector::m_zero, ndFloat32(1.0f), CollectFaceData, &faces[i]);
+		std::sort(faces[i].begin(), faces[i].end());
+	}
+	EXPECT_FALSE(faces[0].empty());
+	EXPECT_EQ(faces[0], faces[1]);
+
+	// the support vertex of the compressed tree is a mesh vertex as far out as the box allows
+	for (ndInt32 i = 0; i < 8; ++i)
+	{
+		const ndVector dir(ndVector((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 0.0f).Normalize());
+		const ndVector support(compressedMesh->ForAllSectorsSupportVertex(dir));
+		const ndFloat32 boxSupport = ndVector((i & 1) ? q1.m_x : q0.m_x, (i & 2) ? q1.m_y : q0.m_y, (i & 4) ? q1.m_z : q0.m_z, 0.0f).DotProduct(dir).GetScalar();
+		EXPECT_LE(support.DotProduct(dir).GetScalar(), boxSupport + ndFloat32(1.0e-4f));
+		EXPECT_GT(support.DotProduct(dir).GetScalar(), ndFloat32(0.0f));
+	}
+}
+
+class ndTestRayNotify : public ndRayCastNotify
+{
+	public:
+	ndFloat32 OnRayCastAction(const ndContactPoint&, ndFloat32 intersetParam)
+	{
+		return intersetParam;
+	}
+};
+
+static ndFloat32 TerrainElevation(ndInt32 x, ndInt32 z)
+{
+	return ndFloat32(2.0f) * ndSin(ndFloat32(0.3f) * ndFloat32(x)) * ndCos(ndFloat32(0.25f) * ndFloat32(z)) + ndFloat32(0.1f) * ndFloat32((x * 7 + z * 13) % 5);
+}
+
+static ndFloat32 RayTriangle(const ndVector& p0, const ndVector& dp, const ndVector& v0, const ndVector& v1, const ndVector& v2)
+{
+	const ndVector e1(v1 - v0);
+	const ndVector e2(v2 - v0);
+	// the terrain is one sided, rays from below pass through
+	const ndVector normal(e1.CrossProduct(e2));
+	if ((normal.m_y * normal.DotProduct(dp).GetScalar()) >= ndFloat32(0.0f))
+	{
+		return ndFloat32(1.2f);
+	}
+	const ndVector p(dp.CrossProduct(e2));
+	const ndFloat32 det = e1.DotProduct(p).GetScalar();
+	if (ndAbs(det) < ndFloat32(1.0e-9f))
+	{
+		return ndFloat32(1.2f);
+	}
+	const ndVector s(p0 - v0);
+	const ndFloat32 u = s.DotProduct(p).GetScalar() / det;
+	const ndVector q(s.CrossProduct(e1));
+	const ndFloat32 v = dp.DotProduct(q).GetScalar() / det;
+	if ((u < ndFloat32(0.0f)) || (v < ndFloat32(0.0f)) || ((u + v) > ndFloat32(1.0f)))
+	{
+		return ndFloat32(1.2f);
+	}
+	const ndFloat32 t = e2.DotProduct(q).GetScalar() / det;
+	return ((t >= ndFloat32(0.0f)) && (t <= ndFloat32(1.0f))) ? t : ndFloat32(1.2f);
+}
+
+// brute force ray cast against every triangle of a heightfield with normal diagonals
+static ndFloat32 RayTerrain(const ndShapeHeightfield& shape, ndInt32 width, ndInt32 height, const ndVector& p0, const ndVector& p1)
+{
+	const ndArray<ndReal>& elevation = shape.GetElevationMap();
+	const ndVector dp(p1 - p0);
+	ndFloat32 tMin = ndFloat32(1.2f);
+	for (ndInt32 z = 0; z < height - 1; ++z)
+	{
+		for (ndInt32 x = 0; x < width - 1; ++x)
+		{
+			const ndVector q0(ndFloat32(x + 0), ndFloat32(elevation[(z + 0) * width + x + 0]), ndFloat32(z + 0), ndFloat32(0.0f));
+			const ndVector q1(ndFloat32(x + 1), ndFloat32(elevation[(z + 0) * width + x + 1]), ndFloat32(z + 0), ndFloat32(0.0f));
+			const ndVector q2(ndFloat32(x + 0), ndFloat32(elevation[(z + 1) * width + x + 0]), ndFloat32(z + 1), ndFloat32(0.0f));
+			const ndVector q3(ndFloat32(x + 1), ndFloat32(elevation[(z + 1) * width + x + 1]), ndFloat32(z + 1), ndFloat32(0.0f));
+			tMin = ndMin(tMin, RayTriangle(p0, dp, q1, q2, q3));
+			tMin = ndMin(tMin, RayTriangle(p0, dp, q1, q0, q2));
+		}
+	}
+	return tMin;
+}
+
+TEST(StaticBody, heightfieldMipQueries)
+{
+	const ndInt32 width = 37;
+	const ndInt32 height = 29;
+	ndShapeHeightfield* const terrain = new ndShapeHeightfield(width, height, ndShapeHeightfield::m_normalDiagonals, ndFloat32(1.0f), ndFloat32(1.0f));
+	ndShapeInstance terrainShape(terrain);
+	for (ndInt32 z = 0; z < height; ++z)
+	{
+		for (ndInt32 x = 0; x < width; ++x)
+		{
+			terrain->GetElevationMap()[z * width + x] = ndReal(TerrainElevation(x, z));
+		}
+	}
+	terrain->UpdateElevationMapAabb();
+
+	// edit a region and update only the tiles under it
+	for (ndInt32 z = 10; z <= 14; ++z)
+	{
+		for (ndInt32 x = 20; x <= 23; ++x)
+		{
+			terrain->GetElevationMap()[z * width + x] = ndReal(6.0f + ndFloat32(x - z) * 0.1f);
+		}
+	}
+	terrain->UpdateElevationMapAabb(20, 10, 23, 14);
+
+	ndFloat32 maxElevation = ndFloat32(-1.0e10f);
+	for (ndInt32 i = 0; i < width * height; ++i)
+	{
+		maxElevation = ndMax(maxElevation, ndFloat32(terrain->GetElevationMap()[i]));
+	}
+	EXPECT_FLOAT_EQ(terrain->GetObbOrigin().m_y + terrain->GetObbSize().m_y, maxElevation);
+
+	// local aabbs must match the elevation of the vertices they cover
+	ndFloat32 seed = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < 200; ++i)
+	{
+		seed += ndFloat32(0.618034f);
+		const ndFloat32 fx = (seed - ndFloor(seed)) * ndFloat32(width - 6);
+		const ndFloat32 fz = ndFloat32((i * 7) % (height - 6)) + ndFloat32(0.25f);
+		const ndFloat32 size = ndFloat32(1 + i % 5);
+		const ndVector q0(fx, ndFloat32(-10.0f), fz, ndFloat32(0.0f));
+		const ndVector q1(fx + size, ndFloat32(10.0f), fz + size, ndFloat32(0.0f));
+		ndVector boxP0;
+		ndVector boxP1;
+		terrain->GetLocalAabb(q0, q1, boxP0, boxP1);
+
+		ndFloat32 minHeight = ndFloat32(1.0e10f);
+		ndFloat32 maxHeight = ndFloat32(-1.0e10f);
+		for (ndInt32 z = ndInt32(boxP0.m_z); z <= ndInt32(boxP1.m_z); ++z)
+		{
+			for (ndInt32 x = ndInt32(boxP0.m_x); x <= ndInt32(boxP1.m_x); ++x)
+			{
+				minHeight = ndMin(minHeight, ndFloat32(terrain->GetElevationMap()[z * width + x]));
+				maxHeight = ndMax(maxHeight, ndFloat32(terrain->GetElevationMap()[z * width + x]));
+			}
+		}
+		EXPECT_FLOAT_EQ(boxP0.m_y, minHeight);
+		EXPECT_FLOAT_EQ(boxP1.m_y, maxHeight);
+	}
+
+	// long grazing rays skip the tiles under them, the first hit must not change
+	ndTestRayNotify notify;
+	ndInt32 hitCount = 0;
+	for (ndInt32 i = 0; i < 300; ++i)
+	{
+		seed += ndFloat32(0.618034f);
+		const ndFloat32 s = seed - ndFloor(seed);
+		const ndFloat32 angle = ndFloat32(i) * ndFloat32(0.37f);
+		const ndVector center(ndFloat32(width - 1) * s, ndFloat32(0.0f), ndFloat32(height - 1) * ndFloat32(0.5f), ndFloat32(0.0f));
+		const ndVector dir(ndCos(angle), ndFloat32(0.0f), ndSin(angle), ndFloat32(0.0f));
+		const ndVector p0(center - dir.Scale(ndFloat32(30.0f)) + ndVector(ndFloat32(0.0f), ndFloat32(3.0f + (i % 4)), ndFloat32(0.0f), ndFloat32(0.0f)));
+		const ndVector p1(center + dir.Scale(ndFloat32(30.0f)) - ndVector(ndFloat32(0.0f), ndFloat32(i % 7), ndFloat32(0.0f), ndFloat32(0.0f)));
+
+		ndContactPoint contact;
+		const ndFloat32 t = terrainShape.RayCast(notify, p0, p1, nullptr, contact);
+		const ndFloat32 tRef = RayTerrain(*terrain, width, height, p0, p1);
+		if (tRef < ndFloat32(1.0f))
+		{
+			hitCount++;
+			EXPECT_NEAR(t, tRef, ndFloat32(1.0e-4f));
+		}
+		else
+		{
+			EXPECT_GE(t, ndFloat32(1.0f));
+		}
+	}
+	EXPECT_GT(hitCount, 50);
+}
+
+TEST(StaticBody, heightfieldSingleRowMip)
+{
+	// maps one vertex wide still build a pyramid that ends in a single root tile
+	for (ndInt32 i = 0; i < 2; ++i)
+	{
+		const ndInt32 width = i ? 1 : 9;
+		const ndInt32 height = i ? 9 : 1;
+		ndShapeHeightfield* const terrain = new ndShapeHeightfield(width, height, ndShapeHeightfield::m_normalDiagonals, ndFloat32(1.0f), ndFloat32(1.0f));
+		ndShapeInstance terrainShape(terrain);
+		for (ndInt32 j = 0; j < width * height; ++j)
+		{
+			terrain->GetElevationMap()[j] = ndReal(ndFloat32(j) * ndFloat32(0.5f));
+		}
+		terrain->UpdateElevationMapAabb();
+		EXPECT_FLOAT_EQ(terrain->GetObbOrigin().m_y + terrain->GetObbSize().m_y, ndFloat32(4.0f));
+		EXPECT_FLOAT_EQ(terrain->GetObbOrigin().m_y - terrain->GetObbSize().m_y, ndFloat32(0.0f));
+	}
+}
+
+class ndTestProceduralGrid : public ndShapeStaticProceduralMesh
+{
+	public:
+	ndTestProceduralGrid()
+		:ndShapeStaticProceduralMesh(ndFloat32(200.0f), ndFloat32(10.0f), ndFloat32(200.0f))
+		,m_callbacks(0)
+	{
+	}
+
+	virtual void GetCollidingFaces(const ndVector& minBox, const ndVector& maxBox, ndArray<ndVector>& vertex, ndArray<ndInt32>& faceList, ndArray<ndInt32>& faceMaterial, ndArray<ndInt32>& indexListList) const
+	{
+		m_callbacks.fetch_add(1);
+		const ndVector p0(minBox.Floor());
+		const ndVector p1(maxBox.Floor() + ndVector::m_one);
+		const ndInt32 count_x = ndInt32(p1.m_x - p0.m_x);
+		const ndInt32 count_z = ndInt32(p1.m_z - p0.m_z);
+		for (ndInt32 iz = 0; iz <= count_z; iz++)
+		{
+			for (ndInt32 ix = 0; ix <= count_x; ix++)
+			{
+				vertex.PushBack(ndVector(p0.m_x + ndFloat32(ix), ndFloat32(0.0f), p0.m_z + ndFloat32(iz), ndFloat32(0.0f)));
+			}
+		}
+
+		const ndInt32 stride = count_x + 1;
+		for (ndInt32 iz = 0; iz < count_z; iz++)
+		{
+			for (ndInt32 ix = 0; ix < count_x; ix++)
+			{
+				faceList.PushBack(4);
+				indexListList.PushBack((iz + 0) * stride + ix + 0);
+				indexListList.PushBack((iz + 1) * stride + ix + 0);
+				indexListList.PushBack((iz + 1) * stride + ix + 1);
+				indexListList.PushBack((iz + 0) * stride + ix + 1);
+				faceMaterial.PushBack(0);
+			}
+		}
+	}
+
+	mutable ndAtomic<ndInt32> m_callbacks;
+};
+
+static ndFloat32 DropBoxOnProceduralGrid(ndTestProceduralGrid* const grid)
+{
+	ndWorld world;
+	ndShapeInstance gridShape(grid);
+	ndBodyKinematic* const floor = new ndBodyKinematic();
+	floor->SetCollisionShape(gridShape);
+	floor->SetMatrix(ndGetIdentityMatrix());
+	world.AddBody(ndSharedPtr<ndBody>(floor));
+
+	ndShapeInstance boxShape(new ndShapeBox(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f)));
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = ndVector(ndFloat32(0.3f), ndFloat32(1.0f), ndFloat32(0.3f), ndFloat32(1.0f));
+	ndBodyDynamic* const box = new ndBodyDynamic();
+	box->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+	box->SetCollisionShape(boxShape);
+	box->SetMatrix(matrix);
+	box->SetMassMatrix(ndFloat32(1.0f), boxShape);
+	world.AddBody(ndSharedPtr<ndBody>(box));
+
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+	const ndFloat32 height = box->GetMatrix().m_posit.m_y;
+	world.CleanUp();
+	return height;
+}
+
+TEST(StaticBody, proceduralFaceCache)
+{
+	ndTestProceduralGrid* const grid = new ndTestProceduralGrid();
+	ndShapeInstance uncachedShape(grid);
+	const ndFloat32 uncachedHeight = DropBoxOnProceduralGrid(grid);
+	const ndInt32 uncachedCallbacks = grid->m_callbacks.load();
+
+	ndTestProceduralGrid* const cachedGrid = new ndTestProceduralGrid();
+	ndShapeInstance cachedShape(cachedGrid);
+	cachedGrid->SetFaceCache(ndFloat32(2.0f), 4);
+	const ndFloat32 cachedHeight = DropBoxOnProceduralGrid(cachedGrid);
+	const ndShapeStaticProceduralMesh::ndFaceCacheStatistics stats(cachedGrid->GetFaceCacheStatistics());
+
+	// the resting box keeps querying the same region, only the fall misses the cache
+	EXPECT_GT(uncachedCallbacks, 20);
+	EXPECT_EQ(ndInt32(stats.m_misses), cachedGrid->m_callbacks.load());
+	EXPECT_LT(stats.m_misses, ndUnsigned64(5));
+	EXPECT_GT(stats.m_hits, ndUnsigned64(20));
+	EXPECT_LE(stats.m_entries, 4);
+	EXPECT_NEAR(cachedHeight, uncachedHeight, ndFloat32(1.0e-3f));
+	EXPECT_GT(cachedHeight, ndFloat32(0.2f));
+
+	cachedGrid->InvalidateFaceCache(ndVector(ndFloat32(-1.0f)), ndVector(ndFloat32(1.0f)));
+	EXPECT_EQ(cachedGrid->GetFaceCacheStatistics().m_entries, 0);
+}
@@ -0,0 +1,178 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Tiled static world: tiles load near dynamic bodies and unload when they move away. */
+class ndTestFloorTile : public ndTiledStaticWorld::ndTile
+{
+	public:
+	ndTestFloorTile(ndFloat32 x)
+		:ndTiledStaticWorld::ndTile(ndVector(x - 5.0f, -1.0f, -5.0f, 0.0f), ndVector(x + 5.0f, 0.0f, 5.0f, 0.0f), 1024)
+		,m_x(x)
+	{
+	}
+
+	ndSharedPtr<ndBody> Load()
+	{
+		ndShapeInstance shape(new ndShapeBox(ndFloat32(10.0f), ndFloat32(1.0f), ndFloat32(10.0f)));
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = m_x;
+		matrix.m_posit.m_y = ndFloat32(-0.5f);
+		ndBodyKinematic* const body = new ndBodyKinematic();
+		body->SetCollisionShape(shape);
+		body->SetMatrix(matrix);
+		return ndSharedPtr<ndBody>(body);
+	}
+
+	ndFloat32 m_x;
+};
+
+TEST(TiledStaticWorld, LoadAndUnload)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+
+	ndShapeInstance boxShape(new ndShapeBox(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f)));
+	ndBodyDynamic* const box = new ndBodyDynamic();
+	box->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+	box->SetCollisionShape(boxShape);
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = ndFloat32(1.0f);
+	box->SetMatrix(matrix);
+	box->SetMassMatrix(ndFloat32(1.0f), boxShape);
+	world.AddBody(ndSharedPtr<ndBody>(box));
+
+	{
+		ndTiledStaticWorld tiles(&world);
+		tiles.SetRadius(ndFloat32(2.0f), ndFloat32(8.0f));
+		tiles.SetMemoryBudget(2 * 1024);
+		for (ndInt32 i = 0; i < 8; ++i)
+		{
+			tiles.AddTile(new ndTestFloorTile(ndFloat32(i * 10)));
+		}
+
+		// only the tile under the box is in range
+		tiles.Update();
+		tiles.Flush();
+		EXPECT_EQ(tiles.GetStatistics().m_loadedCount, 1);
+		EXPECT_EQ(tiles.GetTile(0)->GetState(), ndTiledStaticWorld::ndTile::m_loaded);
+
+		for (ndInt32 i = 0; i < 60; ++i)
+		{
+			world.Update(1.0f / 60.0f);
+			world.Sync();
+			tiles.Update();
+		}
+		// the streamed floor holds the box
+		EXPECT_GT(box->GetMatrix().m_posit.m_y, ndFloat32(0.0f));
+
+		// teleport the box over tile 5, tile 0 is out of the unload radius
+		matrix.m_posit.m_x = ndFloat32(50.0f);
+		box->SetMatrix(matrix);
+		tiles.Update();
+		tiles.Flush();
+		EXPECT_EQ(tiles.GetTile(0)->GetState(), ndTiledStaticWorld::ndTile::m_unloaded);
+		EXPECT_EQ(tiles.GetTile(5)->GetState(), ndTiledStaticWorld::ndTile::m_loaded);
+		EXPECT_LE(tiles.GetStatistics().m_residentMemory, size_t(2 * 1024));
+		EXPECT_EQ(tiles.GetStatistics().m_unloadsCompleted, 1);
+		EXPECT_EQ(tiles.GetStatistics().m_loadsCompleted, 2);
+
+		// the box on the border of tiles 5 and 6 needs both, the budget holds two tiles
+		matrix.m_posit.m_x = ndFloat32(55.0f);
+		box->SetMatrix(matrix);
+		tiles.Update();
+		tiles.Flush();
+		EXPECT_EQ(tiles.GetStatistics().m_loadedCount, 2);
+
+		for (ndInt32 i = 0; i < 10; ++i)
+		{
+			world.Update(1.0f / 60.0f);
+			world.Sync();
+			tiles.Update();
+		}
+		EXPECT_GT(box->GetMatrix().m_posit.m_y, ndFloat32(0.0f));
+		EXPECT_GE(tiles.GetStatistics().m_maxLoadLatency, ndFloat32(0.0f));
+	}
+	world.CleanUp();
+}
+
+/* Changing the thread count replaces the background worker, the loads
+ * queued on the old worker still complete. */
+class ndTestSlowFloorTile : public ndTestFloorTile
+{
+	public:
+	ndTestSlowFloorTile(ndFloat32 x)
+		:ndTestFloorTile(x)
+	{
+	}
+
+	ndSharedPtr<ndBody> Load()
+	{
+		// long enough for the loads to be queued when the worker is replaced
+		const ndUnsigned64 start = ndGetTimeInMicroseconds();
+		while ((ndGetTimeInMicroseconds() - start) < 20000)
+		{
+			ndThreadYield();
+		}
+		return ndTestFloorTile::Load();
+	}
+};
+
+TEST(TiledStaticWorld, ThreadCountChange)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+
+	ndShapeInstance boxShape(new ndShapeBox(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f)));
+	ndBodyDynamic* const box = new ndBodyDynamic();
+	box->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+	box->SetCollisionShape(boxShape);
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = ndFloat32(1.0f);
+	box->SetMatrix(matrix);
+	box->SetMassMatrix(ndFloat32(1.0f), boxShape);
+	world.AddBody(ndSharedPtr<ndBody>(box));
+
+	{
+		ndTiledStaticWorld tiles(&world);
+		tiles.SetRadius(ndFloat32(30.0f), ndFloat32(40.0f));
+		for (ndInt32 i = 0; i < 8; ++i)
+		{
+			tiles.AddTile(new ndTestSlowFloorTile(ndFloat32(i * 10)));
+		}
+
+		// four tiles are in range, all of them are still loading when the worker is replaced
+		tiles.Update();
+		EXPECT_EQ(tiles.GetStatistics().m_loadingCount, 4);
+		world.SetThreadCount(4);
+		tiles.Flush();
+		EXPECT_EQ(tiles.GetStatistics().m_loadedCount, 4);
+		for (ndInt32 i = 0; i < 4; ++i)
+		{
+			EXPECT_EQ(tiles.GetTile(i)->GetState(), ndTiledStaticWorld::ndTile::m_loaded);
+		}
+
+		// the new worker takes the next loads, and the manager is destroyed with loads in flight
+		matrix.m_posit.m_x = ndFloat32(70.0f);
+		box->SetMatrix(matrix);
+		tiles.Update();
+		tiles.Flush();
+		EXPECT_EQ(tiles.GetTile(7)->GetState(), ndTiledStaticWorld::ndTile::m_loaded);
+
+		matrix.m_posit.m_x = ndFloat32(0.0f);
+		box->SetMatrix(matrix);
+		tiles.Update();
+		world.SetThreadCount(2);
+	}
+	world.CleanUp();
+}
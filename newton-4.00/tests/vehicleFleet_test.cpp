@@ -0,0 +1,122 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Vehicle fleet: the batched brush model matches the per vehicle brush model. */
+#ifndef _DEBUG
+// ndMultiBodyVehicle still asserts in its constructor in debug builds.
+class ndFleetTestScene
+{
+	public:
+	ndFleetTestScene(bool perVehicleTireModel)
+		:m_world()
+		,m_vehicle(ndVector(0.0f, 0.0f, 1.0f, 0.0f), ndVector(0.0f, 1.0f, 0.0f, 0.0f))
+		,m_material()
+		,m_fleet(nullptr)
+		,m_tire(nullptr)
+		,m_tireBody(nullptr)
+	{
+		m_material.m_staticFriction0 = ndFloat32(1.0f);
+		m_material.m_flags = m_material.m_flags | m_useBrushTireModel;
+		m_world.GetScene()->GetContactNotify()->GetMaterialPairTable().SetMaterial(0, 0, &m_material);
+
+		const ndVector gravity(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f));
+		ndShapeInstance floorShape(new ndShapeBox(ndFloat32(200.0f), ndFloat32(1.0f), ndFloat32(200.0f)));
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_y = ndFloat32(-0.5f);
+		ndBodyKinematic* const floor = new ndBodyKinematic();
+		floor->SetCollisionShape(floorShape);
+		floor->SetMatrix(matrix);
+		m_world.AddBody(ndSharedPtr<ndBody>(floor));
+
+		// the tire rolls forward, skids sideways and spins slower than the ground speed
+		const ndVector veloc(ndFloat32(1.5f), ndFloat32(0.0f), ndFloat32(10.0f), ndFloat32(0.0f));
+		ndShapeInstance chassisShape(new ndShapeBox(ndFloat32(2.0f), ndFloat32(0.5f), ndFloat32(4.0f)));
+		matrix.m_posit.m_y = ndFloat32(1.0f);
+		ndBodyDynamic* const chassis = new ndBodyDynamic();
+		chassis->SetCollisionShape(chassisShape);
+		chassis->SetMatrix(matrix);
+		chassis->SetMassMatrix(ndFloat32(200.0f), chassisShape);
+		chassis->SetNotifyCallback(new ndBodyNotify(gravity));
+		chassis->SetVelocity(veloc);
+		m_world.AddBody(ndSharedPtr<ndBody>(chassis));
+		m_vehicle.AddChassis(chassis);
+
+		const ndFloat32 radius = ndFloat32(0.4f);
+		ndShapeInstance tireShape(new ndShapeChamferCylinder(ndFloat32(0.5f), ndFloat32(0.5f)));
+		tireShape.SetScale(ndVector(ndFloat32(0.3f), radius, radius, ndFloat32(0.0f)));
+		matrix.m_posit.m_y = radius - ndFloat32(0.01f);
+		m_tireBody = new ndBodyDynamic();
+		m_tireBody->SetCollisionShape(tireShape);
+		m_tireBody->SetMatrix(matrix);
+		m_tireBody->SetMassMatrix(ndFloat32(20.0f), tireShape);
+		m_tireBody->SetNotifyCallback(new ndBodyNotify(gravity));
+		m_tireBody->SetVelocity(veloc);
+		m_tireBody->SetOmega(ndVector(ndFloat32(0.8f) * veloc.m_z / radius, ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+		m_world.AddBody(ndSharedPtr<ndBody>(m_tireBody));
+
+		ndMultiBodyVehicleTireJointInfo info;
+		info.m_radios = radius;
+		info.m_springK = ndFloat32(2000.0f);
+		info.m_damperC = ndFloat32(100.0f);
+		m_tire = new ndMultiBodyVehicleTireJoint(matrix, m_tireBody, chassis, info, &m_vehicle);
+		m_world.AddJoint(ndSharedPtr<ndJointBilateralConstraint>(m_tire));
+
+		m_fleet = new ndMultiBodyVehicleFleet();
+		m_fleet->AddTire(m_tire);
+		m_fleet->SetPerVehicleTireModel(perVehicleTireModel);
+		m_world.AddModel(ndSharedPtr<ndModel>(m_fleet));
+	}
+
+	~ndFleetTestScene()
+	{
+		m_world.CleanUp();
+	}
+
+	ndWorld m_world;
+	ndMultiBodyVehicle m_vehicle;
+	ndMaterial m_material;
+	ndMultiBodyVehicleFleet* m_fleet;
+	ndMultiBodyVehicleTireJoint* m_tire;
+	ndBodyDynamic* m_tireBody;
+};
+
+TEST(VehicleFleet, MatchesPerVehicleTireModel)
+{
+	ndFleetTestScene batched(false);
+	ndFleetTestScene reference(true);
+
+	ndFloat32 maxSideSlip = ndFloat32(0.0f);
+	ndFloat32 maxLongitudinalSlip = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < 20; ++i)
+	{
+		batched.m_world.Update(1.0f / 60.0f);
+		reference.m_world.Update(1.0f / 60.0f);
+		batched.m_world.Sync();
+		reference.m_world.Sync();
+
+		EXPECT_NEAR(batched.m_tire->GetSideSlip(), reference.m_tire->GetSideSlip(), 1.0e-4f);
+		EXPECT_NEAR(batched.m_tire->GetLongitudinalSlip(), reference.m_tire->GetLongitudinalSlip(), 1.0e-4f);
+		const ndVector velocError(batched.m_tireBody->GetVelocity() - reference.m_tireBody->GetVelocity());
+		const ndVector omegaError(batched.m_tireBody->GetOmega() - reference.m_tireBody->GetOmega());
+		EXPECT_LT(ndSqrt(velocError.DotProduct(velocError).GetScalar()), ndFloat32(1.0e-3f));
+		EXPECT_LT(ndSqrt(omegaError.DotProduct(omegaError).GetScalar()), ndFloat32(1.0e-3f));
+		maxSideSlip = ndMax(maxSideSlip, reference.m_tire->GetSideSlip());
+		maxLongitudinalSlip = ndMax(maxLongitudinalSlip, reference.m_tire->GetLongitudinalSlip());
+	}
+
+	// the contacts went through the brush model, not the coulomb fallback
+	EXPECT_GT(maxSideSlip, ndFloat32(0.0f));
+	EXPECT_GT(maxLongitudinalSlip, ndFloat32(0.0f));
+}
+#endif
@@ -0,0 +1,127 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include <vector>
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static void BuildDeterministicPile(ndWorld& world)
+{
+	ndShapeInstance floorShape(new ndShapeBox(ndFloat32(40.0f), ndFloat32(1.0f), ndFloat32(40.0f)));
+	ndBodyKinematic* const floor = new ndBodyKinematic();
+	floor->SetCollisionShape(floorShape);
+	floor->SetMatrix(ndGetIdentityMatrix());
+	world.AddBody(ndSharedPtr<ndBody>(floor));
+
+	ndShapeInstance boxShape(new ndShapeBox(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f)));
+	for (ndInt32 i = 0; i < 64; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32((i % 4) - 2) * ndFloat32(0.45f);
+		matrix.m_posit.m_y = ndFloat32(1.0f) + ndFloat32(i / 4) * ndFloat32(0.55f);
+		matrix.m_posit.m_z = ndFloat32((i / 16) - 2) * ndFloat32(0.45f);
+
+		ndBodyDynamic* const box = new ndBodyDynamic();
+		box->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+		box->SetCollisionShape(boxShape);
+		box->SetMatrix(matrix);
+		box->SetMassMatrix(ndFloat32(1.0f), boxShape);
+		world.AddBody(ndSharedPtr<ndBody>(box));
+	}
+}
+
+/* Deterministic mode: the per frame state hash does not depend on the thread count. */
+TEST(WorldUpdate, DeterministicThreadCount)
+{
+	ndWorld world0;
+	world0.SetThreadCount(1);
+	world0.SetDeterministic(true);
+	BuildDeterministicPile(world0);
+
+	ndWorld world1;
+	world1.SetThreadCount(4);
+	world1.SetDeterministic(true);
+	BuildDeterministicPile(world1);
+
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world0.Update(1.0f / 60.0f);
+		world1.Update(1.0f / 60.0f);
+		world0.Sync();
+		world1.Sync();
+		EXPECT_EQ(world0.GetFrameStateHash(), world1.GetFrameStateHash());
+	}
+	EXPECT_NE(world0.GetFrameStateHash(), ndUnsigned64(0));
+	world0.CleanUp();
+	world1.CleanUp();
+}
+
+/* Frame arena: transient solver buffers are reset every step and trimmed by the policy. */
+TEST(WorldUpdate, FrameArenaTrim)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+	world.SetFrameArenaTrimPolicy(4);
+	BuildDeterministicPile(world);
+
+	for (ndInt32 i = 0; i < 60; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+	const ndFrameArena& arena = world.GetFrameArena();
+	EXPECT_GT(arena.GetHighWaterMark(), size_t(0));
+	EXPECT_GE(arena.GetHighWaterMark(), arena.GetFrameUsage());
+	EXPECT_GE(arena.GetCapacity(), arena.GetFrameUsage());
+	const size_t pileUsage = arena.GetFrameUsage();
+
+	// a spike frame with a thousand resting boxes
+	std::vector<ndBody*> spikeBodies;
+	ndShapeInstance boxShape(new ndShapeBox(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f)));
+	for (ndInt32 i = 0; i < 1024; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32((i % 32) - 16) * ndFloat32(1.0f) + ndFloat32(0.5f);
+		matrix.m_posit.m_y = ndFloat32(0.74f);
+		matrix.m_posit.m_z = ndFloat32((i / 32) - 16) * ndFloat32(1.0f) + ndFloat32(0.5f);
+
+		ndBodyDynamic* const box = new ndBodyDynamic();
+		box->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+		box->SetCollisionShape(boxShape);
+		box->SetMatrix(matrix);
+		box->SetMassMatrix(ndFloat32(1.0f), boxShape);
+		world.AddBody(ndSharedPtr<ndBody>(box));
+		spikeBodies.push_back(box);
+	}
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+	const size_t spikeCapacity = arena.GetCapacity();
+	EXPECT_GT(spikeCapacity, pileUsage + size_t(2 * D_FRAME_ARENA_BLOCK_SIZE));
+
+	// after a few small frames the policy returns the spike memory
+	for (size_t i = 0; i < spikeBodies.size(); ++i)
+	{
+		world.RemoveBody(spikeBodies[i]);
+	}
+	for (ndInt32 i = 0; i < 12; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+	EXPECT_LT(arena.GetCapacity(), spikeCapacity);
+	EXPECT_LE(arena.GetCapacity(), pileUsage + size_t(4 * D_FRAME_ARENA_BLOCK_SIZE));
+
+	world.CleanUp();
+	EXPECT_EQ(world.GetFrameArena().GetCapacity(), size_t(0));
+}